@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch-handler.h"
+#include "date-functions.h"
+#include "db-interface.h"
+#include "planner-functions.h"
+
+void testRunBatch();
+void testManyCommands();
+
+void deleteFileIfExists(char *filename);
+void printError(char *desc, char rc);
+FILE *writeInput(char *text);
+char *readOutput(FILE *file);
+
+char *testDb = "./testing.db";
+DbHandle *handle = NULL;
+
+int main()
+{
+    testRunBatch();
+    testManyCommands();
+
+    deleteFileIfExists(testDb);
+}
+
+void testRunBatch()
+{
+    printf("...Starting testRunBatch.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    FILE *input = writeInput(
+        "# Comments and blank lines don't count.\n"
+        "\n"
+        "add 2024-12-25 Christmas   dinner\n"
+        "add yearly 2024-03-05 Birthday\n"
+        "goto 2024-12-25\r\n"
+        "add f Boxing day?\n"
+        "edit 1 Christmas   lunch\n"
+        "delete 2\n"
+        "commit\n"
+        "edit 99 Nothing\n"
+        "delete x\n"
+        "add 2023-02-29 Not a leap year\n"
+        "add 2024-12-25\n"
+        "dance\n"
+        "delete 2\n"
+        "edit 2 Deleted already\n"
+        "edit 4294967297 Too big for an int\n"
+        "delete 4294967297\n"
+    );
+    FILE *output = tmpfile();
+
+    BatchStats stats;
+
+    if ((rc = batch_handler_run(handle, input, output, &stats))) {
+        char *str;
+        batch_handler_build_err(handle, &stats, &str, rc);
+        printf("ERROR running batch: %s\n", str);
+        free(str);
+        fclose(input);
+        fclose(output);
+        return;
+    }
+    fclose(input);
+
+    char *result = readOutput(output);
+    char *expected =
+        "3 ok 1\n"
+        "4 ok 2\n"
+        "5 ok\n"
+        "6 ok 3\n"
+        "7 ok\n"
+        "8 ok\n"
+        "9 ok\n"
+        "10 error no item with that id\n"
+        "11 error expected an item id\n"
+        "12 error expected a date (YYYY-MM-DD) or a day letter\n"
+        "13 error expected a description\n"
+        "14 error unknown command\n"
+        "15 error no item with that id\n"
+        "16 error no item with that id\n"
+        "17 error no item with that id\n"
+        "18 error no item with that id\n";
+
+    if (strcmp(result, expected) != 0) {
+        printf("FAILURE: Expected output:\n%sBut found:\n%s", expected, result);
+    }
+    free(result);
+
+    if (stats.commands != 16 || stats.failed != 9) {
+        printf("FAILURE: Expected 16 commands with 9 failed, but found %ld with %ld.\n",
+            stats.commands, stats.failed);
+    }
+
+    // Christmas week has the edited item and Boxing Day (a Friday that week),
+    // but the birthday was deleted.
+    PlannerItem *item;
+    char *descs[] = {"Christmas   lunch", "Boxing day?"};
+    int count = 0;
+
+    while ((rc = db_interface_range(handle, &item, buildDate(23, 0, 0), buildDate(23, 11, 30)))
+        == DB_INTERFACE__CONT
+    ) {
+        if (count < 2 && strcmp(item->desc, descs[count]) != 0) {
+            printf("FAILURE: Expected \"%s\" but found \"%s\".\n", descs[count], item->desc);
+        }
+        count++;
+        freeItem(item);
+    }
+
+    if (count != 2) {
+        printf("FAILURE: Expected 2 items in 2024, but found %d.\n", count);
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testRunBatch.\n");
+}
+
+void testManyCommands()
+{
+    printf("...Starting testManyCommands.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    // Add, edit, and delete, so every command has something to find.
+    int rounds = 10000;
+
+    FILE *input = tmpfile();
+    for (int i = 0; i < rounds; i++) {
+        fprintf(input, "add 2024-%02d-%02d item %d\n", i % 12 + 1, i % 28 + 1, i);
+        fprintf(input, "edit %d item %d edited\n", i + 1, i);
+        if (i % 2) {
+            fprintf(input, "delete %d\n", i + 1);
+        }
+    }
+    rewind(input);
+
+    FILE *output = fopen("/dev/null", "w");
+    BatchStats stats;
+
+    if ((rc = batch_handler_run(handle, input, output, &stats))) {
+        printf("ERROR running batch: %d\n", rc);
+    }
+    fclose(input);
+    fclose(output);
+
+    if (stats.commands != rounds * 5 / 2 || stats.failed != 0) {
+        printf("FAILURE: Expected %d commands with none failed, but found %ld with %ld.\n",
+            rounds * 5 / 2, stats.commands, stats.failed);
+    }
+
+    printf("...Ran %ld commands in %.3fs.\n", stats.commands, stats.seconds);
+
+    PlannerItem *item;
+    int count = 0;
+
+    while ((rc = db_interface_day(handle, &item, buildDate(23, 0, 0))) == DB_INTERFACE__CONT) {
+        if (strstr(item->desc, "edited") == NULL) {
+            printf("FAILURE: Expected \"%s\" to have been edited.\n", item->desc);
+        }
+        count++;
+        freeItem(item);
+    }
+
+    // Every 84 items is Jan 1, and those are all even, so none were deleted.
+    if (count != (rounds + 83) / 84) {
+        printf("FAILURE: Expected %d items on Jan 1, but found %d.\n", (rounds + 83) / 84, count);
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testManyCommands.\n");
+}
+
+
+// Helper functions below this line.
+
+void deleteFileIfExists(char *filename)
+{
+    FILE *file;
+
+    if ((file = fopen(filename, "r"))) {
+        fclose(file);
+        remove(filename);
+    }
+}
+
+void printError(char *desc, char rc) {
+    char *str;
+    db_interface_build_err(handle, &str, rc);
+    printf("ERROR %s: %s\n", desc, str);
+    free(str);
+}
+
+/**
+ * Write text to a temporary file and rewind it, to use as input.
+ */
+FILE *writeInput(char *text)
+{
+    FILE *file = tmpfile();
+    fputs(text, file);
+    rewind(file);
+
+    return file;
+}
+
+/**
+ * Read everything that was written to a temporary file, and close it.
+ */
+char *readOutput(FILE *file)
+{
+    long len = ftell(file);
+    char *text = malloc(len + 1);
+
+    rewind(file);
+    text[fread(text, 1, len, file)] = '\0';
+    fclose(file);
+
+    return text;
+}
@@ -0,0 +1,410 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "batch-handler.h"
+
+#include "date-functions.h"
+#include "db-interface.h"
+#include "planner-functions.h"
+
+// Runs a script of commands without displaying anything, one command per
+// line:
+//
+//   add [yearly] DATE DESCRIPTION   Add an item.  DATE is YYYY-MM-DD, or a day
+//                                   letter (S M T W R F A) in the goto week.
+//   edit ID DESCRIPTION             Change an item's description.
+//   delete ID                       Delete an item.
+//   goto DATE                       Go to the week with that date.
+//   commit                          Commit everything so far.
+//
+// Blank lines and lines starting with # are skipped.  Every command writes
+// one line to the output with its line number and "ok" (plus the new id for
+// add) or "error" and why.  A command that fails doesn't stop the ones after
+// it, unless it's the database that failed.  The whole script is one
+// transaction unless it commits, so it's fast and all or nothing.
+
+/**
+ * Where the script is up to.
+ */
+typedef struct batch_state {
+    DbHandle *db;
+    FILE *output;
+
+    /** @var First day (Sunday) of the week that day letters are in. */
+    Date week;
+
+    BatchStats *stats;
+} BatchState;
+
+/**
+ * A command, which returns NULL if it worked or why it didn't.  Errors that
+ * should stop the whole batch are passed back in rc.
+ */
+typedef char *(*BatchCommand)(BatchState *state, char *args, long lineNum, char *rc);
+
+/**
+ * A command and its name in the script.
+ */
+typedef struct batch_command_entry {
+    char *name;
+    BatchCommand run;
+} BatchCommandEntry;
+
+static char runLine(BatchState *state, char *line, long lineNum);
+static char *addCommand(BatchState *state, char *args, long lineNum, char *rc);
+static char *editCommand(BatchState *state, char *args, long lineNum, char *rc);
+static char *deleteCommand(BatchState *state, char *args, long lineNum, char *rc);
+static char *gotoCommand(BatchState *state, char *args, long lineNum, char *rc);
+static char *commitCommand(BatchState *state, char *args, long lineNum, char *rc);
+static char *nextWord(char **str);
+static char parseDay(BatchState *state, char *str, Date *date);
+static char parseId(char *str, long *id);
+
+/** What each command in a script does. */
+static const BatchCommandEntry commands[] = {
+    {"add", addCommand},
+    {"edit", editCommand},
+    {"delete", deleteCommand},
+    {"goto", gotoCommand},
+    {"commit", commitCommand},
+};
+
+/** Letters for the days of the week, starting with Sunday. */
+static char weekdayLetters[7] = {'s', 'm', 't', 'w', 'r', 'f', 'a'};
+
+/**
+ * Run a script of commands against the database, which needs to have already
+ * been initialized.  Writes the result of each command to output.  Returns RC
+ * from constants; commands that fail are counted in stats instead.
+ *
+ * @param   db
+ * @param   input   Script to read (can be stdin).
+ * @param   output  Where the result of each command goes.
+ * @param   stats   Results passed back by argument.
+ */
+char batch_handler_run(DbHandle *db, FILE *input, FILE *output, BatchStats *stats)
+{
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    memset(stats, 0, sizeof(BatchStats));
+
+    BatchState state = {db, output, getWeek(todayDate()), stats};
+    char rc = BATCH_HANDLER__OK;
+
+    char *line = NULL;
+    size_t lineCap = 0;
+    ssize_t lineLen;
+    long lineNum = 0;
+
+    if ((stats->dbRc = db_interface_begin(db))) {
+        return BATCH_HANDLER__DB_ERROR;
+    }
+
+    while ((lineLen = getline(&line, &lineCap, input)) != -1) {
+        lineNum++;
+
+        while (lineLen > 0 && (line[lineLen - 1] == '\n' || line[lineLen - 1] == '\r')) {
+            line[--lineLen] = '\0';
+        }
+
+        if ((rc = runLine(&state, line, lineNum))) {
+            break;
+        }
+    }
+
+    if (rc == BATCH_HANDLER__OK && ferror(input)) {
+        rc = BATCH_HANDLER__IO_ERROR;
+    }
+
+    if (rc == BATCH_HANDLER__OK) {
+        if ((stats->dbRc = db_interface_commit(db))) {
+            rc = BATCH_HANDLER__DB_ERROR;
+        }
+    } else {
+        // Only the commands since the last commit are lost.
+        db_interface_rollback(db);
+    }
+
+    free(line);
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    stats->seconds = (end.tv_sec - start.tv_sec)
+        + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    return rc;
+}
+
+/**
+ * Build an error message from the code.  Returns RC.
+ *
+ * @param   db      Handle the batch was run on, for database errors.
+ * @param   stats   Stats from the batch, for database errors.
+ * @param   str     Passed back by argument.  Needs to be freed.
+ * @param   code
+ */
+char batch_handler_build_err(DbHandle *db, BatchStats *stats, char **str, int code)
+{
+    char *strdum;
+
+    switch (code) {
+        case BATCH_HANDLER__OK:
+            strdum = "No error for batch handler.";
+            break;
+        case BATCH_HANDLER__IO_ERROR:
+            strdum = "Could not read script.";
+            break;
+        case BATCH_HANDLER__OUT_OF_MEMORY:
+            strdum = "Out of memory for batch handler.";
+            break;
+        case BATCH_HANDLER__DB_ERROR:
+            return db_interface_build_err(db, str, stats->dbRc);
+        default:
+            strdum = "Unknown error for batch handler.";
+    }
+
+    *str = malloc(strlen(strdum) + 1);
+
+    if (*str == NULL) {
+        return BATCH_HANDLER__OUT_OF_MEMORY;
+    }
+
+    strcpy(*str, strdum);
+
+    return BATCH_HANDLER__OK;
+}
+
+// Static functions below this line.
+
+/**
+ * Run one line of the script and write how it went.
+ *
+ * @param   state
+ * @param   line
+ * @param   lineNum
+ */
+static char runLine(BatchState *state, char *line, long lineNum)
+{
+    char *rest = line;
+    char *name = nextWord(&rest);
+
+    if (*name == '\0' || *name == '#') {
+        return BATCH_HANDLER__OK;
+    }
+
+    state->stats->commands++;
+
+    char rc = BATCH_HANDLER__OK;
+    char *error = "unknown command";
+
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        if (strcmp(commands[i].name, name) == 0) {
+            error = commands[i].run(state, rest, lineNum, &rc);
+            break;
+        }
+    }
+
+    if (error != NULL) {
+        state->stats->failed++;
+        fprintf(state->output, "%ld error %s\n", lineNum, error);
+    }
+
+    return rc;
+}
+
+/**
+ * add [yearly] DATE DESCRIPTION
+ */
+static char *addCommand(BatchState *state, char *args, long lineNum, char *rc)
+{
+    char *word = nextWord(&args);
+    char rep = REP_NONE;
+
+    if (strcmp(word, "yearly") == 0) {
+        rep = REP_YEARLY;
+        word = nextWord(&args);
+    }
+
+    Date date;
+    if (!parseDate(word, &date) && !parseDay(state, word, &date)) {
+        return "expected a date (YYYY-MM-DD) or a day letter";
+    }
+
+    if (*args == '\0') {
+        return "expected a description";
+    }
+
+    // Not using buildItem, since the description doesn't need to be copied
+    // just to be saved.
+    PlannerItem item = {0, date, args, rep};
+
+    if ((state->stats->dbRc = db_interface_save(state->db, &item))) {
+        *rc = BATCH_HANDLER__DB_ERROR;
+        return "could not save";
+    }
+
+    fprintf(state->output, "%ld ok %ld\n", lineNum, item.id);
+
+    return NULL;
+}
+
+/**
+ * edit ID DESCRIPTION
+ */
+static char *editCommand(BatchState *state, char *args, long lineNum, char *rc)
+{
+    long id;
+    if (!parseId(nextWord(&args), &id)) {
+        return "expected an item id";
+    }
+
+    if (*args == '\0') {
+        return "expected a description";
+    }
+
+    if ((state->stats->dbRc = db_interface_update_desc(state->db, id, args))) {
+        *rc = BATCH_HANDLER__DB_ERROR;
+        return "could not save";
+    }
+
+    if (db_interface_changes(state->db) == 0) {
+        return "no item with that id";
+    }
+
+    fprintf(state->output, "%ld ok\n", lineNum);
+
+    return NULL;
+}
+
+/**
+ * delete ID
+ */
+static char *deleteCommand(BatchState *state, char *args, long lineNum, char *rc)
+{
+    long id;
+    if (!parseId(nextWord(&args), &id) || *args != '\0') {
+        return "expected an item id";
+    }
+
+    if ((state->stats->dbRc = db_interface_delete(state->db, id))) {
+        *rc = BATCH_HANDLER__DB_ERROR;
+        return "could not delete";
+    }
+
+    if (db_interface_changes(state->db) == 0) {
+        return "no item with that id";
+    }
+
+    fprintf(state->output, "%ld ok\n", lineNum);
+
+    return NULL;
+}
+
+/**
+ * goto DATE
+ */
+static char *gotoCommand(BatchState *state, char *args, long lineNum, char *rc)
+{
+    Date date;
+    if (!parseDate(nextWord(&args), &date) || *args != '\0') {
+        return "expected a date (YYYY-MM-DD)";
+    }
+
+    state->week = getWeek(date);
+
+    fprintf(state->output, "%ld ok\n", lineNum);
+
+    return NULL;
+}
+
+/**
+ * commit
+ */
+static char *commitCommand(BatchState *state, char *args, long lineNum, char *rc)
+{
+    if (*args != '\0') {
+        return "commit doesn't take anything after it";
+    }
+
+    if ((state->stats->dbRc = db_interface_commit(state->db)) || (state->stats->dbRc = db_interface_begin(state->db))) {
+        *rc = BATCH_HANDLER__DB_ERROR;
+        return "could not commit";
+    }
+
+    fprintf(state->output, "%ld ok\n", lineNum);
+
+    return NULL;
+}
+
+/**
+ * Cut the next word off the front of a string.  Returns the word (which is
+ * empty at the end), and leaves str pointing after it and any spaces.
+ *
+ * @param   str
+ */
+static char *nextWord(char **str)
+{
+    char *word = *str;
+
+    while (isspace((unsigned char) *word)) {
+        word++;
+    }
+
+    char *end = word;
+    while (*end != '\0' && !isspace((unsigned char) *end)) {
+        end++;
+    }
+
+    *str = end;
+    if (*end != '\0') {
+        *end = '\0';
+        (*str)++;
+        while (isspace((unsigned char) **str)) {
+            (*str)++;
+        }
+    }
+
+    return word;
+}
+
+/**
+ * Parse a day letter into that day of the current week.  Returns true if it's
+ * valid.
+ *
+ * @param   state
+ * @param   str
+ * @param   date
+ */
+static char parseDay(BatchState *state, char *str, Date *date)
+{
+    if (strlen(str) != 1) {
+        return 0;
+    }
+
+    for (int i = 0; i < 7; i++) {
+        if (weekdayLetters[i] == tolower((unsigned char) str[0])) {
+            *date = addDays(state->week, i);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Parse an item id.  Returns true if it's valid.
+ *
+ * @param   str
+ * @param   id
+ */
+static char parseId(char *str, long *id)
+{
+    char *end;
+    *id = strtol(str, &end, 10);
+
+    return *str != '\0' && *end == '\0' && *id > 0;
+}
@@ -0,0 +1,37 @@
+#ifndef batchhandler_h
+#define batchhandler_h
+
+#include <stdio.h>
+
+#include "db-interface.h"
+
+// Constants
+
+#define BATCH_HANDLER__OK               0
+#define BATCH_HANDLER__IO_ERROR         1
+#define BATCH_HANDLER__OUT_OF_MEMORY    2
+#define BATCH_HANDLER__DB_ERROR         3
+
+// Types
+
+typedef struct batch_stats {
+    /** @var Number of commands run (not counting blank lines and comments). */
+    long commands;
+
+    /** @var Number of those commands that failed. */
+    long failed;
+
+    /** @var Seconds the whole batch took. */
+    double seconds;
+
+    /** @var RC from the db interface, for DB_ERROR. */
+    char dbRc;
+} BatchStats;
+
+// Functions
+
+char batch_handler_run(DbHandle *db, FILE *input, FILE *output, BatchStats *stats);
+
+char batch_handler_build_err(DbHandle *db, BatchStats *stats, char **str, int code);
+
+#endif
@@ -0,0 +1,268 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "client-handler.h"
+#include "date-functions.h"
+#include "db-interface.h"
+#include "planner-functions.h"
+#include "serve-handler.h"
+
+void testWeek();
+void testErrors();
+void *runListen(void *arg);
+
+void deleteFileIfExists(char *filename);
+void printError(char *desc, char rc);
+char startDaemon(pthread_t *thread);
+void stopDaemon(pthread_t *thread);
+char *readOutput(FILE *file);
+
+char *testDb = "./testing.db";
+DbHandle *handle = NULL;
+char *testSocket = "./testing.sock";
+ServeListener listener;
+
+int main()
+{
+    testWeek();
+    testErrors();
+
+    deleteFileIfExists(testDb);
+}
+
+/**
+ * Print a week from the daemon, and check it's laid out like the planner.
+ */
+void testWeek()
+{
+    printf("...Starting testWeek.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    PlannerItem items[] = {
+        {0, buildDate(23, 11, 24), "Christmas \"dinner\"", REP_NONE},
+        {0, buildDate(23, 11, 24), "Gifts", REP_NONE},
+        {0, buildDate(20, 11, 27), "Anniversary", REP_YEARLY},
+    };
+
+    for (int i = 0; i < 3; i++) {
+        if ((rc = db_interface_save(handle, &items[i]))) {
+            printError("saving", rc);
+            return;
+        }
+    }
+
+    pthread_t thread;
+    if (startDaemon(&thread)) {
+        return;
+    }
+
+    FILE *output = tmpfile();
+    ClientResult clientResult;
+
+    if ((rc = client_handler_week(testSocket, "2024-12-25", output, &clientResult))) {
+        char *str;
+        client_handler_build_err(&clientResult, &str, rc);
+        printf("FAILURE: Expected the week, but found: %s\n", str);
+        free(str);
+    }
+
+    stopDaemon(&thread);
+
+    char *result = readOutput(output);
+
+    // Skip "Today is...", which changes.
+    char *week = strstr(result, "\n\n");
+    char *expected =
+        "\n\n"
+        "S 2024-12-22\n"
+        "\n"
+        "M 2024-12-23\n"
+        "\n"
+        "T 2024-12-24\n"
+        "\n"
+        "W 2024-12-25\n"
+        "  1) Christmas \"dinner\"\n"
+        "  2) Gifts\n"
+        "\n"
+        "R 2024-12-26\n"
+        "\n"
+        "F 2024-12-27\n"
+        "\n"
+        "A 2024-12-28\n"
+        "  3) Anniversary (yearly)\n"
+        "\n";
+
+    if (strncmp(result, "\nToday is ", 10) != 0 || week == NULL || strcmp(week, expected) != 0) {
+        printf("FAILURE: Expected the week:%sBut found:%s", expected, result);
+    }
+    free(result);
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testWeek.\n");
+}
+
+/**
+ * No daemon, and a date that isn't one.
+ */
+void testErrors()
+{
+    printf("...Starting testErrors.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+    FILE *output = fopen("/dev/null", "w");
+    ClientResult clientResult;
+
+    if ((rc = client_handler_week(testSocket, NULL, output, &clientResult)) != CLIENT_HANDLER__CONNECT_ERROR) {
+        printf("FAILURE: Expected a connection error with no daemon, but found %d.\n", rc);
+    }
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        fclose(output);
+        return;
+    }
+
+    pthread_t thread;
+    if (startDaemon(&thread)) {
+        fclose(output);
+        return;
+    }
+
+    if ((rc = client_handler_week(testSocket, "2023-02-29", output, &clientResult)) != CLIENT_HANDLER__BAD_DATE) {
+        printf("FAILURE: Expected an error for a bad date, but found %d.\n", rc);
+    }
+
+    if ((rc = client_handler_week(testSocket, NULL, output, &clientResult))) {
+        printf("FAILURE: Expected this week with no date, but found %d.\n", rc);
+    }
+
+    stopDaemon(&thread);
+    fclose(output);
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testErrors.\n");
+}
+
+// Helper functions below this line.
+
+/**
+ * Thread for the daemon.
+ */
+void *runListen(void *arg)
+{
+    ServeStats stats;
+
+    *(char *) arg = serve_handler_listen(handle, testSocket, &listener, &stats);
+
+    return NULL;
+}
+
+/** What the daemon thread returned. */
+char listenRc = 0;
+
+/**
+ * Start the daemon on a thread and wait for it to be listening.  Returns true
+ * if it didn't start.
+ */
+char startDaemon(pthread_t *thread)
+{
+    if (serve_handler_listener_initialize(&listener)) {
+        printf("ERROR: Could not initialize the listener.\n");
+        return 1;
+    }
+
+    if (pthread_create(thread, NULL, runListen, &listenRc)) {
+        printf("ERROR: Could not start the thread.\n");
+        serve_handler_listener_finalize(&listener);
+        return 1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, testSocket);
+
+    for (int tries = 0; tries < 500; tries++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        char connected = connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0;
+        close(fd);
+
+        if (connected) {
+            return 0;
+        }
+        usleep(10000);
+    }
+
+    printf("ERROR: The daemon didn't start listening.\n");
+    serve_handler_stop(&listener);
+    pthread_join(*thread, NULL);
+    serve_handler_listener_finalize(&listener);
+
+    return 1;
+}
+
+void stopDaemon(pthread_t *thread)
+{
+    serve_handler_stop(&listener);
+    pthread_join(*thread, NULL);
+    serve_handler_listener_finalize(&listener);
+
+    if (listenRc) {
+        printf("FAILURE: Expected the daemon to stop OK, but found %d.\n", listenRc);
+    }
+}
+
+void deleteFileIfExists(char *filename)
+{
+    FILE *file;
+
+    if ((file = fopen(filename, "r"))) {
+        fclose(file);
+        remove(filename);
+    }
+}
+
+void printError(char *desc, char rc) {
+    char *str;
+    db_interface_build_err(handle, &str, rc);
+    printf("ERROR %s: %s\n", desc, str);
+    free(str);
+}
+
+/**
+ * Read everything that was written to a temporary file, and close it.
+ */
+char *readOutput(FILE *file)
+{
+    long len = ftell(file);
+    char *text = malloc(len + 1);
+
+    rewind(file);
+    text[fread(text, 1, len, file)] = '\0';
+    fclose(file);
+
+    return text;
+}
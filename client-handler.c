@@ -0,0 +1,377 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "client-handler.h"
+
+#include "date-functions.h"
+#include "json-functions.h"
+
+// The thin client for a daemon started with --daemon (see serve-handler).  It
+// asks for a week and prints it the way the planner shows it, without opening
+// the database or linking anything more than it takes to do that, so it
+// starts in about the time it takes to start a process.
+
+/** Responses longer than this are read in more than one go. */
+#define RESPONSE_SIZE 16384
+
+/**
+ * What came back from the daemon.  Strings point into the response.
+ */
+typedef struct week_response {
+    char ok;
+    char *error;
+    char *week;
+
+    /** @var The items array, still to be parsed. */
+    char *items;
+} WeekResponse;
+
+/**
+ * An item in the response.
+ */
+typedef struct week_item {
+    char *date;
+    char *description;
+    char *repetition;
+} WeekItem;
+
+static char connectTo(char *socketPath, int *fd);
+static char sendAll(int fd, const char *bytes, size_t len);
+static char readLine(int fd, char **line);
+static char printWeek(WeekResponse *response, FILE *output);
+static const char *responseField(char *key, JsonValue *value, void *ctx);
+static const char *itemField(char *key, JsonValue *value, void *ctx);
+
+/** Letters for the days of the week, starting with Sunday. */
+static char weekdayLetters[7] = {'S','M','T','W','R','F','A'};
+
+/**
+ * Ask the daemon listening on socketPath for a week, and print it.  Returns
+ * RC from constants.
+ *
+ * @param   socketPath
+ * @param   date        Any day in the week (YYYY-MM-DD), or NULL for this
+ *                      week.
+ * @param   output
+ * @param   result      Passed back by argument.
+ */
+char client_handler_week(char *socketPath, char *date, FILE *output, ClientResult *result)
+{
+    result->error[0] = '\0';
+
+    Date dateObj;
+    if (date != NULL && !parseDate(date, &dateObj)) {
+        return CLIENT_HANDLER__BAD_DATE;
+    }
+
+    int fd;
+    char rc;
+
+    if ((rc = connectTo(socketPath, &fd))) {
+        return rc;
+    }
+
+    // The date was checked, so it doesn't need escaping.
+    char request[64];
+    int len = date != NULL
+        ? snprintf(request, sizeof(request), "{\"op\":\"week\",\"date\":\"%s\"}\n", date)
+        : snprintf(request, sizeof(request), "{\"op\":\"week\"}\n");
+
+    char *line = NULL;
+
+    if ((rc = sendAll(fd, request, len)) == CLIENT_HANDLER__OK) {
+        // Nothing else is being sent.
+        shutdown(fd, SHUT_WR);
+        rc = readLine(fd, &line);
+    }
+    close(fd);
+
+    if (rc) {
+        free(line);
+        return rc;
+    }
+
+    WeekResponse response = {0, NULL, NULL, NULL};
+    char *at = line;
+
+    if (jsonParseObject(&at, responseField, &response) != NULL) {
+        rc = CLIENT_HANDLER__BAD_RESPONSE;
+    } else if (!response.ok) {
+        snprintf(result->error, sizeof(result->error), "%s",
+            response.error != NULL ? response.error : "unknown error");
+        rc = CLIENT_HANDLER__DAEMON_ERROR;
+    } else {
+        rc = printWeek(&response, output);
+    }
+
+    free(line);
+
+    return rc;
+}
+
+/**
+ * Build an error message from the code.  Returns RC.
+ *
+ * @param   result  Result of the request, for DAEMON_ERROR.
+ * @param   str     Passed back by argument.  Needs to be freed.
+ * @param   code
+ */
+char client_handler_build_err(ClientResult *result, char **str, int code)
+{
+    char *strdum;
+
+    switch (code) {
+        case CLIENT_HANDLER__OK:
+            strdum = "No error for client handler.";
+            break;
+        case CLIENT_HANDLER__CONNECT_ERROR:
+            strdum = "Could not connect to the daemon.  Is it running?";
+            break;
+        case CLIENT_HANDLER__IO_ERROR:
+            strdum = "Lost the connection to the daemon.";
+            break;
+        case CLIENT_HANDLER__OUT_OF_MEMORY:
+            strdum = "Out of memory for client handler.";
+            break;
+        case CLIENT_HANDLER__BAD_RESPONSE:
+            strdum = "Could not understand the daemon's response.";
+            break;
+        case CLIENT_HANDLER__DAEMON_ERROR:
+            strdum = result->error;
+            break;
+        case CLIENT_HANDLER__BAD_DATE:
+            strdum = "Expected a date (YYYY-MM-DD).";
+            break;
+        default:
+            strdum = "Unknown error for client handler.";
+    }
+
+    *str = malloc(strlen(strdum) + 1);
+
+    if (*str == NULL) {
+        return CLIENT_HANDLER__OUT_OF_MEMORY;
+    }
+
+    strcpy(*str, strdum);
+
+    return CLIENT_HANDLER__OK;
+}
+
+// Static functions below this line.
+
+/**
+ * Connect to the daemon's socket.
+ *
+ * @param   socketPath
+ * @param   fd          Passed back by argument.
+ */
+static char connectTo(char *socketPath, int *fd)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (strlen(socketPath) >= sizeof(addr.sun_path)) {
+        return CLIENT_HANDLER__CONNECT_ERROR;
+    }
+    strcpy(addr.sun_path, socketPath);
+
+    if ((*fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        return CLIENT_HANDLER__CONNECT_ERROR;
+    }
+
+    if (connect(*fd, (struct sockaddr *) &addr, sizeof(addr))) {
+        close(*fd);
+        return CLIENT_HANDLER__CONNECT_ERROR;
+    }
+
+    return CLIENT_HANDLER__OK;
+}
+
+static char sendAll(int fd, const char *bytes, size_t len)
+{
+    while (len > 0) {
+        ssize_t sent = send(fd, bytes, len, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return CLIENT_HANDLER__IO_ERROR;
+        }
+        bytes += sent;
+        len -= sent;
+    }
+
+    return CLIENT_HANDLER__OK;
+}
+
+/**
+ * Read the first line that comes back, without the newline.
+ *
+ * @param   fd
+ * @param   line    Passed back by argument.  Needs to be freed.
+ */
+static char readLine(int fd, char **line)
+{
+    size_t cap = RESPONSE_SIZE;
+    size_t len = 0;
+
+    if ((*line = malloc(cap)) == NULL) {
+        return CLIENT_HANDLER__OUT_OF_MEMORY;
+    }
+
+    for (;;) {
+        if (len == cap - 1) {
+            char *bigger = realloc(*line, cap * 2);
+            if (bigger == NULL) {
+                return CLIENT_HANDLER__OUT_OF_MEMORY;
+            }
+            *line = bigger;
+            cap *= 2;
+        }
+
+        ssize_t got = read(fd, *line + len, cap - len - 1);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return CLIENT_HANDLER__IO_ERROR;
+        }
+
+        char *newline = memchr(*line + len, '\n', got);
+        len += got;
+
+        if (newline != NULL) {
+            *newline = '\0';
+            return CLIENT_HANDLER__OK;
+        }
+    }
+}
+
+/**
+ * Print the week like the planner does, numbering the items in order.
+ *
+ * @param   response
+ * @param   output
+ */
+static char printWeek(WeekResponse *response, FILE *output)
+{
+    Date day;
+    if (response->week == NULL || response->items == NULL
+        || !parseDate(response->week, &day)
+    ) {
+        return CLIENT_HANDLER__BAD_RESPONSE;
+    }
+
+    char dayStr[DATE_STRING_SIZE];
+    char todayStr[DATE_STRING_SIZE];
+    Date today = todayDate();
+    formatDate(todayStr, today, '-');
+    fprintf(output, "\nToday is %c %s.\n\n", weekdayLetters[getWeekday(today)], todayStr);
+
+    char *at = jsonSkipSpace(response->items + 1);
+    int index = 0;
+    int number = 0;
+
+    formatDate(dayStr, day, '-');
+    fprintf(output, "%c %s%s\n", weekdayLetters[0], dayStr,
+        strcmp(dayStr, todayStr) == 0 ? "*" : "");
+
+    while (*at != ']') {
+        WeekItem item = {NULL, NULL, NULL};
+
+        if (jsonParseObject(&at, itemField, &item) != NULL
+            || item.date == NULL || item.description == NULL
+        ) {
+            return CLIENT_HANDLER__BAD_RESPONSE;
+        }
+
+        // Items are in order, so print the days up to this one's.
+        while (strcmp(item.date, dayStr) != 0) {
+            if (index == 6) {
+                return CLIENT_HANDLER__BAD_RESPONSE;
+            }
+            day = addDays(day, 1);
+            formatDate(dayStr, day, '-');
+            fprintf(output, "\n%c %s%s\n", weekdayLetters[++index], dayStr,
+                strcmp(dayStr, todayStr) == 0 ? "*" : "");
+        }
+
+        fprintf(output, "  %d) %s%s\n", ++number, item.description,
+            item.repetition != NULL && strcmp(item.repetition, "yearly") == 0
+                ? " (yearly)" : "");
+
+        at = jsonSkipSpace(at);
+        if (*at == ',') {
+            at = jsonSkipSpace(at + 1);
+        } else if (*at != ']') {
+            return CLIENT_HANDLER__BAD_RESPONSE;
+        }
+    }
+
+    while (index < 6) {
+        day = addDays(day, 1);
+        formatDate(dayStr, day, '-');
+        fprintf(output, "\n%c %s%s\n", weekdayLetters[++index], dayStr,
+            strcmp(dayStr, todayStr) == 0 ? "*" : "");
+    }
+    fprintf(output, "\n");
+
+    return ferror(output) ? CLIENT_HANDLER__IO_ERROR : CLIENT_HANDLER__OK;
+}
+
+/**
+ * See JsonFieldCallback.
+ *
+ * @param   key
+ * @param   value
+ * @param   ctx     The WeekResponse.
+ */
+static const char *responseField(char *key, JsonValue *value, void *ctx)
+{
+    WeekResponse *response = (WeekResponse *) ctx;
+
+    if (strcmp(key, "ok") == 0) {
+        response->ok = value->type == JSON__LITERAL && strncmp(value->raw, "true", 4) == 0;
+    } else if (strcmp(key, "items") == 0 && value->type == JSON__ARRAY) {
+        response->items = value->raw;
+    } else if (strcmp(key, "error") == 0 && value->type == JSON__STRING) {
+        return jsonParseString(value->raw, &response->error) ? NULL : "bad string";
+    } else if (strcmp(key, "week") == 0 && value->type == JSON__STRING) {
+        return jsonParseString(value->raw, &response->week) ? NULL : "bad string";
+    }
+
+    return NULL;
+}
+
+/**
+ * See JsonFieldCallback.
+ *
+ * @param   key
+ * @param   value
+ * @param   ctx     The WeekItem.
+ */
+static const char *itemField(char *key, JsonValue *value, void *ctx)
+{
+    WeekItem *item = (WeekItem *) ctx;
+    char **field = NULL;
+
+    if (strcmp(key, "date") == 0) {
+        field = &item->date;
+    } else if (strcmp(key, "description") == 0) {
+        field = &item->description;
+    } else if (strcmp(key, "repetition") == 0) {
+        field = &item->repetition;
+    }
+
+    if (field == NULL || value->type != JSON__STRING) {
+        return NULL;
+    }
+
+    return jsonParseString(value->raw, field) ? NULL : "bad string";
+}
@@ -0,0 +1,29 @@
+#ifndef clienthandler_h
+#define clienthandler_h
+
+#include <stdio.h>
+
+// Constants
+
+#define CLIENT_HANDLER__OK              0
+#define CLIENT_HANDLER__CONNECT_ERROR   1
+#define CLIENT_HANDLER__IO_ERROR        2
+#define CLIENT_HANDLER__OUT_OF_MEMORY   3
+#define CLIENT_HANDLER__BAD_RESPONSE    4
+#define CLIENT_HANDLER__DAEMON_ERROR    5
+#define CLIENT_HANDLER__BAD_DATE        6
+
+// Types
+
+typedef struct client_result {
+    /** @var The error the daemon sent back, for DAEMON_ERROR. */
+    char error[256];
+} ClientResult;
+
+// Functions
+
+char client_handler_week(char *socketPath, char *date, FILE *output, ClientResult *result);
+
+char client_handler_build_err(ClientResult *result, char **str, int code);
+
+#endif
@@ -0,0 +1,287 @@
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "csv-handler.h"
+#include "date-functions.h"
+#include "db-interface.h"
+#include "planner-functions.h"
+
+void testImportCsv();
+void testImportTsv();
+void testImportLarge();
+
+void deleteFileIfExists(char *filename);
+void printError(char *desc, char rc);
+FILE *writeInput(char *text);
+
+char *testDb = "./testing.db";
+DbHandle *handle = NULL;
+
+int main()
+{
+    testImportCsv();
+    testImportTsv();
+    testImportLarge();
+
+    deleteFileIfExists(testDb);
+}
+
+void testImportCsv()
+{
+    printf("...Starting testImportCsv.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    FILE *input = writeInput(
+        "date,description,repetition\n"
+        "2024-12-25,Christmas,yearly\n"
+        "2024-12-26,\"Boxing day, in some places\",n\r\n"
+        "2024-12-26,\"Said \"\"hi\"\"\"\n"
+        "2023-02-29,Not a leap year,n\n"
+        "2024-12-27,Bad repetition,sometimes\n"
+        "2024-12-27,\"Unclosed quote\n"
+        "2024-12-28,No newline at end"
+    );
+
+    CsvImportStats stats;
+
+    if ((rc = csv_handler_import(handle, input, ',', &stats))) {
+        char *str;
+        csv_handler_build_err(handle, &stats, &str, rc);
+        printf("ERROR during import: %s\n", str);
+        free(str);
+        fclose(input);
+        return;
+    }
+    fclose(input);
+
+    if (stats.rows != 4) {
+        printf("FAILURE: Expected 4 rows imported, but found %ld.\n", stats.rows);
+    }
+    if (stats.skipped != 3) {
+        printf("FAILURE: Expected 3 lines skipped, but found %ld.\n", stats.skipped);
+    }
+    if (stats.firstSkipped != 5) {
+        printf("FAILURE: Expected line 5 to be skipped first, but found %ld.\n",
+            stats.firstSkipped);
+    }
+
+    char *expected[] = {
+        "Christmas",
+        "Boxing day, in some places",
+        "Said \"hi\"",
+        "No newline at end",
+    };
+
+    PlannerItem *result;
+    int count = 0;
+
+    while ((rc = db_interface_range(
+        handle,
+        &result,
+        buildDate(23, 11, 24),
+        buildDate(23, 11, 30)
+    )) == DB_INTERFACE__CONT) {
+        if (count < 4 && strcmp(result->desc, expected[count]) != 0) {
+            printf("FAILURE: Expected \"%s\" but found \"%s\".\n",
+                expected[count], result->desc);
+        }
+        if (count == 0 && result->rep != REP_YEARLY) {
+            printf("FAILURE: Christmas should be yearly.\n");
+        }
+        count++;
+        freeItem(result);
+    }
+
+    if (count != 4) {
+        printf("FAILURE: Expected 4 items in range, but found %d.\n", count);
+    }
+
+    // A null in a line gets it skipped, without stopping the import.
+    char nullText[] = "date,description\n2024-12-29,bad\0byte,n\n2024-12-29,good,n\n";
+
+    input = tmpfile();
+    fwrite(nullText, 1, sizeof(nullText) - 1, input);
+    rewind(input);
+
+    if ((rc = csv_handler_import(handle, input, ',', &stats))) {
+        printf("ERROR during import with a null: %d\n", rc);
+    }
+    fclose(input);
+
+    if (stats.rows != 1 || stats.skipped != 1 || stats.firstSkipped != 2) {
+        printf("FAILURE: Expected 1 row and line 2 skipped, but found %ld and %ld (first %ld).\n",
+            stats.rows, stats.skipped, stats.firstSkipped);
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testImportCsv.\n");
+}
+
+void testImportTsv()
+{
+    printf("...Starting testImportTsv.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    // No header, and quotes aren't special.
+    FILE *input = writeInput(
+        "2024-07-04\tIndependence day, \"fireworks\"\ty\n"
+        "2024-07-05\tNo repetition column\n"
+    );
+
+    CsvImportStats stats;
+
+    if ((rc = csv_handler_import(handle, input, '\t', &stats))) {
+        printf("ERROR during import: %d\n", rc);
+        fclose(input);
+        return;
+    }
+    fclose(input);
+
+    if (stats.rows != 2 || stats.skipped != 0) {
+        printf("FAILURE: Expected 2 rows and none skipped, but found %ld and %ld.\n",
+            stats.rows, stats.skipped);
+    }
+
+    PlannerItem *result = NULL;
+    int count = 0;
+
+    while ((rc = db_interface_day(handle, &result, buildDate(30, 6, 3))) == DB_INTERFACE__CONT) {
+        if (strcmp(result->desc, "Independence day, \"fireworks\"") != 0) {
+            printf("FAILURE: TSV description not imported as-is.  Found \"%s\".\n",
+                result->desc);
+        }
+        count++;
+        freeItem(result);
+    }
+
+    if (count != 1) {
+        printf("FAILURE: Yearly item from TSV not found in a later year.\n");
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testImportTsv.\n");
+}
+
+void testImportLarge()
+{
+    printf("...Starting testImportLarge.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    // Enough rows to go through several chunks and commits, which also means
+    // the indexes get dropped and rebuilt.
+    int rowCount = 250000;
+
+    FILE *input = tmpfile();
+    for (int i = 0; i < rowCount; i++) {
+        fprintf(input, "2024-%02d-%02d,row %d\n", i % 12 + 1, i % 28 + 1, i);
+    }
+    rewind(input);
+
+    CsvImportStats stats;
+
+    if ((rc = csv_handler_import(handle, input, ',', &stats))) {
+        printf("ERROR during import: %d\n", rc);
+        fclose(input);
+        return;
+    }
+    fclose(input);
+
+    if (stats.rows != rowCount) {
+        printf("FAILURE: Expected %d rows, but found %ld.\n", rowCount, stats.rows);
+    }
+
+    printf("...Imported %ld rows in %.3fs.\n", stats.rows, stats.seconds);
+
+    // Ids should be in the same order as the file.
+    sqlite3_stmt *stmt = NULL;
+    sqlite3_prepare_v2(db_interface_get_db(handle),
+        "SELECT count(*) FROM items WHERE desc != 'row ' || (id - 1);",
+        -1, &stmt, 0);
+    sqlite3_step(stmt);
+    if (sqlite3_column_int(stmt, 0) != 0) {
+        printf("FAILURE: %d rows were saved out of order.\n", sqlite3_column_int(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+
+    sqlite3_prepare_v2(db_interface_get_db(handle),
+        "SELECT count(*) FROM sqlite_master WHERE name = 'idx_live_rep_date';",
+        -1, &stmt, 0);
+    sqlite3_step(stmt);
+    if (sqlite3_column_int(stmt, 0) != 1) {
+        printf("FAILURE: Index was not rebuilt after import.\n");
+    }
+    sqlite3_finalize(stmt);
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testImportLarge.\n");
+}
+
+
+// Helper functions below this line.
+
+void deleteFileIfExists(char *filename)
+{
+    FILE *file;
+
+    if ((file = fopen(filename, "r"))) {
+        fclose(file);
+        remove(filename);
+    }
+}
+
+void printError(char *desc, char rc) {
+    char *str;
+    db_interface_build_err(handle, &str, rc);
+    printf("ERROR %s: %s\n", desc, str);
+    free(str);
+}
+
+/**
+ * Write text to a temporary file and rewind it, to use as input.
+ */
+FILE *writeInput(char *text)
+{
+    FILE *file = tmpfile();
+    fputs(text, file);
+    rewind(file);
+
+    return file;
+}
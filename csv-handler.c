@@ -0,0 +1,708 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "csv-handler.h"
+
+#include "date-functions.h"
+#include "db-interface.h"
+#include "planner-functions.h"
+
+// Importing is a pipeline: one thread reads lines into chunks, worker threads
+// parse the chunks, and the calling thread saves them in the same order they
+// were read.  SQLite is only ever used from the calling thread, and the saves
+// all reuse the same cached INSERT statement inside big transactions, so the
+// only fsyncs are on commits.  Once an import gets past the first commit, the
+// indexes are dropped and then rebuilt at the end, which is about twice as
+// fast as keeping them updated for every row.
+
+// Each line is "date,description,repetition", like "2024-12-25,Christmas,y".
+// The repetition is optional.  For CSV (but not TSV), fields can be quoted
+// with double quotes, with "" for a literal quote.  Quoted fields can't have
+// line breaks in them.  If the first line can't be parsed, it's assumed to be
+// a header and isn't counted as skipped.
+
+/** Number of lines in each chunk. */
+#define CHUNK_LINES 4096
+
+/** Maximum number of threads parsing chunks. */
+#define MAX_WORKERS 8
+
+/** Number of rows saved per transaction. */
+#define COMMIT_ROWS 100000
+
+// Chunk states.
+#define CHUNK_EMPTY     0
+#define CHUNK_FILLED    1
+#define CHUNK_PARSING   2
+#define CHUNK_PARSED    3
+
+/**
+ * A parsed line.  The description points into the text of its chunk.
+ */
+typedef struct csv_row {
+    Date date;
+    char *desc;
+    char rep;
+    char ok;
+} CsvRow;
+
+/**
+ * A block of lines that passes through the pipeline together.
+ */
+typedef struct csv_chunk {
+    /** @var Text of every line in the chunk, each ending with a newline. */
+    char *text;
+    size_t len;
+    size_t cap;
+
+    CsvRow rows[CHUNK_LINES];
+    int lineCount;
+
+    /** @var The valid rows, gathered to be saved together. */
+    PlannerItem items[CHUNK_LINES];
+
+    /** @var Line number (in the file) of the first line in the chunk. */
+    long firstLine;
+
+    /** @var Order the chunk was read in. */
+    long seq;
+
+    char state;
+} CsvChunk;
+
+/**
+ * State shared between all the threads of an import.  Everything after
+ * `chunkCount` needs the lock.
+ */
+typedef struct csv_pipeline {
+    FILE *input;
+    char delim;
+    CsvChunk *chunks;
+    int chunkCount;
+
+    /** @var Sequence number of the next chunk to be read. */
+    long readSeq;
+
+    /** @var True when the reader has hit the end of the input. */
+    char eof;
+
+    /** @var True if the reader had an error. */
+    char readErr;
+
+    /** @var True if the reader ran out of memory. */
+    char outOfMemory;
+
+    /** @var True if everything should stop. */
+    char abort;
+
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} CsvPipeline;
+
+static void *readChunks(void *arg);
+static char appendLine(CsvChunk *chunk, char *line, size_t len);
+static void *parseChunks(void *arg);
+static void parseChunk(CsvChunk *chunk, char delim);
+static char parseLine(char *line, char delim, CsvRow *row);
+static int splitFields(char *line, char delim, char **fields, int max);
+static char parseRep(char *str, char *rep);
+static char saveChunk(
+    DbHandle *db,
+    CsvChunk *chunk,
+    CsvImportStats *stats,
+    long *uncommitted,
+    char *droppedIndexes
+);
+static void abortPipeline(CsvPipeline *pl);
+static int workerCount();
+
+/**
+ * Import planner items from CSV or TSV into the database, which needs to have
+ * already been initialized.  Lines that can't be parsed are skipped and
+ * counted in stats.  Returns RC from constants.
+ *
+ * @param   db
+ * @param   input   File to read from (can be stdin).
+ * @param   delim   ',' for CSV or '\t' for TSV.
+ * @param   stats   Results passed back by argument.
+ */
+char csv_handler_import(DbHandle *db, FILE *input, char delim, CsvImportStats *stats)
+{
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    memset(stats, 0, sizeof(CsvImportStats));
+
+    int workers = workerCount();
+    pthread_t reader;
+    pthread_t parsers[MAX_WORKERS];
+
+    CsvPipeline pl = {};
+    pl.input = input;
+    pl.delim = delim;
+    // Enough chunks to keep every worker busy while one is being saved and
+    // one is being read.
+    pl.chunkCount = workers + 2;
+    pl.chunks = calloc(pl.chunkCount, sizeof(CsvChunk));
+
+    if (pl.chunks == NULL) {
+        return CSV_HANDLER__OUT_OF_MEMORY;
+    }
+
+    pthread_mutex_init(&pl.lock, NULL);
+    pthread_cond_init(&pl.changed, NULL);
+
+    char rc = CSV_HANDLER__OK;
+    char readerStarted = 0;
+    char inTransaction = 0;
+    char droppedIndexes = 0;
+    int started = 0;
+
+    if (pthread_create(&reader, NULL, readChunks, &pl)) {
+        rc = CSV_HANDLER__THREAD_ERROR;
+    } else {
+        readerStarted = 1;
+    }
+
+    for (; rc == CSV_HANDLER__OK && started < workers; started++) {
+        if (pthread_create(&parsers[started], NULL, parseChunks, &pl)) {
+            abortPipeline(&pl);
+            rc = CSV_HANDLER__THREAD_ERROR;
+            break;
+        }
+    }
+
+    if (rc == CSV_HANDLER__OK) {
+        if ((stats->dbRc = db_interface_begin(db))) {
+            abortPipeline(&pl);
+            rc = CSV_HANDLER__DB_ERROR;
+        } else {
+            inTransaction = 1;
+        }
+    }
+
+    long writeSeq = 0;
+    long uncommitted = 0;
+
+    while (rc == CSV_HANDLER__OK) {
+        CsvChunk *chunk = &pl.chunks[writeSeq % pl.chunkCount];
+
+        pthread_mutex_lock(&pl.lock);
+        while (!(chunk->state == CHUNK_PARSED && chunk->seq == writeSeq)
+            && !(pl.eof && writeSeq == pl.readSeq)
+            && !pl.abort
+        ) {
+            pthread_cond_wait(&pl.changed, &pl.lock);
+        }
+        char ready = (chunk->state == CHUNK_PARSED && chunk->seq == writeSeq);
+        pthread_mutex_unlock(&pl.lock);
+
+        if (!ready) {
+            break;
+        }
+
+        if ((rc = saveChunk(db, chunk, stats, &uncommitted, &droppedIndexes))) {
+            abortPipeline(&pl);
+            break;
+        }
+
+        pthread_mutex_lock(&pl.lock);
+        chunk->state = CHUNK_EMPTY;
+        pthread_cond_broadcast(&pl.changed);
+        pthread_mutex_unlock(&pl.lock);
+
+        writeSeq++;
+    }
+
+    if (readerStarted) {
+        pthread_join(reader, NULL);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(parsers[i], NULL);
+    }
+
+    if (rc == CSV_HANDLER__OK && pl.outOfMemory) {
+        rc = CSV_HANDLER__OUT_OF_MEMORY;
+    } else if (rc == CSV_HANDLER__OK && pl.readErr) {
+        rc = CSV_HANDLER__IO_ERROR;
+    }
+
+    if (inTransaction && rc == CSV_HANDLER__OK) {
+        if ((stats->dbRc = db_interface_commit(db))) {
+            rc = CSV_HANDLER__DB_ERROR;
+        }
+    } else if (inTransaction) {
+        // Only the rows since the last commit are lost.
+        db_interface_rollback(db);
+    }
+
+    if (droppedIndexes) {
+        char idxRc = db_interface_create_indexes(db);
+        if (idxRc && rc == CSV_HANDLER__OK) {
+            stats->dbRc = idxRc;
+            rc = CSV_HANDLER__DB_ERROR;
+        }
+    }
+
+    for (int i = 0; i < pl.chunkCount; i++) {
+        free(pl.chunks[i].text);
+    }
+    free(pl.chunks);
+    pthread_mutex_destroy(&pl.lock);
+    pthread_cond_destroy(&pl.changed);
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    stats->seconds = (end.tv_sec - start.tv_sec)
+        + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    return rc;
+}
+
+/**
+ * Build error string from return code, for printing.
+ *
+ * The resulting string is on heap memory and must be freed!
+ *
+ * @param   db      Handle the import was run on, for database errors.
+ * @param   stats   Stats from the import, for database errors.
+ * @param   str     SETS HEAP.  Pointer to string.
+ * @param   code    Previously-returned error code.
+ */
+char csv_handler_build_err(DbHandle *db, CsvImportStats *stats, char **str, int code)
+{
+    char *strdum;
+
+    switch (code) {
+        case CSV_HANDLER__OK:
+            strdum = "No error for csv handler.";
+            break;
+        case CSV_HANDLER__IO_ERROR:
+            strdum = "Could not read input.";
+            break;
+        case CSV_HANDLER__OUT_OF_MEMORY:
+            strdum = "Out of memory for csv handler.";
+            break;
+        case CSV_HANDLER__DB_ERROR:
+            return db_interface_build_err(db, str, stats->dbRc);
+        case CSV_HANDLER__THREAD_ERROR:
+            strdum = "Could not start threads for csv handler.";
+            break;
+        default:
+            strdum = "Unknown error for csv handler.";
+    }
+
+    *str = malloc(strlen(strdum) + 1);
+
+    if (*str == NULL) {
+        return CSV_HANDLER__OUT_OF_MEMORY;
+    }
+
+    strcpy(*str, strdum);
+
+    return CSV_HANDLER__OK;
+}
+
+// Static functions below this line.
+
+/**
+ * Reader thread.  Fills chunks with lines, in order, until the input runs out.
+ *
+ * @param   arg     The CsvPipeline.
+ */
+static void *readChunks(void *arg)
+{
+    CsvPipeline *pl = (CsvPipeline *) arg;
+
+    char *line = NULL;
+    size_t lineCap = 0;
+    ssize_t lineLen = 0;
+    long lineNum = 0;
+
+    while (lineLen != -1) {
+        CsvChunk *chunk = &pl->chunks[pl->readSeq % pl->chunkCount];
+        // readSeq is only changed by this thread, so it's fine to read it
+        // without the lock.
+
+        pthread_mutex_lock(&pl->lock);
+        while (chunk->state != CHUNK_EMPTY && !pl->abort) {
+            pthread_cond_wait(&pl->changed, &pl->lock);
+        }
+        char abort = pl->abort;
+        pthread_mutex_unlock(&pl->lock);
+
+        if (abort) {
+            break;
+        }
+
+        chunk->len = 0;
+        chunk->lineCount = 0;
+        chunk->firstLine = lineNum + 1;
+
+        while (chunk->lineCount < CHUNK_LINES
+            && (lineLen = getline(&line, &lineCap, pl->input)) != -1
+        ) {
+            lineNum++;
+            if (appendLine(chunk, line, lineLen)) {
+                abortPipeline(pl);
+                pthread_mutex_lock(&pl->lock);
+                pl->outOfMemory = 1;
+                pthread_mutex_unlock(&pl->lock);
+                free(line);
+                return NULL;
+            }
+            chunk->lineCount++;
+        }
+
+        pthread_mutex_lock(&pl->lock);
+        if (chunk->lineCount > 0) {
+            chunk->seq = pl->readSeq++;
+            chunk->state = CHUNK_FILLED;
+        }
+        if (lineLen == -1) {
+            pl->eof = 1;
+            pl->readErr = ferror(pl->input) != 0;
+        }
+        pthread_cond_broadcast(&pl->changed);
+        pthread_mutex_unlock(&pl->lock);
+    }
+
+    free(line);
+
+    return NULL;
+}
+
+/**
+ * Append a line to the text of a chunk, making sure it ends in a newline.
+ * Returns true if out of memory.
+ *
+ * @param   chunk
+ * @param   line
+ * @param   len
+ */
+static char appendLine(CsvChunk *chunk, char *line, size_t len)
+{
+    // Newline (if it's missing) and null terminator.
+    size_t needed = chunk->len + len + 2;
+
+    if (needed > chunk->cap) {
+        size_t newCap = chunk->cap ? chunk->cap : 64 * CHUNK_LINES;
+        while (newCap < needed) {
+            newCap *= 2;
+        }
+
+        char *textDum = realloc(chunk->text, newCap);
+        if (textDum == NULL) {
+            return 1;
+        }
+        chunk->text = textDum;
+        chunk->cap = newCap;
+    }
+
+    memcpy(chunk->text + chunk->len, line, len);
+    chunk->len += len;
+
+    if (len == 0 || line[len - 1] != '\n') {
+        chunk->text[chunk->len++] = '\n';
+    }
+    chunk->text[chunk->len] = '\0';
+
+    return 0;
+}
+
+/**
+ * Worker thread.  Parses whichever chunks are waiting, until there aren't
+ * going to be any more.
+ *
+ * @param   arg     The CsvPipeline.
+ */
+static void *parseChunks(void *arg)
+{
+    CsvPipeline *pl = (CsvPipeline *) arg;
+
+    while (1) {
+        CsvChunk *chunk = NULL;
+
+        pthread_mutex_lock(&pl->lock);
+        while (!pl->abort) {
+            for (int i = 0; i < pl->chunkCount; i++) {
+                if (pl->chunks[i].state == CHUNK_FILLED) {
+                    chunk = &pl->chunks[i];
+                    break;
+                }
+            }
+            if (chunk != NULL || pl->eof) {
+                break;
+            }
+            pthread_cond_wait(&pl->changed, &pl->lock);
+        }
+
+        if (chunk == NULL) {
+            // Either aborted or nothing left.
+            pthread_mutex_unlock(&pl->lock);
+            return NULL;
+        }
+
+        chunk->state = CHUNK_PARSING;
+        pthread_mutex_unlock(&pl->lock);
+
+        parseChunk(chunk, pl->delim);
+
+        pthread_mutex_lock(&pl->lock);
+        chunk->state = CHUNK_PARSED;
+        pthread_cond_broadcast(&pl->changed);
+        pthread_mutex_unlock(&pl->lock);
+    }
+}
+
+/**
+ * Parse every line in a chunk, in place.
+ *
+ * @param   chunk
+ * @param   delim
+ */
+static void parseChunk(CsvChunk *chunk, char delim)
+{
+    char *line = chunk->text;
+    char *textEnd = chunk->text + chunk->len;
+
+    for (int i = 0; i < chunk->lineCount; i++) {
+        // Not strchr, since the line could have a null in it.  appendLine
+        // made sure there's a newline to find.
+        char *end = memchr(line, '\n', textEnd - line);
+        size_t len = end - line;
+        *end = '\0';
+
+        if (len > 0 && line[len - 1] == '\r') {
+            line[--len] = '\0';
+        }
+
+        // A null in the middle would cut the line short, so it's skipped
+        // rather than saved as part of a line.
+        chunk->rows[i].ok = memchr(line, '\0', len) == NULL
+            && parseLine(line, delim, &chunk->rows[i]);
+
+        line = end + 1;
+    }
+}
+
+/**
+ * Parse a single line into a row.  Returns true if it's valid.
+ *
+ * @param   line    Null-terminated, without the newline.  Modified in place.
+ * @param   delim
+ * @param   row
+ */
+static char parseLine(char *line, char delim, CsvRow *row)
+{
+    char *fields[3];
+    int count = splitFields(line, delim, fields, 3);
+
+    if (count < 2 || count > 3) {
+        return 0;
+    }
+
+    if (!parseDate(fields[0], &row->date)) {
+        return 0;
+    }
+
+    row->rep = REP_NONE;
+    if (count == 3 && !parseRep(fields[2], &row->rep)) {
+        return 0;
+    }
+
+    row->desc = fields[1];
+
+    return 1;
+}
+
+/**
+ * Split a line into fields, in place.  Quotes are handled for CSV, but not
+ * TSV.  Returns the number of fields, which can be more than `max` (but only
+ * `max` are set).  Returns -1 if the quotes are malformed.
+ *
+ * @param   line
+ * @param   delim
+ * @param   fields  Array of at least `max` pointers.
+ * @param   max
+ */
+static int splitFields(char *line, char delim, char **fields, int max)
+{
+    int count = 0;
+    char *read = line;
+
+    while (1) {
+        char *write = read;
+
+        if (count < max) {
+            fields[count] = write;
+        }
+        count++;
+
+        if (delim == ',' && *read == '"') {
+            // Quoted field.  Copy it over itself without the quotes.
+            read++;
+            while (1) {
+                if (*read == '\0') {
+                    return -1;
+                }
+                if (*read == '"') {
+                    if (read[1] != '"') {
+                        read++;
+                        break;
+                    }
+                    read++; // Escaped quote, so keep the second one.
+                }
+                *write++ = *read++;
+            }
+            if (*read != delim && *read != '\0') {
+                return -1;
+            }
+        } else {
+            while (*read != delim && *read != '\0') {
+                *write++ = *read++;
+            }
+        }
+
+        char atEnd = (*read == '\0');
+        *write = '\0';
+
+        if (atEnd) {
+            return count;
+        }
+
+        read++; // Past the delimiter.
+    }
+}
+
+/**
+ * Parse the repetition type.  Returns true if it's valid.
+ *
+ * @param   str
+ * @param   rep
+ */
+static char parseRep(char *str, char *rep)
+{
+    char *none[] = {"", "0", "n", "no", "none"};
+    char *yearly[] = {"1", "y", "yes", "yearly"};
+
+    for (int i = 0; i < sizeof(none) / sizeof(none[0]); i++) {
+        if (strcasecmp(str, none[i]) == 0) {
+            *rep = REP_NONE;
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < sizeof(yearly) / sizeof(yearly[0]); i++) {
+        if (strcasecmp(str, yearly[i]) == 0) {
+            *rep = REP_YEARLY;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Save every valid row of a chunk, committing once enough rows have been saved
+ * since the last commit.  The indexes are dropped at the first commit.
+ *
+ * @param   db
+ * @param   chunk
+ * @param   stats
+ * @param   uncommitted     Number of rows saved since the last commit.
+ * @param   droppedIndexes  Set to true once the indexes are dropped.
+ */
+static char saveChunk(
+    DbHandle *db,
+    CsvChunk *chunk,
+    CsvImportStats *stats,
+    long *uncommitted,
+    char *droppedIndexes
+) {
+    int itemCount = 0;
+
+    for (int i = 0; i < chunk->lineCount; i++) {
+        CsvRow *row = &chunk->rows[i];
+
+        if (!row->ok) {
+            if (chunk->firstLine + i == 1) {
+                continue; // Header.
+            }
+            if (stats->skipped++ == 0) {
+                stats->firstSkipped = chunk->firstLine + i;
+            }
+            continue;
+        }
+
+        // Not using buildItem, since the description doesn't need to be
+        // copied just to be saved.
+        PlannerItem item = {0, row->date, row->desc, row->rep};
+        chunk->items[itemCount++] = item;
+    }
+
+    // Saved together so the dates are converted in batches.
+    if ((stats->dbRc = db_interface_save_many(db, chunk->items, itemCount))) {
+        return CSV_HANDLER__DB_ERROR;
+    }
+
+    stats->rows += itemCount;
+    *uncommitted += itemCount;
+
+    if (*uncommitted >= COMMIT_ROWS) {
+        if ((stats->dbRc = db_interface_commit(db))) {
+            return CSV_HANDLER__DB_ERROR;
+        }
+        if (!*droppedIndexes) {
+            // Need to set this first, since the index is in an unknown
+            // state if dropping it fails.
+            *droppedIndexes = 1;
+            if ((stats->dbRc = db_interface_drop_indexes(db))) {
+                return CSV_HANDLER__DB_ERROR;
+            }
+        }
+        if ((stats->dbRc = db_interface_begin(db))) {
+            return CSV_HANDLER__DB_ERROR;
+        }
+        *uncommitted = 0;
+    }
+
+    return CSV_HANDLER__OK;
+}
+
+/**
+ * Tell every thread in the pipeline to stop.
+ *
+ * @param   pl
+ */
+static void abortPipeline(CsvPipeline *pl)
+{
+    pthread_mutex_lock(&pl->lock);
+    pl->abort = 1;
+    pthread_cond_broadcast(&pl->changed);
+    pthread_mutex_unlock(&pl->lock);
+}
+
+/**
+ * Number of worker threads to parse with.  Leaves a core for the thread
+ * saving to the database.
+ */
+static int workerCount()
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (cores <= 2) {
+        return 1;
+    }
+
+    if (cores - 1 > MAX_WORKERS) {
+        return MAX_WORKERS;
+    }
+
+    return cores - 1;
+}
@@ -0,0 +1,41 @@
+#ifndef csvhandler_h
+#define csvhandler_h
+
+#include <stdio.h>
+
+#include "db-interface.h"
+
+// Constants
+
+#define CSV_HANDLER__OK             0
+#define CSV_HANDLER__IO_ERROR       1
+#define CSV_HANDLER__OUT_OF_MEMORY  2
+#define CSV_HANDLER__DB_ERROR       3
+#define CSV_HANDLER__THREAD_ERROR   4
+
+// Types
+
+typedef struct csv_import_stats {
+    /** @var Number of rows saved to the database. */
+    long rows;
+
+    /** @var Number of lines that couldn't be parsed, so weren't saved. */
+    long skipped;
+
+    /** @var Line number of the first line that was skipped, or zero. */
+    long firstSkipped;
+
+    /** @var Seconds the whole import took. */
+    double seconds;
+
+    /** @var RC from the db interface, for DB_ERROR. */
+    char dbRc;
+} CsvImportStats;
+
+// Functions
+
+char csv_handler_import(DbHandle *db, FILE *input, char delim, CsvImportStats *stats);
+
+char csv_handler_build_err(DbHandle *db, CsvImportStats *stats, char **str, int code);
+
+#endif
@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "date-functions.h"
+#include "planner-functions.h"
+
+// Build with `make bench CASE=date-functions`, then run
+// ./bench/date-functions-bench.  Not run by anything automatically, since the
+// numbers only mean something on a quiet machine.
+
+#define DATE_COUNT 36500
+#define ROUNDS 100
+
+void benchGetWeekday(Date *dates);
+void benchGetWeek(Date *dates);
+void benchAddDays(Date *dates);
+void benchBatch(Date *dates);
+
+int mktimeWeekday(Date dateObj);
+Date loopingGetWeek(Date dateObj);
+double nsPerCall(struct timespec *start, long calls);
+double datesPerSec(struct timespec *start, long dates);
+
+/** Written to so the compiler can't skip the calls. */
+volatile int sink = 0;
+
+int main()
+{
+    // About a hundred years of days, starting in 2001.
+    Date *dates = malloc(DATE_COUNT * sizeof(Date));
+    Date dateObj = buildDate(0, 0, 0);
+    for (int i = 0; i < DATE_COUNT; i++) {
+        dates[i] = dateObj;
+        datepp(&dateObj);
+    }
+
+    benchGetWeekday(dates);
+    benchGetWeek(dates);
+    benchAddDays(dates);
+    benchBatch(dates);
+
+    free(dates);
+}
+
+void benchGetWeekday(Date *dates)
+{
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < DATE_COUNT; i++) {
+            sink += getWeekday(dates[i]);
+        }
+    }
+    printf("getWeekday:             %8.2f ns/call\n",
+        nsPerCall(&start, (long) ROUNDS * DATE_COUNT));
+
+    // mktime is a lot slower, so fewer rounds.
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < DATE_COUNT; i++) {
+        sink += mktimeWeekday(dates[i]);
+    }
+    printf("getWeekday with mktime: %8.2f ns/call\n", nsPerCall(&start, DATE_COUNT));
+}
+
+void benchGetWeek(Date *dates)
+{
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < DATE_COUNT; i++) {
+            sink += getWeek(dates[i]).day;
+        }
+    }
+    printf("getWeek:                %8.2f ns/call\n",
+        nsPerCall(&start, (long) ROUNDS * DATE_COUNT));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < DATE_COUNT; i++) {
+        sink += loopingGetWeek(dates[i]).day;
+    }
+    printf("getWeek with mktime:    %8.2f ns/call\n", nsPerCall(&start, DATE_COUNT));
+}
+
+
+void benchAddDays(Date *dates)
+{
+    int jumps[3] = {7, 365, 50 * 365};
+    struct timespec start;
+
+    for (int j = 0; j < 3; j++) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < DATE_COUNT; i++) {
+            sink += addDays(dates[i], jumps[j]).day;
+        }
+        printf("addDays(%5d):         %8.2f ns/call\n", jumps[j], nsPerCall(&start, DATE_COUNT));
+
+        // The old way, one day at a time.
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < DATE_COUNT; i++) {
+            Date dateObj = dates[i];
+            for (int k = 0; k < jumps[j]; k++) {
+                datepp(&dateObj);
+            }
+            sink += dateObj.day;
+        }
+        printf("datepp x %5d:         %8.2f ns/call\n", jumps[j], nsPerCall(&start, DATE_COUNT));
+    }
+}
+
+void benchBatch(Date *dates)
+{
+    int *ints = malloc(DATE_COUNT * sizeof(int));
+    int *out = malloc(DATE_COUNT * sizeof(int));
+    Date *datesOut = malloc(DATE_COUNT * sizeof(Date));
+    char *reps = malloc(DATE_COUNT);
+    long total = (long) ROUNDS * DATE_COUNT;
+    struct timespec start;
+
+    for (int i = 0; i < DATE_COUNT; i++) {
+        reps[i] = i % 2 ? REP_YEARLY : REP_NONE;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < DATE_COUNT; i++) {
+            ints[i] = toInt(dates[i]);
+        }
+    }
+    printf("toInt:                  %8.1f M dates/s\n", datesPerSec(&start, total));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < ROUNDS; r++) {
+        sink += toIntBatch(dates, ints, DATE_COUNT);
+    }
+    printf("toIntBatch:             %8.1f M dates/s\n", datesPerSec(&start, total));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < DATE_COUNT; i++) {
+            datesOut[i] = toDate(ints[i]);
+        }
+    }
+    printf("toDate:                 %8.1f M dates/s\n", datesPerSec(&start, total));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < ROUNDS; r++) {
+        toDateBatch(ints, datesOut, DATE_COUNT);
+    }
+    sink += datesOut[DATE_COUNT - 1].day;
+    printf("toDateBatch:            %8.1f M dates/s\n", datesPerSec(&start, total));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < DATE_COUNT; i++) {
+            out[i] = toSerial(dates[i]);
+        }
+    }
+    printf("toSerial:               %8.1f M dates/s\n", datesPerSec(&start, total));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < ROUNDS; r++) {
+        toSerialBatch(dates, out, DATE_COUNT);
+    }
+    sink += out[DATE_COUNT - 1];
+    printf("toSerialBatch:          %8.1f M dates/s\n", datesPerSec(&start, total));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < DATE_COUNT; i++) {
+            out[i] = reduceIntDate(ints[i], reps[i]);
+        }
+    }
+    printf("reduceIntDate:          %8.1f M dates/s\n", datesPerSec(&start, total));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < ROUNDS; r++) {
+        reduceIntDateBatch(ints, reps, out, DATE_COUNT);
+    }
+    sink += out[DATE_COUNT - 1];
+    printf("reduceIntDateBatch:     %8.1f M dates/s\n", datesPerSec(&start, total));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < DATE_COUNT; i++) {
+            out[i] = getWeekday(dates[i]);
+        }
+    }
+    printf("getWeekday:             %8.1f M dates/s\n", datesPerSec(&start, total));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < ROUNDS; r++) {
+        getWeekdayBatch(dates, out, DATE_COUNT);
+    }
+    sink += out[DATE_COUNT - 1];
+    printf("getWeekdayBatch:        %8.1f M dates/s\n", datesPerSec(&start, total));
+
+    free(ints);
+    free(out);
+    free(datesOut);
+    free(reps);
+}
+
+// Helper functions below this line.
+
+/**
+ * How getWeekday used to work.
+ */
+int mktimeWeekday(Date dateObj)
+{
+    struct tm tmObj = {};
+    tmObj.tm_mday = dateObj.day + 1;
+    tmObj.tm_mon = dateObj.month;
+    tmObj.tm_year = dateObj.year + 101;
+    tmObj.tm_isdst = -1;
+    mktime(&tmObj);
+
+    return tmObj.tm_wday;
+}
+
+/**
+ * How getWeek used to work.
+ */
+Date loopingGetWeek(Date dateObj)
+{
+    while (mktimeWeekday(dateObj) != 0) {
+        datemm(&dateObj);
+    }
+
+    return dateObj;
+}
+
+double nsPerCall(struct timespec *start, long calls)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return ((end.tv_sec - start->tv_sec) * 1e9 + (end.tv_nsec - start->tv_nsec)) / calls;
+}
+
+double datesPerSec(struct timespec *start, long dates)
+{
+    return 1e3 / nsPerCall(start, dates);
+}
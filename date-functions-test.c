@@ -4,6 +4,7 @@
 #include <time.h>
 
 #include "date-functions.h"
+#include "planner-functions.h"
 
 void testYearsToDays();
 void testMonthsToDays();
@@ -16,9 +17,15 @@ void testToIntErrorHandling();
 void testToIntErrorHandlingHelper();
 void testGetWeekday();
 void testGetWeek();
+void testWeekdayMatchesMktime();
+void testWeekdayMatchesSerial();
 void testDateMatch();
 void testDatepp();
 void testDatemm();
+void testDateIsValid();
+void testNextOccurrence();
+void testSerial();
+void testBatch();
 
 int main()
 {
@@ -27,9 +34,15 @@ int main()
     testToIntErrorHandling();
     testGetWeekday();
     testGetWeek();
+    testWeekdayMatchesMktime();
+    testWeekdayMatchesSerial();
     testDateMatch();
     testDatepp();
     testDatemm();
+    testDateIsValid();
+    testNextOccurrence();
+    testSerial();
+    testBatch();
 }
 
 /**
@@ -86,7 +99,7 @@ void testToInt()
 }
 
 /**
- * Test toString.
+ * Test toString and formatDate.
  */
 void testToString()
 {
@@ -109,6 +122,18 @@ void testToString()
 
     free(result);
 
+    char buf[DATE_STRING_SIZE];
+
+    formatDate(buf, testObj, '-');
+    if (strcmp(buf, "2004-06-22") != 0) {
+        printf("FAILURE: formatDate gave %s.\n", buf);
+    }
+
+    formatDate(buf, buildDate(98, 11, 30), '\0');
+    if (strcmp(buf, "20991231") != 0) {
+        printf("FAILURE: formatDate without a separator gave %s.\n", buf);
+    }
+
     printf("...Finished testToString.\n");
 }
 
@@ -238,6 +263,53 @@ void testGetWeek()
     printf("...Finished testGetWeek.\n");
 }
 
+/**
+ * Test getWeekday and getWeek against mktime (which is what they used to use)
+ * on every day from 2001 through 2099.
+ */
+void testWeekdayMatchesMktime()
+{
+    printf("...Starting testWeekdayMatchesMktime.\n");
+
+    Date dateObj = buildDate(0, 0, 0);
+    int failures = 0;
+
+    while (dateObj.year < 99 && failures < 5) {
+        struct tm tmObj = {};
+        tmObj.tm_mday = dateObj.day + 1;
+        tmObj.tm_mon = dateObj.month;
+        tmObj.tm_year = dateObj.year + 101;
+        tmObj.tm_isdst = -1;
+        mktime(&tmObj);
+
+        char *dateStr;
+        toString(&dateStr, dateObj);
+
+        if (getWeekday(dateObj) != tmObj.tm_wday) {
+            printf("FAILURE: Weekday for %s is %d, but mktime says %d.\n",
+                dateStr, getWeekday(dateObj), tmObj.tm_wday);
+            failures++;
+        }
+
+        // The old way of finding the week.
+        Date expected = dateObj;
+        for (int i = 0; i < tmObj.tm_wday; i++) {
+            datemm(&expected);
+        }
+
+        Date week = getWeek(dateObj);
+        if (!dateMatch(&week, &expected)) {
+            printf("FAILURE: Wrong week found for %s.\n", dateStr);
+            failures++;
+        }
+
+        free(dateStr);
+        datepp(&dateObj);
+    }
+
+    printf("...Finished testWeekdayMatchesMktime.\n");
+}
+
 /**
  * Test datepp function.
  */
@@ -429,6 +501,274 @@ void testDatemm()
     printf("...Finished testDatemm.\n");
 }
 
+/**
+ * Test dateIsValid function.
+ */
+void testDateIsValid()
+{
+    printf("...Starting testDateIsValid.\n");
+
+    struct {
+        Date date;
+        char valid;
+        char *desc;
+    } cases[] = {
+        {buildDate(23, 1, 28), 1, "Feb 29, 2024"},
+        {buildDate(22, 1, 28), 0, "Feb 29, 2023"},
+        {buildDate(23, 1, 29), 0, "Feb 30, 2024"},
+        {buildDate(23, 3, 29), 1, "Apr 30, 2024"},
+        {buildDate(23, 3, 30), 0, "Apr 31, 2024"},
+        {buildDate(23, 11, 30), 1, "Dec 31, 2024"},
+        {buildDate(23, 12, 0), 0, "Month 13"},
+        {buildDate(-1, 0, 0), 0, "Year 2000"},
+        {buildDate(0, 0, -1), 0, "Negative day"},
+    };
+
+    for (int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if (dateIsValid(cases[i].date) != cases[i].valid) {
+            printf("FAILURE: %s should be %s.\n", cases[i].desc,
+                cases[i].valid ? "valid" : "invalid");
+        }
+    }
+
+    printf("...Finished testDateIsValid.\n");
+}
+
+
+/**
+ * Test getWeekday and getWeek against toSerial on every day from 2001 through
+ * 2300, so that a week is always seven days of the same calendar, even where
+ * it isn't Gregorian any more (2100 is a leap year).
+ */
+void testWeekdayMatchesSerial()
+{
+    printf("...Starting testWeekdayMatchesSerial.\n");
+
+    Date dateObj = buildDate(0, 0, 0);
+    int failures = 0;
+
+    while (dateObj.year < 300 && failures < 5) {
+        // Jan 1, 2001 was a Monday.
+        int expected = (toSerial(dateObj) + 1) % 7;
+        Date week = getWeek(dateObj);
+
+        if (getWeekday(dateObj) != expected || daysBetween(week, dateObj) != expected) {
+            char *dateStr;
+            toString(&dateStr, dateObj);
+            printf("FAILURE: Weekday for %s is %d (week %d days before), but toSerial says %d.\n",
+                dateStr, getWeekday(dateObj), daysBetween(week, dateObj), expected);
+            free(dateStr);
+            failures++;
+        }
+
+        datepp(&dateObj);
+    }
+
+    printf("...Finished testWeekdayMatchesSerial.\n");
+}
+
+/**
+ * Test nextOccurrence function.
+ */
+void testNextOccurrence()
+{
+    printf("...Starting testNextOccurrence.\n");
+
+    Date from = buildDate(23, 5, 14); // Jun 15, 2024
+
+    struct {
+        Date date;
+        char rep;
+        Date expected;
+        char *desc;
+    } cases[] = {
+        {buildDate(20, 0, 0), REP_NONE, buildDate(20, 0, 0), "Not repeating, in the past"},
+        {buildDate(0, 11, 24), REP_YEARLY, buildDate(23, 11, 24), "Later this year"},
+        {buildDate(0, 5, 14), REP_YEARLY, buildDate(23, 5, 14), "Today"},
+        {buildDate(0, 5, 13), REP_YEARLY, buildDate(24, 5, 13), "Yesterday"},
+        {buildDate(0, 0, 0), REP_YEARLY, buildDate(24, 0, 0), "Earlier this year"},
+        {buildDate(0, 1, 28), REP_YEARLY, buildDate(27, 1, 28), "Feb 29"},
+    };
+
+    for (int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int dateInt = reduceIntDate(toInt(cases[i].date), cases[i].rep);
+        Date found = nextOccurrence(dateInt, cases[i].rep, from);
+
+        if (!dateMatch(&found, &cases[i].expected)) {
+            char *str;
+            toString(&str, found);
+            printf("FAILURE: %s came out as %s.\n", cases[i].desc, str);
+            free(str);
+        }
+    }
+
+    printf("...Finished testNextOccurrence.\n");
+}
+
+/**
+ * Test toSerial, fromSerial, addDays, and daysBetween.
+ */
+void testSerial()
+{
+    printf("...Starting testSerial.\n");
+
+    Date dateObj = buildDate(0, 0, 0);
+
+    if (toSerial(dateObj) != 0) {
+        printf("FAILURE: Jan 1, 2001 should be serial 0, but found %d.\n", toSerial(dateObj));
+    }
+
+    // Every day for two hundred years should be one more than the day before,
+    // and convert back to itself.
+    int expected = 0;
+    int failures = 0;
+
+    while (dateObj.year < 200 && failures < 5) {
+        int serial = toSerial(dateObj);
+        Date back = fromSerial(serial);
+
+        if (serial != expected || !dateMatch(&back, &dateObj)) {
+            char *dateStr;
+            toString(&dateStr, dateObj);
+            printf("FAILURE: %s has serial %d (expected %d).\n", dateStr, serial, expected);
+            free(dateStr);
+            failures++;
+        }
+
+        datepp(&dateObj);
+        expected++;
+    }
+
+    // Jumping a long way.  2001 through 2050 has 12 leap years.
+    Date jumped = addDays(buildDate(0, 0, 0), 50 * 365 + 12);
+    Date expectedJump = buildDate(50, 0, 0);
+    if (!dateMatch(&jumped, &expectedJump)) {
+        printf("FAILURE: Adding 50 years of days didn't get to Jan 1, 2051.\n");
+    }
+
+    // Across Feb 29 and the end of the year, both ways.
+    Date leapDay = buildDate(23, 1, 28); // Feb 29, 2024.
+    Date later = addDays(leapDay, 307);
+    Date expectedLater = buildDate(24, 0, 0); // Jan 1, 2025.
+    if (!dateMatch(&later, &expectedLater)) {
+        printf("FAILURE: Expected Jan 1, 2025, but found %d/%d/%d.\n",
+            later.year, later.month, later.day);
+    }
+
+    Date earlier = addDays(later, -307);
+    if (!dateMatch(&earlier, &leapDay)) {
+        printf("FAILURE: Going back didn't get back to Feb 29, 2024.\n");
+    }
+
+    if (daysBetween(leapDay, later) != 307 || daysBetween(later, leapDay) != -307) {
+        printf("FAILURE: daysBetween didn't give 307 and -307.\n");
+    }
+
+    // Before 2001 still works (2000 is a leap year here, too).
+    Date before = fromSerial(-366);
+    Date expectedBefore = buildDate(-1, 0, 0);
+    if (!dateMatch(&before, &expectedBefore) || toSerial(before) != -366) {
+        printf("FAILURE: Serial -366 should be Jan 1, 2000.\n");
+    }
+
+    printf("...Finished testSerial.\n");
+}
+
+/**
+ * Test that the batch conversions give the same results as the single ones.
+ */
+void testBatch()
+{
+    printf("...Starting testBatch.\n");
+
+    // Every day from 1999 to 2099, so toSerialBatch sees some negative years.
+    int count = 101 * 366;
+    Date *dates = malloc(sizeof(Date) * count);
+    Date *datesBack = malloc(sizeof(Date) * count);
+    int *ints = malloc(sizeof(int) * count);
+    int *results = malloc(sizeof(int) * count);
+    char *reps = malloc(count);
+
+    Date dateObj = buildDate(-2, 0, 0);
+    for (int i = 0; i < count; i++) {
+        dates[i] = dateObj;
+        reps[i] = i % 3 == 0 ? REP_YEARLY : REP_NONE;
+        datepp(&dateObj);
+    }
+
+    int failures = 0;
+
+    toSerialBatch(dates, results, count);
+    for (int i = 0; i < count && failures < 5; i++) {
+        if (results[i] != toSerial(dates[i])) {
+            printf("FAILURE: toSerialBatch gave %d for %d/%d/%d, expected %d.\n",
+                results[i], dates[i].year, dates[i].month, dates[i].day,
+                toSerial(dates[i]));
+            failures++;
+        }
+    }
+
+    getWeekdayBatch(dates, results, count);
+    for (int i = 0; i < count && failures < 5; i++) {
+        if (results[i] != getWeekday(dates[i])) {
+            printf("FAILURE: getWeekdayBatch gave %d for %d/%d/%d, expected %d.\n",
+                results[i], dates[i].year, dates[i].month, dates[i].day,
+                getWeekday(dates[i]));
+            failures++;
+        }
+    }
+
+    // The rest only work from 2001 on.
+    Date *from2001 = dates + 2 * 365;
+    int count2001 = count - 2 * 365;
+
+    if (toIntBatch(from2001, ints, count2001) != DATE_FUNCTIONS__OK) {
+        printf("FAILURE: toIntBatch rejected valid dates.\n");
+    }
+
+    toDateBatch(ints, datesBack, count2001);
+    reduceIntDateBatch(ints, reps, results, count2001);
+    for (int i = 0; i < count2001 && failures < 5; i++) {
+        if (ints[i] != toInt(from2001[i])) {
+            printf("FAILURE: toIntBatch gave %d, expected %d.\n", ints[i], toInt(from2001[i]));
+            failures++;
+        }
+        if (!dateMatch(&datesBack[i], &from2001[i])) {
+            printf("FAILURE: toDateBatch didn't convert %d back.\n", ints[i]);
+            failures++;
+        }
+        if (results[i] != reduceIntDate(ints[i], reps[i])) {
+            printf("FAILURE: reduceIntDateBatch gave %d for %d, expected %d.\n",
+                results[i], ints[i], reduceIntDate(ints[i], reps[i]));
+            failures++;
+        }
+    }
+
+    // One bad date anywhere fails the whole batch, without printing anything.
+    from2001[1000].month = 12;
+    if (toIntBatch(from2001, ints, count2001) != DATE_FUNCTIONS__OUT_OF_RANGE) {
+        printf("FAILURE: toIntBatch accepted month 12.\n");
+    }
+    from2001[1000].month = 0;
+    from2001[1000].day = -1;
+    if (toIntBatch(from2001, ints, count2001) != DATE_FUNCTIONS__OUT_OF_RANGE) {
+        printf("FAILURE: toIntBatch accepted day -1.\n");
+    }
+
+    // Empty batches are fine.
+    if (toIntBatch(dates, ints, 0) != DATE_FUNCTIONS__OK) {
+        printf("FAILURE: toIntBatch rejected an empty batch.\n");
+    }
+
+    free(dates);
+    free(datesBack);
+    free(ints);
+    free(results);
+    free(reps);
+
+    printf("...Finished testBatch.\n");
+}
+
 
 // Helper functions below this line.
 
@@ -444,4 +784,5 @@ void testToIntErrorHandlingHelper(char * errPrint, Date dateObj)
     if ((res = toInt(dateObj)) != -1) {
         printf("FAILURE Result is not -1 for %s.  Found %d.\n", errPrint, res);
     }
+
 }
@@ -9,8 +9,8 @@
 // I needed to make this because the `struct tm` object was causing more
 // problems than it solves.  I do not want to have to work around DST or time
 // zones and I don't need anything more precise than days of the year.
-// `struct tm` is actually used, though, within the static functions, to be
-// able to find things like the the weekday, the date range of a week, etc.
+// `struct tm` is only used to find today's date.  Everything else (like the
+// weekday) is plain integer math.
 
 /**
  * The maximum number of days in a month, and a modulo base we use for
@@ -30,13 +30,28 @@
  */
 #define DAYSINYEAR 372
 
+/** The largest year that can be converted to an integer. */
+#define MAXYEAR 5772804
+
 /** The minimum size that this module needs an `int` type to be (in bytes). */
 #define MININTSIZE 4
 
+/** Days in four years, one of which is a leap year. */
+#define DAYSINCYCLE 1461
+
+/** Days before the start of each month, in a year that isn't a leap year. */
+static const int daysBeforeMonth[12] = {
+    0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+};
+
+/** Weekday offset of each month, for Sakamoto's method (see getWeekday). */
+static const int monthOffsets[12] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+
 
 // Forward declarations for helper functions.
 static char toIntErrorHandling(Date dateObj);
-static struct tm dateToTm(Date dateObj);
+static int daysInMonth(int year, int month);
+static int floorDiv(int num, int den);
 
 /**
  * Build a date from the year, month, and day.
@@ -104,6 +119,68 @@ int toString(char **ret, Date dateObj)
     return DATE_FUNCTIONS__OK;
 }
 
+/**
+ * Format a date as Y-m-d (like toString), or Ymd if the separator is '\0',
+ * into a buffer of at least DATE_STRING_SIZE bytes.  Doesn't allocate, so
+ * it's for places that format a lot of dates.  Only for years up to 9999,
+ * unlike toString.
+ *
+ * @param   buf
+ * @param   dateObj
+ * @param   sep
+ */
+void formatDate(char *buf, Date dateObj, char sep)
+{
+    int parts[3] = {dateObj.year + 2001, dateObj.month + 1, dateObj.day + 1};
+    int widths[3] = {4, 2, 2};
+
+    for (int i = 0; i < 3; i++) {
+        if (i > 0 && sep != '\0') {
+            *buf++ = sep;
+        }
+        for (int j = widths[i] - 1; j >= 0; j--) {
+            buf[j] = '0' + parts[i] % 10;
+            parts[i] /= 10;
+        }
+        buf += widths[i];
+    }
+
+    *buf = '\0';
+}
+
+/**
+ * Parse a date in the form YYYY-MM-DD, the opposite of formatDate.  Returns
+ * true if it's valid.
+ *
+ * @param   str
+ * @param   date    Passed back by argument.
+ */
+char parseDate(const char *str, Date *date)
+{
+    // Not using sscanf because it's surprisingly slow when it's a million
+    // lines.
+    if (strlen(str) != 10 || str[4] != '-' || str[7] != '-') {
+        return 0;
+    }
+
+    int parts[3] = {0, 0, 0};
+    int starts[3] = {0, 5, 8};
+    int lens[3] = {4, 2, 2};
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = starts[i]; j < starts[i] + lens[i]; j++) {
+            if (str[j] < '0' || str[j] > '9') {
+                return 0;
+            }
+            parts[i] = parts[i] * 10 + str[j] - '0';
+        }
+    }
+
+    *date = buildDate(parts[0] - 2001, parts[1] - 1, parts[2] - 1);
+
+    return dateIsValid(*date);
+}
+
 /**
  * Convert an integer back to a Date object.
  *
@@ -130,9 +207,107 @@ Date toDate(int dateInt)
  */
 int getWeekday(Date dateObj)
 {
-    struct tm dumval = dateToTm(dateObj);
+    // Sakamoto's method.  Counting from March makes the leap day the last day
+    // of the year, so the offset of each month from the start of the year is
+    // the same every year (that's the table).  The rest counts how many days
+    // each year has shifted the weekday, mod 7.  It's integer-only, so it
+    // doesn't need mktime (or the time zone).
+    //
+    // Every fourth year is a leap year, like everywhere else in this module
+    // (see datepp), so there are no century terms.  The 6 stands in for them
+    // and lines it up with the Gregorian calendar from March 1900 to February
+    // 2100, where the two agree.
+    int year = dateObj.year + 2001;
+
+    if (dateObj.month < 2) {
+        year--;
+    }
+
+    return (year + year / 4 + 6
+        + monthOffsets[dateObj.month] + dateObj.day + 1) % 7;
+}
+
+/**
+ * Convert a Date to the number of days since Jan 1, 2001 (so that's zero).
+ * Unlike toInt, there are no gaps, so these can be added and subtracted like
+ * any other number of days.  Uses the same calendar as datepp, so every
+ * fourth year is a leap year.
+ *
+ * @param   dateObj
+ */
+int toSerial(Date dateObj)
+{
+    // Years start in 2001, so the leap years are 3, 7, 11, ... and there's one
+    // for every four complete years before this one.
+    int serial = 365 * dateObj.year + floorDiv(dateObj.year, 4)
+        + daysBeforeMonth[dateObj.month] + dateObj.day;
 
-    return dumval.tm_wday;
+    if (dateObj.month > 1 && dateObj.year - floorDiv(dateObj.year, 4) * 4 == 3) {
+        serial++;
+    }
+
+    return serial;
+}
+
+/**
+ * Convert a number of days since Jan 1, 2001 back to a Date.  See toSerial.
+ *
+ * @param   serial
+ */
+Date fromSerial(int serial)
+{
+    Date dateObj = {};
+
+    // Every four years is the same length, so find which four years it's in,
+    // and then which year of those (the last one's the leap year).
+    int cycle = floorDiv(serial, DAYSINCYCLE);
+    int dayOfCycle = serial - cycle * DAYSINCYCLE;
+    int yearOfCycle = dayOfCycle / 365;
+
+    if (yearOfCycle > 3) {
+        yearOfCycle = 3; // Dec 31 on the leap year.
+    }
+
+    dateObj.year = cycle * 4 + yearOfCycle;
+
+    int dayOfYear = dayOfCycle - yearOfCycle * 365;
+    char leap = (yearOfCycle == 3);
+
+    // No month is longer than 31 days, so this is never past the right month,
+    // and at most one or two short of it.
+    int month = dayOfYear / 31;
+    while (month < 11 && daysBeforeMonth[month + 1] + (leap && month >= 1) <= dayOfYear) {
+        month++;
+    }
+
+    dateObj.month = month;
+    dateObj.day = dayOfYear - daysBeforeMonth[month] - (leap && month > 1);
+
+    return dateObj;
+}
+
+/**
+ * Move a date by a number of days (negative to go back).  Same as calling
+ * datepp or datemm that many times, but the same speed for any number.
+ *
+ * @param   dateObj
+ * @param   days
+ */
+Date addDays(Date dateObj, int days)
+{
+    return fromSerial(toSerial(dateObj) + days);
+}
+
+/**
+ * Number of days from one date to another.  Negative if `to` is before
+ * `from`.
+ *
+ * @param   from
+ * @param   to
+ */
+int daysBetween(Date from, Date to)
+{
+    return toSerial(to) - toSerial(from);
 }
 
 /**
@@ -142,12 +317,15 @@ int getWeekday(Date dateObj)
  */
 Date getWeek(Date dateObj)
 {
-    Date returnVal = dateObj;
-    while (getWeekday(returnVal) != 0) {
-        datemm(&returnVal);
+    int weekday = getWeekday(dateObj);
+
+    if (dateObj.day >= weekday) {
+        // Sunday is in the same month, which is most of the time.
+        dateObj.day -= weekday;
+        return dateObj;
     }
 
-    return returnVal;
+    return addDays(dateObj, -weekday);
 }
 
 /**
@@ -166,6 +344,143 @@ int reduceIntDate(int dateInt, char rep)
     }
 }
 
+/**
+ * Get the first day on or after `from` that a date (in integer form, reduced
+ * like reduceIntDate) falls on.  Dates that don't repeat fall on themselves,
+ * even if they're before `from`.  A yearly Feb 29 waits for a leap year.
+ *
+ * @param   dateInt
+ * @param   rep
+ * @param   from
+ */
+Date nextOccurrence(int dateInt, char rep, Date from)
+{
+    if (rep != REP_YEARLY) {
+        return toDate(dateInt);
+    }
+
+    Date date = toDate(dateInt % DAYSINYEAR);
+    date.year = from.year;
+
+    if (date.month < from.month || (date.month == from.month && date.day < from.day)) {
+        date.year++;
+    }
+
+    // Every fourth year is a leap year, so a Feb 29 is at most three years off.
+    for (int i = 0; i < 4 && !dateIsValid(date); i++) {
+        date.year++;
+    }
+
+    return date;
+}
+
+
+// Batch versions of the conversions, for converting whole arrays at once (like
+// for imports and exports).  They give the same results as calling the single
+// versions on each element, but the loops have no branches and the arrays
+// can't overlap (restrict), so the compiler can vectorize them.  Checking for
+// errors is done once for the whole batch instead of once per date.
+
+/**
+ * Convert an array of dates to integers (see toInt).  Returns
+ * DATE_FUNCTIONS__OUT_OF_RANGE if any date can't be converted, in which case
+ * what's in `ints` shouldn't be used.  Nothing is printed.
+ *
+ * @param   dates
+ * @param   ints    Result, same length as dates.
+ * @param   count
+ */
+char toIntBatch(const Date *restrict dates, int *restrict ints, int count)
+{
+    unsigned int bad = 0;
+
+    for (int i = 0; i < count; i++) {
+        // Casting to unsigned makes negatives huge, so this checks both ends.
+        bad |= ((unsigned int) dates[i].day > DAYMOD - 1)
+            | ((unsigned int) dates[i].month > MONTHMOD - 1)
+            | ((unsigned int) dates[i].year > MAXYEAR);
+        ints[i] = dates[i].day + DAYMOD * (dates[i].month + MONTHMOD * dates[i].year);
+    }
+
+    return bad ? DATE_FUNCTIONS__OUT_OF_RANGE : DATE_FUNCTIONS__OK;
+}
+
+/**
+ * Convert an array of integers back to dates (see toDate).
+ *
+ * @param   ints
+ * @param   dates   Result, same length as ints.
+ * @param   count
+ */
+void toDateBatch(const int *restrict ints, Date *restrict dates, int count)
+{
+    for (int i = 0; i < count; i++) {
+        int dateInt = ints[i];
+        dates[i].day = dateInt % DAYMOD;
+        dates[i].month = dateInt / DAYMOD % MONTHMOD;
+        dates[i].year = dateInt / DAYSINYEAR;
+    }
+}
+
+/**
+ * Convert an array of dates to serial day numbers (see toSerial).
+ *
+ * @param   dates
+ * @param   serials Result, same length as dates.
+ * @param   count
+ */
+void toSerialBatch(const Date *restrict dates, int *restrict serials, int count)
+{
+    for (int i = 0; i < count; i++) {
+        int year = dates[i].year;
+        int month = dates[i].month;
+
+        // Same as floorDiv(year, 4), and year % 4 == 3 for negatives, too.
+        int leapYearsBefore = (year - (year < 0) * 3) / 4;
+        int leap = (year & 3) == 3;
+
+        serials[i] = 365 * year + leapYearsBefore + daysBeforeMonth[month]
+            + dates[i].day + (leap & (month > 1));
+    }
+}
+
+/**
+ * Reduce an array of integer dates by their repetition types (see
+ * reduceIntDate).
+ *
+ * @param   ints
+ * @param   reps    Repetition type of each one.
+ * @param   reduced Result, same length as ints.
+ * @param   count
+ */
+void reduceIntDateBatch(
+    const int *restrict ints,
+    const char *restrict reps,
+    int *restrict reduced,
+    int count
+) {
+    for (int i = 0; i < count; i++) {
+        // All ones if yearly, so it picks the remainder instead.
+        int yearly = -(reps[i] == REP_YEARLY);
+        reduced[i] = (ints[i] & ~yearly) | ((ints[i] % DAYSINYEAR) & yearly);
+    }
+}
+
+/**
+ * Find the weekday of an array of dates (see getWeekday).
+ *
+ * @param   dates
+ * @param   weekdays    Result, same length as dates.
+ * @param   count
+ */
+void getWeekdayBatch(const Date *restrict dates, int *restrict weekdays, int count)
+{
+    for (int i = 0; i < count; i++) {
+        int year = dates[i].year + 2001 - (dates[i].month < 2);
+        weekdays[i] = (year + year / 4 + 6
+            + monthOffsets[dates[i].month] + dates[i].day + 1) % 7;
+    }
+}
 
 /**
  * Convert a struct tm object to a Date object.
@@ -220,6 +535,21 @@ char dateMatch(Date *dayOne, Date *dayTwo)
     return 1;
 }
 
+/**
+ * Return 1 if the date exists (so not Feb 30, Apr 31, etc.), otherwise 0.
+ * Dates before 2001 don't exist as far as this module is concerned.
+ *
+ * @param   dateObj
+ */
+char dateIsValid(Date dateObj)
+{
+    if (dateObj.year < 0 || dateObj.month < 0 || dateObj.month > 11) {
+        return 0;
+    }
+
+    return dateObj.day >= 0 && dateObj.day < daysInMonth(dateObj.year, dateObj.month);
+}
+
 /**
  * Increment a date object.
  *
@@ -350,7 +680,7 @@ static char toIntErrorHandling(Date dateObj)
         fprintf(stderr, "Month out of range.  Found %d.\n", dateObj.month);
         return 1;
     }
-    if (dateObj.year > 5772804) {
+    if (dateObj.year > MAXYEAR) {
         fprintf(stderr, "Year is out of range.  Found %d.  And there's no" \
         " way this program is still going to be used in this year anyway.\n",
         dateObj.year);
@@ -361,20 +691,36 @@ static char toIntErrorHandling(Date dateObj)
 }
 
 /**
- * Convert a Date object to a struct tm object.
+ * Number of days in a month.  Same rules as datepp (every fourth year is a
+ * leap year).
  *
- * @param   dateObj
+ * @param   year    Years since 2001.
+ * @param   month   0 - 11.
  */
-static struct tm dateToTm(Date dateObj)
+static int daysInMonth(int year, int month)
 {
-    struct tm returnVal = {};
+    static const int lengths[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+    if (month == 1 && year % 4 == 3) {
+        return 29;
+    }
 
-    returnVal.tm_mday      = dateObj.day + 1;
-    returnVal.tm_mon       = dateObj.month;
-    returnVal.tm_year      = dateObj.year + 101;
-    returnVal.tm_isdst     = -1;
+    return lengths[month];
+}
 
-    mktime(&returnVal);
+/**
+ * Divide, rounding down instead of toward zero, so dates before 2001 work.
+ *
+ * @param   num
+ * @param   den     Has to be positive.
+ */
+static int floorDiv(int num, int den)
+{
+    int result = num / den;
 
-    return returnVal;
+    if (num % den < 0) {
+        result--;
+    }
+
+    return result;
 }
@@ -7,6 +7,10 @@
 
 #define DATE_FUNCTIONS__OK              0
 #define DATE_FUNCTIONS__OUT_OF_MEMORY   1
+#define DATE_FUNCTIONS__OUT_OF_RANGE    2
+
+/** Size of a buffer for formatDate, including the null terminator. */
+#define DATE_STRING_SIZE 11
 
 typedef struct date_obj {
     /** @var Number of complete years since the year 2001. (Like 2003 would be 2.)*/
@@ -25,20 +29,51 @@ int toInt(Date dateObj);
 
 int toString(char **ret, Date dateObj);
 
+void formatDate(char *buf, Date dateObj, char sep);
+
+char parseDate(const char *str, Date *date);
+
 Date toDate(int dateInt);
 
+int toSerial(Date dateObj);
+
+Date fromSerial(int serial);
+
+Date addDays(Date dateObj, int days);
+
+int daysBetween(Date from, Date to);
+
 int getWeekday(Date dateObj);
 
 Date getWeek(Date dateObj);
 
 int reduceIntDate(int dateInt, char rep);
 
+Date nextOccurrence(int dateInt, char rep, Date from);
+
+char toIntBatch(const Date *restrict dates, int *restrict ints, int count);
+
+void toDateBatch(const int *restrict ints, Date *restrict dates, int count);
+
+void toSerialBatch(const Date *restrict dates, int *restrict serials, int count);
+
+void reduceIntDateBatch(
+    const int *restrict ints,
+    const char *restrict reps,
+    int *restrict reduced,
+    int count
+);
+
+void getWeekdayBatch(const Date *restrict dates, int *restrict weekdays, int count);
+
 Date tmToDate(struct tm tmObj);
 
 Date todayDate();
 
 char dateMatch(Date *dayOne, Date *dayTwo);
 
+char dateIsValid(Date dateObj);
+
 void datepp(Date *dateObj);
 
 void datemm(Date *dateObj);
@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "date-functions.h"
+#include "db-interface.h"
+#include "planner-functions.h"
+
+// Build with `make bench CASE=db-interface`, then run
+// ./bench/db-interface-bench.  Not run by anything automatically, since the
+// numbers only mean something on a quiet machine, and the fsyncs make them
+// depend a lot on the disk.
+
+#define SAVES 2000
+#define EDITS 2000
+#define READ_ITEMS 50000
+#define READ_WEEKS 520
+#define READ_ROUNDS 5
+
+void benchProfile(char *profile);
+void benchSaves(DbHandle *db, long *ids);
+void benchEdits(DbHandle *db, long *ids);
+void benchReads(DbHandle *db);
+
+char countItem(PlannerItemView *item, void *ctx);
+void printLatency(char *what, double *us, int count);
+int compareDoubles(const void *a, const void *b);
+double usSince(struct timespec *start);
+void deleteDb();
+
+char *benchDb = "./bench/db-interface-bench.db";
+
+/** Written to so the compiler can't skip the calls. */
+volatile long sink = 0;
+
+int main()
+{
+    char *profiles[] = {"compat", "durable", "default"};
+
+    for (int i = 0; i < 3; i++) {
+        benchProfile(profiles[i]);
+    }
+
+    deleteDb();
+}
+
+void benchProfile(char *profile)
+{
+    printf("Profile %s:\n", profile);
+
+    deleteDb();
+    db_interface_clear_tuning();
+    db_interface_set_profile(profile);
+
+    DbHandle *db;
+
+    if (db_interface_initialize(&db, benchDb)) {
+        printf("ERROR: Could not initialize DB.\n");
+        db_interface_finalize(db);
+        return;
+    }
+
+    // Every read should go to the database, not the week cache.
+    db_interface_set_week_cache_size(db, 0);
+
+    long *ids = malloc(SAVES * sizeof(long));
+
+    benchSaves(db, ids);
+    benchEdits(db, ids);
+    benchReads(db);
+
+    free(ids);
+    db_interface_finalize(db);
+}
+
+/**
+ * Adding one item at a time, each in its own transaction, like the planner.
+ *
+ * @param   ids Set to the ids of the saved items.
+ */
+void benchSaves(DbHandle *db, long *ids)
+{
+    double *us = malloc(SAVES * sizeof(double));
+    struct timespec start;
+    Date dateObj = buildDate(23, 0, 0);
+
+    for (int i = 0; i < SAVES; i++) {
+        PlannerItem item = {0, dateObj, "benchmark item", REP_NONE};
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        db_interface_save(db, &item);
+        us[i] = usSince(&start);
+
+        ids[i] = item.id;
+        datepp(&dateObj);
+    }
+
+    printLatency("add", us, SAVES);
+    free(us);
+}
+
+/**
+ * Editing the items that benchSaves added, one at a time.
+ *
+ * @param   ids
+ */
+void benchEdits(DbHandle *db, long *ids)
+{
+    double *us = malloc(EDITS * sizeof(double));
+    struct timespec start;
+
+    for (int i = 0; i < EDITS; i++) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        db_interface_update_desc(db, ids[i % SAVES], "edited benchmark item");
+        us[i] = usSince(&start);
+    }
+
+    printLatency("edit", us, EDITS);
+    free(us);
+}
+
+/**
+ * Reading weeks back, after a bulk load spread over ten years.
+ */
+void benchReads(DbHandle *db)
+{
+    PlannerItem *items = malloc(READ_ITEMS * sizeof(PlannerItem));
+    Date first = buildDate(24, 0, 0);
+
+    for (int i = 0; i < READ_ITEMS; i++) {
+        items[i].id = 0;
+        items[i].date = addDays(first, i % (READ_WEEKS * 7));
+        items[i].desc = "read item";
+        items[i].rep = REP_NONE;
+    }
+
+    db_interface_begin(db);
+    db_interface_save_many(db, items, READ_ITEMS);
+    db_interface_commit(db);
+    free(items);
+
+    struct timespec start;
+    long rows = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < READ_ROUNDS; r++) {
+        Date week = getWeek(first);
+        for (int w = 0; w < READ_WEEKS; w++) {
+            db_interface_each_in_week(db, week, countItem, &rows);
+            week = addDays(week, 7);
+        }
+    }
+    double us = usSince(&start);
+    sink += rows;
+
+    printf("  read: %8.0f weeks/s %10.0f items/s\n",
+        READ_ROUNDS * READ_WEEKS / (us / 1e6), rows / (us / 1e6));
+}
+
+// Helper functions below this line.
+
+char countItem(PlannerItemView *item, void *ctx)
+{
+    (*(long *) ctx)++;
+
+    return 0;
+}
+
+void printLatency(char *what, double *us, int count)
+{
+    double total = 0;
+    for (int i = 0; i < count; i++) {
+        total += us[i];
+    }
+
+    qsort(us, count, sizeof(double), compareDoubles);
+
+    printf("  %-4s: %8.1f us mean %8.1f us p50 %8.1f us p99\n",
+        what, total / count, us[count / 2], us[count * 99 / 100]);
+}
+
+int compareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+
+    return (x > y) - (x < y);
+}
+
+double usSince(struct timespec *start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (end.tv_sec - start->tv_sec) * 1e6 + (end.tv_nsec - start->tv_nsec) / 1e3;
+}
+
+/**
+ * Delete the database, along with anything WAL mode left next to it.
+ */
+void deleteDb()
+{
+    char path[256];
+    char *suffixes[] = {"", "-wal", "-shm", "-journal"};
+
+    for (int i = 0; i < 4; i++) {
+        snprintf(path, sizeof(path), "%s%s", benchDb, suffixes[i]);
+        remove(path);
+    }
+}
@@ -1,7 +1,9 @@
+#include <pthread.h>
 #include <sqlite3.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "date-functions.h"
 #include "db-interface.h"
@@ -14,11 +16,53 @@ void testGettingRecordsForDay();
 void testGettingNonexistentRecord();
 void testUpdatingDesc();
 void testDelete();
+void testStatementCache();
+void testGettingRecordsForWeek();
+void testGettingRepetitionsFromRange();
+void testEachInRange();
+char collectItem(PlannerItemView *item, void *ctx);
+void testWeekCache();
+void checkWeek(Date start, char *expected, char hit, char *when);
+int countStatement(unsigned type, void *ctx, void *p, void *x);
+void testPrefetch();
+char waitForPrefetch(long weeks);
+char countItem(PlannerItemView *item, void *ctx);
+void testSaveMany();
+char checkSavedItem(PlannerItemView *item, void *ctx);
+void testCountDays();
+void testSearch();
+void checkSearch(char *text, char *expected);
+void testSearchIndexUpdate();
+void testSearchAfterDroppingIndexes();
+char checkSearchIndex();
+void testPurge();
+void testPurgeUpdatedDatabase();
+long getPragma(char *sql);
+void testTuning();
+void checkTuning(char *journalMode, long synchronous, long cacheSize, char *when);
+void testBusyTimeout();
+void *releaseLock(void *arg);
+void testUpgradeFromV1();
+void testResumingUpdate();
+void countUpdateCallback(int version, char *desc, long rows, double seconds, char done);
+void testTwoHandles();
+void *useHandle(void *arg);
 
 void deleteFileIfExists(char *filename);
 void printError(char *desc, char rc);
 
 char *testDb = "./testing.db";
+char *otherTestDb = "./testing-other.db";
+DbHandle *handle = NULL;
+
+/** What each thread in testTwoHandles works on. */
+typedef struct handle_run {
+    DbHandle *db;
+    char *desc;
+    int saved;
+    int found;
+    char rc;
+} HandleRun;
 
 int main()
 {
@@ -29,6 +73,24 @@ int main()
     testGettingNonexistentRecord();
     testUpdatingDesc();
     testDelete();
+    testStatementCache();
+    testGettingRecordsForWeek();
+    testGettingRepetitionsFromRange();
+    testEachInRange();
+    testWeekCache();
+    testPrefetch();
+    testSaveMany();
+    testCountDays();
+    testSearch();
+    testSearchIndexUpdate();
+    testSearchAfterDroppingIndexes();
+    testPurge();
+    testPurgeUpdatedDatabase();
+    testTuning();
+    testBusyTimeout();
+    testUpgradeFromV1();
+    testResumingUpdate();
+    testTwoHandles();
 
     deleteFileIfExists(testDb);
 }
@@ -41,7 +103,7 @@ void testBuildError()
 
     char rc;
 
-    rc = db_interface_initialize(testDb);
+    rc = db_interface_initialize(&handle, testDb);
 
     if (rc) {
         printError("Could not initialize DB.", rc);
@@ -51,8 +113,8 @@ void testBuildError()
     char *str;
 
     // Test with db-related error.
-    _db_interface_create_db_err();
-    rc = db_interface_build_err(&str, DB_INTERFACE__DB_ERROR);
+    _db_interface_create_db_err(handle);
+    rc = db_interface_build_err(handle, &str, DB_INTERFACE__DB_ERROR);
 
     if (rc) {
         printError("Out of memory on first call to db_interface_build_err", rc);
@@ -66,7 +128,7 @@ void testBuildError()
     str = NULL;
 
     // Test with interface error.
-    rc = db_interface_build_err(&str, DB_INTERFACE__OK);
+    rc = db_interface_build_err(handle, &str, DB_INTERFACE__OK);
 
     if (rc) {
         printError("Out of memory on second call to db_interface_build_err.", rc);
@@ -80,7 +142,7 @@ void testBuildError()
     free(str);
     str = NULL;
 
-    rc = db_interface_finalize();
+    rc = db_interface_finalize(handle);
 
     if (rc) {
         printError("Could not finalize DB.", rc);
@@ -97,7 +159,7 @@ void testSaving()
 
     char rc;
 
-    if ((rc = db_interface_initialize(testDb))) {
+    if ((rc = db_interface_initialize(&handle, testDb))) {
         printError("during initialization", rc);
         return;
     }
@@ -114,7 +176,7 @@ void testSaving()
         REP_NONE
     );
 
-    if ((rc = db_interface_save(testObj))) {
+    if ((rc = db_interface_save(handle, testObj))) {
         printError("during first save", rc);
         return;
     }
@@ -127,7 +189,7 @@ void testSaving()
 
     PlannerItem *retrieved;
 
-    if ((rc = db_interface_get(&retrieved, testObj->id))) {
+    if ((rc = db_interface_get(handle, &retrieved, testObj->id))) {
         printError("during first retrieval",rc);
         return;
     }
@@ -154,7 +216,7 @@ void testSaving()
 
     strcpy(testObj->desc, newstr);
 
-    if ((rc = db_interface_save(testObj))) {
+    if ((rc = db_interface_save(handle, testObj))) {
         printError("during second save", rc);
         return;
     }
@@ -163,7 +225,7 @@ void testSaving()
     // Now test the results.
     PlannerItem *firstRec;
 
-    if ((rc = db_interface_get(&firstRec, returned_id))) {
+    if ((rc = db_interface_get(handle, &firstRec, returned_id))) {
         printError("during second retrieval", rc);
         return;
     }
@@ -174,7 +236,7 @@ void testSaving()
 
     freeItem(firstRec);
 
-    if ((rc = db_interface_finalize())) {
+    if ((rc = db_interface_finalize(handle))) {
         printError("during finalization", rc);
         return;
     }
@@ -189,7 +251,7 @@ void testGettingRecordsFromRange()
     char rc;
 
     deleteFileIfExists(testDb);
-    rc = db_interface_initialize(testDb);
+    rc = db_interface_initialize(&handle, testDb);
 
     if (rc) {
         printf("ERROR: Could not initialize db. %d\n", rc);
@@ -209,7 +271,7 @@ void testGettingRecordsFromRange()
         notInRes,
         REP_NONE // Doesn't matter.
     );
-    if ((rc = db_interface_save(testObj))) {
+    if ((rc = db_interface_save(handle, testObj))) {
         printError("first save", rc);
     }
     freeItem(testObj);
@@ -221,7 +283,7 @@ void testGettingRecordsFromRange()
         inRes,
         REP_NONE // Doesn't matter.
     );
-    if ((rc = db_interface_save(testObj))) {
+    if ((rc = db_interface_save(handle, testObj))) {
         printError("second save", rc);
     }
     freeItem(testObj);
@@ -233,7 +295,7 @@ void testGettingRecordsFromRange()
         inRes,
         REP_NONE // Doesn't matter.
     );
-    if ((rc = db_interface_save(testObj))) {
+    if ((rc = db_interface_save(handle, testObj))) {
         printError("third save", rc);
     }
     freeItem(testObj);
@@ -245,7 +307,7 @@ void testGettingRecordsFromRange()
         notInRes,
         REP_NONE
     );
-    if ((rc = db_interface_save(testObj))) {
+    if ((rc = db_interface_save(handle, testObj))) {
         printError("fourth save", rc);
     }
     freeItem(testObj);
@@ -253,6 +315,7 @@ void testGettingRecordsFromRange()
     PlannerItem *result;
 
     while ((rc = db_interface_range(
+        handle,
         &result,
         buildDate(22,6,5),
         buildDate(22,6,10)
@@ -270,7 +333,7 @@ void testGettingRecordsFromRange()
         printError("final call to db_interface_rage", rc);
     }
 
-    if ((rc = db_interface_finalize())) {
+    if ((rc = db_interface_finalize(handle))) {
         printError("Could not finalize db.", rc);
     }
 
@@ -285,7 +348,7 @@ void testGettingRecordsForDay()
     int count;
 
     deleteFileIfExists(testDb);
-    rc = db_interface_initialize(testDb);
+    rc = db_interface_initialize(&handle, testDb);
 
     if (rc) {
         printf("ERROR: Could not initialize db. %d\n", rc);
@@ -301,14 +364,14 @@ void testGettingRecordsForDay()
         "Test object.",
         REP_NONE
     );
-    if ((rc = db_interface_save(testObj))) {
+    if ((rc = db_interface_save(handle, testObj))) {
         printError("first save", rc);
     }
     freeItem(testObj);
 
     // Nothing returned;
 
-    if ((rc = db_interface_day(&result, buildDate(22,6,2))) != DB_INTERFACE__OK) {
+    if ((rc = db_interface_day(handle, &result, buildDate(22,6,2))) != DB_INTERFACE__OK) {
         printf("FAILURE:  Found something when should be nothing.");
     }
     if (result != NULL) {
@@ -318,7 +381,7 @@ void testGettingRecordsForDay()
     // One no repetition returned.
 
     count = 0;
-    while ((rc = db_interface_day(&result, buildDate(22,6,1)))) {
+    while ((rc = db_interface_day(handle, &result, buildDate(22,6,1)))) {
         count++;
         if (result->rep != REP_NONE) {
             printf("FAILURE: On no repetition returned: found repetition that should not exist.\n");
@@ -342,13 +405,13 @@ void testGettingRecordsForDay()
         "Yearly rep.",
         REP_YEARLY
     );
-    if ((rc = db_interface_save(testObj))) {
+    if ((rc = db_interface_save(handle, testObj))) {
         printError("Second save", rc);
     }
     freeItem(testObj);
 
     count = 0;
-    while ((rc = db_interface_day(&result, buildDate(22,11,4)))) {
+    while ((rc = db_interface_day(handle, &result, buildDate(22,11,4)))) {
         count++;
         if (result->rep != REP_YEARLY) {
             printf("FAILURE: On yearly returned, found no wrong kind of rep.\n");
@@ -372,7 +435,7 @@ void testGettingRecordsForDay()
         "Both",
         REP_NONE
     );
-    if ((rc = db_interface_save(testObj))) {
+    if ((rc = db_interface_save(handle, testObj))) {
         printError("Third save", rc);
     }
     long int id01 = testObj->id;
@@ -385,7 +448,7 @@ void testGettingRecordsForDay()
         "Both",
         REP_YEARLY
     );
-    if ((rc = db_interface_save(testObj))) {
+    if ((rc = db_interface_save(handle, testObj))) {
         printError("Fourth save", rc);
     }
     long int id02 = testObj->id;
@@ -393,7 +456,7 @@ void testGettingRecordsForDay()
 
     count = 0;
 
-    while ((rc = db_interface_day(&result, buildDate(22,10,4)))) {
+    while ((rc = db_interface_day(handle, &result, buildDate(22,10,4)))) {
         count++;
         if (result->id == id01 && result->rep != REP_NONE) {
             printf("FAILURE: Wrong kind of repetition returned for first item.");
@@ -413,7 +476,7 @@ void testGettingRecordsForDay()
 
     // End tests.
 
-    if ((rc = db_interface_finalize())) {
+    if ((rc = db_interface_finalize(handle))) {
         printError("Could not finalize db.", rc);
     }
 
@@ -428,7 +491,7 @@ void testGettingNonexistentRecord()
 
     char rc;
 
-    if ((rc = db_interface_initialize(testDb))) {
+    if ((rc = db_interface_initialize(&handle, testDb))) {
         printError("during initialization", rc);
         return;
     }
@@ -443,7 +506,7 @@ void testGettingNonexistentRecord()
         REP_NONE
     );
 
-    if ((rc = db_interface_save(testObj))) {
+    if ((rc = db_interface_save(handle, testObj))) {
         printError("during save", rc);
         return;
     }
@@ -459,7 +522,7 @@ void testGettingNonexistentRecord()
 
     printf("...Retrieving existing item.\n");
 
-    if ((rc = db_interface_get(&RetItm, returned_id))) {
+    if ((rc = db_interface_get(handle, &RetItm, returned_id))) {
         printError("on getting existing item", rc);
         return;
     }
@@ -473,7 +536,7 @@ void testGettingNonexistentRecord()
 
     printf("...Retrieving nonexisting item.\n");
 
-    if ((rc = db_interface_get(&RetItm, returned_id + 1))) {
+    if ((rc = db_interface_get(handle, &RetItm, returned_id + 1))) {
         printError("on getting nonexisting item", rc);
         return;
     }
@@ -483,7 +546,7 @@ void testGettingNonexistentRecord()
         return;
     }
 
-    if ((rc = db_interface_finalize())) {
+    if ((rc = db_interface_finalize(handle))) {
         printError("during finalization", rc);
         return;
     }
@@ -498,7 +561,7 @@ void testUpdatingDesc()
     char rc;
 
     deleteFileIfExists(testDb);
-    if ((rc = db_interface_initialize(testDb))) {
+    if ((rc = db_interface_initialize(&handle, testDb))) {
         printf("ERROR: Could not initialize db.  %d\n", rc);
         return;
     }
@@ -513,7 +576,7 @@ void testUpdatingDesc()
         "old description",
         REP_NONE
     );
-    if ((rc = db_interface_save(testObj))) {
+    if ((rc = db_interface_save(handle, testObj))) {
         printError("saving", rc);
         return;
     }
@@ -524,7 +587,7 @@ void testUpdatingDesc()
 
     // Modifying object.
     char *newdesc = "new description purple hippopatamus";
-    rc = db_interface_update_desc(id, newdesc);
+    rc = db_interface_update_desc(handle, id, newdesc);
 
     if (rc) {
         printf("ERROR: %d\n", rc);
@@ -533,7 +596,7 @@ void testUpdatingDesc()
     // Getting object to test.
     PlannerItem *retrieved;
 
-    if ((rc = db_interface_get(&retrieved, id))) {
+    if ((rc = db_interface_get(handle, &retrieved, id))) {
         printError("retrieving saved item", rc);
     }
 
@@ -543,7 +606,7 @@ void testUpdatingDesc()
 
     freeItem(retrieved);
 
-    if ((rc = db_interface_finalize())) {
+    if ((rc = db_interface_finalize(handle))) {
         printError("during finalization", rc);
         return;
     }
@@ -558,7 +621,7 @@ void testDelete()
     char rc;
 
     deleteFileIfExists(testDb);
-    if ((rc = db_interface_initialize(testDb))) {
+    if ((rc = db_interface_initialize(&handle, testDb))) {
         printf("ERROR: Could not initialize db.  %d\n", rc);
     }
 
@@ -575,7 +638,7 @@ void testDelete()
 
     printf("...Saving object to be deleted.\n");
 
-    if ((rc = db_interface_save(testObj))) {
+    if ((rc = db_interface_save(handle, testObj))) {
         printError("saving", rc);
     }
 
@@ -584,7 +647,7 @@ void testDelete()
 
     // Deleting object.
     printf("...Deleting object.\n");
-    rc = db_interface_delete(id);
+    rc = db_interface_delete(handle, id);
 
     if (rc) {
         printError("when deleting", rc);
@@ -592,7 +655,7 @@ void testDelete()
 
     PlannerItem *returnObj;
 
-    if ((rc = db_interface_get(&returnObj, id))) {
+    if ((rc = db_interface_get(handle, &returnObj, id))) {
         printError("when getting nonexisting object", rc);
         return;
     }
@@ -606,7 +669,7 @@ void testDelete()
 
     sqlite3_stmt *stmt = NULL;
     char *sqldum = "SELECT desc,del FROM items WHERE id = ?;";
-    rc = sqlite3_prepare_v2(db_interface_get_db(), sqldum, -1, &stmt, 0);
+    rc = sqlite3_prepare_v2(db_interface_get_db(handle), sqldum, -1, &stmt, 0);
     rc = sqlite3_bind_int(stmt, 1, id);
     rc = sqlite3_step(stmt);
 
@@ -625,7 +688,35 @@ void testDelete()
     free(resdesc);
     resdesc = NULL;
 
-    if ((rc = db_interface_finalize())) {
+    // A deleted item can't be deleted again (which would restart the purge
+    // clock) or edited.
+    sqlite3_exec(db_interface_get_db(handle),
+        "UPDATE items SET deleted_at = 12345;", NULL, NULL, NULL);
+
+    if ((rc = db_interface_delete(handle, id)) || db_interface_changes(handle) != 0) {
+        printf("FAILURE: Expected deleting again to change nothing, but found rc %d and %ld changes.\n",
+            rc, db_interface_changes(handle));
+    }
+    if ((rc = db_interface_update_desc(handle, id, "edited")) || db_interface_changes(handle) != 0) {
+        printf("FAILURE: Expected editing a deleted item to change nothing, but found rc %d and %ld changes.\n",
+            rc, db_interface_changes(handle));
+    }
+
+    sqlite3_prepare_v2(db_interface_get_db(handle),
+        "SELECT desc, deleted_at FROM items WHERE id = ?;", -1, &stmt, 0);
+    sqlite3_bind_int(stmt, 1, id);
+    sqlite3_step(stmt);
+
+    if (strcmp((const char *) sqlite3_column_text(stmt, 0), "to be deleted") != 0
+        || sqlite3_column_int(stmt, 1) != 12345
+    ) {
+        printf("FAILURE: Expected the deleted item to be left alone, but found \"%s\" deleted at %d.\n",
+            sqlite3_column_text(stmt, 0), sqlite3_column_int(stmt, 1));
+    }
+
+    sqlite3_finalize(stmt);
+
+    if ((rc = db_interface_finalize(handle))) {
         printError("during finalization", rc);
         return;
     }
@@ -633,22 +724,1916 @@ void testDelete()
     printf("...Completed testDelete.\n");
 }
 
+void testStatementCache()
+{
+    printf("...Starting testStatementCache.\n");
 
-// Helper functions below this line.
+    char rc;
 
-void deleteFileIfExists(char *filename)
+    deleteFileIfExists(testDb);
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    long startCount = db_interface_get_prepare_count(handle);
+
+    PlannerItem *testObj;
+    PlannerItem *result = NULL;
+
+    for (int i = 0; i < 50; i++) {
+        buildItem(
+            &testObj,
+            0,
+            buildDate(22, 6, i % 28),
+            "cached",
+            i % 2 ? REP_YEARLY : REP_NONE
+        );
+        if ((rc = db_interface_save(handle, testObj))) {
+            printError("saving", rc);
+            return;
+        }
+        if ((rc = db_interface_update_desc(handle, testObj->id, "cached again"))) {
+            printError("updating", rc);
+            return;
+        }
+        freeItem(testObj);
+
+        while ((rc = db_interface_day(handle, &result, buildDate(22, 6, i % 28)))
+            == DB_INTERFACE__CONT
+        ) {
+            if (strcmp(result->desc, "cached again") != 0) {
+                printf("FAILURE: Cached statement returned wrong desc.\n");
+            }
+            freeItem(result);
+        }
+
+        if (rc) {
+            printError("iterating day", rc);
+            return;
+        }
+    }
+
+    // Insert, update, and the select for the day (which is the same SQL for
+    // every repetition type).
+    long prepared = db_interface_get_prepare_count(handle) - startCount;
+    if (prepared != 3) {
+        printf("FAILURE: Expected 3 statements prepared, but found %ld.\n",
+            prepared);
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testStatementCache.\n");
+}
+
+void testGettingRecordsForWeek()
 {
-    FILE *file;
+    printf("...Starting testGettingRecordsForWeek.\n");
 
-    if ((file = fopen(filename, "r"))) {
-        fclose(file);
-        remove(filename);
+    char rc;
+
+    deleteFileIfExists(testDb);
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    // Week of Dec 28, 2025 through Jan 3, 2026, so it crosses the year.
+    struct {
+        Date date;
+        char rep;
+    } saves[] = {
+        {buildDate(24, 11, 26), REP_NONE},   // Before the week.
+        {buildDate(24, 11, 27), REP_NONE},   // Sunday.
+        {buildDate(24, 11, 30), REP_NONE},   // Wednesday, Dec 31.
+        {buildDate(2, 11, 30), REP_YEARLY},  // Dec 31, from years ago.
+        {buildDate(10, 0, 0), REP_YEARLY},   // Jan 1, also years ago.
+        {buildDate(25, 0, 0), REP_NONE},     // Thursday, Jan 1.
+        {buildDate(25, 0, 2), REP_NONE},     // Saturday.
+        {buildDate(25, 0, 3), REP_NONE},     // After the week.
+        {buildDate(23, 0, 4), REP_NONE},     // Different year, not yearly.
+    };
+    int saveCount = sizeof(saves) / sizeof(saves[0]);
+
+    PlannerItem *testObj;
+    for (int i = 0; i < saveCount; i++) {
+        buildItem(&testObj, 0, saves[i].date, "week item", saves[i].rep);
+        if ((rc = db_interface_save(handle, testObj))) {
+            printError("saving", rc);
+            return;
+        }
+        freeItem(testObj);
+    }
+
+    // Get the expected results from db_interface_day, one day at a time.
+    Date start = buildDate(24, 11, 27);
+    Date rollDay = start;
+    long expIds[20];
+    int expCount = 0;
+    PlannerItem *result = NULL;
+
+    for (int i = 0; i < 7; i++) {
+        while ((rc = db_interface_day(handle, &result, rollDay)) == DB_INTERFACE__CONT) {
+            expIds[expCount++] = result->id;
+            freeItem(result);
+        }
+        datepp(&rollDay);
+    }
+
+    if (expCount != 6) {
+        printf("FAILURE: Expected 6 items from db_interface_day, but found %d.\n", expCount);
+    }
+
+    // Now compare with the week.
+    start = buildDate(24, 11, 27);
+    int count = 0;
+    long prevDate = -1;
+
+    while ((rc = db_interface_week(handle, &result, start, NULL)) == DB_INTERFACE__CONT) {
+        if (count < expCount && result->id != expIds[count]) {
+            printf("FAILURE: Week returned id %ld at position %d, expected %ld.\n",
+                result->id, count, expIds[count]);
+        }
+        if (toInt(result->date) < prevDate) {
+            printf("FAILURE: Week results are not grouped by day.\n");
+        }
+        prevDate = toInt(result->date);
+        if (result->rep == REP_YEARLY && result->date.year != 24 + (result->date.month == 0)) {
+            printf("FAILURE: Yearly item is not on the day it's displayed on.\n");
+        }
+        count++;
+        freeItem(result);
+    }
+
+    if (rc) {
+        printError("iterating week", rc);
+    }
+
+    if (count != expCount) {
+        printf("FAILURE: Expected %d items for week, but found %d.\n", expCount, count);
+    }
+
+    // Same thing in an arena, which should only need one allocation.
+    PlannerArena arena = {};
+    count = 0;
+
+    while ((rc = db_interface_week(handle, &result, start, &arena)) == DB_INTERFACE__CONT) {
+        if (count < expCount && result->id != expIds[count]) {
+            printf("FAILURE: Week in arena returned id %ld at position %d, expected %ld.\n",
+                result->id, count, expIds[count]);
+        }
+        count++;
+    }
+
+    if (count != expCount) {
+        printf("FAILURE: Expected %d items for week in arena, but found %d.\n", expCount, count);
     }
+    if (arena.allocations != 1) {
+        printf("FAILURE: Expected 1 allocation for week in arena, but found %ld.\n",
+            arena.allocations);
+    }
+
+    freeArena(&arena);
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testGettingRecordsForWeek.\n");
 }
 
-void printError(char *desc, char rc) {
-    char *str;
-    db_interface_build_err(&str, rc);
-    printf("ERROR %s: %s\n", desc, str);
-    free(str);
+void testGettingRepetitionsFromRange()
+{
+    printf("...Starting testGettingRepetitionsFromRange.\n");
+
+    char rc;
+
+    deleteFileIfExists(testDb);
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    PlannerItem *testObj;
+
+    buildItem(&testObj, 0, buildDate(5, 2, 4), "yearly", REP_YEARLY);
+    db_interface_save(handle, testObj);
+    freeItem(testObj);
+
+    buildItem(&testObj, 0, buildDate(3, 1, 28), "leap day", REP_YEARLY);
+    db_interface_save(handle, testObj);
+    freeItem(testObj);
+
+    buildItem(&testObj, 0, buildDate(22, 2, 4), "once", REP_NONE);
+    db_interface_save(handle, testObj);
+    freeItem(testObj);
+
+    buildItem(&testObj, 0, buildDate(21, 2, 4), "deleted", REP_YEARLY);
+    db_interface_save(handle, testObj);
+    db_interface_delete(handle, testObj->id);
+    freeItem(testObj);
+
+    // Mar 10, 2022 through Mar 4, 2025.  Should get Mar 5 in 2023 and 2024 but
+    // not 2022 or 2025, and Feb 29 only in 2024.
+    char *expected[] = {
+        "2023-03-05 yearly", // Yearly first, same as db_interface_day.
+        "2023-03-05 once",
+        "2024-02-29 leap day",
+        "2024-03-05 yearly",
+    };
+    int expCount = 4;
+
+    PlannerItem *result;
+    int count = 0;
+
+    while ((rc = db_interface_range(
+        handle,
+        &result,
+        buildDate(21, 2, 9),
+        buildDate(24, 2, 3)
+    )) == DB_INTERFACE__CONT) {
+        char *date;
+        toString(&date, result->date);
+        char found[strlen(date) + strlen(result->desc) + 2];
+        sprintf(found, "%s %s", date, result->desc);
+
+        if (count >= expCount) {
+            printf("FAILURE: Extra result in range: %s.\n", found);
+        } else if (strcmp(found, expected[count]) != 0) {
+            printf("FAILURE: Expected \"%s\" but found \"%s\".\n",
+                expected[count], found);
+        }
+
+        free(date);
+        freeItem(result);
+        count++;
+    }
+
+    if (rc) {
+        printError("iterating range", rc);
+    }
+
+    if (count != expCount) {
+        printf("FAILURE: Expected %d results in range, but found %d.\n", expCount, count);
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testGettingRepetitionsFromRange.\n");
+}
+
+/**
+ * Where checkSavedItem is up to.
+ */
+typedef struct checked_items {
+    PlannerItem *items;
+    int index;
+    int failures;
+} CheckedItems;
+
+/**
+ * What collectItem has collected so far.
+ */
+typedef struct collected_items {
+    char found[8][64];
+    int count;
+    int limit;
+} CollectedItems;
+
+void testEachInRange()
+{
+    printf("...Starting testEachInRange.\n");
+
+    char rc;
+
+    deleteFileIfExists(testDb);
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    PlannerItem items[] = {
+        {0, buildDate(5, 2, 4), "yearly", REP_YEARLY},
+        {0, buildDate(3, 1, 28), "leap day", REP_YEARLY},
+        {0, buildDate(22, 2, 4), "once", REP_NONE},
+    };
+
+    for (int i = 0; i < 3; i++) {
+        db_interface_save(handle, &items[i]);
+    }
+
+    // Same as testGettingRepetitionsFromRange, so should get the same thing.
+    char *expected[] = {
+        "2023-03-05 yearly",
+        "2023-03-05 once",
+        "2024-02-29 leap day",
+        "2024-03-05 yearly",
+    };
+
+    CollectedItems collected = {.count = 0, .limit = 8};
+
+    if ((rc = db_interface_each_in_range(
+        handle,
+        buildDate(21, 2, 9),
+        buildDate(24, 2, 3),
+        collectItem,
+        &collected
+    ))) {
+        printError("visiting range", rc);
+    }
+
+    if (collected.count != 4) {
+        printf("FAILURE: Expected 4 items visited in range, but found %d.\n", collected.count);
+    }
+    for (int i = 0; i < collected.count && i < 4; i++) {
+        if (strcmp(collected.found[i], expected[i]) != 0) {
+            printf("FAILURE: Expected \"%s\" but visited \"%s\".\n",
+                expected[i], collected.found[i]);
+        }
+    }
+
+    // Stopping early shouldn't leave anything unfinished.
+    collected.count = 0;
+    collected.limit = 2;
+
+    if ((rc = db_interface_each_in_range(
+        handle,
+        buildDate(21, 2, 9),
+        buildDate(24, 2, 3),
+        collectItem,
+        &collected
+    ))) {
+        printError("visiting range and stopping early", rc);
+    }
+
+    if (collected.count != 2) {
+        printf("FAILURE: Expected to stop after 2 items, but visited %d.\n", collected.count);
+    }
+
+    // Week of Mar 3, 2024 has the yearly item on its day.
+    collected.count = 0;
+    collected.limit = 8;
+
+    if ((rc = db_interface_each_in_week(handle, buildDate(23, 2, 2), collectItem, &collected))) {
+        printError("visiting week", rc);
+    }
+
+    if (collected.count != 1 || strcmp(collected.found[0], "2024-03-05 yearly") != 0) {
+        printf("FAILURE: Expected only the yearly item in the week.\n");
+    }
+
+    // Everything, as it's saved.
+    collected.count = 0;
+
+    if ((rc = db_interface_each(handle, collectItem, &collected))) {
+        printError("visiting everything", rc);
+    }
+
+    // Yearly items are saved reduced to 2001.
+    if (collected.count != 3 || strcmp(collected.found[0], "2001-03-05 yearly") != 0) {
+        printf("FAILURE: Expected 3 items as saved, starting with \"2001-03-05 yearly\".\n");
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testEachInRange.\n");
+}
+
+/**
+ * Collect an item as "date desc" until the limit.  See DbItemCallback.
+ */
+char collectItem(PlannerItemView *item, void *ctx)
+{
+    CollectedItems *collected = (CollectedItems *) ctx;
+
+    char *date;
+    toString(&date, item->date);
+    snprintf(collected->found[collected->count], 64, "%s %.*s", date, item->descLen, item->desc);
+    free(date);
+
+    return ++collected->count >= collected->limit;
+}
+
+/**
+ * Weeks come back from the cache until something changes them, and only the
+ * weeks that a change affects are fetched again.
+ */
+void testWeekCache()
+{
+    printf("...Starting testWeekCache.\n");
+
+    char rc;
+
+    deleteFileIfExists(testDb);
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    PlannerItem items[] = {
+        {0, buildDate(23, 11, 24), "christmas", REP_NONE},
+        {0, buildDate(19, 2, 4), "birthday", REP_YEARLY},
+    };
+
+    for (int i = 0; i < 2; i++) {
+        db_interface_save(handle, &items[i]);
+    }
+
+    Date christmasWeek = buildDate(23, 11, 21);
+    Date weekBefore = buildDate(23, 11, 14);
+    Date march2024 = buildDate(23, 2, 2);
+    Date march2025 = buildDate(24, 2, 1);
+
+    checkWeek(christmasWeek, "2024-12-25 christmas", 0, "first fetching Christmas");
+    checkWeek(weekBefore, "", 0, "first fetching the week before");
+    checkWeek(march2024, "2024-03-05 birthday", 0, "first fetching March 2024");
+    checkWeek(march2025, "2025-03-05 birthday", 0, "first fetching March 2025");
+
+    // Paging back and forth shouldn't run anything.
+    int statements = 0;
+    sqlite3_trace_v2(db_interface_get_db(handle), SQLITE_TRACE_STMT, countStatement, &statements);
+
+    for (int i = 0; i < 10; i++) {
+        checkWeek(weekBefore, "", 1, "paging back");
+        checkWeek(christmasWeek, "2024-12-25 christmas", 1, "paging forward");
+    }
+
+    if (statements != 0) {
+        printf("FAILURE: Expected no statements while paging, but found %d.\n", statements);
+    }
+
+    // A new item only drops its own week.
+    PlannerItem shopping = {0, buildDate(23, 11, 16), "shopping", REP_NONE};
+    db_interface_save(handle, &shopping);
+
+    checkWeek(christmasWeek, "2024-12-25 christmas", 1, "adding to the week before");
+    checkWeek(weekBefore, "2024-12-17 shopping", 0, "adding to the week before");
+
+    // A yearly item drops the weeks with its day in every year.
+    PlannerItem anniversary = {0, buildDate(21, 2, 5), "anniversary", REP_YEARLY};
+    db_interface_save(handle, &anniversary);
+
+    checkWeek(march2024, "2024-03-05 birthday; 2024-03-06 anniversary", 0, "adding yearly");
+    checkWeek(march2025, "2025-03-05 birthday; 2025-03-06 anniversary", 0, "adding yearly");
+    checkWeek(christmasWeek, "2024-12-25 christmas", 1, "adding yearly");
+
+    // Editing and deleting drop the weeks the item's in.
+    db_interface_update_desc(handle, items[1].id, "party");
+
+    checkWeek(march2024, "2024-03-05 party; 2024-03-06 anniversary", 0, "editing yearly");
+    checkWeek(march2025, "2025-03-05 party; 2025-03-06 anniversary", 0, "editing yearly");
+    checkWeek(christmasWeek, "2024-12-25 christmas", 1, "editing yearly");
+
+    db_interface_delete(handle, items[0].id);
+
+    checkWeek(christmasWeek, "", 0, "deleting");
+    checkWeek(weekBefore, "2024-12-17 shopping", 1, "deleting");
+
+    // Moving an item drops where it was and where it's going.
+    shopping.date = buildDate(23, 2, 3);
+    db_interface_save(handle, &shopping);
+
+    checkWeek(weekBefore, "", 0, "moving an item");
+    checkWeek(march2024, "2024-03-04 shopping; 2024-03-05 party; 2024-03-06 anniversary", 0,
+        "moving an item");
+
+    sqlite3_trace_v2(db_interface_get_db(handle), 0, NULL, NULL);
+
+    // The least recently used week goes first.
+    db_interface_set_week_cache_size(handle, 2);
+
+    checkWeek(christmasWeek, "", 0, "filling a small cache");
+    checkWeek(weekBefore, "", 0, "filling a small cache");
+    checkWeek(christmasWeek, "", 1, "filling a small cache");
+    checkWeek(march2025, "2025-03-05 party; 2025-03-06 anniversary", 0, "evicting");
+    checkWeek(weekBefore, "", 0, "evicting");
+    checkWeek(christmasWeek, "", 0, "evicting");
+
+    // Rolling back drops what was cached during the transaction.
+    db_interface_begin(handle);
+    PlannerItem undone = {0, buildDate(23, 11, 26), "undone", REP_NONE};
+    db_interface_save(handle, &undone);
+    checkWeek(christmasWeek, "2024-12-27 undone", 0, "adding in a transaction");
+    db_interface_rollback(handle);
+
+    checkWeek(christmasWeek, "", 0, "rolling back");
+
+    // And it can be turned off.
+    db_interface_set_week_cache_size(handle, 0);
+
+    checkWeek(christmasWeek, "", 0, "without a cache");
+    checkWeek(christmasWeek, "", 0, "without a cache");
+
+    db_interface_set_week_cache_size(handle, 16);
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testWeekCache.\n");
+}
+
+/**
+ * Check what's in a week, and whether it came from the cache.
+ *
+ * @param   start
+ * @param   expected    Items as "date desc", separated by "; ".
+ * @param   hit         Whether it should come from the cache.
+ * @param   when        What the test was doing, for the failure message.
+ */
+void checkWeek(Date start, char *expected, char hit, char *when)
+{
+    long hits = db_interface_get_week_cache_hits(handle);
+    long misses = db_interface_get_week_cache_misses(handle);
+
+    CollectedItems collected = {.count = 0, .limit = 8};
+    char rc;
+
+    if ((rc = db_interface_each_in_week(handle, start, collectItem, &collected))) {
+        printError("visiting week", rc);
+        return;
+    }
+
+    char found[512] = "";
+    for (int i = 0; i < collected.count; i++) {
+        if (i > 0) {
+            strcat(found, "; ");
+        }
+        strcat(found, collected.found[i]);
+    }
+
+    if (strcmp(found, expected) != 0) {
+        printf("FAILURE: Expected \"%s\" %s, but found \"%s\".\n", expected, when, found);
+    }
+
+    if (db_interface_get_week_cache_hits(handle) - hits != hit
+        || db_interface_get_week_cache_misses(handle) - misses != !hit
+    ) {
+        printf("FAILURE: Expected a cache %s %s.\n", hit ? "hit" : "miss", when);
+    }
+}
+
+/**
+ * Count statements run.  See sqlite3_trace_v2.
+ */
+int countStatement(unsigned type, void *ctx, void *p, void *x)
+{
+    (*(int *) ctx)++;
+
+    return 0;
+}
+
+/**
+ * Prefetched weeks come from the cache without using the program's
+ * connection, and writing while prefetching neither waits for a lock nor
+ * leaves an old week in the cache.
+ */
+void testPrefetch()
+{
+    printf("...Starting testPrefetch.\n");
+
+    char rc;
+
+    deleteFileIfExists(testDb);
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    PlannerItem christmas = {0, buildDate(23, 11, 24), "christmas", REP_NONE};
+    db_interface_save(handle, &christmas);
+
+    Date weeks[] = {buildDate(23, 11, 14), buildDate(23, 11, 21), buildDate(23, 11, 28)};
+
+    db_interface_prefetch_weeks(handle, weeks, 3);
+    if (waitForPrefetch(3)) {
+        printf("FAILURE: Expected 3 weeks prefetched, but found %ld.\n",
+            db_interface_get_prefetched_weeks(handle));
+    }
+
+    int statements = 0;
+    sqlite3_trace_v2(db_interface_get_db(handle), SQLITE_TRACE_STMT, countStatement, &statements);
+
+    checkWeek(weeks[0], "", 1, "after prefetching");
+    checkWeek(weeks[1], "2024-12-25 christmas", 1, "after prefetching");
+    checkWeek(weeks[2], "", 1, "after prefetching");
+
+    if (statements != 0) {
+        printf("FAILURE: Expected no statements for prefetched weeks, but found %d.\n",
+            statements);
+    }
+
+    sqlite3_trace_v2(db_interface_get_db(handle), 0, NULL, NULL);
+
+    // Save into a week while it's being prefetched, over and over, so some
+    // saves land while the prefetch thread is reading.
+    char expected[512] = "2024-12-25 christmas";
+
+    for (int i = 0; i < 40; i++) {
+        db_interface_set_week_cache_size(handle, 16);
+        db_interface_prefetch_weeks(handle, weeks, 3);
+
+        PlannerItem item = {0, buildDate(23, 11, 26), "gift", REP_NONE};
+        if ((rc = db_interface_save(handle, &item))) {
+            printError("saving while prefetching", rc);
+            break;
+        }
+
+        // Only as many as checkWeek can collect.
+        if (i < 6) {
+            strcat(expected, "; 2024-12-27 gift");
+            checkWeek(weeks[1], expected, 0, "saving while prefetching");
+        }
+    }
+
+    // Prefetching again after the last save gets the new items.
+    db_interface_set_week_cache_size(handle, 16);
+    long before = db_interface_get_prefetched_weeks(handle);
+    db_interface_prefetch_weeks(handle, weeks + 1, 1);
+    if (waitForPrefetch(before + 1)) {
+        printf("FAILURE: Expected the week to be prefetched again.\n");
+    }
+
+    int count = 0;
+    db_interface_each_in_week(handle, weeks[1], countItem, &count);
+    if (count != 41) {
+        printf("FAILURE: Expected 41 prefetched items, but found %d.\n", count);
+    }
+
+    // Canceling leaves nothing waiting, and nothing to prefetch in a
+    // transaction.
+    db_interface_set_week_cache_size(handle, 16);
+    db_interface_prefetch_weeks(handle, weeks, 3);
+    db_interface_cancel_prefetch(handle);
+    before = db_interface_get_prefetched_weeks(handle);
+
+    db_interface_begin(handle);
+    db_interface_prefetch_weeks(handle, weeks, 3);
+    usleep(20000);
+    db_interface_commit(handle);
+
+    if (db_interface_get_prefetched_weeks(handle) != before) {
+        printf("FAILURE: Expected nothing prefetched after canceling or in a transaction.\n");
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testPrefetch.\n");
+}
+
+/**
+ * Wait up to a few seconds for the prefetch thread.  Returns true if it
+ * didn't get to the given number of weeks.
+ *
+ * @param   weeks   Total prefetched weeks to wait for.
+ */
+char waitForPrefetch(long weeks)
+{
+    for (int i = 0; i < 5000; i++) {
+        if (db_interface_get_prefetched_weeks(handle) >= weeks) {
+            return 0;
+        }
+        usleep(1000);
+    }
+
+    return 1;
+}
+
+/**
+ * Count items.  See DbItemCallback.
+ */
+char countItem(PlannerItemView *item, void *ctx)
+{
+    (*(int *) ctx)++;
+
+    return 0;
+}
+
+/**
+ * Items saved together should come back the same as items saved one at a
+ * time would.
+ */
+void testSaveMany()
+{
+    printf("...Starting testSaveMany.\n");
+
+    char rc;
+
+    deleteFileIfExists(testDb);
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    // More than one batch's worth, so it has to go around more than once.
+    int count = 2500;
+    PlannerItem *items = malloc(sizeof(PlannerItem) * count);
+    Date dateObj = buildDate(20, 0, 0);
+
+    for (int i = 0; i < count; i++) {
+        items[i].id = 0;
+        items[i].date = dateObj;
+        items[i].desc = i % 2 ? "odd" : "even";
+        items[i].rep = i % 5 == 0 ? REP_YEARLY : REP_NONE;
+        datepp(&dateObj);
+    }
+
+    if ((rc = db_interface_begin(handle))) {
+        printError("beginning", rc);
+    }
+    if ((rc = db_interface_save_many(handle, items, count))) {
+        printError("saving many", rc);
+    }
+    if ((rc = db_interface_commit(handle))) {
+        printError("committing", rc);
+    }
+
+    for (int i = 1; i < count; i++) {
+        if (items[i].id != items[i - 1].id + 1) {
+            printf("FAILURE: Expected ids in order, but found %ld after %ld.\n",
+                items[i].id, items[i - 1].id);
+            break;
+        }
+    }
+
+    CheckedItems checked = {items, 0, 0};
+
+    if ((rc = db_interface_each(handle, checkSavedItem, &checked))) {
+        printError("visiting saved items", rc);
+    }
+    if (checked.index != count) {
+        printf("FAILURE: Expected %d items saved, but found %d.\n", count, checked.index);
+    }
+
+    // A bad date anywhere in a batch stops before any of that batch is saved.
+    for (int i = 0; i < count; i++) {
+        items[i].id = 0;
+    }
+    items[1500].date.month = 12;
+
+    if ((rc = db_interface_save_many(handle, items + 1024, 1024)) != DB_INTERFACE__BAD_DATE) {
+        printf("FAILURE: Expected DB_INTERFACE__BAD_DATE, but found %d.\n", rc);
+    }
+    if (items[1024].id != 0) {
+        printf("FAILURE: Expected nothing from the bad batch to be saved.\n");
+    }
+
+    free(items);
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testSaveMany.\n");
+}
+
+/**
+ * Check that items come back the same, in the order that they were saved in.
+ * See DbItemCallback.
+ */
+char checkSavedItem(PlannerItemView *item, void *ctx)
+{
+    CheckedItems *checked = (CheckedItems *) ctx;
+    PlannerItem *saved = &checked->items[checked->index++];
+
+    // Yearly items are saved reduced to 2001.
+    Date expected = toDate(reduceIntDate(toInt(saved->date), saved->rep));
+
+    if (item->id != saved->id || !dateMatch(&item->date, &expected)
+        || item->rep != saved->rep || item->descLen != (int) strlen(saved->desc)
+        || strncmp(item->desc, saved->desc, item->descLen) != 0
+    ) {
+        printf("FAILURE: Item %ld didn't come back the same as it was saved.\n", saved->id);
+        return ++checked->failures >= 5;
+    }
+
+    return 0;
+}
+
+/**
+ * Counts for every day in a range come from one query, with yearly items on
+ * every year they fall in.
+ */
+void testCountDays()
+{
+    printf("...Starting testCountDays.\n");
+
+    char rc;
+
+    deleteFileIfExists(testDb);
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    PlannerItem items[] = {
+        {0, buildDate(23, 2, 4), "dentist", REP_NONE},
+        {0, buildDate(23, 2, 4), "lunch", REP_NONE},
+        {0, buildDate(19, 2, 4), "birthday", REP_YEARLY},
+        {0, buildDate(19, 1, 28), "leap day", REP_YEARLY},
+        {0, buildDate(23, 2, 6), "deleted", REP_NONE},
+        {0, buildDate(24, 0, 0), "next year", REP_NONE},
+    };
+
+    for (int i = 0; i < 6; i++) {
+        db_interface_save(handle, &items[i]);
+    }
+    db_interface_delete(handle, items[4].id);
+
+    int statements = 0;
+    sqlite3_trace_v2(db_interface_get_db(handle), SQLITE_TRACE_STMT, countStatement, &statements);
+
+    // All of 2024 and 2025.
+    Date lower = buildDate(23, 0, 0);
+    Date upper = buildDate(24, 11, 30);
+    int counts[731];
+
+    if ((rc = db_interface_count_days(handle, lower, upper, counts))) {
+        printError("counting days", rc);
+    }
+
+    if (statements != 1) {
+        printf("FAILURE: Expected 1 statement for two years, but found %d.\n", statements);
+    }
+
+    sqlite3_trace_v2(db_interface_get_db(handle), 0, NULL, NULL);
+
+    struct {
+        Date day;
+        int count;
+    } expected[] = {
+        {buildDate(23, 2, 4), 3},   // Two and a birthday.
+        {buildDate(24, 2, 4), 1},   // Birthday.
+        {buildDate(23, 1, 28), 1},  // Leap day.
+        {buildDate(23, 2, 6), 0},   // Deleted.
+        {buildDate(24, 0, 0), 1},
+    };
+
+    int total = 0;
+    for (int i = 0; i < 731; i++) {
+        total += counts[i];
+    }
+    if (total != 6) {
+        printf("FAILURE: Expected 6 items in two years, but found %d.\n", total);
+    }
+
+    for (int i = 0; i < 5; i++) {
+        int found = counts[daysBetween(lower, expected[i].day)];
+        if (found != expected[i].count) {
+            char *dayStr;
+            toString(&dayStr, expected[i].day);
+            printf("FAILURE: Expected %d on %s, but found %d.\n", expected[i].count, dayStr,
+                found);
+            free(dayStr);
+        }
+    }
+
+    // One day, and a range that's backwards.
+    if ((rc = db_interface_count_days(handle, expected[0].day, expected[0].day, counts))
+        || counts[0] != 3
+    ) {
+        printf("FAILURE: Expected 3 on one day, but found %d.\n", counts[0]);
+    }
+
+    if ((rc = db_interface_count_days(handle, upper, lower, counts)) != DB_INTERFACE__BAD_DATE) {
+        printf("FAILURE: Expected a bad date for a backwards range, but found %d.\n", rc);
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testCountDays.\n");
+}
+
+/**
+ * Searching finds live items by the start of their words, best first, with the
+ * next day that yearly ones fall on, and keeps up with edits and deletes.
+ */
+void testSearch()
+{
+    printf("...Starting testSearch.\n");
+
+    char rc;
+
+    deleteFileIfExists(testDb);
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    PlannerItem items[] = {
+        {0, buildDate(23, 5, 0), "Birthday party at the office", REP_NONE},
+        {0, buildDate(20, 2, 4), "birthday", REP_YEARLY},
+        {0, buildDate(23, 6, 1), "Café meeting", REP_NONE},
+        {0, buildDate(23, 6, 2), "birthday cake", REP_NONE},
+        {0, buildDate(23, 6, 3), "say \"hi\" to everyone", REP_NONE},
+    };
+
+    if ((rc = db_interface_save_many(handle, items, 2))) {
+        printError("saving many", rc);
+    }
+    for (int i = 2; i < 5; i++) {
+        db_interface_save(handle, &items[i]);
+    }
+
+    // The yearly one comes with its next birthday.
+    Date next = nextOccurrence(reduceIntDate(toInt(items[1].date), REP_YEARLY),
+        REP_YEARLY, todayDate());
+    char *nextStr;
+    toString(&nextStr, next);
+
+    char expected[256];
+    snprintf(expected, sizeof(expected), "%s birthday; 2024-07-03 birthday cake;"
+        " 2024-06-01 Birthday party at the office", nextStr);
+    free(nextStr);
+
+    checkSearch("birth", expected);
+    checkSearch("  BIRTH   part ", "2024-06-01 Birthday party at the office");
+    checkSearch("cafe", "2024-07-02 Café meeting");
+    checkSearch("\"hi\"", "2024-07-04 say \"hi\" to everyone");
+    checkSearch("hi OR birthday", "");
+    checkSearch("   ", "");
+
+    db_interface_update_desc(handle, items[2].id, "Lunch");
+    checkSearch("cafe", "");
+    checkSearch("lunch", "2024-07-02 Lunch");
+
+    db_interface_delete(handle, items[3].id);
+    checkSearch("cake", "");
+
+    // Moving an item doesn't change what finds it.
+    items[0].date = buildDate(23, 5, 1);
+    db_interface_save(handle, &items[0]);
+    checkSearch("office", "2024-06-02 Birthday party at the office");
+
+    // And the limit is the best ones.
+    CollectedItems collected = {.count = 0, .limit = 8};
+    if ((rc = db_interface_search(handle, "birth", 1, collectItem, &collected))) {
+        printError("searching with a limit", rc);
+    }
+    if (collected.count != 1 || strstr(collected.found[0], " birthday") == NULL) {
+        printf("FAILURE: Expected only the best match with a limit of 1.\n");
+    }
+
+    // The triggers should have kept the index in step with every change.
+    if (checkSearchIndex()) {
+        printf("FAILURE: Search index doesn't match the items.\n");
+    }
+
+    // Without the index the search can't even be prepared, which is an error
+    // but nothing worse.  Opened again so the search isn't already prepared.
+    sqlite3_exec(db_interface_get_db(handle), "DROP TABLE items_fts;", NULL, NULL, NULL);
+    db_interface_finalize(handle);
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization without the index", rc);
+        db_interface_finalize(handle);
+        return;
+    }
+
+    collected.count = 0;
+    if ((rc = db_interface_search(handle, "birth", 8, collectItem, &collected))
+        != DB_INTERFACE__DB_ERROR
+    ) {
+        printf("FAILURE: Expected DB_INTERFACE__DB_ERROR without the index, but found %d.\n", rc);
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testSearch.\n");
+}
+
+/**
+ * Check what a search finds.
+ *
+ * @param   text
+ * @param   expected    Items as "date desc" in order, separated by "; ".
+ */
+void checkSearch(char *text, char *expected)
+{
+    CollectedItems collected = {.count = 0, .limit = 8};
+    char rc;
+
+    if ((rc = db_interface_search(handle, text, 20, collectItem, &collected))) {
+        printError("searching", rc);
+        return;
+    }
+
+    char found[512] = "";
+    for (int i = 0; i < collected.count; i++) {
+        if (i > 0) {
+            strcat(found, "; ");
+        }
+        strcat(found, collected.found[i]);
+    }
+
+    if (strcmp(found, expected) != 0) {
+        printf("FAILURE: Expected \"%s\" searching for \"%s\", but found \"%s\".\n",
+            expected, text, found);
+    }
+}
+
+/**
+ * Updating a version 3 database indexes the live items that were already
+ * there, in batches.
+ */
+void testSearchIndexUpdate()
+{
+    printf("...Starting testSearchIndexUpdate.\n");
+
+    char rc;
+
+    deleteFileIfExists(testDb);
+
+    sqlite3 *db;
+    sqlite3_open(testDb, &db);
+    rc = sqlite3_exec(db,
+        "CREATE TABLE meta(name TEXT NOT NULL, desc TEXT NOT NULL,"
+        " value TEXT NOT NULL);"
+        "INSERT INTO meta VALUES('version', 'The version number.', '3');"
+        "CREATE TABLE items(id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        " date INTEGER NOT NULL, desc TEXT, rep INTEGER NOT NULL,"
+        " del INTEGER NOT NULL);"
+        "CREATE INDEX idx_live_rep_date ON items(rep, date, id, desc, del)"
+        " WHERE del = 0;"
+        "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n"
+        " WHERE i < 35)"
+        " INSERT INTO items(date, desc, rep, del)"
+        " SELECT 8000 + i, 'old item', 0, i % 7 = 0 FROM n;",
+        0, 0, NULL);
+    sqlite3_close(db);
+
+    if (rc) {
+        printf("ERROR: Could not build version 3 database.\n");
+        return;
+    }
+
+    _db_interface_set_update_batch(10);
+    rc = db_interface_initialize(&handle, testDb);
+    _db_interface_set_update_batch(10000);
+
+    if (rc) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    // Five of them were deleted.
+    int count = 0;
+    if ((rc = db_interface_search(handle, "old", 100, countItem, &count))) {
+        printError("searching", rc);
+    }
+    if (count != 30) {
+        printf("FAILURE: Expected 30 items indexed, but found %d.\n", count);
+    }
+
+    sqlite3_stmt *stmt = NULL;
+    sqlite3_prepare_v2(db_interface_get_db(handle),
+        "SELECT"
+        " (SELECT value FROM meta WHERE name = 'version'),"
+        " (SELECT count(*) FROM meta WHERE name <> 'version');",
+        -1, &stmt, 0);
+    sqlite3_step(stmt);
+
+    if (atoi((const char *) sqlite3_column_text(stmt, 0)) < 4) {
+        printf("FAILURE: Version was not updated to 4.\n");
+    }
+    if (sqlite3_column_int(stmt, 1) != 0) {
+        printf("FAILURE: Update progress was left in meta.\n");
+    }
+    sqlite3_finalize(stmt);
+
+    // The index has to agree with the items, or searches could come back
+    // wrong later.
+    if (checkSearchIndex()) {
+        printf("FAILURE: Search index doesn't match the items.\n");
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testSearchIndexUpdate.\n");
+}
+
+/**
+ * Items inserted while the indexes are dropped become searchable when they're
+ * put back, or when the database is opened again if they never were.
+ */
+void testSearchAfterDroppingIndexes()
+{
+    printf("...Starting testSearchAfterDroppingIndexes.\n");
+
+    char rc;
+
+    deleteFileIfExists(testDb);
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    PlannerItem items[] = {
+        {0, buildDate(23, 5, 0), "before", REP_NONE},
+        {0, buildDate(23, 5, 1), "imported", REP_NONE},
+        {0, buildDate(23, 5, 2), "imported", REP_NONE},
+        {0, buildDate(23, 5, 3), "crashed", REP_NONE},
+    };
+
+    db_interface_save(handle, &items[0]);
+
+    if ((rc = db_interface_drop_indexes(handle))) {
+        printError("dropping indexes", rc);
+    }
+    db_interface_save_many(handle, items + 1, 2);
+
+    checkSearch("imported", "");
+
+    if ((rc = db_interface_create_indexes(handle))) {
+        printError("creating indexes", rc);
+    }
+
+    checkSearch("imported", "2024-06-02 imported; 2024-06-03 imported");
+    checkSearch("before", "2024-06-01 before");
+
+    // Dropped twice and never put back, like if an import crashed.
+    db_interface_drop_indexes(handle);
+    db_interface_save(handle, &items[3]);
+    db_interface_drop_indexes(handle);
+    db_interface_finalize(handle);
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    checkSearch("crashed", "2024-06-04 crashed");
+
+    // And new items are indexed again.
+    PlannerItem after = {0, buildDate(23, 5, 4), "after", REP_NONE};
+    db_interface_save(handle, &after);
+    checkSearch("after", "2024-06-05 after");
+
+    if (checkSearchIndex()) {
+        printf("FAILURE: Search index doesn't match the items.\n");
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testSearchAfterDroppingIndexes.\n");
+}
+
+/**
+ * Purging removes the items deleted before the retention window, in batches,
+ * and shrinks the file.
+ */
+void testPurge()
+{
+    printf("...Starting testPurge.\n");
+
+    char rc;
+
+    deleteFileIfExists(testDb);
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    if (getPragma("PRAGMA auto_vacuum;") != 2) {
+        printf("FAILURE: New database doesn't use incremental vacuum.\n");
+    }
+
+    // Long descriptions, so that removing them frees whole pages.
+    char desc[501];
+    memset(desc, 'x', 500);
+    desc[500] = '\0';
+
+    db_interface_begin(handle);
+    for (int i = 0; i < 200; i++) {
+        PlannerItem item = {0, buildDate(i % 28, 2, 24), desc, REP_NONE};
+        db_interface_save(handle, &item);
+        db_interface_delete(handle, item.id);
+    }
+    db_interface_commit(handle);
+
+    // The other ways an item can be: deleted before times were recorded,
+    // deleted just now, and not deleted.
+    PlannerItem untimed = {0, buildDate(1, 3, 24), "untimed", REP_NONE};
+    PlannerItem recent = {0, buildDate(2, 3, 24), "recent", REP_NONE};
+    PlannerItem live = {0, buildDate(3, 3, 24), "live", REP_YEARLY};
+    db_interface_save(handle, &untimed);
+    db_interface_save(handle, &recent);
+    db_interface_save(handle, &live);
+    db_interface_delete(handle, untimed.id);
+    db_interface_delete(handle, recent.id);
+
+    sqlite3_exec(db_interface_get_db(handle),
+        "UPDATE items SET deleted_at = deleted_at - 10 * 86400"
+        " WHERE desc LIKE 'xxx%';"
+        "UPDATE items SET deleted_at = NULL WHERE desc = 'untimed';",
+        0, 0, NULL);
+
+    long pagesBefore = getPragma("PRAGMA page_count;");
+
+    DbPurgeStats stats;
+    _db_interface_set_purge_batch(50);
+    rc = db_interface_purge(handle, 7, &stats);
+    _db_interface_set_purge_batch(10000);
+
+    if (rc) {
+        printError("purging", rc);
+    }
+
+    if (stats.rows != 201) {
+        printf("FAILURE: Expected 201 rows purged, but found %ld.\n", stats.rows);
+    }
+    if (stats.batches != 5) {
+        printf("FAILURE: Expected 5 batches, but found %ld.\n", stats.batches);
+    }
+    if (stats.pages <= 0 || stats.pages != pagesBefore - getPragma("PRAGMA page_count;")) {
+        printf("FAILURE: Expected the file to shrink, but it went from %ld pages by %ld.\n",
+            pagesBefore, stats.pages);
+    }
+    if (stats.bytes != stats.pages * getPragma("PRAGMA page_size;")) {
+        printf("FAILURE: Bytes reclaimed don't match the pages.\n");
+    }
+
+    if (getPragma("SELECT count(*) FROM items WHERE del = 1;") != 1) {
+        printf("FAILURE: Expected only the recent item left deleted.\n");
+    }
+
+    int count = 0;
+    db_interface_each_in_range(handle, buildDate(3, 3, 24), buildDate(3, 3, 24),
+        countItem, &count);
+    if (count != 1) {
+        printf("FAILURE: Live item is gone after purging.\n");
+    }
+
+    if (checkSearchIndex()) {
+        printf("FAILURE: Search index doesn't match the items.\n");
+    }
+
+    // With no window, everything deleted goes.
+    if ((rc = db_interface_purge(handle, 0, &stats))) {
+        printError("purging again", rc);
+    }
+    if (stats.rows != 1 || stats.batches != 1) {
+        printf("FAILURE: Expected the recent item purged, but found %ld rows.\n",
+            stats.rows);
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testPurge.\n");
+}
+
+/**
+ * A database from before version 5 has no deletion times and no auto_vacuum,
+ * and gets both sorted out.
+ */
+void testPurgeUpdatedDatabase()
+{
+    printf("...Starting testPurgeUpdatedDatabase.\n");
+
+    char rc;
+
+    deleteFileIfExists(testDb);
+
+    sqlite3 *db;
+    sqlite3_open(testDb, &db);
+    rc = sqlite3_exec(db,
+        "CREATE TABLE meta(name TEXT NOT NULL, desc TEXT NOT NULL,"
+        " value TEXT NOT NULL);"
+        "INSERT INTO meta VALUES('version', 'The version number.', '3');"
+        "CREATE TABLE items(id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        " date INTEGER NOT NULL, desc TEXT, rep INTEGER NOT NULL,"
+        " del INTEGER NOT NULL);"
+        "CREATE INDEX idx_live_rep_date ON items(rep, date, id, desc, del)"
+        " WHERE del = 0;"
+        "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n"
+        " WHERE i < 100)"
+        " INSERT INTO items(date, desc, rep, del)"
+        " SELECT 8000 + i, 'old item ' || printf('%500d', i), 0, i % 10 <> 0"
+        " FROM n;",
+        0, 0, NULL);
+    sqlite3_close(db);
+
+    if (rc) {
+        printf("ERROR: Could not build version 3 database.\n");
+        return;
+    }
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    DbPurgeStats stats;
+    if ((rc = db_interface_purge(handle, 30, &stats))) {
+        printError("purging", rc);
+    }
+
+    if (stats.rows != 90) {
+        printf("FAILURE: Expected 90 rows purged, but found %ld.\n", stats.rows);
+    }
+    if (stats.pages <= 0) {
+        printf("FAILURE: Expected the file to shrink, but it went by %ld pages.\n",
+            stats.pages);
+    }
+    if (getPragma("PRAGMA auto_vacuum;") != 2) {
+        printf("FAILURE: Database wasn't switched to incremental vacuum.\n");
+    }
+    if (getPragma("SELECT count(*) FROM items;") != 10) {
+        printf("FAILURE: Live items were purged.\n");
+    }
+
+    if (checkSearchIndex()) {
+        printf("FAILURE: Search index doesn't match the items.\n");
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testPurgeUpdatedDatabase.\n");
+}
+
+/**
+ * Pragmas come from the profile, then the meta table, then whatever was set
+ * before initializing, and only allowed values get through.
+ */
+void testTuning()
+{
+    printf("...Starting testTuning.\n");
+
+    char rc;
+
+    deleteFileIfExists(testDb);
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    checkTuning("wal", 1, -16384, "with the default profile");
+    if (getPragma("PRAGMA mmap_size;") != 268435456) {
+        printf("FAILURE: mmap_size wasn't set by the default profile.\n");
+    }
+    if (getPragma("PRAGMA temp_store;") != 2) {
+        printf("FAILURE: temp_store wasn't set by the default profile.\n");
+    }
+
+    // Saved with the database.  The bad value is skipped instead of stopping
+    // it from opening.
+    sqlite3_exec(db_interface_get_db(handle),
+        "INSERT INTO meta VALUES('tuning_profile', '', 'durable');"
+        "INSERT INTO meta VALUES('tuning_cache_size', '', '-4096');"
+        "INSERT INTO meta VALUES('tuning_synchronous', '', 'OFF; DROP TABLE items');",
+        0, 0, NULL);
+    db_interface_finalize(handle);
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+    checkTuning("wal", 2, -4096, "from the meta table");
+    db_interface_finalize(handle);
+
+    // Set before opening beats the meta table.
+    if ((rc = db_interface_set_profile("compat"))) {
+        printError("setting the profile", rc);
+    }
+    if ((rc = db_interface_set_tuning("cache_size", "500"))) {
+        printError("setting cache_size", rc);
+    }
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+    checkTuning("delete", 2, 500, "from the arguments");
+    if (getPragma("PRAGMA mmap_size;") != 0) {
+        printf("FAILURE: mmap_size wasn't turned off by the compat profile.\n");
+    }
+    db_interface_finalize(handle);
+
+    struct {
+        char *name;
+        char *value;
+    } bad[] = {
+        {"journal_mode", "OFF"},
+        {"journal_mode", "WAL; DROP TABLE items"},
+        {"synchronous", ""},
+        {"mmap_size", "-1"},
+        {"mmap_size", "99999999999999999999"},
+        {"cache_size", "12abc"},
+        {"cache_size", "-99999999999999999999"},
+        {"page_size", "4096"},
+    };
+
+    for (int i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        if (db_interface_set_tuning(bad[i].name, bad[i].value) != DB_INTERFACE__BAD_TUNING) {
+            printf("FAILURE: %s = %s was allowed.\n", bad[i].name, bad[i].value);
+        }
+    }
+    if (db_interface_set_profile("fastest") != DB_INTERFACE__BAD_TUNING) {
+        printf("FAILURE: Unknown profile was allowed.\n");
+    }
+
+    // Case doesn't matter for the words.
+    if (db_interface_set_tuning("journal_mode", "truncate")) {
+        printf("FAILURE: Lowercase journal mode wasn't allowed.\n");
+    }
+
+    db_interface_clear_tuning();
+
+    printf("...Completed testTuning.\n");
+}
+
+/**
+ * A save waits for another process's write to finish, instead of failing
+ * straight away, for as long as busy_timeout says.
+ */
+void testBusyTimeout()
+{
+    printf("...Starting testBusyTimeout.\n");
+
+    char rc;
+
+    deleteFileIfExists(testDb);
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    if (getPragma("PRAGMA busy_timeout;") != 5000) {
+        printf("FAILURE: busy_timeout wasn't set by the default profile.\n");
+    }
+
+    // Another connection writing, which finishes after a while.
+    sqlite3 *other;
+    sqlite3_open(testDb, &other);
+    sqlite3_exec(other, "BEGIN EXCLUSIVE;", 0, 0, NULL);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, releaseLock, other)) {
+        printf("ERROR: Could not start the thread.\n");
+        return;
+    }
+
+    PlannerItem item = {0, buildDate(24, 0, 0), "waited", REP_NONE};
+    if ((rc = db_interface_save(handle, &item))) {
+        printf("FAILURE: Expected the save to wait for the lock, but found %d.\n", rc);
+    }
+    pthread_join(thread, NULL);
+    db_interface_finalize(handle);
+
+    // With a short timeout, it gives up while the lock's still held.
+    if ((rc = db_interface_set_tuning("busy_timeout", "50"))) {
+        printError("setting busy_timeout", rc);
+    }
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+    if (getPragma("PRAGMA busy_timeout;") != 50) {
+        printf("FAILURE: Expected busy_timeout = 50 from the arguments.\n");
+    }
+
+    sqlite3_exec(other, "BEGIN EXCLUSIVE;", 0, 0, NULL);
+
+    // Every kind of write gives back SQLite's RC, and doesn't leave its
+    // cached statement half run.
+    long id = item.id;
+    char *writes[] = {"save new", "save existing", "update_desc", "delete"};
+
+    for (int i = 0; i < 4; i++) {
+        item.id = i == 0 ? 0 : id;
+
+        if (i < 2) {
+            rc = db_interface_save(handle, &item);
+        } else if (i == 2) {
+            rc = db_interface_update_desc(handle, id, "changed");
+        } else {
+            rc = db_interface_delete(handle, id);
+        }
+
+        if (rc != DB_INTERFACE__DB_ERROR) {
+            printf("FAILURE: Expected %s to give up on the lock, but found %d.\n", writes[i], rc);
+        }
+        if (db_interface_get_db_err(handle) != SQLITE_BUSY) {
+            printf("FAILURE: Expected SQLITE_BUSY from %s, but found %d.\n",
+                writes[i], db_interface_get_db_err(handle));
+        }
+
+        sqlite3_stmt *stmt = NULL;
+        while ((stmt = sqlite3_next_stmt(db_interface_get_db(handle), stmt)) != NULL) {
+            if (sqlite3_stmt_busy(stmt)) {
+                printf("FAILURE: Expected %s to reset its statement: %s\n",
+                    writes[i], sqlite3_sql(stmt));
+            }
+        }
+    }
+    sqlite3_exec(other, "COMMIT;", 0, 0, NULL);
+    sqlite3_close(other);
+
+    db_interface_finalize(handle);
+    db_interface_clear_tuning();
+
+    printf("...Completed testBusyTimeout.\n");
+}
+
+void testUpgradeFromV1()
+{
+    printf("...Starting testUpgradeFromV1.\n");
+
+    char rc;
+
+    // Build a version 1 database by hand, the way createDbV1 made them.
+    deleteFileIfExists(testDb);
+
+    sqlite3 *db;
+    sqlite3_open(testDb, &db);
+    rc = sqlite3_exec(db,
+        "CREATE TABLE meta(name TEXT NOT NULL, desc TEXT NOT NULL,"
+        " value TEXT NOT NULL);"
+        "INSERT INTO meta VALUES('version', 'The version number.', '1');"
+        "CREATE TABLE items(id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        " date INTEGER NOT NULL, desc TEXT, rep INTEGER NOT NULL,"
+        " del INTEGER NOT NULL);"
+        "CREATE INDEX idx_date ON items(date);"
+        "INSERT INTO items(date, desc, rep, del) VALUES(8000, 'old', 0, 0);",
+        0, 0, NULL);
+    sqlite3_close(db);
+
+    if (rc) {
+        printf("ERROR: Could not build version 1 database.\n");
+        return;
+    }
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    sqlite3_stmt *stmt = NULL;
+
+    sqlite3_prepare_v2(db_interface_get_db(handle),
+        "SELECT value FROM meta WHERE name = 'version';", -1, &stmt, 0);
+    sqlite3_step(stmt);
+    if (atoi((const char *) sqlite3_column_text(stmt, 0)) < 2) {
+        printf("FAILURE: Version was not updated.\n");
+    }
+    sqlite3_finalize(stmt);
+
+    // The day lookup should be answered from the new index alone.
+    sqlite3_prepare_v2(db_interface_get_db(handle),
+        "EXPLAIN QUERY PLAN SELECT id,date,desc,rep FROM items"
+        " WHERE del = 0 AND (date == ? AND rep = ?);", -1, &stmt, 0);
+    char foundCovering = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (strstr((const char *) sqlite3_column_text(stmt, 3),
+            "COVERING INDEX idx_live_rep_date") != NULL
+        ) {
+            foundCovering = 1;
+        }
+    }
+    sqlite3_finalize(stmt);
+
+    if (!foundCovering) {
+        printf("FAILURE: Day lookup does not use covering index.\n");
+    }
+
+    PlannerItem *result = NULL;
+    int count = 0;
+    while ((rc = db_interface_day(handle, &result, toDate(8000))) == DB_INTERFACE__CONT) {
+        count++;
+        freeItem(result);
+    }
+    if (count != 1) {
+        printf("FAILURE: Existing item not found after update.\n");
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testUpgradeFromV1.\n");
+}
+
+/** Number of batches reported to countUpdateCallback. */
+int updateCallbackCount = 0;
+
+/** Rows reported the last time countUpdateCallback was called. */
+long updateCallbackRows = 0;
+
+void testResumingUpdate()
+{
+    printf("...Starting testResumingUpdate.\n");
+
+    char rc;
+
+    // A version 2 database that was interrupted while updating to version 3,
+    // after the first ten rows.  The yearly rows were saved with full dates.
+    deleteFileIfExists(testDb);
+
+    sqlite3 *db;
+    sqlite3_open(testDb, &db);
+    rc = sqlite3_exec(db,
+        "CREATE TABLE meta(name TEXT NOT NULL, desc TEXT NOT NULL,"
+        " value TEXT NOT NULL);"
+        "INSERT INTO meta VALUES('version', 'The version number.', '2');"
+        "INSERT INTO meta VALUES('update_progress', '', '3:10');"
+        "CREATE TABLE items(id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        " date INTEGER NOT NULL, desc TEXT, rep INTEGER NOT NULL,"
+        " del INTEGER NOT NULL);"
+        "CREATE INDEX idx_live_rep_date ON items(rep, date, id, desc, del)"
+        " WHERE del = 0;"
+        "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n"
+        " WHERE i < 35)"
+        " INSERT INTO items(date, desc, rep, del)"
+        " SELECT 8000 + i, 'yearly', 1, 0 FROM n;",
+        0, 0, NULL);
+    sqlite3_close(db);
+
+    if (rc) {
+        printf("ERROR: Could not build interrupted database.\n");
+        return;
+    }
+
+    updateCallbackCount = 0;
+    updateCallbackRows = 0;
+    _db_interface_set_update_batch(10);
+    db_interface_set_update_callback(countUpdateCallback);
+
+    rc = db_interface_initialize(&handle, testDb);
+
+    _db_interface_set_update_batch(10000);
+    db_interface_set_update_callback(NULL);
+
+    if (rc) {
+        printError("during initialization", rc);
+        return;
+    }
+
+    // Ids 11 - 35 in batches of ten, and the last one finds nothing.
+    if (updateCallbackCount != 4) {
+        printf("FAILURE: Expected 4 batches, but found %d.\n", updateCallbackCount);
+    }
+    if (updateCallbackRows != 25) {
+        printf("FAILURE: Expected 25 rows updated, but found %ld.\n", updateCallbackRows);
+    }
+
+    sqlite3_stmt *stmt = NULL;
+    sqlite3_prepare_v2(db_interface_get_db(handle),
+        "SELECT"
+        " (SELECT value FROM meta WHERE name = 'version'),"
+        " (SELECT count(*) FROM meta WHERE name = 'update_progress'),"
+        " (SELECT count(*) FROM items WHERE date >= 372 AND id <= 10),"
+        " (SELECT count(*) FROM items WHERE date >= 372 AND id > 10);",
+        -1, &stmt, 0);
+    sqlite3_step(stmt);
+
+    if (atoi((const char *) sqlite3_column_text(stmt, 0)) < 3) {
+        printf("FAILURE: Version was not updated to 3.\n");
+    }
+    if (sqlite3_column_int(stmt, 1) != 0) {
+        printf("FAILURE: Update progress was not cleared.\n");
+    }
+    if (sqlite3_column_int(stmt, 2) != 10) {
+        printf("FAILURE: Rows before the cursor should not have been touched.\n");
+    }
+    if (sqlite3_column_int(stmt, 3) != 0) {
+        printf("FAILURE: Rows after the cursor were not reduced.\n");
+    }
+    sqlite3_finalize(stmt);
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testResumingUpdate.\n");
+}
+
+/**
+ * Two databases open at once, each used by its own thread, shouldn't see
+ * each other's items or get in the way of each other's reads.
+ */
+void testTwoHandles()
+{
+    printf("...Starting testTwoHandles.\n");
+
+    char rc;
+    DbHandle *other = NULL;
+
+    deleteFileIfExists(testDb);
+    deleteFileIfExists(otherTestDb);
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printError("during initialization", rc);
+        db_interface_finalize(handle);
+        return;
+    }
+    if ((rc = db_interface_initialize(&other, otherTestDb))) {
+        printError("during initialization of the other database", rc);
+        db_interface_finalize(handle);
+        db_interface_finalize(other);
+        return;
+    }
+
+    HandleRun runs[] = {{handle, "first", 300, 0, 0}, {other, "second", 200, 0, 0}};
+    pthread_t threads[2];
+
+    for (int i = 0; i < 2; i++) {
+        pthread_create(&threads[i], NULL, useHandle, &runs[i]);
+    }
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+
+        if (runs[i].rc) {
+            printError(runs[i].desc, runs[i].rc);
+        }
+        if (runs[i].found != runs[i].saved) {
+            printf("FAILURE: Expected %d %s items, but found %d.\n",
+                runs[i].saved, runs[i].desc, runs[i].found);
+        }
+    }
+
+    // Closing one leaves the other usable.
+    if ((rc = db_interface_finalize(other))) {
+        printError("during finalization of the other database", rc);
+    }
+
+    int count = 0;
+    db_interface_each_in_week(handle, getWeek(buildDate(23, 4, 9)), countItem, &count);
+    if (count != runs[0].saved) {
+        printf("FAILURE: Expected %d items after closing the other database, but found %d.\n",
+            runs[0].saved, count);
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    deleteFileIfExists(otherTestDb);
+
+    printf("...Completed testTwoHandles.\n");
+}
+
+
+// Helper functions below this line.
+
+/**
+ * Thread for testBusyTimeout: let go of the other connection's write lock
+ * after a while.
+ *
+ * @param   arg     The other connection.
+ */
+void *releaseLock(void *arg)
+{
+    usleep(200000);
+    sqlite3_exec((sqlite3 *) arg, "COMMIT;", 0, 0, NULL);
+
+    return NULL;
+}
+
+/**
+ * Save items for one day through one handle, then read them back a day at a
+ * time.  See HandleRun.
+ */
+void *useHandle(void *arg)
+{
+    HandleRun *run = (HandleRun *) arg;
+    Date day = buildDate(23, 4, 9);
+
+    for (int i = 0; i < run->saved; i++) {
+        PlannerItem item = {0, day, run->desc, REP_NONE};
+
+        if ((run->rc = db_interface_save(run->db, &item))) {
+            return NULL;
+        }
+    }
+
+    PlannerItem *result;
+    char rc;
+
+    while ((rc = db_interface_day(run->db, &result, day)) == DB_INTERFACE__CONT) {
+        if (strcmp(result->desc, run->desc) == 0) {
+            run->found++;
+        }
+        freeItem(result);
+    }
+    run->rc = rc;
+
+    return NULL;
+}
+
+void deleteFileIfExists(char *filename)
+{
+    FILE *file;
+
+    if ((file = fopen(filename, "r"))) {
+        fclose(file);
+        remove(filename);
+    }
+}
+
+/**
+ * Run FTS5's check that the search index matches the items.  Returns the
+ * SQLite RC.
+ */
+char checkSearchIndex()
+{
+    return sqlite3_exec(db_interface_get_db(handle),
+        "INSERT INTO items_fts(items_fts, rank) VALUES('integrity-check', 1);",
+        0, 0, NULL);
+}
+
+/**
+ * Run a query or pragma that returns a single number, and return it.
+ *
+ * @param   sql
+ */
+long getPragma(char *sql)
+{
+    sqlite3_stmt *stmt = NULL;
+    long value = -1;
+
+    sqlite3_prepare_v2(db_interface_get_db(handle), sql, -1, &stmt, 0);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        value = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+
+    return value;
+}
+
+/**
+ * Check the pragmas that the tuning profiles differ the most in.
+ *
+ * @param   journalMode As SQLite reports it, in lowercase.
+ * @param   synchronous 0 - 3 for OFF - EXTRA.
+ * @param   cacheSize
+ * @param   when        For the failure message.
+ */
+void checkTuning(char *journalMode, long synchronous, long cacheSize, char *when)
+{
+    sqlite3_stmt *stmt = NULL;
+
+    sqlite3_prepare_v2(db_interface_get_db(handle), "PRAGMA journal_mode;", -1, &stmt, 0);
+    sqlite3_step(stmt);
+    if (strcmp((const char *) sqlite3_column_text(stmt, 0), journalMode) != 0) {
+        printf("FAILURE: Expected journal mode %s %s, but found %s.\n",
+            journalMode, when, sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+
+    if (getPragma("PRAGMA synchronous;") != synchronous) {
+        printf("FAILURE: Expected synchronous = %ld %s.\n", synchronous, when);
+    }
+    if (getPragma("PRAGMA cache_size;") != cacheSize) {
+        printf("FAILURE: Expected cache_size = %ld %s.\n", cacheSize, when);
+    }
+}
+
+void printError(char *desc, char rc) {
+    char *str;
+    db_interface_build_err(handle, &str, rc);
+    printf("ERROR %s: %s\n", desc, str);
+    free(str);
+}
+
+void countUpdateCallback(int version, char *desc, long rows, double seconds, char done)
+{
+    if (version == 3) {
+        updateCallbackCount++;
+        updateCallbackRows = rows;
+    }
 }
@@ -1,36 +1,334 @@
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
 #include <sqlite3.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <time.h>
 
 #include "db-interface.h"
 #include "date-functions.h"
 #include "planner-functions.h"
 
-/** var dbFile Pointer to sqlite3 database object. */
-static sqlite3 *dbFile;
+/** Number of dates that db_interface_save_many converts at once. */
+#define SAVE_BATCH 1024
 
-static char prepStat(char *str, sqlite3_stmt **stmtptr);
-static int execStr(char *strInp);
-static char saveNew(PlannerItem *item);
-static char saveExisting(PlannerItem *item);
-static char getFromWhere(PlannerItem **result, char *where, int *values, int count);
-static char getFromWherePrepare(sqlite3_stmt **stmtGfw, char *where, int *values, int count);
+/** Number of weeks that db_interface_each_in_week keeps, to start with. */
+#define WEEK_CACHE_WEEKS 16
 
+/** Most weeks that can be waiting to be prefetched. */
+#define PREFETCH_WEEKS 8
 
-static char db_interface_build_err__db(char **str);
+/** Number of settings in tuningSettings. */
+#define TUNING_COUNT 6
+
+/**
+ * How long to wait for another connection's lock to go, in ms, before giving
+ * up with SQLITE_BUSY.  WAL still only lets one connection write at a time.
+ */
+#define BUSY_TIMEOUT "5000"
+
+/** Longest value a setting can be given, including the terminator. */
+#define TUNING_VALUE_SIZE 24
+
+/**
+ * An entry in the prepared statement cache.  The SQL is a heap copy, since the
+ * string that it was prepared from is frequently built on the stack.
+ */
+typedef struct stmt_cache_entry {
+    char *sql;
+    sqlite3_stmt *stmt;
+} StmtCacheEntry;
+
+/**
+ * A week that db_interface_each_in_week fetched, kept so that going back to it
+ * doesn't run the query again.  The items are views of copies in the arena,
+ * in the order the query returned them.
+ */
+typedef struct week_cache_entry {
+    /**
+     * @var The values bound to the week query, (day, rep, reduced day) for
+     * each row, starting with the first day.  An item is in the week exactly
+     * when its rep and saved date match one of these rows, so this is also
+     * what tells which weeks a change affects.
+     */
+    int vals[7 * REP_MAX * 3];
+
+    PlannerItemView *items;
+    int count;
+    int cap;
+
+    PlannerArena arena;
+
+    /** @var weekCacheClock when it was last used, for finding the oldest. */
+    long lastUsed;
+} WeekCacheEntry;
+
+/**
+ * Collects a week into a cache entry while passing it on to the callback.
+ */
+typedef struct week_cache_fill {
+    WeekCacheEntry *entry;
+    DbItemCallback callback;
+    void *ctx;
+
+    /** @var Set if the entry is missing anything, so it can't be kept. */
+    char incomplete;
+} WeekCacheFill;
+
+/**
+ * Everything about one open database.  Nothing in here is shared with other
+ * handles, so each one can be used from its own thread.  A handle itself is
+ * only safe to use from one thread at a time (not counting its prefetch
+ * thread, which it looks after).
+ */
+struct db_handle {
+    /** @var Pointer to sqlite3 database object. */
+    sqlite3 *dbFile;
+
+    /** @var Prepared statements, kept for as long as the connection is open. */
+    StmtCacheEntry *stmtCache;
+
+    /** @var Number of entries in stmtCache. */
+    int stmtCacheCount;
+
+    /** @var Number of times sqlite3_prepare_v2 has been called since initializing. */
+    long prepareCount;
+
+    /** @var The statement that getFromWhere is currently iterating through. */
+    sqlite3_stmt *stmtGfw;
+
+    /**
+     * @var Arena that stepGetFrom builds items in, or NULL to build them on
+     * the heap.  Only set while a function that takes an arena is stepping.
+     */
+    PlannerArena *gfwArena;
+
+    /** @var What db_interface_day is looking up, between calls. */
+    char dayRepType;
+    char dayRefresh;
+
+    /**
+     * @var Recently fetched weeks, least recently used evicted first.  Writes
+     * through this handle drop the weeks they affect, so the cache only goes
+     * stale if another connection changes the database.
+     */
+    WeekCacheEntry *weekCache;
+
+    /** @var Number of entries in weekCache. */
+    int weekCacheCount;
+
+    /** @var Most weeks to keep.  0 turns the cache off. */
+    int weekCacheSize;
+
+    /** @var Goes up every time a week is used. */
+    long weekCacheClock;
+
+    /** @var Weeks that came from the cache and weeks that had to be queried. */
+    long weekCacheHits;
+    long weekCacheMisses;
+
+    /**
+     * @var Guards the week cache, which the prefetch thread adds to, and
+     * everything shared with the prefetch thread.
+     */
+    pthread_mutex_t cacheLock;
+
+    /** @var Signaled when there's something to prefetch, or it's time to stop. */
+    pthread_cond_t prefetchWork;
+
+    /** @var Signaled when the prefetch thread stops fetching. */
+    pthread_cond_t prefetchIdle;
+
+    /**
+     * @var Fetches weeks into the cache on its own read-only connection, so
+     * the program doesn't wait for them.  Only running once something's been
+     * prefetched.
+     */
+    pthread_t prefetchThread;
+    char prefetchRunning;
+    char prefetchStopping;
+    sqlite3 *prefetchDb;
+
+    /** @var Weeks waiting to be prefetched, as the first day from toInt. */
+    int prefetchQueue[PREFETCH_WEEKS];
+    int prefetchQueueCount;
+
+    /** @var Set while the prefetch thread is running a query. */
+    char prefetchBusy;
+
+    /**
+     * @var Goes up whenever prefetching is canceled.  A week fetched while it
+     * changed could be out of date, so it's thrown away instead of cached.
+     */
+    long prefetchGeneration;
+
+    /** @var Number of weeks that the prefetch thread has added to the cache. */
+    long prefetchedWeeks;
+
+    /** @var The most recent error code from SQLite. */
+    int dbRc;
+
+    /** @var The most recent error code from Planner functions. */
+    char pfRc;
+};
+
+static int prepStat(DbHandle *db, char *str, sqlite3_stmt **stmtptr);
+static int releaseStat(sqlite3_stmt *stmt);
+static void clearStmtCache(DbHandle *db);
+static WeekCacheEntry *findCachedWeek(DbHandle *db, int startInt);
+static char fillCachedWeek(PlannerItemView *item, void *ctx);
+static void cacheWeek(DbHandle *db, WeekCacheEntry *entry);
+static void freeCachedWeek(WeekCacheEntry *entry);
+static void dropCachedWeek(DbHandle *db, int index);
+static void dropWeeksWithDate(DbHandle *db, int dateInt, char rep);
+static void dropWeeksWithId(DbHandle *db, long id);
+static void clearWeekCache(DbHandle *db);
+static char startPrefetching(DbHandle *db);
+static void stopPrefetching(DbHandle *db);
+static void *prefetchWeeks(void *arg);
+static int fetchWeek(DbHandle *db, sqlite3_stmt *stmt, int *vals, WeekCacheEntry *entry);
+static int execStr(DbHandle *db, char *strInp);
+static char saveNew(DbHandle *db, PlannerItem *item);
+static char insertItem(DbHandle *db, PlannerItem *item, int dateInt);
+static char saveExisting(DbHandle *db, PlannerItem *item);
+static char getFromWhere(DbHandle *db, PlannerItem **result, char *where, int *values, int count);
+static char getFromWherePrepare(DbHandle *db, sqlite3_stmt **stmtptr, char *where, int *values, int count);
+static char getFromSql(DbHandle *db, PlannerItem **result, char *sql, int *values, int count);
+static char getFromSqlPrepare(DbHandle *db, sqlite3_stmt **stmtptr, char *sql, int *values, int count);
+static char stepGetFrom(DbHandle *db, PlannerItem **result);
+static char eachFromSql(DbHandle *db, char *sql, int *values, int count, DbItemCallback callback, void *ctx);
+static char *rangeQuery(int *vals, Date lower, Date upper);
+static char *buildMatchQuery(const char *text);
+static size_t weekQueryLength();
+static void buildWeekQuery(char *sql, int *vals, Date start);
+
+
+static char db_interface_build_err__db(DbHandle *db, char **str);
 static char db_interface_build_err__ifce(char **str, int code);
 
 
-static char updateDatabase();
-static char doesDatabaseExist(char *result);
-static char createDbV1();
+static char updateDatabase(DbHandle *db);
+static char runUpdateStep(DbHandle *db, DbUpdateStep *step);
+static char runUpdateBatches(DbHandle *db, DbUpdateStep *step, long cursor);
+static char doesDatabaseExist(DbHandle *db, char *result);
+static char createDbV1(DbHandle *db);
+static char updateDbV2(DbHandle *db);
+static char updateDbV3(DbHandle *db, long *cursor, long *rows, char *done);
+static char updateDbV4Schema(DbHandle *db);
+static char updateDbV4(DbHandle *db, long *cursor, long *rows, char *done);
+static char updateDbV5Schema(DbHandle *db);
+static char getDbVersion(DbHandle *db, int *version);
+static char setDbVersion(DbHandle *db, int version);
+static char getUpdateProgress(DbHandle *db, int *version, long *cursor);
+static char setUpdateProgress(DbHandle *db, int version, long cursor);
+static char clearUpdateProgress(DbHandle *db);
+static double secondsSince(struct timespec *start);
+static char createIndexes(DbHandle *db);
+static char catchUpSearchIndex(DbHandle *db);
+static char purgeBatch(DbHandle *db, long cutoff, long *rows);
+static char getPragma(DbHandle *db, char *sql, long *value);
+static int findTuningSetting(char *name);
+static int findTuningProfile(char *name);
+static char checkTuningValue(int setting, char *value);
+static char readMetaTuning(DbHandle *db, int *profile, char values[][TUNING_VALUE_SIZE]);
+static char applyTuning(DbHandle *db);
+
+/** Parts of the week query.  See buildWeekQuery. */
+static char *weekSqlStart = "WITH days(date, rep, reduced) AS (VALUES ";
+static char *weekSqlRow = "(?,?,?),";
+static char *weekSqlEnd = ") SELECT items.id, days.date, items.desc, items.rep"
+    " FROM days JOIN items"
+    " ON items.date = days.reduced AND items.rep = days.rep"
+    " WHERE items.del = 0"
+    " ORDER BY days.date, items.rep DESC, items.id;";
+
+/**
+ * Keeps the search index up to date with new items.  Separate from the other
+ * triggers, since bulk imports drop it.  See db_interface_drop_indexes.
+ */
+static char *searchInsertTrigger = "CREATE TRIGGER IF NOT EXISTS items_fts_insert"
+    " AFTER INSERT ON items WHEN new.del = 0 BEGIN"
+    " INSERT INTO items_fts(rowid, desc) VALUES (new.id, new.desc);"
+    " END;";
+
+/** Called with progress when updating the database.  Can be NULL. */
+static DbUpdateCallback updateCallback = NULL;
+
+/** Maximum number of rows that an update step rewrites per transaction. */
+static long updateBatchSize = 10000;
+
+/** Maximum number of deleted rows that db_interface_purge removes per transaction. */
+static long purgeBatchSize = 10000;
+
+/**
+ * The steps to update the database, in order.  Each one takes the database
+ * from the version before it to its own version.  Never change or remove a
+ * step once it's been released-- Add a new one instead.
+ */
+static DbUpdateStep updateSteps[] = {
+    {1, "Create tables", createDbV1, NULL},
+    {2, "Index live rows by repetition and date", updateDbV2, NULL},
+    {3, "Reduce yearly dates saved as full dates", NULL, updateDbV3},
+    {4, "Index descriptions for searching", updateDbV4Schema, updateDbV4},
+    {5, "Record when items are deleted", updateDbV5Schema, NULL},
+};
+
+static char *journalModes[] = {"DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", NULL};
+static char *synchronousLevels[] = {"OFF", "NORMAL", "FULL", "EXTRA", NULL};
+static char *tempStores[] = {"DEFAULT", "FILE", "MEMORY", NULL};
+
+/**
+ * A pragma that can be tuned when the database is opened.  It either takes one
+ * of the words in `allowed`, or (if that's NULL) a whole number of at least
+ * `min`.  Nothing else gets near the SQL.
+ */
+typedef struct tuning_setting {
+    char *name;
+    char **allowed;
+    long long min;
+} TuningSetting;
+
+/**
+ * The pragmas that can be tuned.  journal_mode = OFF is left out on purpose,
+ * since a crash in the middle of a write would corrupt the file.
+ */
+static TuningSetting tuningSettings[TUNING_COUNT] = {
+    {"journal_mode", journalModes, 0},
+    {"synchronous", synchronousLevels, 0},
+    {"mmap_size", NULL, 0},
+    {"cache_size", NULL, LLONG_MIN}, // Negative is in KiB instead of pages.
+    {"temp_store", tempStores, 0},
+    {"busy_timeout", NULL, 0}, // In ms.
+};
+
+/** Values for every one of tuningSettings, in the same order. */
+typedef struct tuning_profile {
+    char *name;
+    char *values[TUNING_COUNT];
+} TuningProfile;
+
+/**
+ * The first one is the default.  With WAL, synchronous = NORMAL only syncs at
+ * checkpoints, so a power cut can lose the last few saves but never corrupts
+ * the file.  durable syncs every commit, and compat is how SQLite opens a
+ * database when nothing's set, except that they all wait for locks, since
+ * the daemon and batch mode share the file with other processes.
+ */
+static TuningProfile tuningProfiles[] = {
+    {"default", {"WAL", "NORMAL", "268435456", "-16384", "MEMORY", BUSY_TIMEOUT}},
+    {"durable", {"WAL", "FULL", "268435456", "-16384", "MEMORY", BUSY_TIMEOUT}},
+    {"compat", {"DELETE", "FULL", "0", "-2000", "DEFAULT", BUSY_TIMEOUT}},
+};
 
-/** This is the error code from SQLite. */
-int dbRc = 0;
+/** Profile picked with db_interface_set_profile, or -1 for none. */
+static int tuningProfile = -1;
 
-/** This is the error code from Planner functions. */
-char pfRc = 0;
+/** Values set with db_interface_set_tuning.  Empty if not set. */
+static char tuningOverrides[TUNING_COUNT][TUNING_VALUE_SIZE];
 
 // Internal-use-only macros.
 #define RETURN_ERR_IF_APP(CODE, EXPR, RETVAL) \
@@ -39,34 +337,100 @@ char pfRc = 0;
     }
 
 /**
- * Open the database file.  Create one if it doesn't exist.  Returns RC from
- * constants.
+ * Open the database file in a new handle.  Create one if it doesn't exist.
+ * Returns RC from constants.  The handle is passed back even if opening fails
+ * (unless it couldn't be allocated), so the error can be built from it, and
+ * needs to be finalized either way.
  *
+ * @param   dbptr       SETS HEAP.  Set to the new handle.
  * @param   filename    String representing filename path.
  */
-char db_interface_initialize(char *filename)
+char db_interface_initialize(DbHandle **dbptr, char *filename)
 {
+    DbHandle *db = calloc(1, sizeof(DbHandle));
+    *dbptr = db;
+
+    if (db == NULL) {
+        return DB_INTERFACE__OUT_OF_MEMORY;
+    }
+
+    db->dayRepType = REP_MAX - 1;
+    db->dayRefresh = 1;
+    db->weekCacheSize = WEEK_CACHE_WEEKS;
+
+    pthread_mutex_init(&db->cacheLock, NULL);
+    pthread_cond_init(&db->prefetchWork, NULL);
+    pthread_cond_init(&db->prefetchIdle, NULL);
+
     // https://sqlite.org/c3ref/open.html
     RETURN_ERR_IF_APP(
-        dbRc,
-        sqlite3_open(filename, &dbFile),
+        db->dbRc,
+        sqlite3_open(filename, &db->dbFile),
+        DB_INTERFACE__DB_ERROR
+    )
+
+    // Until applyTuning sets the one that's tuned, so that reading the tuning
+    // waits for locks too.
+    sqlite3_busy_timeout(db->dbFile, atoi(BUSY_TIMEOUT));
+
+    // So db_interface_purge can shrink the file without a full VACUUM.  Only
+    // does anything for a new database, and has to be before the first table
+    // (and the transaction that creates it).
+    RETURN_ERR_IF_APP(
+        db->dbRc,
+        execStr(db, "PRAGMA auto_vacuum = INCREMENTAL;"),
         DB_INTERFACE__DB_ERROR
     )
 
-    return updateDatabase();
+    // Before updating, so the update gets the tuning too.
+    char rc;
+    RETURN_ERR_IF_APP(rc, applyTuning(db), rc)
+
+    return updateDatabase(db);
 }
 
 /**
- * Close the database file.
+ * Close the database file and free the handle, which can't be used after.
+ * Cached statements are finalized first, since SQLite won't close a
+ * connection that still has statements attached.
+ *
+ * @param   db  Can be NULL, to make cleaning up after errors easier.
  */
-char db_interface_finalize()
+char db_interface_finalize(DbHandle *db)
 {
+    if (db == NULL) {
+        return DB_INTERFACE__OK;
+    }
+
+    if (db->prefetchRunning) {
+        pthread_mutex_lock(&db->cacheLock);
+        db->prefetchStopping = 1;
+        pthread_mutex_unlock(&db->cacheLock);
+
+        stopPrefetching(db);
+        pthread_cond_signal(&db->prefetchWork);
+        pthread_join(db->prefetchThread, NULL);
+
+        sqlite3_close(db->prefetchDb);
+        db->prefetchDb = NULL;
+        db->prefetchRunning = 0;
+        db->prefetchStopping = 0;
+    }
+
+    clearStmtCache(db);
+    clearWeekCache(db);
+
     // https://sqlite.org/c3ref/close.html
-    RETURN_ERR_IF_APP(
-        dbRc,
-        sqlite3_close(dbFile),
-        DB_INTERFACE__DB_ERROR
-    );
+    int closeRc = sqlite3_close(db->dbFile);
+
+    pthread_mutex_destroy(&db->cacheLock);
+    pthread_cond_destroy(&db->prefetchWork);
+    pthread_cond_destroy(&db->prefetchIdle);
+    free(db);
+
+    if (closeRc) {
+        return DB_INTERFACE__DB_ERROR;
+    }
 
     return DB_INTERFACE__OK;
 }
@@ -74,646 +438,2819 @@ char db_interface_finalize()
 /**
  * Get the db object.  Mostly needed for for testing purposes.
  */
-sqlite3 *db_interface_get_db()
+sqlite3 *db_interface_get_db(DbHandle *db)
 {
-    return dbFile;
+    return db->dbFile;
 }
 
 /**
- * Save array of PlannerItem objects.
+ * Get the number of statements that have been compiled since the database was
+ * initialized.  Since statements are cached, this should stay at about the
+ * number of distinct queries used, no matter how many times they're run.
+ */
+long db_interface_get_prepare_count(DbHandle *db)
+{
+    return db->prepareCount;
+}
+
+/**
+ * Set how many weeks db_interface_each_in_week keeps.  0 turns the cache off.
+ * Empties the cache.
  *
- * @param   items   Array of items to save.
+ * @param   weeks
  */
-char db_interface_save(PlannerItem *item)
+void db_interface_set_week_cache_size(DbHandle *db, int weeks)
 {
-    char rc;
+    stopPrefetching(db);
+    clearWeekCache(db);
+    db->weekCacheSize = weeks;
+}
 
-    if (item->id == 0) {
-        RETURN_ERR_IF_APP(rc, saveNew(item), rc)
-    } else {
-        RETURN_ERR_IF_APP(rc, saveExisting(item), rc)
-    }
+/**
+ * Get the number of weeks that came from the cache since the database was
+ * initialized, without running a query.
+ */
+long db_interface_get_week_cache_hits(DbHandle *db)
+{
+    return db->weekCacheHits;
+}
 
-    return DB_INTERFACE__OK;
+/**
+ * Get the number of weeks that had to be queried since the database was
+ * initialized.
+ */
+long db_interface_get_week_cache_misses(DbHandle *db)
+{
+    return db->weekCacheMisses;
 }
 
 /**
- * Update description of a planner record by id.
+ * Fetch weeks into the cache in the background, like the ones next to the
+ * week being shown, so they're there if they're asked for.  Returns straight
+ * away.  Replaces any weeks still waiting from the last time.  Does nothing
+ * in a transaction, since what it would fetch could be about to change.
  *
- * @param   id
- * @param   newdesc
+ * Prefetching never holds up writing: anything that writes cancels it first.
+ *
+ * @param   starts  First day of each week.
+ * @param   count
  */
-char db_interface_update_desc(long id, char *newdesc)
+void db_interface_prefetch_weeks(DbHandle *db, Date *starts, int count)
 {
-    char *updateRow = "UPDATE items SET desc = ? WHERE id = ?;";
-
-    sqlite3_stmt *stmt;
+    if (db->weekCacheSize == 0 || !sqlite3_get_autocommit(db->dbFile)) {
+        return;
+    }
 
-    RETURN_ERR_IF_APP(dbRc, prepStat(updateRow, &stmt), DB_INTERFACE__DB_ERROR)
+    if (!db->prefetchRunning && startPrefetching(db)) {
+        return;
+    }
 
-    RETURN_ERR_IF_APP(dbRc, sqlite3_bind_text(stmt, 1, newdesc, -1, 0),
-        DB_INTERFACE__DB_ERROR)
-    RETURN_ERR_IF_APP(dbRc, sqlite3_bind_int(stmt, 2, id),
-        DB_INTERFACE__DB_ERROR)
+    pthread_mutex_lock(&db->cacheLock);
 
-    if ((dbRc = sqlite3_step(stmt)) != SQLITE_DONE) {
-        return DB_INTERFACE__DB_ERROR;
+    db->prefetchQueueCount = 0;
+    for (int i = 0; i < count && i < PREFETCH_WEEKS; i++) {
+        db->prefetchQueue[db->prefetchQueueCount++] = toInt(starts[i]);
     }
 
-    RETURN_ERR_IF_APP(dbRc, sqlite3_finalize(stmt), DB_INTERFACE__DB_ERROR)
-
-    return DB_INTERFACE__OK;
+    pthread_cond_signal(&db->prefetchWork);
+    pthread_mutex_unlock(&db->cacheLock);
 }
 
 /**
- * Delete item by id.
- *
- * @param   id
+ * Stop prefetching, including any week being fetched right now, and wait for
+ * the prefetch thread to let go of the database.
  */
-char db_interface_delete(long id)
+void db_interface_cancel_prefetch(DbHandle *db)
 {
-    //char *deleteRow = "DELETE FROM items WHERE id = ?;";
-    char *deleteRow = "UPDATE items SET del = 1 WHERE id = ?;";
-
-    sqlite3_stmt *stmt;
-
-    RETURN_ERR_IF_APP(dbRc, prepStat(deleteRow, &stmt), DB_INTERFACE__DB_ERROR)
-
-    RETURN_ERR_IF_APP(dbRc, sqlite3_bind_int(stmt, 1, id),
-        DB_INTERFACE__DB_ERROR)
-
-    if ((dbRc = sqlite3_step(stmt)) != SQLITE_DONE) {
-        return DB_INTERFACE__DB_ERROR;
-    }
+    stopPrefetching(db);
+}
 
-    RETURN_ERR_IF_APP(dbRc, sqlite3_finalize(stmt), DB_INTERFACE__DB_ERROR)
+/**
+ * Get the number of weeks that have been prefetched into the cache since the
+ * database was initialized.
+ */
+long db_interface_get_prefetched_weeks(DbHandle *db)
+{
+    pthread_mutex_lock(&db->cacheLock);
+    long weeks = db->prefetchedWeeks;
+    pthread_mutex_unlock(&db->cacheLock);
 
-    return 0;
+    return weeks;
 }
 
 /**
- * Get the most recent error code from SQLite.
+ * Set the function to report progress to while updating the database.  Needs
+ * to be set before db_interface_initialize, since that's when it updates.
  *
- * NOTE: This doesn't seem to work for SQL misuse!  Making this function largely
- * untrustworthy.  Should refactor not to depend on the most recent error.
+ * @param   callback    Function to call, or NULL for none.
  */
-int db_interface_get_db_err()
+void db_interface_set_update_callback(DbUpdateCallback callback)
 {
-    return dbRc;
+    updateCallback = callback;
 }
 
 /**
- * Build error string from return code, for printing.
+ * Set how many rows an update step rewrites per transaction, for purposes of
+ * testing.
  *
- * If the error code is for SQLite, this will use the most recent error.
- *
- * The resulting string is on heap memory and must be freed!
+ * @param   size
+ */
+void _db_interface_set_update_batch(long size)
+{
+    updateBatchSize = size;
+}
+
+/**
+ * Pick the tuning profile for db_interface_initialize to start from, instead
+ * of the one in the database's meta table (as `tuning_profile`) or "default".
+ * Returns DB_INTERFACE__BAD_TUNING if there's no such profile.
  *
- * @param   str     SETS HEAP.  Pointer to string.
- * @param   code    Previously-returned error code.
+ * @param   name    default, durable, or compat.
  */
-char db_interface_build_err(char **str, int code)
+char db_interface_set_profile(char *name)
 {
-    // I decided to use heap memory for this because it makes the code
-    // significantly easier and passing a function-scope pointer to this
-    // function is not memory-safe and runs the risk of truncating the output
-    // string.  There is also some precedent here, because this is also how
-    // sqlite3_exec handles their errmsg string, if it's not null.  Having to
-    // free the memory is worth it to have manageable code.  Can look at the
-    // previous commit to see what it looked like before.
+    int profile = findTuningProfile(name);
 
-    if (code == DB_INTERFACE__DB_ERROR) {
-        return db_interface_build_err__db(str);
+    if (profile < 0) {
+        return DB_INTERFACE__BAD_TUNING;
     }
 
-    if (code == DB_INTERFACE__PLANNER) {
-        return planner_functions_build_err(str, pfRc);
+    tuningProfile = profile;
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Set a pragma for db_interface_initialize to use instead of the profile's,
+ * or the one in the database's meta table (as `tuning_<name>`).  Returns
+ * DB_INTERFACE__BAD_TUNING if the pragma can't be tuned or can't take the
+ * value.
+ *
+ * @param   name    journal_mode, synchronous, mmap_size, cache_size, or
+ *  temp_store.
+ * @param   value   Like WAL or 268435456.
+ */
+char db_interface_set_tuning(char *name, char *value)
+{
+    int setting = findTuningSetting(name);
+
+    if (setting < 0 || checkTuningValue(setting, value)) {
+        return DB_INTERFACE__BAD_TUNING;
     }
 
-    return db_interface_build_err__ifce(str, code);
+    strcpy(tuningOverrides[setting], value);
 
+    return DB_INTERFACE__OK;
 }
 
 /**
- * Intentionally create a database error, for purposes of testing.
+ * Forget the profile and pragmas set with db_interface_set_profile and
+ * db_interface_set_tuning.
  */
-void _db_interface_create_db_err()
+void db_interface_clear_tuning()
 {
-    char *sqldum = "definitely not valid sql code";
+    tuningProfile = -1;
 
-    dbRc = execStr(sqldum);
+    for (int i = 0; i < TUNING_COUNT; i++) {
+        tuningOverrides[i][0] = '\0';
+    }
 }
 
 /**
- * Retrieve single PlannerItem object.
+ * Save array of PlannerItem objects.
  *
- * @param   result  Result passed back by argument.
- * @param   id      Id of row to retrieve.
+ * @param   items   Array of items to save.
  */
-char db_interface_get(PlannerItem **result, int id)
+char db_interface_save(DbHandle *db, PlannerItem *item)
 {
-    int vals[1];
-    vals[0] = id;
+    char rc;
 
-    int rc = getFromWhere(result, "id = ?", vals, 1);
+    stopPrefetching(db);
 
-    if (rc != DB_INTERFACE__CONT && rc != DB_INTERFACE__OK) {
-        return DB_INTERFACE__DB_ERROR;
+    if (item->id == 0) {
+        RETURN_ERR_IF_APP(rc, saveNew(db, item), rc)
+    } else {
+        RETURN_ERR_IF_APP(rc, saveExisting(db, item), rc)
     }
 
-    if (*result != NULL) {
-        // If it's null, then nothing was found, so don't need to complete the
-        // statement.
-        RETURN_ERR_IF_APP(
-            rc,
-            getFromWhere(NULL, "", vals, 0),
-            DB_INTERFACE__DB_ERROR
-        )
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Save an array of items, converting their dates in batches instead of one at
+ * a time.  New items (id 0) get their ids set.  Stops at the first error, with
+ * the items before it saved.  Empties the week cache instead of working out
+ * which weeks every item is in, since it's for saving a lot at once.
+ *
+ * @param   items   Array of items to save.
+ * @param   count   Number of items.
+ */
+char db_interface_save_many(DbHandle *db, PlannerItem *items, int count)
+{
+    Date dates[SAVE_BATCH];
+    int ints[SAVE_BATCH];
+    int reduced[SAVE_BATCH];
+    char reps[SAVE_BATCH];
+
+    stopPrefetching(db);
+    clearWeekCache(db);
+
+    for (int start = 0; start < count; start += SAVE_BATCH) {
+        int batch = count - start < SAVE_BATCH ? count - start : SAVE_BATCH;
+        PlannerItem *batchItems = items + start;
+
+        for (int i = 0; i < batch; i++) {
+            dates[i] = batchItems[i].date;
+            reps[i] = batchItems[i].rep;
+        }
+
+        if (toIntBatch(dates, ints, batch)) {
+            return DB_INTERFACE__BAD_DATE;
+        }
+        reduceIntDateBatch(ints, reps, reduced, batch);
+
+        for (int i = 0; i < batch; i++) {
+            char rc;
+
+            if (batchItems[i].id == 0) {
+                RETURN_ERR_IF_APP(rc, insertItem(db, &batchItems[i], reduced[i]), rc)
+            } else {
+                RETURN_ERR_IF_APP(rc, saveExisting(db, &batchItems[i]), rc)
+            }
+        }
     }
 
     return DB_INTERFACE__OK;
 }
 
 /**
- * Iterate through PlannerItem pointers from date range.  Returns
- * DB_INTERFACE__CONT when it successfully returns an item and DB_INTERFACE__OK
- * when the items to retrieve have been exhausted.
- *
- * DEFUNCT because does not include repetitions.  Use db_interface_day instead
- * to get one day at a time.
- *
- * @param   result  Result passed back by argument.
- * @param   lower   Lower bound (inclusive)
- * @param   upper   Upper bound (inclusive)
+ * Start a transaction, so that saves after it are committed together instead
+ * of each one being committed (and synced to disk) separately.
  */
-char db_interface_range(PlannerItem **result, Date lower, Date upper)
+char db_interface_begin(DbHandle *db)
 {
-    int vals[2];
-    vals[0] = toInt(upper);
-    vals[1] = toInt(lower);
+    stopPrefetching(db);
 
-    return getFromWhere(result, "date <= ? AND date >= ?", vals, 2);
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, "BEGIN;"), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
 }
 
 /**
- * Iterate through PlannerItem pointers for a particular date, including
- * repetitions.  Returns DB_INTERFACE__CONT when it successfully returns an
- * item and DB_INTERFACE__OK when the items to retrieve have been exhausted and
- * result is set to null pointer.
- *
- * Definitely want to continue until DB_INTERFACE__OK is returned, because
- * otherwise future db calls will be undefined.  (I know what they'll do, I just
- * don't care to document them since that's not desired behavior; hence
- * "undefined").
- *
- * @param   result  Result passed back by argument.  Needs to be null *every*
- *  time this is called.
- * @param   date01  Date
+ * Commit the transaction started by db_interface_begin.
  */
-char db_interface_day(PlannerItem **result, Date date01)
+char db_interface_commit(DbHandle *db)
 {
-    static char repType = REP_MAX - 1;
-    static char refresh = 1;
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, "COMMIT;"), DB_INTERFACE__DB_ERROR)
 
-    char rc;
-    int vals[2];
-    vals[0] = 0;
-    vals[1] = 0;
+    return DB_INTERFACE__OK;
+}
 
-    if (refresh) {
-        // Only want to bother calculating these values if they're actually
-        // going to be used, and they're not if the where clause isn't changed.
-        vals[0] = reduceIntDate(toInt(date01), repType);
-        vals[1] = repType;
-        refresh = 0;
-    }
+/**
+ * Roll back the transaction started by db_interface_begin.
+ */
+char db_interface_rollback(DbHandle *db)
+{
+    // Weeks cached during the transaction could have things that are about to
+    // be undone.
+    clearWeekCache(db);
 
-    // Run calc.
-    rc = getFromWhere(result, "date == ? AND rep = ?", vals, 2);
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, "ROLLBACK;"), DB_INTERFACE__DB_ERROR)
 
-    if (rc == DB_INTERFACE__CONT) {
-        return rc;
-    }
+    return DB_INTERFACE__OK;
+}
 
-    // If reach end, may only have reached end of repetition type.  Need to
-    // switch to the next repetition type and continue (hence the recursive at
-    // the bottom).
-    if (rc == DB_INTERFACE__OK) {
-        repType = (repType - 1 + REP_MAX) % REP_MAX;
-        // Add REP_MAX to make sure it's always positive.
-        refresh = 1;
-    } else {
-        // In this case, there's an error, b/c it's neither cont nor ok.
-        return rc;
-    }
+/**
+ * Drop the indexes on items, for bulk imports.  Inserting a lot of rows and
+ * then building the indexes all at once is a lot faster than keeping them up
+ * to date through every insert.  Use db_interface_create_indexes when done.
+ * If that never happens (e.g., the program crashes), db_interface_initialize
+ * will put them back.
+ *
+ * New items stop being added to the search index too, and get added all at
+ * once by db_interface_create_indexes.  Only insert until then: editing or
+ * deleting one of them would take it out of an index it isn't in yet.
+ */
+char db_interface_drop_indexes(DbHandle *db)
+{
+    stopPrefetching(db);
 
-    // But if repType is back to the first type, then that means we've reached
-    // the end of the day, so we're actually done.
-    if (repType == REP_MAX - 1) {
-        return rc;
+    // Remembers where the search index is up to, unless an import that never
+    // finished already did.
+    char *sqldum = "DROP INDEX IF EXISTS idx_live_rep_date;"
+        "DROP TRIGGER IF EXISTS items_fts_insert;"
+        "INSERT INTO meta(name, desc, value)"
+        " SELECT 'search_unindexed', 'Items after this id need to be searchable.',"
+        " coalesce(max(id), 0) FROM items"
+        " WHERE NOT EXISTS (SELECT 1 FROM meta WHERE name = 'search_unindexed');";
+
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, "BEGIN IMMEDIATE;"), DB_INTERFACE__DB_ERROR)
+
+    if ((db->dbRc = execStr(db, sqldum))) {
+        execStr(db, "ROLLBACK;");
+        return DB_INTERFACE__DB_ERROR;
     }
 
-    return db_interface_day(result, date01);
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, "COMMIT;"), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
 }
 
+/**
+ * Put back indexes dropped with db_interface_drop_indexes.
+ */
+char db_interface_create_indexes(DbHandle *db)
+{
+    stopPrefetching(db);
 
-// Static functions below this line.
+    return createIndexes(db);
+}
 
 /**
- * Helper function for dealing with preparing statements.
+ * Update description of a planner record by id.
  *
- * @param   str
- * @param   stmtptr
- */
-static char prepStat(char *str, sqlite3_stmt **stmtptr)
+ * @param   id
+ * @param   newdesc
+ */
+char db_interface_update_desc(DbHandle *db, long id, char *newdesc)
+{
+    char *updateRow = "UPDATE items SET desc = ? WHERE id = ? AND del = 0;";
+
+    sqlite3_stmt *stmt;
+
+    stopPrefetching(db);
+    dropWeeksWithId(db, id);
+
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, updateRow, &stmt), DB_INTERFACE__DB_ERROR)
+
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_text(stmt, 1, newdesc, -1, 0),
+        DB_INTERFACE__DB_ERROR)
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int64(stmt, 2, id),
+        DB_INTERFACE__DB_ERROR)
+
+    if ((db->dbRc = sqlite3_step(stmt)) != SQLITE_DONE) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Delete item by id.
+ *
+ * @param   id
+ */
+char db_interface_delete(DbHandle *db, long id)
+{
+    // The row stays until db_interface_purge, which goes by when it was
+    // deleted.
+    char *deleteRow = "UPDATE items SET del = 1,"
+        " deleted_at = CAST(strftime('%s', 'now') AS INTEGER) WHERE id = ? AND del = 0;";
+
+    sqlite3_stmt *stmt;
+
+    stopPrefetching(db);
+    dropWeeksWithId(db, id);
+
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, deleteRow, &stmt), DB_INTERFACE__DB_ERROR)
+
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int64(stmt, 1, id),
+        DB_INTERFACE__DB_ERROR)
+
+    if ((db->dbRc = sqlite3_step(stmt)) != SQLITE_DONE) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    return 0;
+}
+
+/**
+ * Remove deleted items for good, once they've been deleted for longer than
+ * the retention window, and give the space back.  The rows go in batches of
+ * their own transactions, so the database isn't locked for the whole purge,
+ * and then an incremental vacuum shrinks the file.
+ *
+ * Databases made before auto_vacuum was turned on get a full VACUUM the first
+ * time, to switch them over.  That needs about as much free disk as the file.
+ *
+ * Can't be called inside db_interface_begin.
+ *
+ * @param   retentionDays   Keep items deleted less than this many days ago.
+ * @param   stats           Set to what was reclaimed.
+ */
+char db_interface_purge(DbHandle *db, int retentionDays, DbPurgeStats *stats)
+{
+    char rc;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    memset(stats, 0, sizeof(DbPurgeStats));
+
+    stopPrefetching(db);
+
+    long pageSize, pagesBefore, pagesAfter, autoVacuum;
+    RETURN_ERR_IF_APP(rc, getPragma(db, "PRAGMA page_size;", &pageSize), rc)
+    RETURN_ERR_IF_APP(rc, getPragma(db, "PRAGMA page_count;", &pagesBefore), rc)
+
+    long cutoff = (long) time(NULL) - retentionDays * 86400L;
+    long rows;
+
+    do {
+        RETURN_ERR_IF_APP(rc, purgeBatch(db, cutoff, &rows), rc)
+
+        if (rows) {
+            stats->rows += rows;
+            stats->batches++;
+        }
+    } while (rows == purgeBatchSize);
+
+    RETURN_ERR_IF_APP(rc, getPragma(db, "PRAGMA auto_vacuum;", &autoVacuum), rc)
+
+    if (autoVacuum != 2) {
+        // Only takes effect on an existing database with a VACUUM.
+        RETURN_ERR_IF_APP(db->dbRc, execStr(db, "PRAGMA auto_vacuum = INCREMENTAL; VACUUM;"),
+            DB_INTERFACE__DB_ERROR)
+    } else {
+        RETURN_ERR_IF_APP(db->dbRc, execStr(db, "PRAGMA incremental_vacuum;"),
+            DB_INTERFACE__DB_ERROR)
+    }
+
+    RETURN_ERR_IF_APP(rc, getPragma(db, "PRAGMA page_count;", &pagesAfter), rc)
+
+    stats->pages = pagesBefore - pagesAfter;
+    stats->bytes = stats->pages * pageSize;
+    stats->seconds = secondsSince(&start);
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Set how many rows db_interface_purge removes per transaction, for purposes
+ * of testing.
+ *
+ * @param   size
+ */
+void _db_interface_set_purge_batch(long size)
+{
+    purgeBatchSize = size;
+}
+
+/**
+ * Number of rows changed by the most recent update or delete, like to tell if
+ * the id it was given exists.
+ */
+long db_interface_changes(DbHandle *db)
+{
+    return sqlite3_changes(db->dbFile);
+}
+
+/**
+ * Get the most recent error code from SQLite.
+ *
+ * NOTE: This doesn't seem to work for SQL misuse!  Making this function largely
+ * untrustworthy.  Should refactor not to depend on the most recent error.
+ */
+int db_interface_get_db_err(DbHandle *db)
+{
+    return db->dbRc;
+}
+
+/**
+ * Build error string from return code, for printing.
+ *
+ * If the error code is for SQLite, this will use the handle's most recent
+ * error.
+ *
+ * The resulting string is on heap memory and must be freed!
+ *
+ * @param   db      Handle the code came from.  Can be NULL.
+ * @param   str     SETS HEAP.  Pointer to string.
+ * @param   code    Previously-returned error code.
+ */
+char db_interface_build_err(DbHandle *db, char **str, int code)
+{
+    // I decided to use heap memory for this because it makes the code
+    // significantly easier and passing a function-scope pointer to this
+    // function is not memory-safe and runs the risk of truncating the output
+    // string.  There is also some precedent here, because this is also how
+    // sqlite3_exec handles their errmsg string, if it's not null.  Having to
+    // free the memory is worth it to have manageable code.  Can look at the
+    // previous commit to see what it looked like before.
+
+    // Without a handle (like if one couldn't be allocated), there's no
+    // detail to look up.
+    if (code == DB_INTERFACE__DB_ERROR && db != NULL) {
+        return db_interface_build_err__db(db, str);
+    }
+
+    if (code == DB_INTERFACE__PLANNER && db != NULL) {
+        return planner_functions_build_err(str, db->pfRc);
+    }
+
+    return db_interface_build_err__ifce(str, code);
+
+}
+
+/**
+ * Intentionally create a database error, for purposes of testing.
+ */
+void _db_interface_create_db_err(DbHandle *db)
+{
+    char *sqldum = "definitely not valid sql code";
+
+    db->dbRc = execStr(db, sqldum);
+}
+
+/**
+ * Retrieve single PlannerItem object.
+ *
+ * @param   result  Result passed back by argument.
+ * @param   id      Id of row to retrieve.
+ */
+char db_interface_get(DbHandle *db, PlannerItem **result, int id)
+{
+    int vals[1];
+    vals[0] = id;
+
+    int rc = getFromWhere(db, result, "id = ?", vals, 1);
+
+    if (rc != DB_INTERFACE__CONT && rc != DB_INTERFACE__OK) {
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    if (*result != NULL) {
+        // If it's null, then nothing was found, so don't need to complete the
+        // statement.
+        RETURN_ERR_IF_APP(
+            rc,
+            getFromWhere(db, NULL, "", vals, 0),
+            DB_INTERFACE__DB_ERROR
+        )
+    }
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Iterate through PlannerItem pointers from date range, including
+ * repetitions.  Returns DB_INTERFACE__CONT when it successfully returns an item
+ * and DB_INTERFACE__OK when the items to retrieve have been exhausted.
+ *
+ * Every occurrence is returned separately, with its date set to the date of
+ * that occurrence, so a yearly item in a three-year range is returned three
+ * times.  Items are ordered by date, then in the same order as
+ * db_interface_day.
+ *
+ * Same as db_interface_day, want to continue until DB_INTERFACE__OK is
+ * returned.  The bounds are only used on the first call.
+ *
+ * @param   result  Result passed back by argument.
+ * @param   lower   Lower bound (inclusive)
+ * @param   upper   Upper bound (inclusive)
+ */
+char db_interface_range(DbHandle *db, PlannerItem **result, Date lower, Date upper)
+{
+    int vals[5];
+    char *sql = rangeQuery(vals, lower, upper);
+
+    return getFromSql(db, result, sql, vals, 5);
+}
+
+/**
+ * Call `callback` with every item between two dates (inclusive), in the same
+ * order as db_interface_range, but without copying anything.  Stops early if
+ * the callback returns non-zero.  Returns RC from constants.
+ *
+ * @param   lower       Lower bound (inclusive)
+ * @param   upper       Upper bound (inclusive)
+ * @param   callback    See DbItemCallback.
+ * @param   ctx         Passed to the callback.
+ */
+char db_interface_each_in_range(DbHandle *db, Date lower, Date upper, DbItemCallback callback, void *ctx)
+{
+    int vals[5];
+    char *sql = rangeQuery(vals, lower, upper);
+
+    return eachFromSql(db, sql, vals, 5, callback, ctx);
+}
+
+/**
+ * Iterate through PlannerItem pointers for a particular date, including
+ * repetitions.  Returns DB_INTERFACE__CONT when it successfully returns an
+ * item and DB_INTERFACE__OK when the items to retrieve have been exhausted and
+ * result is set to null pointer.
+ *
+ * Definitely want to continue until DB_INTERFACE__OK is returned, because
+ * otherwise future db calls will be undefined.  (I know what they'll do, I just
+ * don't care to document them since that's not desired behavior; hence
+ * "undefined").
+ *
+ * @param   result  Result passed back by argument.  Needs to be null *every*
+ *  time this is called.
+ * @param   date01  Date
+ */
+char db_interface_day(DbHandle *db, PlannerItem **result, Date date01)
+{
+    char rc;
+    int vals[2];
+    vals[0] = 0;
+    vals[1] = 0;
+
+    if (db->dayRefresh) {
+        // Only want to bother calculating these values if they're actually
+        // going to be used, and they're not if the where clause isn't changed.
+        vals[0] = reduceIntDate(toInt(date01), db->dayRepType);
+        vals[1] = db->dayRepType;
+        db->dayRefresh = 0;
+    }
+
+    // Run calc.
+    rc = getFromWhere(db, result, "date == ? AND rep = ?", vals, 2);
+
+    if (rc == DB_INTERFACE__CONT) {
+        return rc;
+    }
+
+    // If reach end, may only have reached end of repetition type.  Need to
+    // switch to the next repetition type and continue (hence the recursive at
+    // the bottom).
+    if (rc == DB_INTERFACE__OK) {
+        db->dayRepType = (db->dayRepType - 1 + REP_MAX) % REP_MAX;
+        // Add REP_MAX to make sure it's always positive.
+        db->dayRefresh = 1;
+    } else {
+        // In this case, there's an error, b/c it's neither cont nor ok.
+        return rc;
+    }
+
+    // But if the rep type is back to the first type, then that means we've reached
+    // the end of the day, so we're actually done.
+    if (db->dayRepType == REP_MAX - 1) {
+        return rc;
+    }
+
+    return db_interface_day(db, result, date01);
+}
+
+/**
+ * Iterate through PlannerItem pointers for the seven days starting at `start`,
+ * including repetitions, all from one query.  Returns DB_INTERFACE__CONT when
+ * it successfully returns an item and DB_INTERFACE__OK when the items have
+ * been exhausted and result is set to null pointer.
+ *
+ * Items come back grouped by day, in the same order as calling db_interface_day
+ * on each day.  Unlike db_interface_day, the date on each item is the day that
+ * it's displayed on, even if it repeats, so that's how to tell the days apart.
+ *
+ * Same as db_interface_day, want to continue until DB_INTERFACE__OK is
+ * returned.  `start` is only used on the first call.
+ *
+ * If `arena` isn't NULL, items are built in it instead of on the heap, so
+ * they're freed with the arena instead of with freeItem.
+ *
+ * @param   result  Result passed back by argument.
+ * @param   start   First day of the week.
+ * @param   arena   Arena to build items in, or NULL.
+ */
+char db_interface_week(DbHandle *db, PlannerItem **result, Date start, PlannerArena *arena)
+{
+    int vals[7 * REP_MAX * 3];
+    char sql[weekQueryLength()];
+
+    if (db->stmtGfw == NULL) {
+        // Only build it if it's actually going to be prepared.
+        buildWeekQuery(sql, vals, start);
+    }
+
+    db->gfwArena = arena;
+    char rc = getFromSql(db, result, sql, vals, 7 * REP_MAX * 3);
+    db->gfwArena = NULL;
+
+    return rc;
+}
+
+/**
+ * Call `callback` with every item in the seven days starting at `start`, in
+ * the same order as db_interface_week (so with the day it's displayed on), but
+ * without copying anything.  Stops early if the callback returns non-zero.
+ * Returns RC from constants.
+ *
+ * Recent weeks are cached (see db_interface_prefetch_weeks too), so going
+ * back to one doesn't touch the database.  The callback mustn't use the db
+ * interface, since the cache is locked while it's called.
+ *
+ * @param   start       First day of the week.
+ * @param   callback    See DbItemCallback.
+ * @param   ctx         Passed to the callback.
+ */
+char db_interface_each_in_week(DbHandle *db, Date start, DbItemCallback callback, void *ctx)
+{
+    // Held while calling back, so the prefetch thread can't evict the week.
+    pthread_mutex_lock(&db->cacheLock);
+    WeekCacheEntry *cached = findCachedWeek(db, toInt(start));
+
+    if (cached != NULL) {
+        db->weekCacheHits++;
+        cached->lastUsed = ++db->weekCacheClock;
+
+        for (int i = 0; i < cached->count; i++) {
+            if (callback(&cached->items[i], ctx)) {
+                break;
+            }
+        }
+
+        pthread_mutex_unlock(&db->cacheLock);
+        return DB_INTERFACE__OK;
+    }
+
+    db->weekCacheMisses++;
+    pthread_mutex_unlock(&db->cacheLock);
+
+    int vals[7 * REP_MAX * 3];
+    char sql[weekQueryLength()];
+    buildWeekQuery(sql, vals, start);
+
+    if (db->weekCacheSize == 0) {
+        return eachFromSql(db, sql, vals, 7 * REP_MAX * 3, callback, ctx);
+    }
+
+    WeekCacheEntry entry;
+    memset(&entry, 0, sizeof(WeekCacheEntry));
+    memcpy(entry.vals, vals, sizeof(vals));
+
+    WeekCacheFill fill = {&entry, callback, ctx, 0};
+    char rc = eachFromSql(db, sql, vals, 7 * REP_MAX * 3, fillCachedWeek, &fill);
+
+    pthread_mutex_lock(&db->cacheLock);
+    // The prefetch thread could have cached it in the meantime.
+    if (rc == DB_INTERFACE__OK && !fill.incomplete
+        && findCachedWeek(db, entry.vals[0]) == NULL
+    ) {
+        cacheWeek(db, &entry);
+    } else {
+        freeCachedWeek(&entry);
+    }
+    pthread_mutex_unlock(&db->cacheLock);
+
+    return rc;
+}
+
+/**
+ * Count the items on every day between two dates (inclusive), including
+ * yearly items, for overviews like a month or a year.  It's one grouped query
+ * that only reads the index, instead of a query for every day.  Returns RC
+ * from constants.
+ *
+ * @param   lower   Lower bound (inclusive)
+ * @param   upper   Upper bound (inclusive)
+ * @param   counts  One for each day from lower to upper, which are set to the
+ *  number of items on the day.
+ */
+char db_interface_count_days(DbHandle *db, Date lower, Date upper, int *counts)
+{
+    int days = daysBetween(lower, upper) + 1;
+
+    if (days <= 0) {
+        return DB_INTERFACE__BAD_DATE;
+    }
+
+    memset(counts, 0, days * sizeof(int));
+
+    // Same as rangeQuery, but grouped.  A day can come back twice, once for
+    // each repetition type.
+    char *sqldum = "WITH RECURSIVE years(base) AS ("
+        " SELECT ?3"
+        " UNION ALL SELECT base + ?4 FROM years WHERE base + ?4 <= ?2"
+    ")"
+    " SELECT date, count(*) FROM items"
+        " WHERE del = 0 AND rep = 0 AND date BETWEEN ?1 AND ?2"
+        " GROUP BY date"
+    " UNION ALL"
+    " SELECT years.base + items.date, count(*)"
+        " FROM years JOIN items"
+        " ON items.rep = 1 AND items.del = 0"
+        " AND items.date BETWEEN ?1 - years.base AND ?2 - years.base"
+        " WHERE NOT (items.date = ?5 AND (years.base / ?4) % 4 != 3)"
+        " GROUP BY 1;";
+
+    int vals[5];
+    rangeQuery(vals, lower, upper);
+
+    sqlite3_stmt *stmt = NULL;
+
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sqldum, &stmt), DB_INTERFACE__DB_ERROR)
+
+    for (int i = 0; i < 5; i++) {
+        if ((db->dbRc = sqlite3_bind_int(stmt, i + 1, vals[i]))) {
+            releaseStat(stmt);
+            return DB_INTERFACE__DB_ERROR;
+        }
+    }
+
+    while ((db->dbRc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        int day = daysBetween(lower, toDate(sqlite3_column_int(stmt, 0)));
+
+        if (day >= 0 && day < days) {
+            counts[day] += sqlite3_column_int(stmt, 1);
+        }
+    }
+
+    if (db->dbRc != SQLITE_DONE) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Call `callback` with the items whose descriptions have every word in
+ * `text`, best matches first.  Words match the start of words, so "birth"
+ * finds "birthday", and case and accents don't matter.  Yearly items come
+ * with the next day they fall on (today or later), and everything else with
+ * its own date.  Deleted items aren't searched.  Stops early if the callback
+ * returns non-zero.  Returns RC from constants.
+ *
+ * @param   text        What to search for.
+ * @param   limit       Most items to return.
+ * @param   callback    See DbItemCallback.
+ * @param   ctx         Passed to the callback.
+ */
+char db_interface_search(DbHandle *db, char *text, int limit, DbItemCallback callback, void *ctx)
+{
+    sqlite3_stmt *stmt = NULL;
+
+    char *match = buildMatchQuery(text);
+    if (match == NULL) {
+        return DB_INTERFACE__OUT_OF_MEMORY;
+    }
+
+    if (*match == '\0') {
+        // Nothing to search for.
+        free(match);
+        return DB_INTERFACE__OK;
+    }
+
+    // Ranking is done on the search index alone, and only the rows that make
+    // the cut are looked up in items.
+    char *sqldum = "SELECT items.id, items.date, items.desc, items.rep FROM"
+        " (SELECT rowid, rank FROM items_fts WHERE items_fts MATCH ?"
+        " ORDER BY rank LIMIT ?) AS found"
+        " JOIN items ON items.id = found.rowid"
+        " WHERE items.del = 0"
+        " ORDER BY found.rank, items.id;";
+
+    if ((db->dbRc = prepStat(db, sqldum, &stmt))) {
+        // The match only belongs to SQLite once it's bound.
+        free(match);
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    if ((db->dbRc = sqlite3_bind_text(stmt, 1, match, -1, free))
+        || (db->dbRc = sqlite3_bind_int(stmt, 2, limit))
+    ) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    Date today = todayDate();
+    PlannerItemView view;
+
+    while ((db->dbRc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        view.id = sqlite3_column_int64(stmt, 0);
+        view.rep = sqlite3_column_int(stmt, 3);
+        view.date = nextOccurrence(sqlite3_column_int(stmt, 1), view.rep, today);
+        view.desc = (const char *) sqlite3_column_text(stmt, 2);
+        view.descLen = sqlite3_column_bytes(stmt, 2);
+
+        if (callback(&view, ctx)) {
+            db->dbRc = SQLITE_DONE;
+            break;
+        }
+    }
+
+    if (db->dbRc != SQLITE_DONE) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Call `callback` with every item that hasn't been deleted, in the order they
+ * were saved, without copying anything.  Stops early if the callback returns
+ * non-zero.  Returns RC from constants.
+ *
+ * Dates are what's saved, so yearly items have their reduced date (see
+ * reduceIntDate), meaning they're in the year 2001.
+ *
+ * @param   callback    See DbItemCallback.
+ * @param   ctx         Passed to the callback.
+ */
+char db_interface_each(DbHandle *db, DbItemCallback callback, void *ctx)
+{
+    return eachFromSql(
+        db,
+        "SELECT id,date,desc,rep FROM items WHERE del = 0 ORDER BY id;",
+        NULL,
+        0,
+        callback,
+        ctx
+    );
+}
+
+
+// Static functions below this line.
+
+/**
+ * Helper function for dealing with preparing statements.  Statements are only
+ * compiled the first time that their SQL is seen, and after that the cached
+ * statement is reset and has its bindings cleared, so it's ready to be bound
+ * again.  Returns SQLite RC.
+ *
+ * Statements from here must *not* be finalized.  Use releaseStat instead.
+ *
+ * @param   str
+ * @param   stmtptr
+ */
+static int prepStat(DbHandle *db, char *str, sqlite3_stmt **stmtptr)
+{
+    for (int i = 0; i < db->stmtCacheCount; i++) {
+        if (strcmp(db->stmtCache[i].sql, str) == 0) {
+            *stmtptr = db->stmtCache[i].stmt;
+            // Don't care about the RC from the reset, since that's the RC
+            // from the *last* time it was stepped.
+            releaseStat(*stmtptr);
+            return SQLITE_OK;
+        }
+    }
+
+    int rc;
+    db->prepareCount++;
+
+    if ((rc = sqlite3_prepare_v2(db->dbFile, str, -1, stmtptr, 0))) {
+        return rc;
+    }
+
+    char *sqlDum = malloc(strlen(str) + 1);
+    StmtCacheEntry *cacheDum = NULL;
+
+    if (sqlDum != NULL) {
+        cacheDum = (StmtCacheEntry *) realloc(
+            db->stmtCache,
+            (db->stmtCacheCount + 1) * sizeof(StmtCacheEntry)
+        );
+    }
+
+    if (cacheDum == NULL) {
+        free(sqlDum);
+        sqlite3_finalize(*stmtptr);
+        *stmtptr = NULL;
+        return SQLITE_NOMEM;
+    }
+
+    strcpy(sqlDum, str);
+    db->stmtCache = cacheDum;
+    db->stmtCache[db->stmtCacheCount].sql = sqlDum;
+    db->stmtCache[db->stmtCacheCount].stmt = *stmtptr;
+    db->stmtCacheCount++;
+
+    return SQLITE_OK;
+}
+
+/**
+ * Release a cached statement after it's been used, so it doesn't hold a lock
+ * or pointers to bound values that may not exist anymore.  Returns SQLite RC.
+ *
+ * @param   stmt
+ */
+static int releaseStat(sqlite3_stmt *stmt)
+{
+    int rc = sqlite3_reset(stmt);
+
+    sqlite3_clear_bindings(stmt);
+
+    return rc;
+}
+
+/**
+ * Finalize every cached statement and empty the cache.
+ */
+static void clearStmtCache(DbHandle *db)
+{
+    for (int i = 0; i < db->stmtCacheCount; i++) {
+        sqlite3_finalize(db->stmtCache[i].stmt);
+        free(db->stmtCache[i].sql);
+    }
+
+    free(db->stmtCache);
+    db->stmtCache = NULL;
+    db->stmtCacheCount = 0;
+    db->stmtGfw = NULL;
+    db->prepareCount = 0;
+}
+
+/**
+ * Find the cached week starting on a day.  Returns NULL if it isn't cached.
+ *
+ * @param   startInt    First day, from toInt.
+ */
+static WeekCacheEntry *findCachedWeek(DbHandle *db, int startInt)
+{
+    for (int i = 0; i < db->weekCacheCount; i++) {
+        if (db->weekCache[i].vals[0] == startInt) {
+            return &db->weekCache[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * DbItemCallback that copies each item into a cache entry and then passes it
+ * on (if there's a callback).  If the callback stops early, the entry doesn't
+ * have the whole week.
+ *
+ * @param   item
+ * @param   ctx     The WeekCacheFill.
+ */
+static char fillCachedWeek(PlannerItemView *item, void *ctx)
+{
+    WeekCacheFill *fill = (WeekCacheFill *) ctx;
+    WeekCacheEntry *entry = fill->entry;
+
+    if (!fill->incomplete && entry->count == entry->cap) {
+        int cap = entry->cap ? entry->cap * 2 : 16;
+        PlannerItemView *itemsDum = realloc(entry->items, cap * sizeof(PlannerItemView));
+
+        if (itemsDum == NULL) {
+            fill->incomplete = 1;
+        } else {
+            entry->items = itemsDum;
+            entry->cap = cap;
+        }
+    }
+
+    PlannerItem *copy;
+
+    if (!fill->incomplete) {
+        if (buildArenaItem(&entry->arena, &copy, item->id, item->date, (char *) item->desc,
+            item->rep)
+        ) {
+            fill->incomplete = 1;
+        } else {
+            PlannerItemView *view = &entry->items[entry->count++];
+            *view = *item;
+            view->desc = copy->desc;
+        }
+    }
+
+    if (fill->callback != NULL && fill->callback(item, fill->ctx)) {
+        fill->incomplete = 1;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Add a week to the cache, in place of the least recently used one if it's
+ * full.  The cache takes over the entry's memory.
+ *
+ * @param   entry
+ */
+static void cacheWeek(DbHandle *db, WeekCacheEntry *entry)
+{
+    if (db->weekCache == NULL) {
+        if ((db->weekCache = malloc(db->weekCacheSize * sizeof(WeekCacheEntry))) == NULL) {
+            freeCachedWeek(entry);
+            return;
+        }
+    }
+
+    entry->lastUsed = ++db->weekCacheClock;
+
+    if (db->weekCacheCount < db->weekCacheSize) {
+        db->weekCache[db->weekCacheCount++] = *entry;
+        return;
+    }
+
+    int oldest = 0;
+    for (int i = 1; i < db->weekCacheCount; i++) {
+        if (db->weekCache[i].lastUsed < db->weekCache[oldest].lastUsed) {
+            oldest = i;
+        }
+    }
+
+    freeCachedWeek(&db->weekCache[oldest]);
+    db->weekCache[oldest] = *entry;
+}
+
+static void freeCachedWeek(WeekCacheEntry *entry)
+{
+    free(entry->items);
+    freeArena(&entry->arena);
+}
+
+/**
+ * Take a week out of the cache, moving the last one into its place.
+ *
+ * @param   index
+ */
+static void dropCachedWeek(DbHandle *db, int index)
+{
+    freeCachedWeek(&db->weekCache[index]);
+    db->weekCache[index] = db->weekCache[--db->weekCacheCount];
+}
+
+/**
+ * Drop the cached weeks that an item with this date and repetition is in, the
+ * same way the week query matches them.  For yearly items, that's the weeks
+ * with that day in any year.
+ *
+ * @param   dateInt     Date as it's saved (reduced for the repetition).
+ * @param   rep
+ */
+static void dropWeeksWithDate(DbHandle *db, int dateInt, char rep)
+{
+    pthread_mutex_lock(&db->cacheLock);
+
+    // Backwards, so the week moved into a dropped one's place has already
+    // been checked.
+    for (int i = db->weekCacheCount - 1; i >= 0; i--) {
+        int *vals = db->weekCache[i].vals;
+
+        for (int row = 0; row < 7 * REP_MAX; row++) {
+            if (vals[row * 3 + 1] == rep && vals[row * 3 + 2] == dateInt) {
+                dropCachedWeek(db, i);
+                break;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&db->cacheLock);
+}
+
+/**
+ * Drop the cached weeks that have an item in them.
+ *
+ * @param   id
+ */
+static void dropWeeksWithId(DbHandle *db, long id)
+{
+    pthread_mutex_lock(&db->cacheLock);
+
+    for (int i = db->weekCacheCount - 1; i >= 0; i--) {
+        for (int j = 0; j < db->weekCache[i].count; j++) {
+            if (db->weekCache[i].items[j].id == id) {
+                dropCachedWeek(db, i);
+                break;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&db->cacheLock);
+}
+
+/**
+ * Empty the week cache.
+ */
+static void clearWeekCache(DbHandle *db)
+{
+    pthread_mutex_lock(&db->cacheLock);
+
+    for (int i = 0; i < db->weekCacheCount; i++) {
+        freeCachedWeek(&db->weekCache[i]);
+    }
+
+    free(db->weekCache);
+    db->weekCache = NULL;
+    db->weekCacheCount = 0;
+
+    pthread_mutex_unlock(&db->cacheLock);
+}
+
+/**
+ * Open the prefetch thread's connection and start it.  Returns true if it
+ * couldn't, in which case nothing is prefetched.
+ */
+static char startPrefetching(DbHandle *db)
+{
+    // An in-memory or temporary database has no name, and couldn't be shared
+    // with another connection anyway.
+    const char *filename = sqlite3_db_filename(db->dbFile, "main");
+
+    if (filename == NULL || *filename == '\0') {
+        return 1;
+    }
+
+    if (sqlite3_open_v2(filename, &db->prefetchDb, SQLITE_OPEN_READONLY, NULL)) {
+        sqlite3_close(db->prefetchDb);
+        db->prefetchDb = NULL;
+        return 1;
+    }
+
+    if (pthread_create(&db->prefetchThread, NULL, prefetchWeeks, db)) {
+        sqlite3_close(db->prefetchDb);
+        db->prefetchDb = NULL;
+        return 1;
+    }
+
+    db->prefetchRunning = 1;
+
+    return 0;
+}
+
+/**
+ * Cancel anything waiting to be prefetched, interrupt the week being fetched,
+ * and wait for the prefetch thread to let go of the database, so that it
+ * can't hold a lock that a write would wait on.  Interrupting stops the query
+ * straight away, so this doesn't wait on the query itself.
+ */
+static void stopPrefetching(DbHandle *db)
+{
+    if (!db->prefetchRunning) {
+        return;
+    }
+
+    pthread_mutex_lock(&db->cacheLock);
+
+    db->prefetchGeneration++;
+    db->prefetchQueueCount = 0;
+
+    while (db->prefetchBusy) {
+        sqlite3_interrupt(db->prefetchDb);
+        pthread_cond_wait(&db->prefetchIdle, &db->cacheLock);
+    }
+
+    pthread_mutex_unlock(&db->cacheLock);
+}
+
+/**
+ * The prefetch thread.  Fetches the queued weeks that aren't already cached,
+ * newest request first, until it's stopped.
+ *
+ * @param   arg     The handle to prefetch for.
+ */
+static void *prefetchWeeks(void *arg)
+{
+    DbHandle *db = (DbHandle *) arg;
+    int vals[7 * REP_MAX * 3];
+    char sql[weekQueryLength()];
+    sqlite3_stmt *stmt = NULL;
+
+    pthread_mutex_lock(&db->cacheLock);
+
+    for (;;) {
+        while (db->prefetchQueueCount == 0 && !db->prefetchStopping) {
+            pthread_cond_wait(&db->prefetchWork, &db->cacheLock);
+        }
+
+        if (db->prefetchStopping) {
+            break;
+        }
+
+        int startInt = db->prefetchQueue[0];
+        memmove(db->prefetchQueue, db->prefetchQueue + 1, --db->prefetchQueueCount * sizeof(int));
+
+        if (findCachedWeek(db, startInt) != NULL) {
+            continue;
+        }
+
+        long generation = db->prefetchGeneration;
+        db->prefetchBusy = 1;
+        pthread_mutex_unlock(&db->cacheLock);
+
+        buildWeekQuery(sql, vals, toDate(startInt));
+
+        WeekCacheEntry entry;
+        memset(&entry, 0, sizeof(WeekCacheEntry));
+        memcpy(entry.vals, vals, sizeof(vals));
+
+        int rc = stmt == NULL
+            ? sqlite3_prepare_v2(db->prefetchDb, sql, -1, &stmt, NULL)
+            : SQLITE_OK;
+
+        if (rc == SQLITE_OK) {
+            rc = fetchWeek(db, stmt, vals, &entry);
+        }
+
+        pthread_mutex_lock(&db->cacheLock);
+        db->prefetchBusy = 0;
+
+        // Only keep it if nothing was written while it was being fetched,
+        // and the program didn't fetch it first.
+        if (rc == SQLITE_DONE && generation == db->prefetchGeneration
+            && findCachedWeek(db, startInt) == NULL
+        ) {
+            cacheWeek(db, &entry);
+            db->prefetchedWeeks++;
+        } else {
+            freeCachedWeek(&entry);
+        }
+
+        pthread_cond_broadcast(&db->prefetchIdle);
+    }
+
+    pthread_mutex_unlock(&db->cacheLock);
+    sqlite3_finalize(stmt);
+
+    return NULL;
+}
+
+/**
+ * Run the week query on the prefetch connection into a cache entry.  Returns
+ * the SQLite RC, which is SQLITE_DONE if it got the whole week.  The
+ * statement is reset either way, so it doesn't keep the database locked.
+ *
+ * @param   stmt    Prepared week query.
+ * @param   vals    Values to bind to it.
+ * @param   entry
+ */
+static int fetchWeek(DbHandle *db, sqlite3_stmt *stmt, int *vals, WeekCacheEntry *entry)
+{
+    int rc = SQLITE_OK;
+
+    for (int i = 0; i < 7 * REP_MAX * 3 && rc == SQLITE_OK; i++) {
+        rc = sqlite3_bind_int(stmt, i + 1, vals[i]);
+    }
+
+    WeekCacheFill fill = {entry, NULL, NULL, 0};
+    PlannerItemView view;
+
+    while (rc == SQLITE_OK && (rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        view.id = sqlite3_column_int64(stmt, 0);
+        view.date = toDate(sqlite3_column_int(stmt, 1));
+        view.desc = (const char *) sqlite3_column_text(stmt, 2);
+        view.descLen = sqlite3_column_bytes(stmt, 2);
+        view.rep = sqlite3_column_int(stmt, 3);
+
+        fillCachedWeek(&view, &fill);
+
+        if (fill.incomplete) {
+            rc = SQLITE_NOMEM;
+        } else {
+            rc = SQLITE_OK;
+        }
+    }
+
+    sqlite3_reset(stmt);
+
+    return rc;
+}
+
+/**
+ * Helper function for quickly executing statements (that don't need
+ * parameters).
+ *
+ * @param   strInp
+ * @return  int
+ */
+static int execStr(DbHandle *db, char *strInp)
+{
+    return sqlite3_exec(db->dbFile, strInp, 0, 0, NULL);
+}
+
+/**
+ * Save a new record to the database, and save the id.  Returns rc.
+ *
+ * @param   item    A PlannerItem pointer.
+ */
+static char saveNew(DbHandle *db, PlannerItem *item)
+{
+    return insertItem(db, item, reduceIntDate(toInt(item->date), item->rep));
+}
+
+/**
+ * Insert an item with a date that's already been converted (and reduced) to
+ * an integer.  Sets the item's id.
+ *
+ * @param   item    A PlannerItem pointer.
+ * @param   dateInt
+ */
+static char insertItem(DbHandle *db, PlannerItem *item, int dateInt)
+{
+    char *insertRow = "INSERT INTO items(date, desc, rep, del) \
+        VALUES (?, ?, ?, 0);";
+
+    sqlite3_stmt *stmt;
+
+    dropWeeksWithDate(db, dateInt, item->rep);
+
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, insertRow, &stmt), DB_INTERFACE__DB_ERROR)
+
+    int bindints[4];
+    bindints[0] = 1;
+    bindints[1] = dateInt;
+
+    bindints[2] = 3;
+    bindints[3] = item->rep;
+
+    for (int i = 0; i < 4; i += 2) {
+        RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int(stmt, bindints[i], bindints[i+1]),
+            DB_INTERFACE__DB_ERROR)
+    }
+
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_text(stmt, 2, item->desc, -1, 0),
+        DB_INTERFACE__DB_ERROR);
+
+    if ((db->dbRc = sqlite3_step(stmt)) != SQLITE_DONE) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    long iddum;
+    iddum = sqlite3_last_insert_rowid(db->dbFile);
+
+    item->id = iddum;
+
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Save an existing record to the database.
+ *
+ * @param   item    A PlannerItem pointer.
+ */
+static char saveExisting(DbHandle *db, PlannerItem *item)
+{
+    char *updateRow = "UPDATE items SET date = ?, desc = ?, rep = ? WHERE id = ?;";
+
+    sqlite3_stmt *stmt;
+
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, updateRow, &stmt), DB_INTERFACE__DB_ERROR)
+
+    int bindints[4];
+    bindints[0] = 1;
+    bindints[1] = reduceIntDate(toInt(item->date), item->rep);
+
+    // Both the weeks it was in and the weeks it's going to be in.
+    dropWeeksWithId(db, item->id);
+    dropWeeksWithDate(db, bindints[1], item->rep);
+
+    bindints[2] = 3;
+    bindints[3] = item->rep;
+
+    for (int i = 0; i < 4; i += 2) {
+        RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int(stmt, bindints[i], bindints[i+1]),
+            DB_INTERFACE__DB_ERROR)
+    }
+
+    // Ids are 64-bit, so it can't go in with the ints.
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int64(stmt, 4, item->id),
+        DB_INTERFACE__DB_ERROR)
+
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_text(stmt, 2, item->desc, -1, 0),
+        DB_INTERFACE__DB_ERROR)
+
+    if ((db->dbRc = sqlite3_step(stmt)) != SQLITE_DONE) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR);
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Iterate over PlannerItem pointers from where clause and the integers to be
+ * bound to it.  (This assumes only integers will be bound.)
+ *
+ * Results dumped into `result` argument one at a time.  Returns
+ * DB_INTERFACE__CONT if there are more results to be retrieved, or
+ * DB_INTERFACE__OK when done.  Sets result to NULL if there's nothing to do.
+ *
+ * Helper method for db_interface_get and db_interface_day.
+ *
+ * @param   result
+ *  Result passed back by argument.  If this is null (not what it points to),
+ *  then this was intentionally passed just to close the argument.
+ * @param   where
+ *  WHERE clause, including ?s.
+ * @param   values
+ *  Array of integers to bind.
+ * @param   count
+ *  Number of integers to bind (i.e., count of "values").
+ */
+static char getFromWhere(DbHandle *db, PlannerItem **result, char *where, int *values, int count)
+{
+    char rc;
+
+    if (db->stmtGfw == NULL) {
+        RETURN_ERR_IF_APP(rc, getFromWherePrepare(db, &db->stmtGfw, where, values, count), rc)
+    }
+
+    return stepGetFrom(db, result);
+}
+
+/**
+ * Same as getFromWhere, but with the whole SQL statement instead of just the
+ * WHERE clause, for queries that need more than `items` by itself.  The
+ * statement needs to return the same columns in the same order as
+ * getFromWherePrepare does (id, date, desc, rep).
+ *
+ * @param   result  Same as getFromWhere.
+ * @param   sql     Full SQL statement, including ?s.
+ * @param   values  Array of integers to bind.
+ * @param   count   Number of integers to bind.
+ */
+static char getFromSql(DbHandle *db, PlannerItem **result, char *sql, int *values, int count)
+{
+    char rc;
+
+    if (db->stmtGfw == NULL) {
+        RETURN_ERR_IF_APP(rc, getFromSqlPrepare(db, &db->stmtGfw, sql, values, count), rc)
+    }
+
+    return stepGetFrom(db, result);
+}
+
+/**
+ * Step through the statement prepared by getFromWhere or getFromSql, building
+ * the PlannerItem for the current row.  Helper function for both of them.
+ *
+ * @param   result  Passed directly from getFromWhere or getFromSql.
+ */
+static char stepGetFrom(DbHandle *db, PlannerItem **result)
+{
+    db->dbRc = sqlite3_step(db->stmtGfw);
+
+    if (db->dbRc == SQLITE_DONE) {
+        // If SQLITE_DONE is returned, that means that it's *already* returned
+        // the final row.
+        // Note that if SQLITE_DONE is returned on first row, that means that
+        // there were no records found, so the *first* result is null.
+        if (result != NULL) {
+            // If result *itself* is null, then that was intentionally passed
+            // just to close the statement.
+            *result = NULL;
+        }
+        db->dbRc = releaseStat(db->stmtGfw);
+        db->stmtGfw = NULL;
+
+        if (db->dbRc) {
+            return DB_INTERFACE__DB_ERROR;
+        }
+
+        return DB_INTERFACE__OK;
+    }
+
+    if (db->dbRc != SQLITE_ROW) {
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    if (result == NULL) {
+        // This means a null pointer was passed when it wasn't ready to close.
+        return DB_INTERFACE__INTERNAL;
+    }
+
+    if (db->gfwArena != NULL) {
+        db->pfRc = buildArenaItem(
+            db->gfwArena,
+            result,
+            sqlite3_column_int(db->stmtGfw, 0),
+            toDate(sqlite3_column_int(db->stmtGfw, 1)),
+            (char *) sqlite3_column_text(db->stmtGfw, 2),
+            sqlite3_column_int(db->stmtGfw, 3)
+        );
+    } else {
+        db->pfRc = buildItem(
+            result,
+            sqlite3_column_int(db->stmtGfw, 0),
+            toDate(sqlite3_column_int(db->stmtGfw, 1)),
+            (char *) sqlite3_column_text(db->stmtGfw, 2),
+            sqlite3_column_int(db->stmtGfw, 3)
+        );
+    }
+
+    if (db->pfRc != PLANNER_STATUS__OK) {
+        releaseStat(db->stmtGfw); // Don't bother with RC here.
+        db->stmtGfw = NULL;
+        if (db->gfwArena == NULL) {
+            freeItem(*result); // Result can't be trusted.
+        }
+        result = NULL;
+        return DB_INTERFACE__PLANNER;
+    }
+
+    return DB_INTERFACE__CONT;
+}
+
+/**
+ * Step through a statement, calling `callback` with a view of each row.  The
+ * view points straight into SQLite's memory, so it's only good until the
+ * callback returns.  The statement has to select id, date, desc, and rep, like
+ * getFromSql.
+ *
+ * The statement is cached like the others, so the callback can't run the same
+ * query.
+ *
+ * @param   sql
+ * @param   values      Ints to bind, in order.
+ * @param   count       Number of values.
+ * @param   callback
+ * @param   ctx         Passed to the callback.
+ */
+static char eachFromSql(DbHandle *db, char *sql, int *values, int count, DbItemCallback callback, void *ctx)
+{
+    sqlite3_stmt *stmt = NULL;
+
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sql, &stmt), DB_INTERFACE__DB_ERROR)
+
+    for (int i = 0; i < count; i++) {
+        if ((db->dbRc = sqlite3_bind_int(stmt, i + 1, values[i]))) {
+            releaseStat(stmt);
+            return DB_INTERFACE__DB_ERROR;
+        }
+    }
+
+    PlannerItemView view;
+
+    while ((db->dbRc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        view.id = sqlite3_column_int64(stmt, 0);
+        view.date = toDate(sqlite3_column_int(stmt, 1));
+        view.desc = (const char *) sqlite3_column_text(stmt, 2);
+        view.descLen = sqlite3_column_bytes(stmt, 2);
+        view.rep = sqlite3_column_int(stmt, 3);
+
+        if (callback(&view, ctx)) {
+            db->dbRc = SQLITE_DONE;
+            break;
+        }
+    }
+
+    if (db->dbRc != SQLITE_DONE) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Get the query for everything in a range (see db_interface_range) and fill
+ * in the five values to bind to it.
+ *
+ * @param   vals    Values to bind, passed back by argument.
+ * @param   lower
+ * @param   upper
+ */
+static char *rangeQuery(int *vals, Date lower, Date upper)
+{
+    // Yearly items are stored as the day of the year (see reduceIntDate), so
+    // they're expanded by adding them to the start of every year in the range,
+    // which is what the recursive `years` table is (?4 is the length of a
+    // year).  Feb 29 (?5) only exists on leap years (year % 4 == 3, since
+    // years count from 2001).
+    // If adding repetition types, they'll need their own branch here.
+    char *sql = "WITH RECURSIVE years(base) AS ("
+        " SELECT ?3"
+        " UNION ALL SELECT base + ?4 FROM years WHERE base + ?4 <= ?2"
+    ")"
+    " SELECT id, date, desc, rep FROM items"
+        " WHERE del = 0 AND rep = 0 AND date BETWEEN ?1 AND ?2"
+    " UNION ALL"
+    " SELECT items.id, years.base + items.date, items.desc, items.rep"
+        " FROM years JOIN items"
+        " ON items.rep = 1 AND items.del = 0"
+        " AND items.date BETWEEN ?1 - years.base AND ?2 - years.base"
+        " WHERE NOT (items.date = ?5 AND (years.base / ?4) % 4 != 3)"
+    " ORDER BY 2, 4 DESC, 1;";
+
+    vals[0] = toInt(lower);
+    vals[1] = toInt(upper);
+    vals[2] = toInt(buildDate(lower.year, 0, 0));
+    vals[3] = toInt(buildDate(1, 0, 0));
+    vals[4] = toInt(buildDate(0, 1, 28));
+
+    return sql;
+}
+
+/**
+ * Turn what was typed into a search into an FTS5 query: every word quoted
+ * (so nothing in it is taken as query syntax) and matching as a prefix.  Like
+ * `"birth"* "party"*`.  Returns NULL if out of memory, or an empty string if
+ * there aren't any words.  Free it after.
+ *
+ * @param   text
+ */
+static char *buildMatchQuery(const char *text)
+{
+    // Worst case is every character a quote (doubled) or a one-letter word
+    // (which grows to five).
+    char *match = malloc(strlen(text) * 5 + 1);
+    if (match == NULL) {
+        return NULL;
+    }
+
+    char *out = match;
+    const char *in = text;
+
+    while (*in != '\0') {
+        while (isspace((unsigned char) *in)) {
+            in++;
+        }
+
+        if (*in == '\0') {
+            break;
+        }
+
+        if (out != match) {
+            *out++ = ' ';
+        }
+
+        *out++ = '"';
+        while (*in != '\0' && !isspace((unsigned char) *in)) {
+            if (*in == '"') {
+                *out++ = '"';
+            }
+            *out++ = *in++;
+        }
+        *out++ = '"';
+        *out++ = '*';
+    }
+
+    *out = '\0';
+
+    return match;
+}
+
+/**
+ * Size of the buffer that buildWeekQuery needs, including null terminator.
+ */
+static size_t weekQueryLength()
+{
+    return strlen(weekSqlStart) + 7 * REP_MAX * strlen(weekSqlRow)
+        + strlen(weekSqlEnd) + 1;
+}
+
+/**
+ * Build the query for a week (see db_interface_week) and fill in the values to
+ * bind to it (three per row, so 7 * REP_MAX * 3).
+ *
+ * @param   sql     Buffer of weekQueryLength().
+ * @param   vals
+ * @param   start   First day of the week.
+ */
+static void buildWeekQuery(char *sql, int *vals, Date start)
+{
+    // One row per day per repetition type: (day, rep, reduced day).  Joining
+    // this to items means every repetition type is matched with its own
+    // reduction of the date, so yearly items work across the end of the year
+    // like they do in db_interface_day.
+    int rows = 7 * REP_MAX;
+
+    strcpy(sql, weekSqlStart);
+    for (int i = 0; i < rows; i++) {
+        strcat(sql, weekSqlRow);
+    }
+    sql[strlen(sql) - 1] = '\0'; // Trailing comma.
+    strcat(sql, weekSqlEnd);
+
+    Date rollDay = start;
+    for (int i = 0; i < 7; i++) {
+        int dayInt = toInt(rollDay);
+        for (char rep = 0; rep < REP_MAX; rep++) {
+            int *row = vals + (i * REP_MAX + rep) * 3;
+            row[0] = dayInt;
+            row[1] = rep;
+            row[2] = reduceIntDate(dayInt, rep);
+        }
+        datepp(&rollDay);
+    }
+}
+
+/**
+ * Prepare statement for getFromWhere.  Helper function for getFromWhere.
+ *
+ * @param   stmtptr The SQLite statement object.
+ * @param   where   Directly passed by getFromWhere.
+ * @param   values  Directly passed by getFromWhere.
+ * @param   count   Directly passed by getFromWhere.
+ */
+static char getFromWherePrepare(DbHandle *db, sqlite3_stmt **stmtptr, char *where, int *values, int count)
+{
+    // Build SQL.
+
+    char *sqldum = "SELECT id,date,desc,rep FROM items WHERE del = 0 AND (";
+    // Not using "SELECT *" because the columns are only identified by
+    // number, so explicitly naming the columns makes it more future-proof
+    // and easier to update.
+
+    char sql[strlen(sqldum) + strlen(where) + 3]; // Semicol, closing paren, and null term.
+    strcpy(sql, sqldum);
+    strcat(sql, where);
+    strcat(sql, ");");
+
+    return getFromSqlPrepare(db, stmtptr, sql, values, count);
+}
+
+/**
+ * Prepare statement for getFromSql and bind its values.  Also used by
+ * getFromWherePrepare once it's built its SQL.
+ *
+ * @param   stmtptr The SQLite statement object.
+ * @param   sql     Directly passed by getFromSql.
+ * @param   values  Directly passed by getFromSql.
+ * @param   count   Directly passed by getFromSql.
+ */
+static char getFromSqlPrepare(DbHandle *db, sqlite3_stmt **stmtptr, char *sql, int *values, int count)
+{
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sql, stmtptr), DB_INTERFACE__DB_ERROR)
+
+    for (int i = 0; i < count; i++) {
+        // https://sqlite.org/c3ref/bind_blob.html
+        RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int(*stmtptr, i + 1, values[i]),
+            DB_INTERFACE__DB_ERROR);
+    }
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Set error string from database error.
+ *
+ * @param   str     HEAP.  Pointer to string.
+ * @param   code
+ */
+static char db_interface_build_err__db(DbHandle *db, char **str)
+{
+    char *fmt = "Database error: %d. ";
+
+    int strlen01 = snprintf(NULL, 0, fmt, db->dbRc);
+
+    int dbCode = sqlite3_errcode(db->dbFile);
+    // This is not reliable-- In some cases, it will return zero, so...
+
+    char *dbMsg;
+    if (dbCode) {
+        // ...if it's nonzero, we go ahead and use it, because the message is
+        // more detailed this way, but...
+        dbMsg = (char *) sqlite3_errmsg(db->dbFile);
+    } else {
+        // ...if it's zero, we use the description according to the code.
+        dbMsg = (char *) sqlite3_errstr(db->dbRc);
+    }
+
+    int sizedum = strlen01 + strlen(dbMsg) + 1;
+    *str = malloc(sizedum);
+
+    if (str == NULL) {
+        return DB_INTERFACE__OUT_OF_MEMORY;
+    }
+
+    snprintf(*str, sizedum, fmt, db->dbRc);
+    strcat(*str, dbMsg);
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Set error string for interface error.
+ *
+ * @param   str     HEAP.  Pointer to string.
+ * @param   code
+ */
+static char db_interface_build_err__ifce(char **str, int code)
+{
+    char *strdum;
+
+    switch (code) {
+        case DB_INTERFACE__OK:
+            strdum = "No error for db interface.";
+            break;
+        case DB_INTERFACE__DB_ERROR:
+            strdum = "Database error.";
+            break;
+        case DB_INTERFACE__OUT_OF_MEMORY:
+            strdum = "Out of memory or db interface.";
+            break;
+        case DB_INTERFACE__CONT:
+            strdum = "No error: Continue.";
+            break;
+        case DB_INTERFACE__INTERNAL:
+            strdum = "Coding problem inside this class.";
+            break;
+        case DB_INTERFACE__BAD_DATE:
+            strdum = "Date out of range for db interface.";
+            break;
+        case DB_INTERFACE__BAD_TUNING:
+            strdum = "Unknown tuning profile or setting for db interface.";
+            break;
+        default:
+            strdum = "Unknown error for db interface.";
+    }
+
+    *str = malloc(strlen(strdum) + 1);
+
+    if (str == NULL) {
+        return DB_INTERFACE__OUT_OF_MEMORY;
+    }
+
+    strcpy(*str, strdum);
+
+    return DB_INTERFACE__OK;
+}
+
+
+// Database update functions.
+
+/**
+ * Update database to latest version, running every step after the current
+ * version in order.  If a previous update was interrupted partway through its
+ * batches, it picks up where it left off.
+ */
+static char updateDatabase(DbHandle *db)
+{
+    char rc; // Will be from this module's constants.  (Can return.)
+
+    int version;
+    RETURN_ERR_IF_APP(rc, getDbVersion(db, &version), rc);
+
+    int progressVersion;
+    long cursor;
+    RETURN_ERR_IF_APP(rc, getUpdateProgress(db, &progressVersion, &cursor), rc);
+
+    int stepCount = sizeof(updateSteps) / sizeof(updateSteps[0]);
+
+    for (int i = 0; i < stepCount; i++) {
+        if (updateSteps[i].version <= version) {
+            continue;
+        }
+
+        if (updateSteps[i].version == progressVersion) {
+            // Schema's already done, so only need to finish the batches.
+            RETURN_ERR_IF_APP(rc, runUpdateBatches(db, &updateSteps[i], cursor), rc);
+            continue;
+        }
+
+        RETURN_ERR_IF_APP(rc, runUpdateStep(db, &updateSteps[i]), rc);
+    }
+
+    // In case a bulk import dropped them and never finished.
+    RETURN_ERR_IF_APP(rc, createIndexes(db), rc);
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Run a single update step from the start.  The schema changes are one
+ * transaction, which also either sets the new version or (if there are
+ * batches to run) records that the step is in progress, so the database is
+ * never left with a half-applied schema.
+ *
+ * @param   step
+ */
+static char runUpdateStep(DbHandle *db, DbUpdateStep *step)
+{
+    char rc;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, "BEGIN IMMEDIATE;"), DB_INTERFACE__DB_ERROR)
+
+    if (step->schema != NULL && (rc = step->schema(db))) {
+        execStr(db, "ROLLBACK;");
+        return rc;
+    }
+
+    if (step->batch != NULL) {
+        rc = setUpdateProgress(db, step->version, 0);
+    } else {
+        rc = setDbVersion(db, step->version);
+    }
+
+    if (rc) {
+        execStr(db, "ROLLBACK;");
+        return rc;
+    }
+
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, "COMMIT;"), DB_INTERFACE__DB_ERROR)
+
+    if (step->batch != NULL) {
+        return runUpdateBatches(db, step, 0);
+    }
+
+    if (updateCallback != NULL) {
+        updateCallback(step->version, step->desc, 0, secondsSince(&start), 1);
+    }
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Run the batches of an update step, one transaction each, starting after
+ * `cursor`.  Every transaction saves the cursor along with the rows it
+ * rewrote, so an interruption only loses the batch that was running.
+ *
+ * @param   step
+ * @param   cursor  Where the batch function left off (zero to start).
+ */
+static char runUpdateBatches(DbHandle *db, DbUpdateStep *step, long cursor)
+{
+    char rc;
+    char done = 0;
+    long rows = 0;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (!done) {
+        RETURN_ERR_IF_APP(db->dbRc, execStr(db, "BEGIN IMMEDIATE;"), DB_INTERFACE__DB_ERROR)
+
+        if ((rc = step->batch(db, &cursor, &rows, &done))) {
+            execStr(db, "ROLLBACK;");
+            return rc;
+        }
+
+        if (done) {
+            if (!(rc = clearUpdateProgress(db))) {
+                rc = setDbVersion(db, step->version);
+            }
+        } else {
+            rc = setUpdateProgress(db, step->version, cursor);
+        }
+
+        if (rc) {
+            execStr(db, "ROLLBACK;");
+            return rc;
+        }
+
+        RETURN_ERR_IF_APP(db->dbRc, execStr(db, "COMMIT;"), DB_INTERFACE__DB_ERROR)
+
+        if (updateCallback != NULL) {
+            updateCallback(step->version, step->desc, rows, secondsSince(&start), done);
+        }
+    }
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Get the version number of the database from the meta table.
+ *
+ * @param   version Result passed back by argument.
+ */
+static char getDbVersion(DbHandle *db, int *version)
+{
+    char rc;
+    char tf;
+    RETURN_ERR_IF_APP(rc, doesDatabaseExist(db, &tf), rc);
+
+    if (!tf) {
+        // Nothing's been created yet.
+        *version = 0;
+        return DB_INTERFACE__OK;
+    }
+
+    sqlite3_stmt *stmt;
+
+    char *sqldum = "SELECT value FROM meta WHERE name = 'version';";
+
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sqldum, &stmt), DB_INTERFACE__DB_ERROR)
+
+    db->dbRc = sqlite3_step(stmt);
+
+    if (db->dbRc != SQLITE_ROW) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    // The value is text, so it needs to be converted, not cast.
+    *version = atoi((const char *) sqlite3_column_text(stmt, 0));
+
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Set the version number of the database in the meta table.
+ *
+ * @param   version
+ */
+static char setDbVersion(DbHandle *db, int version)
+{
+    sqlite3_stmt *stmt;
+
+    char *sqldum = "UPDATE meta SET value = ? WHERE name = 'version';";
+
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sqldum, &stmt), DB_INTERFACE__DB_ERROR)
+
+    char versionStr[12];
+    snprintf(versionStr, sizeof(versionStr), "%d", version);
+
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_text(stmt, 1, versionStr, -1, 0),
+        DB_INTERFACE__DB_ERROR)
+
+    if ((db->dbRc = sqlite3_step(stmt)) != SQLITE_DONE) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Get the version and cursor of an update step that's in progress.  Version is
+ * zero if none is.
+ *
+ * @param   version Result passed back by argument.
+ * @param   cursor  Result passed back by argument.
+ */
+static char getUpdateProgress(DbHandle *db, int *version, long *cursor)
+{
+    *version = 0;
+    *cursor = 0;
+
+    char rc;
+    char tf;
+    RETURN_ERR_IF_APP(rc, doesDatabaseExist(db, &tf), rc);
+
+    if (!tf) {
+        return DB_INTERFACE__OK;
+    }
+
+    sqlite3_stmt *stmt;
+
+    char *sqldum = "SELECT value FROM meta WHERE name = 'update_progress';";
+
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sqldum, &stmt), DB_INTERFACE__DB_ERROR)
+
+    db->dbRc = sqlite3_step(stmt);
+
+    if (db->dbRc == SQLITE_ROW) {
+        // Stored as "version:cursor".
+        sscanf((const char *) sqlite3_column_text(stmt, 0), "%d:%ld", version, cursor);
+    } else if (db->dbRc != SQLITE_DONE) {
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Record that an update step is in progress and where its batches left off.
+ *
+ * @param   version
+ * @param   cursor
+ */
+static char setUpdateProgress(DbHandle *db, int version, long cursor)
+{
+    char rc;
+    RETURN_ERR_IF_APP(rc, clearUpdateProgress(db), rc);
+
+    sqlite3_stmt *stmt;
+
+    char *sqldum = "INSERT INTO meta(name, desc, value) VALUES("
+        " 'update_progress',"
+        " 'Version and cursor of an update that is in progress.',"
+        " ?"
+    ");";
+
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sqldum, &stmt), DB_INTERFACE__DB_ERROR)
+
+    char progressStr[36];
+    snprintf(progressStr, sizeof(progressStr), "%d:%ld", version, cursor);
+
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_text(stmt, 1, progressStr, -1, 0),
+        DB_INTERFACE__DB_ERROR)
+
+    if ((db->dbRc = sqlite3_step(stmt)) != SQLITE_DONE) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Remove the record of an update step in progress.
+ */
+static char clearUpdateProgress(DbHandle *db)
+{
+    sqlite3_stmt *stmt;
+
+    char *sqldum = "DELETE FROM meta WHERE name = 'update_progress';";
+
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sqldum, &stmt), DB_INTERFACE__DB_ERROR)
+
+    if ((db->dbRc = sqlite3_step(stmt)) != SQLITE_DONE) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Seconds since the start time, for reporting how long updates take.
+ *
+ * @param   start
+ */
+static double secondsSince(struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Check if there is a database to update.  Pointer is pointed to result.
+ * Returns return code.
+ *
+ * @param   result
+ */
+static char doesDatabaseExist(DbHandle *db, char *result)
+{
+    sqlite3_stmt *stmt;
+
+    char *sqldum = "SELECT count(*) as count FROM sqlite_master \
+    WHERE type='table' AND name=?";
+
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sqldum, &stmt), DB_INTERFACE__DB_ERROR)
+
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_text(stmt, 1, "meta", -1, 0),
+        DB_INTERFACE__DB_ERROR)
+
+    db->dbRc = sqlite3_step(stmt);
+
+    if(db->dbRc != SQLITE_ROW) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
+
+    *result = sqlite3_column_int(stmt, 0);
+
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
+}
+
+/**
+ * Create version 1 of database.
+ */
+static char createDbV1(DbHandle *db)
 {
-    return sqlite3_prepare_v2(dbFile, str, -1, stmtptr, 0);
+    char *sqldum;
+
+    // Create meta table.
+    sqldum = "CREATE TABLE meta("
+        " name TEXT NOT NULL,"
+        " desc TEXT NOT NULL,"
+        " value TEXT NOT NULL"
+    ");";
+
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, sqldum), DB_INTERFACE__DB_ERROR)
+
+    // Put version into meta table.
+    sqldum = "INSERT INTO meta("
+        " name,"
+        " desc,"
+        " value"
+    ") VALUES("
+        " \"version\","
+        " \"The version number.\","
+        " \"1\""
+    ");";
+
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, sqldum), DB_INTERFACE__DB_ERROR)
+
+    // Create planner_items table.
+    sqldum = "CREATE TABLE items("
+        " id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        " date INTEGER NOT NULL,"
+        " desc TEXT,"
+        " rep INTEGER NOT NULL,"
+        " del INTEGER NOT NULL"
+    ");";
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, sqldum), DB_INTERFACE__DB_ERROR)
+
+    sqldum = "CREATE INDEX idx_date ON items(date);";
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, sqldum), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
 }
 
 /**
- * Helper function for quickly executing statements (that don't need
- * parameters).
+ * Update database to version 2.
  *
- * @param   strInp
- * @return  int
+ * Replaces idx_date with an index on (rep, date) that only has live rows, so
+ * soft-deleted rows don't make lookups slower and the yearly rows (which all
+ * have small dates) don't get mixed up with everything else in 2001.  It also
+ * has id and desc, so every query in this module can be answered from the
+ * index alone.
  */
-static int execStr(char *strInp)
+static char updateDbV2(DbHandle *db)
 {
-    return sqlite3_exec(dbFile, strInp, 0, 0, NULL);
+    char rc;
+    RETURN_ERR_IF_APP(rc, createIndexes(db), rc);
+
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, "DROP INDEX idx_date;"), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
 }
 
 /**
- * Save a new record to the database, and save the id.  Returns rc.
+ * Update database to version 3, one batch at a time.
  *
- * @param   item    A PlannerItem pointer.
+ * saveExisting used to save yearly items with the full date instead of
+ * reducing it, which made them disappear, since they're only looked up by
+ * the reduced date.  This reduces them, going through the table by id.
+ *
+ * @param   cursor  Last id from the previous batch.  Set to the last id of
+ *  this one.
+ * @param   rows    Incremented by the number of rows rewritten.
+ * @param   done    Set to true when there are no rows left.
  */
-static char saveNew(PlannerItem *item)
+static char updateDbV3(DbHandle *db, long *cursor, long *rows, char *done)
 {
-    char *insertRow = "INSERT INTO items(date, desc, rep, del) \
-        VALUES (?, ?, ?, 0);";
-
     sqlite3_stmt *stmt;
 
-    RETURN_ERR_IF_APP(dbRc, prepStat(insertRow, &stmt), DB_INTERFACE__DB_ERROR)
+    char *sqldum = "SELECT max(id) FROM"
+        " (SELECT id FROM items WHERE id > ? ORDER BY id LIMIT ?);";
 
-    int bindints[4];
-    bindints[0] = 1;
-    bindints[1] = reduceIntDate(toInt(item->date), item->rep);
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sqldum, &stmt), DB_INTERFACE__DB_ERROR)
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int64(stmt, 1, *cursor),
+        DB_INTERFACE__DB_ERROR)
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int64(stmt, 2, updateBatchSize),
+        DB_INTERFACE__DB_ERROR)
 
-    bindints[2] = 3;
-    bindints[3] = item->rep;
+    if ((db->dbRc = sqlite3_step(stmt)) != SQLITE_ROW) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
 
-    for (int i = 0; i < 4; i += 2) {
-        RETURN_ERR_IF_APP(dbRc, sqlite3_bind_int(stmt, bindints[i], bindints[i+1]),
-            DB_INTERFACE__DB_ERROR)
+    if (sqlite3_column_type(stmt, 0) == SQLITE_NULL) {
+        *done = 1;
+        RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+        return DB_INTERFACE__OK;
     }
 
-    RETURN_ERR_IF_APP(dbRc, sqlite3_bind_text(stmt, 2, item->desc, -1, 0),
-        DB_INTERFACE__DB_ERROR);
+    long last = sqlite3_column_int64(stmt, 0);
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    sqldum = "UPDATE items SET date = date % ?1"
+        " WHERE rep = ?2 AND date >= ?1 AND id > ?3 AND id <= ?4;";
+
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sqldum, &stmt), DB_INTERFACE__DB_ERROR)
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int(stmt, 1, toInt(buildDate(1, 0, 0))),
+        DB_INTERFACE__DB_ERROR)
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int(stmt, 2, REP_YEARLY),
+        DB_INTERFACE__DB_ERROR)
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int64(stmt, 3, *cursor),
+        DB_INTERFACE__DB_ERROR)
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int64(stmt, 4, last),
+        DB_INTERFACE__DB_ERROR)
 
-    if ((dbRc = sqlite3_step(stmt) != SQLITE_DONE)) {
+    if ((db->dbRc = sqlite3_step(stmt)) != SQLITE_DONE) {
+        releaseStat(stmt);
         return DB_INTERFACE__DB_ERROR;
     }
 
-    long iddum;
-    iddum = sqlite3_last_insert_rowid(dbFile);
-
-    item->id = iddum;
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
 
-    RETURN_ERR_IF_APP(dbRc, sqlite3_finalize(stmt), DB_INTERFACE__DB_ERROR)
+    *rows += sqlite3_changes(db->dbFile);
+    *cursor = last;
 
     return DB_INTERFACE__OK;
 }
 
 /**
- * Save an existing record to the database.
+ * Update database to version 4: add a full-text index of the descriptions of
+ * live items, for db_interface_search.
  *
- * @param   item    A PlannerItem pointer.
+ * It's an FTS5 table that reads the text from the live items instead of keeping
+ * its own copy.  Triggers keep it up to date from here on, for every way that
+ * items are written, and updateDbV4 adds the items that are already there.
+ * Deleted items are left out, so a soft delete takes an item out of the index.
  */
-static char saveExisting(PlannerItem *item)
+static char updateDbV4Schema(DbHandle *db)
 {
-    char *updateRow = "UPDATE items SET date = ?, desc = ?, rep = ? WHERE id = ?;";
+    // Reading from a view of the live items means the index matches what it
+    // reads from, so FTS5's integrity check and rebuild work.
+    char *sqldum = "CREATE VIEW live_items AS"
+        " SELECT id, desc FROM items WHERE del = 0;";
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, sqldum), DB_INTERFACE__DB_ERROR)
+
+    sqldum = "CREATE VIRTUAL TABLE items_fts USING fts5("
+        " desc, content = 'live_items', content_rowid = 'id',"
+        " tokenize = 'unicode61 remove_diacritics 2'"
+    ");";
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, sqldum), DB_INTERFACE__DB_ERROR)
+
+    // The index can only have an entry taken out with the exact text that went
+    // in, so the update trigger uses the old row's.
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, searchInsertTrigger), DB_INTERFACE__DB_ERROR)
+
+    sqldum = "CREATE TRIGGER items_fts_update AFTER UPDATE OF desc, del ON items BEGIN"
+        " INSERT INTO items_fts(items_fts, rowid, desc)"
+        "  SELECT 'delete', old.id, old.desc WHERE old.del = 0;"
+        " INSERT INTO items_fts(rowid, desc)"
+        "  SELECT new.id, new.desc WHERE new.del = 0;"
+        " END;"
+        "CREATE TRIGGER items_fts_delete AFTER DELETE ON items"
+        " WHEN old.del = 0 BEGIN"
+        " INSERT INTO items_fts(items_fts, rowid, desc)"
+        "  VALUES ('delete', old.id, old.desc);"
+        " END;";
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, sqldum), DB_INTERFACE__DB_ERROR)
+
+    // Anything after the last id now gets indexed by the triggers, so the
+    // batches have to stop there, even if they're resumed later.
+    sqldum = "INSERT INTO meta(name, desc, value)"
+        " SELECT 'search_backfill', 'Last id that updating to version 4 indexes.',"
+        " coalesce(max(id), 0) FROM items;";
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, sqldum), DB_INTERFACE__DB_ERROR)
 
-    sqlite3_stmt *stmt;
+    return DB_INTERFACE__OK;
+}
 
-    RETURN_ERR_IF_APP(dbRc, prepStat(updateRow, &stmt), DB_INTERFACE__DB_ERROR)
+/**
+ * Update database to version 4, one batch at a time.  Adds the live items
+ * that were there before the triggers to the search index, going through the
+ * table by id.  See updateDbV4Schema.
+ *
+ * @param   cursor  Last id from the previous batch.  Set to the last id of
+ *  this one.
+ * @param   rows    Incremented by the number of rows indexed.
+ * @param   done    Set to true when there are no rows left.
+ */
+static char updateDbV4(DbHandle *db, long *cursor, long *rows, char *done)
+{
+    sqlite3_stmt *stmt;
 
-    int bindints[6];
-    bindints[0] = 1;
-    bindints[1] = toInt(item->date);
+    char *sqldum = "SELECT max(id) FROM"
+        " (SELECT id FROM items WHERE id > ? AND id <="
+        "  (SELECT CAST(value AS INTEGER) FROM meta WHERE name = 'search_backfill')"
+        " ORDER BY id LIMIT ?);";
 
-    bindints[2] = 3;
-    bindints[3] = item->rep;
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sqldum, &stmt), DB_INTERFACE__DB_ERROR)
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int64(stmt, 1, *cursor),
+        DB_INTERFACE__DB_ERROR)
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int64(stmt, 2, updateBatchSize),
+        DB_INTERFACE__DB_ERROR)
 
-    bindints[4] = 4;
-    bindints[5] = item->id;
+    if ((db->dbRc = sqlite3_step(stmt)) != SQLITE_ROW) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
 
-    for (int i = 0; i < 6; i += 2) {
-        RETURN_ERR_IF_APP(dbRc, sqlite3_bind_int(stmt, bindints[i], bindints[i+1]),
+    if (sqlite3_column_type(stmt, 0) == SQLITE_NULL) {
+        *done = 1;
+        RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+        RETURN_ERR_IF_APP(db->dbRc,
+            execStr(db, "DELETE FROM meta WHERE name = 'search_backfill';"),
             DB_INTERFACE__DB_ERROR)
+        return DB_INTERFACE__OK;
     }
 
-    RETURN_ERR_IF_APP(dbRc, sqlite3_bind_text(stmt, 2, item->desc, -1, 0),
+    long last = sqlite3_column_int64(stmt, 0);
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    sqldum = "INSERT INTO items_fts(rowid, desc) SELECT id, desc FROM items"
+        " WHERE del = 0 AND id > ? AND id <= ?;";
+
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sqldum, &stmt), DB_INTERFACE__DB_ERROR)
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int64(stmt, 1, *cursor),
+        DB_INTERFACE__DB_ERROR)
+    RETURN_ERR_IF_APP(db->dbRc, sqlite3_bind_int64(stmt, 2, last),
         DB_INTERFACE__DB_ERROR)
 
-    if ((dbRc = sqlite3_step(stmt) != SQLITE_DONE)) {
+    if ((db->dbRc = sqlite3_step(stmt)) != SQLITE_DONE) {
+        releaseStat(stmt);
         return DB_INTERFACE__DB_ERROR;
     }
 
-    RETURN_ERR_IF_APP(dbRc, sqlite3_finalize(stmt), DB_INTERFACE__DB_ERROR);
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    *rows += sqlite3_changes(db->dbFile);
+    *cursor = last;
 
     return DB_INTERFACE__OK;
 }
 
 /**
- * Iterate over PlannerItem pointers from where clause and the integers to be
- * bound to it.  (This assumes only integers will be bound.)
- *
- * Results dumped into `result` argument one at a time.  Returns
- * DB_INTERFACE__CONT if there are more results to be retrieved, or
- * DB_INTERFACE__OK when done.  Sets result to NULL if there's nothing to do.
- *
- * Helper method for db_interface_get and db_interface_range.
- *
- * @param   result
- *  Result passed back by argument.  If this is null (not what it points to),
- *  then this was intentionally passed just to close the argument.
- * @param   where
- *  WHERE clause, including ?s.
- * @param   values
- *  Array of integers to bind.
- * @param   count
- *  Number of integers to bind (i.e., count of "values").
+ * Update database to version 5: record when items are deleted, for
+ * db_interface_purge.  Items deleted before this have no time, and count as
+ * older than any retention window.  The index only has deleted rows, so it
+ * stays small and costs live rows nothing.
  */
-static char getFromWhere(PlannerItem **result, char *where, int *values, int count)
+static char updateDbV5Schema(DbHandle *db)
 {
-    char rc;
+    char *sqldum = "ALTER TABLE items ADD COLUMN deleted_at INTEGER;"
+        "CREATE INDEX idx_deleted ON items(deleted_at) WHERE del = 1;";
 
-    static sqlite3_stmt *stmtGfw = NULL;
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, sqldum), DB_INTERFACE__DB_ERROR)
 
-    if (stmtGfw == NULL) {
-        RETURN_ERR_IF_APP(rc, getFromWherePrepare(&stmtGfw, where, values, count), rc)
-    }
+    return DB_INTERFACE__OK;
+}
 
-    dbRc = sqlite3_step(stmtGfw);
+/**
+ * Create the indexes for the current version of the database, if they don't
+ * exist already.
+ */
+static char createIndexes(DbHandle *db)
+{
+    // Having del on the end seems redundant, but older versions of SQLite
+    // don't count the index as covering without it.
+    char *sqldum = "CREATE INDEX IF NOT EXISTS idx_live_rep_date"
+        " ON items(rep, date, id, desc, del) WHERE del = 0;";
 
-    if (dbRc == SQLITE_DONE) {
-        // If SQLITE_DONE is returned, that means that it's *already* returned
-        // the final row.
-        // Note that if SQLITE_DONE is returned on first row, that means that
-        // there were no records found, so the *first* result is null.
-        if (result != NULL) {
-            // If result *itself* is null, then that was intentionally passed
-            // just to close the statement.
-            *result = NULL;
-        }
-        dbRc = sqlite3_finalize(stmtGfw);
-        stmtGfw = NULL;
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, sqldum), DB_INTERFACE__DB_ERROR)
 
-        if (dbRc) {
-            return DB_INTERFACE__DB_ERROR;
-        }
+    return catchUpSearchIndex(db);
+}
 
-        return DB_INTERFACE__OK;
-    }
+/**
+ * Add the items inserted since db_interface_drop_indexes to the search index,
+ * and start adding new ones again.  Does nothing if the search index isn't
+ * behind.
+ */
+static char catchUpSearchIndex(DbHandle *db)
+{
+    sqlite3_stmt *stmt;
+
+    char *sqldum = "SELECT count(*) FROM meta WHERE name = 'search_unindexed';";
+
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sqldum, &stmt), DB_INTERFACE__DB_ERROR)
 
-    if (dbRc != SQLITE_ROW) {
+    if ((db->dbRc = sqlite3_step(stmt)) != SQLITE_ROW) {
+        releaseStat(stmt);
         return DB_INTERFACE__DB_ERROR;
     }
 
-    if (result == NULL) {
-        // This means a null pointer was passed when it wasn't ready to close.
-        return DB_INTERFACE__INTERNAL;
+    int behind = sqlite3_column_int(stmt, 0);
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
+
+    if (!behind) {
+        return DB_INTERFACE__OK;
     }
 
-    pfRc = buildItem(
-        result,
-        sqlite3_column_int(stmtGfw, 0),
-        toDate(sqlite3_column_int(stmtGfw, 1)),
-        (char *) sqlite3_column_text(stmtGfw, 2),
-        sqlite3_column_int(stmtGfw, 3)
-    );
+    // Merging segments as they're written is wasted on a bulk insert, since
+    // the later ones get merged again anyway.  Turned off just for this
+    // (4 is FTS5's default), and merged as things are saved from then on.
+    sqldum = "INSERT INTO items_fts(items_fts, rank) VALUES ('automerge', 0);"
+        "INSERT INTO items_fts(rowid, desc) SELECT id, desc FROM live_items"
+        " WHERE id > (SELECT CAST(value AS INTEGER) FROM meta"
+        "  WHERE name = 'search_unindexed');"
+        "INSERT INTO items_fts(items_fts, rank) VALUES ('automerge', 4);"
+        "DELETE FROM meta WHERE name = 'search_unindexed';";
 
-    if (pfRc != PLANNER_STATUS__OK) {
-        sqlite3_finalize(stmtGfw); // Don't bother with RC here.
-        stmtGfw = NULL;
-        freeItem(*result); // Result can't be trusted.
-        result = NULL;
-        return DB_INTERFACE__PLANNER;
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, "BEGIN IMMEDIATE;"), DB_INTERFACE__DB_ERROR)
+
+    if ((db->dbRc = execStr(db, sqldum)) || (db->dbRc = execStr(db, searchInsertTrigger))) {
+        execStr(db, "ROLLBACK;");
+        return DB_INTERFACE__DB_ERROR;
     }
 
-    return DB_INTERFACE__CONT;
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, "COMMIT;"), DB_INTERFACE__DB_ERROR)
+
+    return DB_INTERFACE__OK;
 }
 
 /**
- * Prepare statement for getFromWhere.  Helper function for getFromWhere.
+ * Remove one batch of deleted rows for db_interface_purge, in its own
+ * transaction.  They're found with idx_deleted, taking the ones without a
+ * time first.  The search index doesn't have deleted rows, so it's left alone.
  *
- * @param   stmtGfw The SQLite statement object.
- * @param   where   Directly passed by getFromWhere.
- * @param   values  Directly passed by getFromWhere.
- * @param   count   Directly passed by getFromWhere.
+ * @param   cutoff  Remove rows deleted at or before this Unix time.
+ * @param   rows    Set to the number of rows removed.
  */
-static char getFromWherePrepare(sqlite3_stmt **stmtGfw, char *where, int *values, int count)
+static char purgeBatch(DbHandle *db, long cutoff, long *rows)
 {
-    // Build SQL.
-
-    char *sqldum = "SELECT id,date,desc,rep FROM items WHERE del = 0 AND (";
-    // Not using "SELECT *" because the columns are only identified by
-    // number, so explicitly naming the columns makes it more future-proof
-    // and easier to update.
-
-    char sql[strlen(sqldum) + strlen(where) + 3]; // Semicol, closing paren, and null term.
-    strcpy(sql, sqldum);
-    strcat(sql, where);
-    strcat(sql, ");");
+    sqlite3_stmt *stmt = NULL;
+
+    char *sqldum = "DELETE FROM items WHERE id IN (SELECT id FROM items"
+        " WHERE (del = 1 AND deleted_at IS NULL)"
+        " OR (del = 1 AND deleted_at <= ?) LIMIT ?);";
+
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, "BEGIN IMMEDIATE;"), DB_INTERFACE__DB_ERROR)
+
+    if ((db->dbRc = prepStat(db, sqldum, &stmt))
+        || (db->dbRc = sqlite3_bind_int64(stmt, 1, cutoff))
+        || (db->dbRc = sqlite3_bind_int64(stmt, 2, purgeBatchSize))
+        || (db->dbRc = sqlite3_step(stmt)) != SQLITE_DONE
+        || (db->dbRc = releaseStat(stmt))
+    ) {
+        sqlite3_reset(stmt);
+        execStr(db, "ROLLBACK;");
+        return DB_INTERFACE__DB_ERROR;
+    }
 
-    RETURN_ERR_IF_APP(dbRc, prepStat(sql, stmtGfw), DB_INTERFACE__DB_ERROR)
+    *rows = sqlite3_changes(db->dbFile);
 
-    for (int i = 0; i < count; i++) {
-        // https://sqlite.org/c3ref/bind_blob.html
-        RETURN_ERR_IF_APP(dbRc, sqlite3_bind_int(*stmtGfw, i + 1, values[i]),
-            DB_INTERFACE__DB_ERROR);
-    }
+    RETURN_ERR_IF_APP(db->dbRc, execStr(db, "COMMIT;"), DB_INTERFACE__DB_ERROR)
 
     return DB_INTERFACE__OK;
 }
 
 /**
- * Set error string from database error.
+ * Get the number from a pragma that returns one, like page_count.
  *
- * @param   str     HEAP.  Pointer to string.
- * @param   code
+ * @param   sql
+ * @param   value
  */
-static char db_interface_build_err__db(char **str)
+static char getPragma(DbHandle *db, char *sql, long *value)
 {
-    char *fmt = "Database error: %d. ";
-
-    int strlen01 = snprintf(NULL, 0, fmt, dbRc);
+    sqlite3_stmt *stmt;
 
-    int dbCode = sqlite3_errcode(dbFile);
-    // This is not reliable-- In some cases, it will return zero, so...
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sql, &stmt), DB_INTERFACE__DB_ERROR)
 
-    char *dbMsg;
-    if (dbCode) {
-        // ...if it's nonzero, we go ahead and use it, because the message is
-        // more detailed this way, but...
-        dbMsg = (char *) sqlite3_errmsg(dbFile);
-    } else {
-        // ...if it's zero, we use the description according to the code.
-        dbMsg = (char *) sqlite3_errstr(dbRc);
+    if ((db->dbRc = sqlite3_step(stmt)) != SQLITE_ROW) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
     }
 
-    int sizedum = strlen01 + strlen(dbMsg) + 1;
-    *str = malloc(sizedum);
-
-    if (str == NULL) {
-        return DB_INTERFACE__OUT_OF_MEMORY;
-    }
+    *value = sqlite3_column_int64(stmt, 0);
 
-    snprintf(*str, sizedum, fmt, dbRc);
-    strcat(*str, dbMsg);
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
 
     return DB_INTERFACE__OK;
 }
 
 /**
- * Set error string for interface error.
+ * Index of a setting in tuningSettings, or -1 if it can't be tuned.
  *
- * @param   str     HEAP.  Pointer to string.
- * @param   code
+ * @param   name
  */
-static char db_interface_build_err__ifce(char **str, int code)
+static int findTuningSetting(char *name)
 {
-    char *strdum;
-
-    switch (code) {
-        case DB_INTERFACE__OK:
-            strdum = "No error for db interface.";
-            break;
-        case DB_INTERFACE__OUT_OF_MEMORY:
-            strdum = "Out of memory or db interface.";
-            break;
-        case DB_INTERFACE__CONT:
-            strdum = "No error: Continue.";
-            break;
-        case DB_INTERFACE__INTERNAL:
-            strdum = "Coding problem inside this class.";
-            break;
-        default:
-            strdum = "Unknown error for db interface.";
+    for (int i = 0; i < TUNING_COUNT; i++) {
+        if (strcmp(tuningSettings[i].name, name) == 0) {
+            return i;
+        }
     }
 
-    *str = malloc(strlen(strdum) + 1);
+    return -1;
+}
 
-    if (str == NULL) {
-        return DB_INTERFACE__OUT_OF_MEMORY;
-    }
+/**
+ * Index of a profile in tuningProfiles, or -1 if there's no such profile.
+ *
+ * @param   name
+ */
+static int findTuningProfile(char *name)
+{
+    int count = sizeof(tuningProfiles) / sizeof(tuningProfiles[0]);
 
-    strcpy(*str, strdum);
+    for (int i = 0; i < count; i++) {
+        if (strcmp(tuningProfiles[i].name, name) == 0) {
+            return i;
+        }
+    }
 
-    return DB_INTERFACE__OK;
+    return -1;
 }
 
-
-// Database update functions.
-
 /**
- * Update database to latest version.
+ * Check that a value is one the setting allows.  Since it ends up in the
+ * pragma as is, anything that isn't a listed word or a plain number is
+ * rejected.  Returns DB_INTERFACE__BAD_TUNING if it isn't allowed.
+ *
+ * @param   setting Index in tuningSettings.
+ * @param   value
  */
-static char updateDatabase()
+static char checkTuningValue(int setting, char *value)
 {
-    char rc; // Will be from this module's constants.  (Can return.)
+    if (strlen(value) >= TUNING_VALUE_SIZE) {
+        return DB_INTERFACE__BAD_TUNING;
+    }
 
-    char tf;
-    rc = doesDatabaseExist(&tf);
+    char **allowed = tuningSettings[setting].allowed;
 
-    RETURN_ERR_IF_APP(rc, doesDatabaseExist(&tf), rc);
+    if (allowed != NULL) {
+        for (int i = 0; allowed[i] != NULL; i++) {
+            if (strcasecmp(allowed[i], value) == 0) {
+                return DB_INTERFACE__OK;
+            }
+        }
 
-    if (!tf) {
-        RETURN_ERR_IF_APP(rc, createDbV1(), rc);
+        return DB_INTERFACE__BAD_TUNING;
     }
 
-    // When need newer database versions, will want some kind of "get database
-    // version" function with cascading updates based on the version number.
-    // The "value" in the database's meta table is text, though, so will need to
-    // use one of those functions to convert c strings to int.  (Remember, can't
-    // just do it through casting.)
+    // Out of range would be clamped here, but passed on to the pragma as is.
+    char *end;
+    errno = 0;
+    long long number = strtoll(value, &end, 10);
+
+    if (*value == '\0' || *end != '\0' || errno == ERANGE
+        || number < tuningSettings[setting].min
+    ) {
+        return DB_INTERFACE__BAD_TUNING;
+    }
 
     return DB_INTERFACE__OK;
 }
 
 /**
- * Check if there is a database to update.  Pointer is pointed to result.
- * Returns return code.
+ * Read the tuning saved in the meta table, if there is one yet.  Values that
+ * aren't allowed are skipped, so a typo can't stop the database from opening.
  *
- * @param   result
+ * @param   profile Set to the profile's index, if one is saved.
+ * @param   values  Set to the values saved for each setting.
  */
-static char doesDatabaseExist(char *result)
+static char readMetaTuning(DbHandle *db, int *profile, char values[][TUNING_VALUE_SIZE])
 {
+    char rc;
+    char exists;
+    RETURN_ERR_IF_APP(rc, doesDatabaseExist(db, &exists), rc)
+
+    if (!exists) {
+        return DB_INTERFACE__OK;
+    }
+
     sqlite3_stmt *stmt;
 
-    char *sqldum = "SELECT count(*) as count FROM sqlite_master \
-    WHERE type='table' AND name=?";
+    char *sqldum = "SELECT name, value FROM meta WHERE name GLOB 'tuning_*';";
 
-    RETURN_ERR_IF_APP(dbRc, prepStat(sqldum, &stmt), DB_INTERFACE__DB_ERROR)
+    RETURN_ERR_IF_APP(db->dbRc, prepStat(db, sqldum, &stmt), DB_INTERFACE__DB_ERROR)
 
-    RETURN_ERR_IF_APP(dbRc, sqlite3_bind_text(stmt, 1, "meta", -1, 0),
-        DB_INTERFACE__DB_ERROR)
+    while ((db->dbRc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        char *name = (char *) sqlite3_column_text(stmt, 0) + strlen("tuning_");
+        char *value = (char *) sqlite3_column_text(stmt, 1);
+
+        if (strcmp(name, "profile") == 0) {
+            int found = findTuningProfile(value);
+            if (found >= 0) {
+                *profile = found;
+            }
+            continue;
+        }
 
-    dbRc = sqlite3_step(stmt);
+        int setting = findTuningSetting(name);
 
-    if(dbRc != SQLITE_ROW) {
-        return DB_INTERFACE__DB_ERROR;
+        if (setting >= 0 && !checkTuningValue(setting, value)) {
+            strcpy(values[setting], value);
+        }
     }
 
-    *result = sqlite3_column_int(stmt, 0);
+    if (db->dbRc != SQLITE_DONE) {
+        releaseStat(stmt);
+        return DB_INTERFACE__DB_ERROR;
+    }
 
-    RETURN_ERR_IF_APP(dbRc, sqlite3_finalize(stmt), DB_INTERFACE__DB_ERROR)
+    RETURN_ERR_IF_APP(db->dbRc, releaseStat(stmt), DB_INTERFACE__DB_ERROR)
 
     return DB_INTERFACE__OK;
 }
 
 /**
- * Create version 1 of database.
+ * Set the tuning pragmas on the connection.  Each one comes from the first
+ * of: db_interface_set_tuning, the meta table, and the profile.  The profile
+ * comes from db_interface_set_profile, the meta table, or is the default.
  */
-static char createDbV1()
+static char applyTuning(DbHandle *db)
 {
-    char *sqldum;
+    char rc;
+    int profile = 0;
+    char values[TUNING_COUNT][TUNING_VALUE_SIZE] = {{0}};
 
-    // Create meta table.
-    sqldum = "CREATE TABLE meta("
-        " name TEXT NOT NULL,"
-        " desc TEXT NOT NULL,"
-        " value TEXT NOT NULL"
-    ");";
+    RETURN_ERR_IF_APP(rc, readMetaTuning(db, &profile, values), rc)
 
-    RETURN_ERR_IF_APP(dbRc, execStr(sqldum), DB_INTERFACE__DB_ERROR)
+    if (tuningProfile >= 0) {
+        profile = tuningProfile;
+    }
 
-    // Put version into meta table.
-    sqldum = "INSERT INTO meta("
-        " name,"
-        " desc,"
-        " value"
-    ") VALUES("
-        " \"version\","
-        " \"The version number.\","
-        " \"1\""
-    ");";
+    char sql[256];
 
-    RETURN_ERR_IF_APP(dbRc, execStr(sqldum), DB_INTERFACE__DB_ERROR)
+    for (int i = 0; i < TUNING_COUNT; i++) {
+        char *value = tuningProfiles[profile].values[i];
 
-    // Create planner_items table.
-    sqldum = "CREATE TABLE items("
-        " id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        " date INTEGER NOT NULL,"
-        " desc TEXT,"
-        " rep INTEGER NOT NULL,"
-        " del INTEGER NOT NULL"
-    ");";
-    RETURN_ERR_IF_APP(dbRc, execStr(sqldum), DB_INTERFACE__DB_ERROR)
+        if (tuningOverrides[i][0] != '\0') {
+            value = tuningOverrides[i];
+        } else if (values[i][0] != '\0') {
+            value = values[i];
+        }
 
-    sqldum = "CREATE INDEX idx_date ON items(date);";
-    RETURN_ERR_IF_APP(dbRc, execStr(sqldum), DB_INTERFACE__DB_ERROR)
+        snprintf(sql, sizeof(sql), "PRAGMA %s = %s;", tuningSettings[i].name, value);
+
+        RETURN_ERR_IF_APP(db->dbRc, execStr(db, sql), DB_INTERFACE__DB_ERROR)
+    }
 
     return DB_INTERFACE__OK;
 }
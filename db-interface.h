@@ -13,32 +13,155 @@
 #define DB_INTERFACE__CONT          3
 #define DB_INTERFACE__PLANNER       4
 #define DB_INTERFACE__INTERNAL      5
+#define DB_INTERFACE__BAD_DATE      6
+#define DB_INTERFACE__BAD_TUNING    7
+
+// Types.
+
+/**
+ * An open database, with everything that goes with it.  Made by
+ * db_interface_initialize and passed to everything else, so any number can be
+ * open at once.  Only use one from one thread at a time.
+ */
+typedef struct db_handle DbHandle;
+
+/**
+ * Called while updating the database, after every batch of an update step and
+ * again when the step is done.
+ *
+ * @param   version Version that the step updates the database to.
+ * @param   desc    Description of the step.
+ * @param   rows    Rows rewritten by the step so far.
+ * @param   seconds Time spent on the step so far.
+ * @param   done    True if this is the last call for the step.
+ */
+typedef void (*DbUpdateCallback)(
+    int version,
+    char *desc,
+    long rows,
+    double seconds,
+    char done
+);
+
+/**
+ * Called with each item by the db_interface_each functions.  The view is only
+ * good until the callback returns, so copy anything that needs to be kept.
+ * Return non-zero to stop early.
+ *
+ * @param   item
+ * @param   ctx     Whatever was passed to the db_interface_each function.
+ */
+typedef char (*DbItemCallback)(PlannerItemView *item, void *ctx);
+
+/**
+ * A step for updating the database to a new version.  `schema` runs in one
+ * transaction.  `batch` (if there is one) runs after it, in as many
+ * transactions as it takes, and needs to rewrite at most `batchSize` rows
+ * after `cursor` each time.  Either can be NULL.
+ */
+typedef struct db_update_step {
+    int version;
+    char *desc;
+    char (*schema)(DbHandle *db);
+    char (*batch)(DbHandle *db, long *cursor, long *rows, char *done);
+} DbUpdateStep;
+
+typedef struct db_purge_stats {
+    /** @var Number of deleted rows removed for good. */
+    long rows;
+
+    /** @var Number of transactions they were removed in. */
+    long batches;
+
+    /** @var Number of pages the file shrank by. */
+    long pages;
+
+    /** @var Number of bytes the file shrank by. */
+    long bytes;
+
+    /** @var Time it took, including the vacuum. */
+    double seconds;
+} DbPurgeStats;
 
 
 // Functions.
 
-char db_interface_initialize(char *filename);
+char db_interface_initialize(DbHandle **dbptr, char *filename);
 
-char db_interface_finalize();
+char db_interface_finalize(DbHandle *db);
 
-sqlite3 *db_interface_get_db();
+sqlite3 *db_interface_get_db(DbHandle *db);
 
-char db_interface_save(PlannerItem *item);
+long db_interface_get_prepare_count(DbHandle *db);
 
-char db_interface_update_desc(long id, char *newdesc);
+void db_interface_set_week_cache_size(DbHandle *db, int weeks);
 
-char db_interface_delete(long id);
+long db_interface_get_week_cache_hits(DbHandle *db);
 
-int db_interface_get_db_err();
+long db_interface_get_week_cache_misses(DbHandle *db);
 
-char db_interface_build_err(char **str, int code);
+void db_interface_prefetch_weeks(DbHandle *db, Date *starts, int count);
 
-void _db_interface_create_db_err();
+void db_interface_cancel_prefetch(DbHandle *db);
 
-char db_interface_get(PlannerItem **result, int id);
+long db_interface_get_prefetched_weeks(DbHandle *db);
 
-char db_interface_range(PlannerItem **result, Date lower, Date upper);
+void db_interface_set_update_callback(DbUpdateCallback callback);
 
-char db_interface_day(PlannerItem **result, Date date01);
+char db_interface_set_profile(char *name);
+
+char db_interface_set_tuning(char *name, char *value);
+
+void db_interface_clear_tuning();
+
+void _db_interface_set_update_batch(long size);
+
+char db_interface_save(DbHandle *db, PlannerItem *item);
+
+char db_interface_save_many(DbHandle *db, PlannerItem *items, int count);
+
+char db_interface_begin(DbHandle *db);
+
+char db_interface_commit(DbHandle *db);
+
+char db_interface_rollback(DbHandle *db);
+
+char db_interface_drop_indexes(DbHandle *db);
+
+char db_interface_create_indexes(DbHandle *db);
+
+char db_interface_update_desc(DbHandle *db, long id, char *newdesc);
+
+char db_interface_delete(DbHandle *db, long id);
+
+char db_interface_purge(DbHandle *db, int retentionDays, DbPurgeStats *stats);
+
+void _db_interface_set_purge_batch(long size);
+
+long db_interface_changes(DbHandle *db);
+
+int db_interface_get_db_err(DbHandle *db);
+
+char db_interface_build_err(DbHandle *db, char **str, int code);
+
+void _db_interface_create_db_err(DbHandle *db);
+
+char db_interface_get(DbHandle *db, PlannerItem **result, int id);
+
+char db_interface_range(DbHandle *db, PlannerItem **result, Date lower, Date upper);
+
+char db_interface_day(DbHandle *db, PlannerItem **result, Date date01);
+
+char db_interface_week(DbHandle *db, PlannerItem **result, Date start, PlannerArena *arena);
+
+char db_interface_each(DbHandle *db, DbItemCallback callback, void *ctx);
+
+char db_interface_each_in_range(DbHandle *db, Date lower, Date upper, DbItemCallback callback, void *ctx);
+
+char db_interface_each_in_week(DbHandle *db, Date start, DbItemCallback callback, void *ctx);
+
+char db_interface_count_days(DbHandle *db, Date lower, Date upper, int *counts);
+
+char db_interface_search(DbHandle *db, char *text, int limit, DbItemCallback callback, void *ctx);
 
 #endif
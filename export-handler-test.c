@@ -0,0 +1,291 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "csv-handler.h"
+#include "date-functions.h"
+#include "db-interface.h"
+#include "export-handler.h"
+#include "ics-handler.h"
+#include "planner-functions.h"
+
+void testExportCsv();
+void testExportJsonl();
+void testExportIcs();
+
+void deleteFileIfExists(char *filename);
+void printError(char *desc, char rc);
+char setUpItems();
+char *exportToString(char format);
+
+char *testDb = "./testing.db";
+DbHandle *handle = NULL;
+
+int main()
+{
+    testExportCsv();
+    testExportJsonl();
+    testExportIcs();
+
+    deleteFileIfExists(testDb);
+}
+
+void testExportCsv()
+{
+    printf("...Starting testExportCsv.\n");
+
+    if (setUpItems()) {
+        return;
+    }
+
+    char *result = exportToString(EXPORT_FORMAT__CSV);
+
+    char *expected =
+        "date,description,repetition\n"
+        "2001-12-25,Christmas,yearly\n"
+        "2004-02-29,Leap day,yearly\n"
+        "2024-12-26,\"Said \"\"hi\"\", then left\",none\n";
+
+    if (result == NULL || strcmp(result, expected) != 0) {
+        printf("FAILURE: Unexpected CSV export:\n%s", result);
+    }
+
+    char rc;
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        free(result);
+        return;
+    }
+
+    // It should import back the same.
+    deleteFileIfExists(testDb);
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        free(result);
+        return;
+    }
+
+    FILE *input = tmpfile();
+    fputs(result, input);
+    rewind(input);
+    free(result);
+
+    CsvImportStats stats;
+    if ((rc = csv_handler_import(handle, input, ',', &stats))) {
+        printf("ERROR during import: %d\n", rc);
+    }
+    fclose(input);
+
+    result = exportToString(EXPORT_FORMAT__CSV);
+
+    if (result == NULL || strcmp(result, expected) != 0) {
+        printf("FAILURE: CSV export changed after importing it:\n%s", result);
+    }
+    free(result);
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testExportCsv.\n");
+}
+
+void testExportJsonl()
+{
+    printf("...Starting testExportJsonl.\n");
+
+    if (setUpItems()) {
+        return;
+    }
+
+    char *result = exportToString(EXPORT_FORMAT__JSONL);
+
+    char *expected =
+        "{\"id\":1,\"date\":\"2001-12-25\",\"description\":\"Christmas\",\"repetition\":\"yearly\"}\n"
+        "{\"id\":2,\"date\":\"2004-02-29\",\"description\":\"Leap day\",\"repetition\":\"yearly\"}\n"
+        "{\"id\":3,\"date\":\"2024-12-26\",\"description\":\"Said \\\"hi\\\", then left\",\"repetition\":\"none\"}\n";
+
+    if (result == NULL || strcmp(result, expected) != 0) {
+        printf("FAILURE: Unexpected JSON Lines export:\n%s", result);
+    }
+    free(result);
+
+    char rc;
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testExportJsonl.\n");
+}
+
+void testExportIcs()
+{
+    printf("...Starting testExportIcs.\n");
+
+    if (setUpItems()) {
+        return;
+    }
+
+    // Long enough to need folding, with a multi-byte character right where
+    // it would fold.
+    char longDesc[100];
+    memset(longDesc, 'x', 66);
+    strcpy(longDesc + 66, "\xc3\xa9 and more");
+    PlannerItem item = {0, buildDate(23, 0, 0), longDesc, REP_NONE};
+    db_interface_save(handle, &item);
+
+    char *result = exportToString(EXPORT_FORMAT__ICS);
+
+    if (result == NULL) {
+        printf("FAILURE: Nothing exported.\n");
+        db_interface_finalize(handle);
+        return;
+    }
+
+    char *expectedParts[] = {
+        "BEGIN:VCALENDAR\r\n",
+        "DTSTART;VALUE=DATE:20011225\r\nRRULE:FREQ=YEARLY\r\nSUMMARY:Christmas\r\n",
+        "DTSTART;VALUE=DATE:20040229\r\nRRULE:FREQ=YEARLY\r\n",
+        "SUMMARY:Said \"hi\"\\, then left\r\n",
+        "SUMMARY:xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx\r\n \xc3\xa9 and more\r\n",
+        "END:VCALENDAR\r\n",
+    };
+
+    for (int i = 0; i < 6; i++) {
+        if (strstr(result, expectedParts[i]) == NULL) {
+            printf("FAILURE: Expected to find \"%s\" in ICS export.\n", expectedParts[i]);
+        }
+    }
+
+    char rc;
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        free(result);
+        return;
+    }
+
+    // And it should import back, unfolded.
+    deleteFileIfExists(testDb);
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        free(result);
+        return;
+    }
+
+    FILE *input = tmpfile();
+    fputs(result, input);
+    rewind(input);
+    free(result);
+
+    IcsImportStats stats;
+    if ((rc = ics_handler_import(handle, input, &stats))) {
+        printf("ERROR during import: %d\n", rc);
+    }
+    fclose(input);
+
+    if (stats.events != 4 || stats.yearly != 2) {
+        printf("FAILURE: Expected 4 events with 2 yearly, but found %ld and %ld.\n",
+            stats.events, stats.yearly);
+    }
+
+    PlannerItem *found = NULL;
+    db_interface_get(handle, &found, 4);
+
+    if (found == NULL || strcmp(found->desc, longDesc) != 0) {
+        printf("FAILURE: Folded summary didn't import back the same.\n");
+    }
+    freeItem(found);
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testExportIcs.\n");
+}
+
+
+// Helper functions below this line.
+
+void deleteFileIfExists(char *filename)
+{
+    FILE *file;
+
+    if ((file = fopen(filename, "r"))) {
+        fclose(file);
+        remove(filename);
+    }
+}
+
+void printError(char *desc, char rc) {
+    char *str;
+    db_interface_build_err(handle, &str, rc);
+    printf("ERROR %s: %s\n", desc, str);
+    free(str);
+}
+
+/**
+ * Create a new database with a few items in it, one of which is deleted.
+ */
+char setUpItems()
+{
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return rc;
+    }
+
+    PlannerItem items[] = {
+        {0, buildDate(23, 11, 24), "Christmas", REP_YEARLY},
+        {0, buildDate(23, 1, 28), "Leap day", REP_YEARLY},
+        {0, buildDate(23, 11, 25), "Said \"hi\", then left", REP_NONE},
+        {0, buildDate(23, 11, 26), "Deleted", REP_NONE},
+    };
+
+    for (int i = 0; i < 4; i++) {
+        if ((rc = db_interface_save(handle, &items[i]))) {
+            printError("saving item", rc);
+            return rc;
+        }
+    }
+
+    if ((rc = db_interface_delete(handle, 4))) {
+        printError("deleting item", rc);
+        return rc;
+    }
+
+    return 0;
+}
+
+/**
+ * Export to a temporary file and read it back.  Result is on heap memory.
+ */
+char *exportToString(char format)
+{
+    FILE *output = tmpfile();
+    ExportStats stats;
+    char rc;
+
+    if ((rc = export_handler_export(handle, output, format, &stats))) {
+        printf("ERROR during export: %d\n", rc);
+        fclose(output);
+        return NULL;
+    }
+
+    char *result = malloc(stats.bytes + 1);
+    rewind(output);
+    result[fread(result, 1, stats.bytes, output)] = '\0';
+    fclose(output);
+
+    return result;
+}
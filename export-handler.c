@@ -0,0 +1,452 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "export-handler.h"
+
+#include "date-functions.h"
+#include "db-interface.h"
+#include "json-functions.h"
+#include "planner-functions.h"
+
+// Everything is written straight from one cursor over the items table, without
+// copying each item, through one buffer.  So memory doesn't depend on how big
+// the database is, and the output can be a pipe.  CSV is the same format that csv-handler imports, and ICS is
+// what ics-handler imports, so an export can be imported again.
+
+/** Size of the output buffer. */
+#define BUFFER_SIZE (1 << 20)
+
+/** Longest an ICS line can be before it's folded, in bytes. */
+#define ICS_LINE_LENGTH 75
+
+/**
+ * Buffered writer.  Errors are sticky, so they only need to be checked once
+ * per item instead of after every write.
+ */
+typedef struct export_writer {
+    FILE *output;
+    char *buffer;
+    size_t len;
+    long bytes;
+    char failed;
+} ExportWriter;
+
+/**
+ * Everything exportItem needs, since it's a callback.
+ */
+typedef struct export_context {
+    ExportWriter *writer;
+    char format;
+    char *stamp;
+    ExportStats *stats;
+    char rc;
+} ExportContext;
+
+static char exportItem(PlannerItemView *item, void *ctx);
+static char writeItem(ExportWriter *writer, char format, PlannerItemView *item, char *stamp);
+static void writeCsvItem(ExportWriter *writer, PlannerItemView *item, Date date);
+static void writeJsonItem(ExportWriter *writer, PlannerItemView *item, Date date);
+static void writeJsonBytes(const char *bytes, size_t len, void *ctx);
+static void writeIcsItem(ExportWriter *writer, PlannerItemView *item, Date date, char *stamp);
+static void writeIcsText(ExportWriter *writer, const char *text, char escape, int *lineLen);
+static void writeBytes(ExportWriter *writer, const char *bytes, size_t len);
+static void writeStr(ExportWriter *writer, const char *str);
+static void flushWriter(ExportWriter *writer);
+
+/**
+ * Get the format constant from its name (csv, jsonl, or ics).  Returns RC
+ * from constants.
+ *
+ * @param   name
+ * @param   format  Result passed back by argument.
+ */
+char export_handler_format(char *name, char *format)
+{
+    if (strcmp(name, "csv") == 0) {
+        *format = EXPORT_FORMAT__CSV;
+    } else if (strcmp(name, "jsonl") == 0) {
+        *format = EXPORT_FORMAT__JSONL;
+    } else if (strcmp(name, "ics") == 0) {
+        *format = EXPORT_FORMAT__ICS;
+    } else {
+        return EXPORT_HANDLER__UNKNOWN_FORMAT;
+    }
+
+    return EXPORT_HANDLER__OK;
+}
+
+/**
+ * Write every item in the database (which needs to have already been
+ * initialized) to the output.  Returns RC from constants.
+ *
+ * @param   db
+ * @param   output  File to write to (can be stdout).
+ * @param   format  Format from constants.
+ * @param   stats   Results passed back by argument.
+ */
+char export_handler_export(DbHandle *db, FILE *output, char format, ExportStats *stats)
+{
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    memset(stats, 0, sizeof(ExportStats));
+
+    if (format != EXPORT_FORMAT__CSV
+        && format != EXPORT_FORMAT__JSONL
+        && format != EXPORT_FORMAT__ICS
+    ) {
+        return EXPORT_HANDLER__UNKNOWN_FORMAT;
+    }
+
+    // The buffer is on the heap so that a big one doesn't go on the stack.
+    ExportWriter writer = {output, malloc(BUFFER_SIZE), 0, 0, 0};
+
+    if (writer.buffer == NULL) {
+        return EXPORT_HANDLER__OUT_OF_MEMORY;
+    }
+
+    // ICS needs a timestamp on every event, which might as well be when it was
+    // exported.
+    char stamp[17];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y%m%dT%H%M%SZ", gmtime(&now));
+
+    if (format == EXPORT_FORMAT__CSV) {
+        writeStr(&writer, "date,description,repetition\n");
+    } else if (format == EXPORT_FORMAT__ICS) {
+        writeStr(&writer,
+            "BEGIN:VCALENDAR\r\n"
+            "VERSION:2.0\r\n"
+            "PRODID:-//simple-planner//EN\r\n");
+    }
+
+    ExportContext context = {&writer, format, stamp, stats, EXPORT_HANDLER__OK};
+
+    if ((stats->dbRc = db_interface_each(db, exportItem, &context))) {
+        context.rc = EXPORT_HANDLER__DB_ERROR;
+    }
+
+    char rc = context.rc;
+
+    if (rc == EXPORT_HANDLER__OK) {
+        if (format == EXPORT_FORMAT__ICS) {
+            writeStr(&writer, "END:VCALENDAR\r\n");
+        }
+
+        flushWriter(&writer);
+
+        if (writer.failed || fflush(output) != 0) {
+            rc = EXPORT_HANDLER__IO_ERROR;
+        }
+    }
+
+    free(writer.buffer);
+    stats->bytes = writer.bytes;
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    stats->seconds = (end.tv_sec - start.tv_sec)
+        + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    return rc;
+}
+
+/**
+ * Build error string from return code, for printing.
+ *
+ * The resulting string is on heap memory and must be freed!
+ *
+ * @param   db      Handle the export was run on, for database errors.
+ * @param   stats   Stats from the export, for database errors.
+ * @param   str     SETS HEAP.  Pointer to string.
+ * @param   code    Previously-returned error code.
+ */
+char export_handler_build_err(DbHandle *db, ExportStats *stats, char **str, int code)
+{
+    char *strdum;
+
+    switch (code) {
+        case EXPORT_HANDLER__OK:
+            strdum = "No error for export handler.";
+            break;
+        case EXPORT_HANDLER__IO_ERROR:
+            strdum = "Could not write output.";
+            break;
+        case EXPORT_HANDLER__OUT_OF_MEMORY:
+            strdum = "Out of memory for export handler.";
+            break;
+        case EXPORT_HANDLER__DB_ERROR:
+            return db_interface_build_err(db, str, stats->dbRc);
+        case EXPORT_HANDLER__UNKNOWN_FORMAT:
+            strdum = "Unknown export format.  Use csv, jsonl, or ics.";
+            break;
+        default:
+            strdum = "Unknown error for export handler.";
+    }
+
+    *str = malloc(strlen(strdum) + 1);
+
+    if (*str == NULL) {
+        return EXPORT_HANDLER__OUT_OF_MEMORY;
+    }
+
+    strcpy(*str, strdum);
+
+    return EXPORT_HANDLER__OK;
+}
+
+// Static functions below this line.
+
+/**
+ * Write an item straight from the query.  See DbItemCallback.
+ *
+ * @param   item
+ * @param   ctx     The ExportContext.
+ */
+static char exportItem(PlannerItemView *item, void *ctx)
+{
+    ExportContext *context = (ExportContext *) ctx;
+
+    if ((context->rc = writeItem(context->writer, context->format, item, context->stamp))) {
+        return 1; // No point in going on.
+    }
+
+    context->stats->rows++;
+
+    return 0;
+}
+
+/**
+ * Write one item in the format.  Returns RC from constants.
+ *
+ * @param   writer
+ * @param   format
+ * @param   item
+ * @param   stamp   Timestamp for ICS.
+ */
+static char writeItem(ExportWriter *writer, char format, PlannerItemView *item, char *stamp)
+{
+    Date date = item->date;
+
+    if (item->rep == REP_YEARLY && !dateIsValid(date)) {
+        // Yearly items are saved in 2001, which doesn't have Feb 29, so use
+        // the first year that does.
+        date.year = 3;
+    }
+
+    switch (format) {
+        case EXPORT_FORMAT__CSV:
+            writeCsvItem(writer, item, date);
+            break;
+        case EXPORT_FORMAT__JSONL:
+            writeJsonItem(writer, item, date);
+            break;
+        case EXPORT_FORMAT__ICS:
+            writeIcsItem(writer, item, date, stamp);
+            break;
+    }
+
+    return writer->failed ? EXPORT_HANDLER__IO_ERROR : EXPORT_HANDLER__OK;
+}
+
+/**
+ * Write an item as a CSV line.  The description is only quoted if it needs to
+ * be.
+ *
+ * @param   writer
+ * @param   item
+ * @param   date    Date to write, instead of the item's.
+ */
+static void writeCsvItem(ExportWriter *writer, PlannerItemView *item, Date date)
+{
+    char dateStr[DATE_STRING_SIZE];
+    formatDate(dateStr, date, '-');
+
+    writeStr(writer, dateStr);
+    writeStr(writer, ",");
+
+    if (strpbrk(item->desc, ",\"\r\n") == NULL) {
+        writeBytes(writer, item->desc, item->descLen);
+    } else {
+        writeStr(writer, "\"");
+        for (const char *c = item->desc; *c != '\0'; c++) {
+            if (*c == '"') {
+                writeStr(writer, "\"\"");
+            } else if (*c == '\r' || *c == '\n') {
+                // The import is one item per line.
+                writeStr(writer, " ");
+            } else {
+                writeBytes(writer, c, 1);
+            }
+        }
+        writeStr(writer, "\"");
+    }
+
+    writeStr(writer, item->rep == REP_YEARLY ? ",yearly\n" : ",none\n");
+}
+
+/**
+ * Write an item as a JSON object on one line.
+ *
+ * @param   writer
+ * @param   item
+ * @param   date    Date to write, instead of the item's.
+ */
+static void writeJsonItem(ExportWriter *writer, PlannerItemView *item, Date date)
+{
+    char dateStr[DATE_STRING_SIZE];
+    formatDate(dateStr, date, '-');
+
+    char start[64];
+    snprintf(start, sizeof(start), "{\"id\":%ld,\"date\":\"%s\",\"description\":",
+        item->id, dateStr);
+    writeStr(writer, start);
+
+    jsonWriteString(item->desc, item->descLen, writeJsonBytes, writer);
+
+    writeStr(writer, item->rep == REP_YEARLY
+        ? ",\"repetition\":\"yearly\"}\n"
+        : ",\"repetition\":\"none\"}\n");
+}
+
+/**
+ * Write part of a string from jsonWriteString.  See JsonWriteCallback.
+ *
+ * @param   bytes
+ * @param   len
+ * @param   ctx     The ExportWriter.
+ */
+static void writeJsonBytes(const char *bytes, size_t len, void *ctx)
+{
+    writeBytes((ExportWriter *) ctx, bytes, len);
+}
+
+/**
+ * Write an item as a VEVENT.  Yearly items get a yearly RRULE.
+ *
+ * @param   writer
+ * @param   item
+ * @param   date    Date to write, instead of the item's.
+ * @param   stamp   Timestamp, for DTSTAMP.
+ */
+static void writeIcsItem(ExportWriter *writer, PlannerItemView *item, Date date, char *stamp)
+{
+    char dateStr[DATE_STRING_SIZE];
+    formatDate(dateStr, date, '\0');
+
+    char lines[160];
+    snprintf(lines, sizeof(lines),
+        "BEGIN:VEVENT\r\n"
+        "UID:%ld@simple-planner\r\n"
+        "DTSTAMP:%s\r\n"
+        "DTSTART;VALUE=DATE:%s\r\n"
+        "%s",
+        item->id, stamp, dateStr,
+        item->rep == REP_YEARLY ? "RRULE:FREQ=YEARLY\r\n" : "");
+    writeStr(writer, lines);
+
+    int lineLen = 0;
+    writeIcsText(writer, "SUMMARY:", 0, &lineLen);
+    writeIcsText(writer, item->desc, 1, &lineLen);
+    writeStr(writer, "\r\nEND:VEVENT\r\n");
+}
+
+/**
+ * Write text to an ICS line, folding it whenever it gets too long (but never
+ * in the middle of a UTF-8 character).
+ *
+ * @param   writer
+ * @param   text
+ * @param   escape  Whether to escape it as a TEXT value.
+ * @param   lineLen Length of the line so far.
+ */
+static void writeIcsText(ExportWriter *writer, const char *text, char escape, int *lineLen)
+{
+    for (const char *c = text; *c != '\0'; c++) {
+        char out[2] = {*c, '\0'};
+        int outLen = 1;
+
+        if (escape) {
+            if (*c == '\\' || *c == ';' || *c == ',') {
+                out[0] = '\\';
+                out[1] = *c;
+                outLen = 2;
+            } else if (*c == '\n') {
+                out[0] = '\\';
+                out[1] = 'n';
+                outLen = 2;
+            } else if (*c == '\r') {
+                continue;
+            }
+        }
+
+        // The first byte of a UTF-8 character says how long it is, and the
+        // rest of its bytes go on the same line as it.
+        unsigned char byte = *c;
+        int charLen = byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : byte >= 0xC0 ? 2 : outLen;
+        char continuation = (byte & 0xC0) == 0x80;
+
+        if (!continuation && *lineLen + charLen > ICS_LINE_LENGTH) {
+            writeStr(writer, "\r\n ");
+            *lineLen = 1;
+        }
+
+        writeBytes(writer, out, outLen);
+        *lineLen += outLen;
+    }
+}
+
+/**
+ * Add bytes to the buffer, writing it out when it's full.
+ *
+ * @param   writer
+ * @param   bytes
+ * @param   len
+ */
+static void writeBytes(ExportWriter *writer, const char *bytes, size_t len)
+{
+    if (writer->len + len > BUFFER_SIZE) {
+        flushWriter(writer);
+    }
+
+    if (len > BUFFER_SIZE) {
+        // Doesn't fit even in an empty buffer, so write it directly.
+        if (fwrite(bytes, 1, len, writer->output) != len) {
+            writer->failed = 1;
+        }
+    } else {
+        memcpy(writer->buffer + writer->len, bytes, len);
+        writer->len += len;
+    }
+
+    writer->bytes += len;
+}
+
+/**
+ * Add a string to the buffer.
+ *
+ * @param   writer
+ * @param   str
+ */
+static void writeStr(ExportWriter *writer, const char *str)
+{
+    writeBytes(writer, str, strlen(str));
+}
+
+/**
+ * Write out everything in the buffer.
+ *
+ * @param   writer
+ */
+static void flushWriter(ExportWriter *writer)
+{
+    if (writer->len > 0
+        && fwrite(writer->buffer, 1, writer->len, writer->output) != writer->len
+    ) {
+        writer->failed = 1;
+    }
+
+    writer->len = 0;
+}
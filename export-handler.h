@@ -0,0 +1,44 @@
+#ifndef exporthandler_h
+#define exporthandler_h
+
+#include <stdio.h>
+
+#include "db-interface.h"
+
+// Constants
+
+#define EXPORT_HANDLER__OK              0
+#define EXPORT_HANDLER__IO_ERROR        1
+#define EXPORT_HANDLER__OUT_OF_MEMORY   2
+#define EXPORT_HANDLER__DB_ERROR        3
+#define EXPORT_HANDLER__UNKNOWN_FORMAT  4
+
+#define EXPORT_FORMAT__CSV      0
+#define EXPORT_FORMAT__JSONL    1
+#define EXPORT_FORMAT__ICS      2
+
+// Types
+
+typedef struct export_stats {
+    /** @var Number of items written. */
+    long rows;
+
+    /** @var Number of bytes written. */
+    long bytes;
+
+    /** @var Seconds the whole export took. */
+    double seconds;
+
+    /** @var RC from the db interface, for DB_ERROR. */
+    char dbRc;
+} ExportStats;
+
+// Functions
+
+char export_handler_format(char *name, char *format);
+
+char export_handler_export(DbHandle *db, FILE *output, char format, ExportStats *stats);
+
+char export_handler_build_err(DbHandle *db, ExportStats *stats, char **str, int code);
+
+#endif
@@ -0,0 +1,331 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ics-handler.h"
+#include "date-functions.h"
+#include "db-interface.h"
+#include "planner-functions.h"
+
+void testImportIcs();
+void testImportManyEvents();
+void testYearlyRules();
+
+void deleteFileIfExists(char *filename);
+void printError(char *desc, char rc);
+FILE *writeInput(char *text);
+
+char *testDb = "./testing.db";
+DbHandle *handle = NULL;
+
+int main()
+{
+    testImportIcs();
+    testImportManyEvents();
+    testYearlyRules();
+
+    deleteFileIfExists(testDb);
+}
+
+void testImportIcs()
+{
+    printf("...Starting testImportIcs.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    FILE *input = writeInput(
+        "BEGIN:VCALENDAR\r\n"
+        "VERSION:2.0\r\n"
+        "SUMMARY:Not in an event\r\n"
+        "BEGIN:VEVENT\r\n"
+        "DTSTART;VALUE=DATE:20241225\r\n"
+        "RRULE:FREQ=YEARLY;BYMONTH=12\r\n"
+        "SUMMARY:Christmas\r\n"
+        "BEGIN:VALARM\r\n"
+        "SUMMARY:Alarm summary\r\n"
+        "END:VALARM\r\n"
+        "END:VEVENT\r\n"
+        "BEGIN:VEVENT\r\n"
+        "SUMMARY:Folded\\, with \\;escapes\r\n"
+        "  and a line\\nbreak\r\n"
+        "DTSTART;TZID=\"Somewhere: odd\":20241226T090000\r\n"
+        "END:VEVENT\r\n"
+        "BEGIN:VEVENT\r\n"
+        "DTSTART:20241227T100000Z\r\n"
+        "RRULE:FREQ=WEEKLY\r\n"
+        "SUMMARY:Weekly\r\n"
+        "END:VEVENT\r\n"
+        "BEGIN:VEVENT\r\n"
+        "SUMMARY:No start\r\n"
+        "END:VEVENT\r\n"
+        "BEGIN:VEVENT\r\n"
+        "DTSTART:20230229\r\n"
+        "SUMMARY:Not a leap year\r\n"
+        "END:VEVENT\r\n"
+        "END:VCALENDAR"
+    );
+
+    IcsImportStats stats;
+
+    if ((rc = ics_handler_import(handle, input, &stats))) {
+        char *str;
+        ics_handler_build_err(handle, &stats, &str, rc);
+        printf("ERROR during import: %s\n", str);
+        free(str);
+        fclose(input);
+        return;
+    }
+    fclose(input);
+
+    if (stats.events != 3) {
+        printf("FAILURE: Expected 3 events imported, but found %ld.\n", stats.events);
+    }
+    if (stats.yearly != 1) {
+        printf("FAILURE: Expected 1 yearly event, but found %ld.\n", stats.yearly);
+    }
+    if (stats.skipped != 2) {
+        printf("FAILURE: Expected 2 events skipped, but found %ld.\n", stats.skipped);
+    }
+    if (stats.unsupportedRules != 1) {
+        printf("FAILURE: Expected 1 unsupported rule, but found %ld.\n",
+            stats.unsupportedRules);
+    }
+
+    char *expected[] = {
+        "Christmas",
+        "Folded, with ;escapes and a line break",
+        "Weekly",
+    };
+
+    PlannerItem *result;
+    int count = 0;
+
+    // Looking a year later, so the yearly event shows up but the others don't.
+    while ((rc = db_interface_range(
+        handle,
+        &result,
+        buildDate(24, 11, 24),
+        buildDate(24, 11, 30)
+    )) == DB_INTERFACE__CONT) {
+        if (count == 0 && strcmp(result->desc, expected[0]) != 0) {
+            printf("FAILURE: Expected \"%s\" but found \"%s\".\n",
+                expected[0], result->desc);
+        }
+        count++;
+        freeItem(result);
+    }
+
+    if (count != 1) {
+        printf("FAILURE: Expected only the yearly event a year later, but found %d.\n", count);
+    }
+
+    count = 0;
+
+    while ((rc = db_interface_range(
+        handle,
+        &result,
+        buildDate(23, 11, 24),
+        buildDate(23, 11, 30)
+    )) == DB_INTERFACE__CONT) {
+        if (count < 3 && strcmp(result->desc, expected[count]) != 0) {
+            printf("FAILURE: Expected \"%s\" but found \"%s\".\n",
+                expected[count], result->desc);
+        }
+        count++;
+        freeItem(result);
+    }
+
+    if (count != 3) {
+        printf("FAILURE: Expected 3 items in range, but found %d.\n", count);
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testImportIcs.\n");
+}
+
+void testImportManyEvents()
+{
+    printf("...Starting testImportManyEvents.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    // Enough events to go through several commits.
+    int eventCount = 25000;
+
+    FILE *input = tmpfile();
+    fputs("BEGIN:VCALENDAR\n", input);
+    for (int i = 0; i < eventCount; i++) {
+        fprintf(input,
+            "BEGIN:VEVENT\nDTSTART:2024%02d%02d\nSUMMARY:event %d\nEND:VEVENT\n",
+            i % 12 + 1, i % 28 + 1, i);
+    }
+    fputs("END:VCALENDAR\n", input);
+    rewind(input);
+
+    IcsImportStats stats;
+
+    if ((rc = ics_handler_import(handle, input, &stats))) {
+        printf("ERROR during import: %d\n", rc);
+        fclose(input);
+        return;
+    }
+    fclose(input);
+
+    if (stats.events != eventCount) {
+        printf("FAILURE: Expected %d events, but found %ld.\n", eventCount, stats.events);
+    }
+
+    printf("...Imported %ld events in %.3fs.\n", stats.events, stats.seconds);
+
+    PlannerItem *result;
+    int count = 0;
+
+    while ((rc = db_interface_day(handle, &result, buildDate(23, 0, 0))) == DB_INTERFACE__CONT) {
+        count++;
+        freeItem(result);
+    }
+
+    // Every 12 events is January, and every 28 is the first, so every 84.
+    if (count != (eventCount + 83) / 84) {
+        printf("FAILURE: Expected %d events on Jan 1, but found %d.\n",
+            (eventCount + 83) / 84, count);
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testImportManyEvents.\n");
+}
+
+/**
+ * Only yearly rules that mean every year on the start date become yearly
+ * items.  The rest are saved once and counted as unsupported.
+ */
+void testYearlyRules()
+{
+    printf("...Starting testYearlyRules.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    char *rules[] = {
+        "FREQ=YEARLY;INTERVAL=1;WKST=MO",
+        "BYMONTHDAY=25;FREQ=YEARLY;BYMONTH=12",
+        "FREQ=YEARLY;INTERVAL=4",
+        "FREQ=YEARLY;COUNT=2",
+        "FREQ=YEARLY;UNTIL=20261225",
+        "FREQ=YEARLY;BYMONTH=6",
+        "FREQ=YEARLY;BYMONTH=12,6",
+        "FREQ=YEARLY;BYDAY=-1SU",
+    };
+    int ruleCount = 8;
+
+    FILE *input = tmpfile();
+    fputs("BEGIN:VCALENDAR\n", input);
+    for (int i = 0; i < ruleCount; i++) {
+        // The rule comes before the start, so BYMONTH can't be checked right away.
+        fprintf(input,
+            "BEGIN:VEVENT\nRRULE:%s\nDTSTART:20241225\nSUMMARY:rule %d\nEND:VEVENT\n",
+            rules[i], i);
+    }
+    fputs("END:VCALENDAR\n", input);
+    rewind(input);
+
+    IcsImportStats stats;
+
+    if ((rc = ics_handler_import(handle, input, &stats))) {
+        printf("ERROR during import: %d\n", rc);
+        fclose(input);
+        return;
+    }
+    fclose(input);
+
+    if (stats.events != ruleCount) {
+        printf("FAILURE: Expected %d events, but found %ld.\n", ruleCount, stats.events);
+    }
+    if (stats.yearly != 2) {
+        printf("FAILURE: Expected 2 yearly events, but found %ld.\n", stats.yearly);
+    }
+    if (stats.unsupportedRules != ruleCount - 2) {
+        printf("FAILURE: Expected %d unsupported rules, but found %ld.\n",
+            ruleCount - 2, stats.unsupportedRules);
+    }
+
+    PlannerItem *result;
+    int count = 0;
+
+    // A year later, only the two yearly ones.
+    while ((rc = db_interface_day(handle, &result, buildDate(24, 11, 24))) == DB_INTERFACE__CONT) {
+        count++;
+        freeItem(result);
+    }
+
+    if (count != 2) {
+        printf("FAILURE: Expected 2 events a year later, but found %d.\n", count);
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testYearlyRules.\n");
+}
+
+
+// Helper functions below this line.
+
+void deleteFileIfExists(char *filename)
+{
+    FILE *file;
+
+    if ((file = fopen(filename, "r"))) {
+        fclose(file);
+        remove(filename);
+    }
+}
+
+void printError(char *desc, char rc) {
+    char *str;
+    db_interface_build_err(handle, &str, rc);
+    printf("ERROR %s: %s\n", desc, str);
+    free(str);
+}
+
+/**
+ * Write text to a temporary file and rewind it, to use as input.
+ */
+FILE *writeInput(char *text)
+{
+    FILE *file = tmpfile();
+    fputs(text, file);
+    rewind(file);
+
+    return file;
+}
@@ -0,0 +1,489 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "ics-handler.h"
+
+#include "date-functions.h"
+#include "db-interface.h"
+#include "planner-functions.h"
+
+// iCalendar (RFC 5545) is read one line at a time, so memory only depends on
+// the longest line, not the size of the file.  Only the parts that mean
+// something here are used:  DTSTART (just the date-- times are ignored),
+// SUMMARY, and RRULE (only a plain FREQ=YEARLY means anything; other rules,
+// including yearly ones with a count, an end, or an interval, are saved as the
+// first occurrence and counted in the stats).
+
+/** Number of events saved per transaction. */
+#define COMMIT_EVENTS 10000
+
+/**
+ * The parts of the VEVENT currently being read.
+ */
+typedef struct ics_event {
+    Date date;
+    char hasDate;
+    char *summary;
+    size_t summaryCap;
+    char rep;
+    char unsupportedRule;
+
+    /** @var BYMONTH and BYMONTHDAY of a yearly rule (1-based), or 0 if not given. */
+    int ruleMonth;
+    int ruleDay;
+} IcsEvent;
+
+static char readLogicalLine(FILE *input, char **line, size_t *cap, char **next, size_t *nextCap, ssize_t *nextLen);
+static char handleLine(DbHandle *db, char *line, IcsEvent *event, int *depth, IcsImportStats *stats, long *uncommitted);
+static char *splitProperty(char *line, char **params);
+static char parseIcsDate(char *value, Date *date);
+static char isYearlyRule(char *value, int *month, int *day);
+static char setSummary(IcsEvent *event, char *value);
+static char saveEvent(DbHandle *db, IcsEvent *event, IcsImportStats *stats, long *uncommitted);
+
+/**
+ * Import the events from an iCalendar file into the database, which needs to
+ * have already been initialized.  Returns RC from constants.
+ *
+ * @param   db
+ * @param   input   File to read from (can be stdin).
+ * @param   stats   Results passed back by argument.
+ */
+char ics_handler_import(DbHandle *db, FILE *input, IcsImportStats *stats)
+{
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    memset(stats, 0, sizeof(IcsImportStats));
+
+    char rc = ICS_HANDLER__OK;
+
+    // The line after the current one has to be read before the current one
+    // can be handled, since it might be a continuation.
+    char *line = NULL;
+    size_t lineCap = 0;
+    char *next = NULL;
+    size_t nextCap = 0;
+    ssize_t nextLen = getline(&next, &nextCap, input);
+
+    IcsEvent event = {0};
+    int depth = 0; // How many components deep inside a VEVENT.
+    long uncommitted = 0;
+
+    if ((stats->dbRc = db_interface_begin(db))) {
+        free(next);
+        return ICS_HANDLER__DB_ERROR;
+    }
+
+    while (nextLen != -1) {
+        if ((rc = readLogicalLine(input, &line, &lineCap, &next, &nextCap, &nextLen))) {
+            break;
+        }
+
+        if ((rc = handleLine(db, line, &event, &depth, stats, &uncommitted))) {
+            break;
+        }
+    }
+
+    if (rc == ICS_HANDLER__OK && ferror(input)) {
+        rc = ICS_HANDLER__IO_ERROR;
+    }
+
+    if (rc == ICS_HANDLER__OK) {
+        if ((stats->dbRc = db_interface_commit(db))) {
+            rc = ICS_HANDLER__DB_ERROR;
+        }
+    } else {
+        // Only the events since the last commit are lost.
+        db_interface_rollback(db);
+    }
+
+    free(line);
+    free(next);
+    free(event.summary);
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    stats->seconds = (end.tv_sec - start.tv_sec)
+        + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    return rc;
+}
+
+/**
+ * Build error string from return code, for printing.
+ *
+ * The resulting string is on heap memory and must be freed!
+ *
+ * @param   db      Handle the import was run on, for database errors.
+ * @param   stats   Stats from the import, for database errors.
+ * @param   str     SETS HEAP.  Pointer to string.
+ * @param   code    Previously-returned error code.
+ */
+char ics_handler_build_err(DbHandle *db, IcsImportStats *stats, char **str, int code)
+{
+    char *strdum;
+
+    switch (code) {
+        case ICS_HANDLER__OK:
+            strdum = "No error for ics handler.";
+            break;
+        case ICS_HANDLER__IO_ERROR:
+            strdum = "Could not read input.";
+            break;
+        case ICS_HANDLER__OUT_OF_MEMORY:
+            strdum = "Out of memory for ics handler.";
+            break;
+        case ICS_HANDLER__DB_ERROR:
+            return db_interface_build_err(db, str, stats->dbRc);
+        default:
+            strdum = "Unknown error for ics handler.";
+    }
+
+    *str = malloc(strlen(strdum) + 1);
+
+    if (*str == NULL) {
+        return ICS_HANDLER__OUT_OF_MEMORY;
+    }
+
+    strcpy(*str, strdum);
+
+    return ICS_HANDLER__OK;
+}
+
+// Static functions below this line.
+
+/**
+ * Read one logical line, which is the physical line in `next` plus any lines
+ * after it that start with a space or tab (which is how long lines are folded
+ * in iCalendar).  The result is in `line`, without the line break, and `next`
+ * is left holding the first line that isn't part of it.
+ *
+ * @param   input
+ * @param   line    Result, reused between calls.
+ * @param   cap     Size of `line`.
+ * @param   next    The line that's been read ahead.
+ * @param   nextCap Size of `next`.
+ * @param   nextLen Length of `next`, or -1 at the end of the input.
+ */
+static char readLogicalLine(FILE *input, char **line, size_t *cap, char **next, size_t *nextCap, ssize_t *nextLen)
+{
+    size_t len = 0;
+    char *part = *next;
+    ssize_t partLen = *nextLen;
+
+    while (1) {
+        // Drop the line break.
+        while (partLen > 0 && (part[partLen - 1] == '\n' || part[partLen - 1] == '\r')) {
+            partLen--;
+        }
+
+        if (len + partLen + 1 > *cap) {
+            size_t newCap = *cap ? *cap : 256;
+            while (newCap < len + partLen + 1) {
+                newCap *= 2;
+            }
+            char *lineDum = realloc(*line, newCap);
+            if (lineDum == NULL) {
+                return ICS_HANDLER__OUT_OF_MEMORY;
+            }
+            *line = lineDum;
+            *cap = newCap;
+        }
+
+        memcpy(*line + len, part, partLen);
+        len += partLen;
+
+        *nextLen = getline(next, nextCap, input);
+
+        if (*nextLen == -1 || ((*next)[0] != ' ' && (*next)[0] != '\t')) {
+            break;
+        }
+
+        // Continuation, without the space or tab that marks it.
+        part = *next + 1;
+        partLen = *nextLen - 1;
+    }
+
+    (*line)[len] = '\0';
+
+    return ICS_HANDLER__OK;
+}
+
+/**
+ * Handle one logical line.
+ *
+ * @param   db
+ * @param   line
+ * @param   event       The event being read.
+ * @param   depth       Components deep inside the event (0 if not in one).
+ * @param   stats
+ * @param   uncommitted Number of events saved since the last commit.
+ */
+static char handleLine(DbHandle *db, char *line, IcsEvent *event, int *depth, IcsImportStats *stats, long *uncommitted)
+{
+    char *params;
+    char *value = splitProperty(line, &params);
+
+    if (value == NULL) {
+        return ICS_HANDLER__OK; // Not a property, so nothing to do with it.
+    }
+
+    if (strcasecmp(line, "BEGIN") == 0) {
+        if (*depth > 0) {
+            (*depth)++; // Something inside the event, like a VALARM.
+        } else if (strcasecmp(value, "VEVENT") == 0) {
+            *depth = 1;
+            event->hasDate = 0;
+            event->rep = REP_NONE;
+            event->unsupportedRule = 0;
+            event->ruleMonth = 0;
+            event->ruleDay = 0;
+            if (event->summary != NULL) {
+                event->summary[0] = '\0';
+            }
+        }
+        return ICS_HANDLER__OK;
+    }
+
+    if (strcasecmp(line, "END") == 0) {
+        if (*depth == 1) {
+            *depth = 0;
+            return saveEvent(db, event, stats, uncommitted);
+        }
+        if (*depth > 1) {
+            (*depth)--;
+        }
+        return ICS_HANDLER__OK;
+    }
+
+    if (*depth != 1) {
+        // Either not in an event, or in something inside of one (and an
+        // alarm's summary isn't the event's summary).
+        return ICS_HANDLER__OK;
+    }
+
+    if (strcasecmp(line, "DTSTART") == 0) {
+        event->hasDate = parseIcsDate(value, &event->date);
+    } else if (strcasecmp(line, "SUMMARY") == 0) {
+        return setSummary(event, value);
+    } else if (strcasecmp(line, "RRULE") == 0) {
+        if (isYearlyRule(value, &event->ruleMonth, &event->ruleDay)) {
+            event->rep = REP_YEARLY;
+        } else {
+            event->unsupportedRule = 1;
+        }
+    }
+
+    return ICS_HANDLER__OK;
+}
+
+/**
+ * Split a content line into its name, parameters, and value, in place.  The
+ * line is left holding just the name.  Returns a pointer to the value, or NULL
+ * if there's no value.
+ *
+ * @param   line
+ * @param   params  Set to the parameters (after the first ';'), or NULL.
+ */
+static char *splitProperty(char *line, char **params)
+{
+    *params = NULL;
+
+    char inQuotes = 0;
+
+    for (char *c = line; *c != '\0'; c++) {
+        if (*c == '"') {
+            // Parameter values can be quoted, and can have colons in them.
+            inQuotes = !inQuotes;
+        } else if (*c == ';' && !inQuotes && *params == NULL) {
+            *c = '\0';
+            *params = c + 1;
+        } else if (*c == ':' && !inQuotes) {
+            *c = '\0';
+            return c + 1;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Parse the date out of a DTSTART value, which is either YYYYMMDD or
+ * YYYYMMDDTHHMMSS (with an optional Z).  The time is ignored.  Returns true if
+ * it's a valid date.
+ *
+ * @param   value
+ * @param   date
+ */
+static char parseIcsDate(char *value, Date *date)
+{
+    int parts[3] = {0, 0, 0};
+    int lens[3] = {4, 2, 2};
+    int pos = 0;
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < lens[i]; j++, pos++) {
+            if (value[pos] < '0' || value[pos] > '9') {
+                return 0;
+            }
+            parts[i] = parts[i] * 10 + value[pos] - '0';
+        }
+    }
+
+    if (value[pos] != '\0' && value[pos] != 'T') {
+        return 0;
+    }
+
+    *date = buildDate(parts[0] - 2001, parts[1] - 1, parts[2] - 1);
+
+    return dateIsValid(*date);
+}
+
+/**
+ * Check whether an RRULE value means every year on the same day, with no end.
+ * Anything that changes which years (or days) it happens on, or stops it,
+ * makes it something else.  A single BYMONTH or BYMONTHDAY is allowed, but it
+ * has to match DTSTART, which might not have been read yet-- so it's passed
+ * back to be checked when the event is saved.
+ *
+ * @param   value   Like "FREQ=YEARLY;BYMONTH=12".
+ * @param   month   Set to BYMONTH, if it's there.
+ * @param   day     Set to BYMONTHDAY, if it's there.
+ */
+static char isYearlyRule(char *value, int *month, int *day)
+{
+    char yearly = 0;
+
+    for (char *part = value; *part != '\0'; ) {
+        size_t len = strcspn(part, ";");
+        int *by = NULL;
+        size_t nameLen = 0;
+
+        if (len > 8 && strncasecmp(part, "BYMONTH=", 8) == 0) {
+            by = month;
+            nameLen = 8;
+        } else if (len > 11 && strncasecmp(part, "BYMONTHDAY=", 11) == 0) {
+            by = day;
+            nameLen = 11;
+        }
+
+        if (by != NULL) {
+            // Just one number.  A list means more than one day a year.
+            *by = 0;
+            for (size_t i = nameLen; i < len; i++) {
+                if (part[i] < '0' || part[i] > '9' || *by > 31) {
+                    return 0;
+                }
+                *by = *by * 10 + part[i] - '0';
+            }
+        } else if (len == 11 && strncasecmp(part, "FREQ=YEARLY", 11) == 0) {
+            yearly = 1;
+        } else if (!(len == 10 && strncasecmp(part, "INTERVAL=1", 10) == 0)
+            && strncasecmp(part, "WKST=", 5) != 0
+        ) {
+            return 0;
+        }
+
+        part += len;
+        if (*part == ';') {
+            part++;
+        }
+    }
+
+    return yearly;
+}
+
+/**
+ * Unescape a SUMMARY value into the event.  Line breaks become spaces, since
+ * descriptions are only one line.
+ *
+ * @param   event
+ * @param   value
+ */
+static char setSummary(IcsEvent *event, char *value)
+{
+    size_t needed = strlen(value) + 1;
+
+    if (needed > event->summaryCap) {
+        char *summaryDum = realloc(event->summary, needed);
+        if (summaryDum == NULL) {
+            return ICS_HANDLER__OUT_OF_MEMORY;
+        }
+        event->summary = summaryDum;
+        event->summaryCap = needed;
+    }
+
+    char *write = event->summary;
+
+    for (char *read = value; *read != '\0'; read++) {
+        if (*read != '\\' || read[1] == '\0') {
+            *write++ = *read;
+            continue;
+        }
+
+        read++;
+        *write++ = (*read == 'n' || *read == 'N') ? ' ' : *read;
+    }
+
+    *write = '\0';
+
+    return ICS_HANDLER__OK;
+}
+
+/**
+ * Save the event that was just read, committing whenever enough have been
+ * saved since the last commit.
+ *
+ * @param   db
+ * @param   event
+ * @param   stats
+ * @param   uncommitted Number of events saved since the last commit.
+ */
+static char saveEvent(DbHandle *db, IcsEvent *event, IcsImportStats *stats, long *uncommitted)
+{
+    if (!event->hasDate) {
+        stats->skipped++;
+        return ICS_HANDLER__OK;
+    }
+
+    if (event->rep == REP_YEARLY
+        && ((event->ruleMonth && event->ruleMonth != event->date.month + 1)
+            || (event->ruleDay && event->ruleDay != event->date.day + 1))
+    ) {
+        // Yearly, but not on the day it starts.  Just the first one, then.
+        event->rep = REP_NONE;
+        event->unsupportedRule = 1;
+    }
+
+    // Not using buildItem, since the summary doesn't need to be copied just
+    // to be saved.
+    PlannerItem item = {
+        0,
+        event->date,
+        event->summary != NULL ? event->summary : "",
+        event->rep
+    };
+
+    if ((stats->dbRc = db_interface_save(db, &item))) {
+        return ICS_HANDLER__DB_ERROR;
+    }
+
+    stats->events++;
+    stats->yearly += (event->rep == REP_YEARLY);
+    stats->unsupportedRules += event->unsupportedRule;
+
+    if (++(*uncommitted) >= COMMIT_EVENTS) {
+        if ((stats->dbRc = db_interface_commit(db))
+            || (stats->dbRc = db_interface_begin(db))
+        ) {
+            return ICS_HANDLER__DB_ERROR;
+        }
+        *uncommitted = 0;
+    }
+
+    return ICS_HANDLER__OK;
+}
@@ -0,0 +1,43 @@
+#ifndef icshandler_h
+#define icshandler_h
+
+#include <stdio.h>
+
+#include "db-interface.h"
+
+// Constants
+
+#define ICS_HANDLER__OK             0
+#define ICS_HANDLER__IO_ERROR       1
+#define ICS_HANDLER__OUT_OF_MEMORY  2
+#define ICS_HANDLER__DB_ERROR       3
+
+// Types
+
+typedef struct ics_import_stats {
+    /** @var Number of events saved to the database. */
+    long events;
+
+    /** @var Number of those events that repeat yearly. */
+    long yearly;
+
+    /** @var Number of events without a usable date, so weren't saved. */
+    long skipped;
+
+    /** @var Number of events that repeat in a way that isn't supported. */
+    long unsupportedRules;
+
+    /** @var Seconds the whole import took. */
+    double seconds;
+
+    /** @var RC from the db interface, for DB_ERROR. */
+    char dbRc;
+} IcsImportStats;
+
+// Functions
+
+char ics_handler_import(DbHandle *db, FILE *input, IcsImportStats *stats);
+
+char ics_handler_build_err(DbHandle *db, IcsImportStats *stats, char **str, int code);
+
+#endif
@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json-functions.h"
+
+void testParseObject();
+void testParseString();
+void testBadObjects();
+void testWriteString();
+
+const char *collectField(char *key, JsonValue *value, void *ctx);
+void collectBytes(const char *bytes, size_t len, void *ctx);
+
+/**
+ * What collectField saw, as "key=type:raw;" for each field.
+ */
+typedef struct collected_fields {
+    char text[512];
+} CollectedFields;
+
+int main()
+{
+    testParseObject();
+    testParseString();
+    testBadObjects();
+    testWriteString();
+}
+
+void testParseObject()
+{
+    printf("...Starting testParseObject.\n");
+
+    char line[] = " { \"a\" : \"x\\\"y\", \"b\":-12,\"c\":true, \"d\":null,"
+        "\"e\":[1,{\"f\":\"]\"}],\"g\":{}, \"h\":false } tail";
+    char *p = line;
+
+    CollectedFields fields = {""};
+    const char *error = jsonParseObject(&p, collectField, &fields);
+
+    char *expected = "a=1:\"x\\\"y\";b=2:-12;c=3:true;d=3:null;"
+        "e=4:[1,{\"f\":\"]\"}];g=5:{};h=3:false;";
+
+    if (error != NULL) {
+        printf("FAILURE: Expected to parse, but found: %s\n", error);
+    } else if (strcmp(fields.text, expected) != 0) {
+        printf("FAILURE: Expected fields %s but found %s\n", expected, fields.text);
+    } else if (strcmp(p, " tail") != 0) {
+        printf("FAILURE: Expected to stop after the object, but found \"%s\".\n", p);
+    }
+
+    char empty[] = "{}";
+    p = empty;
+    if ((error = jsonParseObject(&p, collectField, &fields)) != NULL || *p != '\0') {
+        printf("FAILURE: Expected an empty object to parse.\n");
+    }
+
+    printf("...Completed testParseObject.\n");
+}
+
+void testParseString()
+{
+    printf("...Starting testParseString.\n");
+
+    char *cases[][2] = {
+        {"\"plain\"", "plain"},
+        {"\"tab\\tquote\\\"slash\\/back\\\\\"", "tab\tquote\"slash/back\\"},
+        {"\"\\u00e9\\u20ac\"", "\xc3\xa9\xe2\x82\xac"},
+        {"\"\\ud83d\\ude00\"", "\xf0\x9f\x98\x80"},
+    };
+
+    for (int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        char buf[64];
+        strcpy(buf, cases[i][0]);
+
+        char *str;
+        char *end = jsonParseString(buf, &str);
+
+        if (end == NULL || *end != '\0' || strcmp(str, cases[i][1]) != 0) {
+            printf("FAILURE: Expected %s to parse to \"%s\".\n", cases[i][0], cases[i][1]);
+        }
+    }
+
+    char *bad[] = {
+        "\"no end",
+        "\"bad \\x escape\"",
+        "\"\\u00zz\"",
+        "\"\\u0000\"",
+        "\"\\ud83d alone\"",
+        "\"\\ude00\"",
+        "\"new\nline\"",
+    };
+
+    for (int i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        char buf[64];
+        strcpy(buf, bad[i]);
+
+        char *str;
+        if (jsonParseString(buf, &str) != NULL) {
+            printf("FAILURE: Expected %s not to parse.\n", bad[i]);
+        }
+    }
+
+    printf("...Completed testParseString.\n");
+}
+
+void testBadObjects()
+{
+    printf("...Starting testBadObjects.\n");
+
+    char *bad[] = {
+        "",
+        "[]",
+        "{\"a\"}",
+        "{\"a\":}",
+        "{a:1}",
+        "{\"a\":1,}",
+        "{\"a\":1.5}",
+        "{\"a\":1e3}",
+        "{\"a\":tru}",
+        "{\"a\":[1,2}",
+        "{\"a\":99999999999999999999}",
+        "{\"a\":1",
+        "{\"a\":1 \"b\":2}",
+    };
+
+    for (int i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        char buf[64];
+        strcpy(buf, bad[i]);
+        char *p = buf;
+
+        CollectedFields fields = {""};
+        if (jsonParseObject(&p, collectField, &fields) == NULL) {
+            printf("FAILURE: Expected %s not to parse.\n", bad[i]);
+        }
+    }
+
+    printf("...Completed testBadObjects.\n");
+}
+
+void testWriteString()
+{
+    printf("...Starting testWriteString.\n");
+
+    char *cases[][2] = {
+        {"plain", "\"plain\""},
+        {"", "\"\""},
+        {"tab\tquote\"back\\", "\"tab\\u0009quote\\\"back\\\\\""},
+        {"\x1f\n", "\"\\u001f\\u000a\""},
+        {"\xc3\xa9\xe2\x82\xac", "\"\xc3\xa9\xe2\x82\xac\""},
+    };
+
+    for (int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        CollectedFields out = {""};
+        jsonWriteString(cases[i][0], strlen(cases[i][0]), collectBytes, &out);
+
+        if (strcmp(out.text, cases[i][1]) != 0) {
+            printf("FAILURE: Expected %s, got %s.\n", cases[i][1], out.text);
+            continue;
+        }
+
+        char *str;
+        char *end = jsonParseString(out.text, &str);
+
+        if (end == NULL || *end != '\0' || strcmp(str, cases[i][0]) != 0) {
+            printf("FAILURE: Expected %s to parse back.\n", cases[i][1]);
+        }
+    }
+
+    // Only len bytes are written, so the string doesn't need to end there.
+    CollectedFields out = {""};
+    jsonWriteString("cut\"off", 3, collectBytes, &out);
+
+    if (strcmp(out.text, "\"cut\"") != 0) {
+        printf("FAILURE: Expected \"cut\", got %s.\n", out.text);
+    }
+
+    printf("...Completed testWriteString.\n");
+}
+
+// Helper functions below this line.
+
+/**
+ * See JsonFieldCallback.  Collects into a CollectedFields.
+ */
+const char *collectField(char *key, JsonValue *value, void *ctx)
+{
+    CollectedFields *fields = (CollectedFields *) ctx;
+    size_t len = strlen(fields->text);
+
+    snprintf(fields->text + len, sizeof(fields->text) - len, "%s=%d:%.*s;",
+        key, value->type, (int) value->rawLen, value->raw);
+
+    return NULL;
+}
+
+/**
+ * See JsonWriteCallback.  Collects into the text of a CollectedFields.
+ */
+void collectBytes(const char *bytes, size_t len, void *ctx)
+{
+    CollectedFields *out = (CollectedFields *) ctx;
+    size_t used = strlen(out->text);
+
+    snprintf(out->text + used, sizeof(out->text) - used, "%.*s", (int) len, bytes);
+}
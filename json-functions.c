@@ -0,0 +1,356 @@
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json-functions.h"
+
+static char *skipValue(char *p, char *type);
+static char *skipString(char *p);
+static char *skipNested(char *p);
+static int parseHex(const char *p);
+static int encodeUtf8(long codePoint, char *out);
+
+/**
+ * Parse an object, calling back with each key and value.  Returns NULL if it
+ * parsed, or why it didn't.
+ *
+ * @param   p           The opening brace (or spaces before it).  Passed back
+ *                      pointing after the closing brace.
+ * @param   callback    See JsonFieldCallback.
+ * @param   ctx         Passed to the callback.
+ */
+const char *jsonParseObject(char **p, JsonFieldCallback callback, void *ctx)
+{
+    char *at = jsonSkipSpace(*p);
+    if (*at != '{') {
+        return "expected a JSON object";
+    }
+    at = jsonSkipSpace(at + 1);
+
+    if (*at == '}') {
+        *p = at + 1;
+        return NULL;
+    }
+
+    for (;;) {
+        char *key;
+        if (*at != '"' || (at = jsonParseString(at, &key)) == NULL) {
+            return "expected a key";
+        }
+
+        at = jsonSkipSpace(at);
+        if (*at != ':') {
+            return "expected a colon after a key";
+        }
+        at = jsonSkipSpace(at + 1);
+
+        JsonValue value = {0, at, 0, 0};
+        if ((at = skipValue(at, &value.type)) == NULL) {
+            return "expected a string, whole number, true, false, null, array, or object";
+        }
+        value.rawLen = at - value.raw;
+
+        if (value.type == JSON__NUMBER) {
+            errno = 0;
+            value.num = strtol(value.raw, NULL, 10);
+            if (errno) {
+                return "expected a whole number";
+            }
+        }
+
+        const char *error;
+        if ((error = callback(key, &value, ctx)) != NULL) {
+            return error;
+        }
+
+        at = jsonSkipSpace(at);
+
+        if (*at == '}') {
+            *p = at + 1;
+            return NULL;
+        }
+        if (*at != ',') {
+            return "expected a comma or the end of the object";
+        }
+        at = jsonSkipSpace(at + 1);
+    }
+}
+
+/**
+ * Unescape a string in place.  The result starts where the opening quote was,
+ * and is shorter than the string was, so nothing after it is touched.  Returns
+ * what's after the closing quote, or NULL if it's not a valid string.
+ *
+ * @param   p       The opening quote.
+ * @param   str     Passed back by argument.
+ */
+char *jsonParseString(char *p, char **str)
+{
+    char *read = p + 1;
+    char *write = p;
+    *str = p;
+
+    while (*read != '"') {
+        if ((unsigned char) *read < 0x20) {
+            // Including the end of the text.
+            return NULL;
+        }
+
+        if (*read != '\\') {
+            *write++ = *read++;
+            continue;
+        }
+
+        read++;
+        switch (*read++) {
+            case '"': *write++ = '"'; break;
+            case '\\': *write++ = '\\'; break;
+            case '/': *write++ = '/'; break;
+            case 'b': *write++ = '\b'; break;
+            case 'f': *write++ = '\f'; break;
+            case 'n': *write++ = '\n'; break;
+            case 'r': *write++ = '\r'; break;
+            case 't': *write++ = '\t'; break;
+            case 'u': {
+                long codePoint = parseHex(read);
+                read += 4;
+
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                    // High surrogate, which needs a low one after it.
+                    int low = read[0] == '\\' && read[1] == 'u' ? parseHex(read + 2) : -1;
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        return NULL;
+                    }
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    read += 6;
+                } else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+                    return NULL;
+                }
+
+                if (codePoint <= 0) {
+                    // Bad hex, or a null that would cut the string short.
+                    return NULL;
+                }
+
+                write += encodeUtf8(codePoint, write);
+                break;
+            }
+            default:
+                return NULL;
+        }
+    }
+
+    *write = '\0';
+
+    return read + 1;
+}
+
+/**
+ * Write a string quoted and escaped, so that jsonParseString gives it back.
+ * Runs of characters that don't need escaping are written in one piece.
+ *
+ * @param   str
+ * @param   len
+ * @param   write   See JsonWriteCallback.
+ * @param   ctx     Passed to write.
+ */
+void jsonWriteString(const char *str, size_t len, JsonWriteCallback write, void *ctx)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    write("\"", 1, ctx);
+
+    const char *plain = str;
+    const char *end = str + len;
+
+    for (const char *c = str; c < end; c++) {
+        unsigned char ch = *c;
+
+        if (ch != '"' && ch != '\\' && ch >= 0x20) {
+            continue;
+        }
+
+        write(plain, c - plain, ctx);
+        plain = c + 1;
+
+        if (ch == '"' || ch == '\\') {
+            char escaped[2] = {'\\', ch};
+            write(escaped, 2, ctx);
+        } else {
+            char escaped[6] = {'\\', 'u', '0', '0', hex[ch >> 4], hex[ch & 0xf]};
+            write(escaped, 6, ctx);
+        }
+    }
+
+    write(plain, end - plain, ctx);
+    write("\"", 1, ctx);
+}
+
+char *jsonSkipSpace(char *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+        p++;
+    }
+
+    return p;
+}
+
+// Static functions below this line.
+
+/**
+ * Skip over a value without changing it.  Returns what's after it, or NULL if
+ * it isn't one.
+ *
+ * @param   p
+ * @param   type    Passed back by argument.
+ */
+static char *skipValue(char *p, char *type)
+{
+    if (*p == '"') {
+        *type = JSON__STRING;
+        return skipString(p);
+    }
+
+    if (*p == '[' || *p == '{') {
+        *type = *p == '[' ? JSON__ARRAY : JSON__OBJECT;
+        return skipNested(p);
+    }
+
+    if (*p == '-' || isdigit((unsigned char) *p)) {
+        *type = JSON__NUMBER;
+        char *end = p + (*p == '-');
+        if (!isdigit((unsigned char) *end)) {
+            return NULL;
+        }
+        while (isdigit((unsigned char) *end)) {
+            end++;
+        }
+        // Only whole numbers.
+        return *end == '.' || *end == 'e' || *end == 'E' ? NULL : end;
+    }
+
+    *type = JSON__LITERAL;
+    if (strncmp(p, "true", 4) == 0 || strncmp(p, "null", 4) == 0) {
+        return p + 4;
+    }
+    if (strncmp(p, "false", 5) == 0) {
+        return p + 5;
+    }
+
+    return NULL;
+}
+
+/**
+ * Skip over a string without unescaping it.  Returns what's after the closing
+ * quote, or NULL if it doesn't end.
+ *
+ * @param   p       The opening quote.
+ */
+static char *skipString(char *p)
+{
+    for (p++; *p != '"'; p++) {
+        if ((unsigned char) *p < 0x20) {
+            return NULL;
+        }
+        if (*p == '\\' && (unsigned char) *++p < 0x20) {
+            return NULL;
+        }
+    }
+
+    return p + 1;
+}
+
+/**
+ * Skip over an array or object, as long as its brackets and braces match up.
+ * Returns what's after it, or NULL if they don't.
+ *
+ * @param   p       The opening bracket or brace.
+ */
+static char *skipNested(char *p)
+{
+    // Only needs to be as deep as anything this reads.
+    char closers[32];
+    int depth = 0;
+
+    do {
+        if (*p == '"') {
+            if ((p = skipString(p)) == NULL) {
+                return NULL;
+            }
+            continue;
+        }
+
+        if (*p == '[' || *p == '{') {
+            if (depth == sizeof(closers)) {
+                return NULL;
+            }
+            closers[depth++] = *p == '[' ? ']' : '}';
+        } else if (*p == ']' || *p == '}') {
+            if (*p != closers[--depth]) {
+                return NULL;
+            }
+        } else if (*p == '\0') {
+            return NULL;
+        }
+        p++;
+    } while (depth > 0);
+
+    return p;
+}
+
+/**
+ * Parse four hex digits.  Returns -1 if they aren't.
+ *
+ * @param   p
+ */
+static int parseHex(const char *p)
+{
+    int value = 0;
+
+    for (int i = 0; i < 4; i++) {
+        int digit;
+        if (p[i] >= '0' && p[i] <= '9') {
+            digit = p[i] - '0';
+        } else if (p[i] >= 'a' && p[i] <= 'f') {
+            digit = p[i] - 'a' + 10;
+        } else if (p[i] >= 'A' && p[i] <= 'F') {
+            digit = p[i] - 'A' + 10;
+        } else {
+            return -1;
+        }
+        value = value * 16 + digit;
+    }
+
+    return value;
+}
+
+/**
+ * Write a code point as UTF-8.  Returns how many bytes it took.
+ *
+ * @param   codePoint
+ * @param   out
+ */
+static int encodeUtf8(long codePoint, char *out)
+{
+    if (codePoint < 0x80) {
+        out[0] = codePoint;
+        return 1;
+    }
+    if (codePoint < 0x800) {
+        out[0] = 0xC0 | (codePoint >> 6);
+        out[1] = 0x80 | (codePoint & 0x3F);
+        return 2;
+    }
+    if (codePoint < 0x10000) {
+        out[0] = 0xE0 | (codePoint >> 12);
+        out[1] = 0x80 | ((codePoint >> 6) & 0x3F);
+        out[2] = 0x80 | (codePoint & 0x3F);
+        return 3;
+    }
+    out[0] = 0xF0 | (codePoint >> 18);
+    out[1] = 0x80 | ((codePoint >> 12) & 0x3F);
+    out[2] = 0x80 | ((codePoint >> 6) & 0x3F);
+    out[3] = 0x80 | (codePoint & 0x3F);
+    return 4;
+}
@@ -0,0 +1,65 @@
+#ifndef jsonfunctions_h
+#define jsonfunctions_h
+
+#include <stddef.h>
+
+// Just enough JSON for JSON Lines requests and responses: objects whose
+// values are strings, whole numbers, true, false, or null.  Arrays and objects
+// inside them are checked and passed along without being parsed, so they can
+// be parsed on their own afterwards.  Strings are unescaped in place, so
+// nothing is allocated, and escaped a piece at a time straight into whatever
+// is being written.
+
+// Constants
+
+#define JSON__STRING    1
+#define JSON__NUMBER    2
+#define JSON__LITERAL   3
+#define JSON__ARRAY     4
+#define JSON__OBJECT    5
+
+// Types
+
+typedef struct json_value {
+    /** @var Type, from constants. */
+    char type;
+
+    /** @var The value exactly as it is in the text. */
+    char *raw;
+    size_t rawLen;
+
+    /** @var The number, for JSON__NUMBER. */
+    long num;
+} JsonValue;
+
+/**
+ * Called with each key and value in an object.  The key is unescaped, but the
+ * value isn't; use jsonParseString on its raw text if it's a string.  Return
+ * NULL to carry on, or why the value is wrong to stop.
+ *
+ * @param   key
+ * @param   value
+ * @param   ctx     Whatever was passed to jsonParseObject.
+ */
+typedef const char *(*JsonFieldCallback)(char *key, JsonValue *value, void *ctx);
+
+/**
+ * Called by jsonWriteString with each piece of the escaped string, in order.
+ *
+ * @param   bytes
+ * @param   len
+ * @param   ctx     Whatever was passed to jsonWriteString.
+ */
+typedef void (*JsonWriteCallback)(const char *bytes, size_t len, void *ctx);
+
+// Functions
+
+const char *jsonParseObject(char **p, JsonFieldCallback callback, void *ctx);
+
+char *jsonParseString(char *p, char **str);
+
+void jsonWriteString(const char *str, size_t len, JsonWriteCallback write, void *ctx);
+
+char *jsonSkipSpace(char *p);
+
+#endif
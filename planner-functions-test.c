@@ -8,6 +8,7 @@
 
 static void buildErrTest();
 static void buildItemTest();
+static void arenaTest();
 
 static PlannerItem *buildItemDummyFunction();
 
@@ -15,6 +16,7 @@ int main()
 {
     buildErrTest();
     buildItemTest();
+    arenaTest();
 }
 
 /**
@@ -74,6 +76,62 @@ static void buildItemTest()
     printf("...Finished buildItemTest.\n");
 }
 
+/**
+ * Test building items in an arena, and that resetting it reuses its memory.
+ */
+static void arenaTest()
+{
+    printf("...Starting arenaTest.\n");
+
+    PlannerArena arena = {};
+    PlannerItem *items[2000];
+    char desc[32];
+
+    // Enough to need more than one block.
+    for (int i = 0; i < 2000; i++) {
+        sprintf(desc, "Arena item %d", i);
+        if (buildArenaItem(&arena, &items[i], i, buildDate(24, 0, i % 31), desc, REP_NONE)) {
+            printf("FAILURE: Could not build item in arena.\n");
+            freeArena(&arena);
+            return;
+        }
+    }
+
+    for (int i = 0; i < 2000; i++) {
+        sprintf(desc, "Arena item %d", i);
+        if (items[i]->id != i || strcmp(items[i]->desc, desc) != 0) {
+            printf("FAILURE: Arena item %d was overwritten.\n", i);
+            break;
+        }
+        if ((unsigned long) items[i] % sizeof(long) != 0) {
+            printf("FAILURE: Arena item %d is not aligned.\n", i);
+            break;
+        }
+    }
+
+    if (arena.allocations < 2 || arena.allocations > 5) {
+        printf("FAILURE: Expected a few allocations, but found %ld.\n", arena.allocations);
+    }
+
+    // After resetting, the same items should fit without allocating again.
+    resetArena(&arena);
+    long allocations = arena.allocations;
+
+    for (int i = 0; i < 2000; i++) {
+        sprintf(desc, "Arena item %d", i);
+        buildArenaItem(&arena, &items[i], i, buildDate(24, 0, i % 31), desc, REP_NONE);
+    }
+
+    if (arena.allocations != allocations) {
+        printf("FAILURE: Expected no allocations after reset, but found %ld.\n",
+            arena.allocations - allocations);
+    }
+
+    freeArena(&arena);
+
+    printf("...Finished arenaTest.\n");
+}
+
 // Helper functions below this line.
 
 /**
@@ -7,6 +7,26 @@
 #include "planner-functions.h"
 #include "date-functions.h"
 
+/** Smallest block an arena allocates.  Enough for a normal week. */
+#define ARENA_BLOCK_SIZE 16384
+
+/** Everything in an arena is aligned to this. */
+#define ARENA_ALIGN 16
+
+/**
+ * Block of memory in an arena.  The memory itself comes right after this.
+ */
+struct planner_arena_block
+{
+    struct planner_arena_block *next;
+    size_t size;
+    size_t used;
+};
+
+static void *arenaAlloc(PlannerArena *arena, size_t size);
+static char addArenaBlock(PlannerArena *arena, size_t size);
+static size_t alignedSize(size_t size);
+
 
 /**
  * Build a planner item object.  Returns status as integer.
@@ -62,6 +82,93 @@ void freeItem(PlannerItem *obj)
     obj = NULL; // (Almost) Always set freed pointers to null.
 }
 
+/**
+ * Build a planner item object in an arena, with its description right after
+ * it.  Same as buildItem otherwise, but the item is only valid until the arena
+ * is reset or freed, and it must not be passed to freeItem.
+ *
+ * @param   arena   Arena to build it in.
+ * @param   item    Pointer to pointer to point to new object.
+ * @param   id      Id from db.  Zero if new object.
+ * @param   dateObj Date object.
+ * @param   desc    Description string.
+ * @param   rep     Repetition, from header file's constants.
+ * @return  int
+ */
+int buildArenaItem(
+    PlannerArena *arena,
+    PlannerItem **item,
+    long id,
+    Date dateObj,
+    char *desc,
+    char rep
+) {
+    size_t descLen = strlen(desc) + 1;
+    PlannerItem *itmDum = arenaAlloc(arena, sizeof(PlannerItem) + descLen);
+
+    if (itmDum == NULL) {
+        return PLANNER_STATUS__OUT_OF_MEMORY;
+    }
+
+    itmDum->id     = id;
+    itmDum->date   = dateObj;
+    itmDum->desc   = (char *) (itmDum + 1);
+    itmDum->rep    = rep;
+
+    memcpy(itmDum->desc, desc, descLen);
+
+    *item = itmDum;
+
+    return PLANNER_STATUS__OK;
+}
+
+/**
+ * Throw away everything in an arena, but keep its memory to use again.  If it
+ * had to grow, its blocks are replaced with one block big enough for all of it,
+ * so next time it doesn't need to grow.
+ *
+ * @param   arena
+ */
+void resetArena(PlannerArena *arena)
+{
+    if (arena->blocks == NULL) {
+        return;
+    }
+
+    if (arena->blocks->next == NULL) {
+        arena->blocks->used = 0;
+        return;
+    }
+
+    size_t total = 0;
+    for (struct planner_arena_block *block = arena->blocks; block != NULL; block = block->next) {
+        total += block->size;
+    }
+
+    freeArena(arena);
+
+    // If this fails, the next allocation will just try again.
+    addArenaBlock(arena, total);
+}
+
+/**
+ * Free all of an arena's memory.  It can still be used after this.
+ *
+ * @param   arena
+ */
+void freeArena(PlannerArena *arena)
+{
+    struct planner_arena_block *block = arena->blocks;
+
+    while (block != NULL) {
+        struct planner_arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    arena->blocks = NULL;
+}
+
 /**
  * Build error string from return code, for printing.
  *
@@ -95,3 +202,72 @@ int planner_functions_build_err(char **str, int code)
 
     return PLANNER_STATUS__OK;
 }
+
+// Static functions below this line.
+
+/**
+ * Get memory from an arena, adding a block if the newest one doesn't have
+ * room.  Returns NULL if out of memory.
+ *
+ * @param   arena
+ * @param   size
+ */
+static void *arenaAlloc(PlannerArena *arena, size_t size)
+{
+    size = alignedSize(size);
+
+    struct planner_arena_block *block = arena->blocks;
+
+    if (block == NULL || block->used + size > block->size) {
+        size_t blockSize = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        if (block != NULL && block->size * 2 > blockSize) {
+            // Keep doubling, so a big week only needs a few blocks.
+            blockSize = block->size * 2;
+        }
+        if (addArenaBlock(arena, blockSize)) {
+            return NULL;
+        }
+        block = arena->blocks;
+    }
+
+    void *result = (char *) block + alignedSize(sizeof(struct planner_arena_block)) + block->used;
+    block->used += size;
+
+    return result;
+}
+
+/**
+ * Add an empty block to the front of an arena.  Returns status as integer.
+ *
+ * @param   arena
+ * @param   size    Usable size of the block.
+ */
+static char addArenaBlock(PlannerArena *arena, size_t size)
+{
+    struct planner_arena_block *block = malloc(
+        alignedSize(sizeof(struct planner_arena_block)) + size
+    );
+
+    if (block == NULL) {
+        return PLANNER_STATUS__OUT_OF_MEMORY;
+    }
+
+    arena->allocations++;
+
+    block->next = arena->blocks;
+    block->size = size;
+    block->used = 0;
+    arena->blocks = block;
+
+    return PLANNER_STATUS__OK;
+}
+
+/**
+ * Round a size up so that whatever comes after it is aligned.
+ *
+ * @param   size
+ */
+static size_t alignedSize(size_t size)
+{
+    return (size + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1);
+}
@@ -7,6 +7,8 @@
 // screws that up.  If need to do that, then will need to make a special
 // function in the same way that I needed to make a special function for freeing
 // the object.
+// Also, never use freeItem on an item that was built in an arena.  Those are
+// freed with the arena.
 
 // Constants
 
@@ -25,7 +27,8 @@
 // Note on repetition: Right now, yearly is the only kind I want, but more can
 // be added.  But some of the logic might be annoying.  The place that will
 // need to be updated will be reduceIntDate and setRepType, but possibly other
-// places, too, like db_interface_day.
+// places, too, like db_interface_day, db_interface_week, and
+// db_interface_range.
 
 
 typedef struct planner_itemstruct
@@ -44,6 +47,46 @@ typedef struct planner_itemstruct
 
 } PlannerItem;
 
+/**
+ * An item that's borrowed instead of built, like straight from a query.  The
+ * description isn't owned by it, so it's only good for as long as whatever
+ * passed it says.
+ */
+typedef struct planner_item_view
+{
+    /** @var Id in database. */
+    long id;
+
+    /** @var Date event takes place. */
+    Date date;
+
+    /** @var Description.  Null-terminated, but descLen is its length. */
+    const char *desc;
+
+    /** @var Length of description, in bytes. */
+    int descLen;
+
+    /** @var Type of repetition, from constants. */
+    char rep;
+
+} PlannerItemView;
+
+/**
+ * Memory that items can be built in all at once and then all freed at once,
+ * like for everything on the screen.  Each item and its description are
+ * next to each other, so building one is usually just moving a pointer.
+ * Start it zeroed (`PlannerArena arena = {};`).
+ */
+typedef struct planner_arena
+{
+    /** @var Blocks of memory, newest first. */
+    struct planner_arena_block *blocks;
+
+    /** @var Number of times it's called malloc, for measuring. */
+    long allocations;
+
+} PlannerArena;
+
 int buildItem(
     PlannerItem **item,
     long id,
@@ -54,6 +97,19 @@ int buildItem(
 
 void freeItem(PlannerItem *item);
 
+int buildArenaItem(
+    PlannerArena *arena,
+    PlannerItem **item,
+    long id,
+    Date dateObj,
+    char *desc,
+    char rep
+);
+
+void resetArena(PlannerArena *arena);
+
+void freeArena(PlannerArena *arena);
+
 int planner_functions_build_err(char **str, int code);
 
 
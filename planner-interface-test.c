@@ -0,0 +1,287 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "planner-interface.h"
+
+void testRunCommands();
+void testManyCommands();
+void testInputEndsInCommand();
+void testAddAfterPaging();
+void *runPlanner(void *arg);
+
+void deleteFileIfExists(char *filename);
+
+char *testDb = "./testing.db";
+DbHandle *handle = NULL;
+
+/** Commands are run on a thread with this much stack, to catch any growth. */
+#define SMALL_STACK (256 * 1024)
+
+#define MANY_COMMANDS 100000
+
+/**
+ * What runPlanner runs with and what it got back.
+ */
+typedef struct planner_run {
+    FILE *in;
+    FILE *out;
+    char rc;
+} PlannerRun;
+
+int main()
+{
+    testRunCommands();
+    testManyCommands();
+    testInputEndsInCommand();
+    testAddAfterPaging();
+
+    deleteFileIfExists(testDb);
+}
+
+/**
+ * Add, edit, and move around, and check what's displayed.
+ */
+void testRunCommands()
+{
+    printf("...Starting testRunCommands.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+    if ((rc = planner_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize, rc %d.\n", rc);
+        return;
+    }
+
+    FILE *in = tmpfile();
+    FILE *out = tmpfile();
+
+    fputs(
+        "a w\nfirst item\nn\n"   // Add to Wednesday.
+        "e 1\nchanged item\n"    // Edit it.
+        "e 7\n"                  // No item 7.
+        "x\n"                    // Not a command.
+        "n\np\n"                 // Away and back.
+        "s CHANG\n"              // Search.
+        "s nothing here\n"
+        "m\ny\nw\n"              // Month, year, and back.
+        "q\n"
+        "n\n",                   // Never read.
+        in
+    );
+    rewind(in);
+
+    if ((rc = planner_interface_run(handle, in, out))) {
+        printf("FAILURE: Expected OK from running, but found %d.\n", rc);
+    }
+
+    size_t len = ftell(out);
+    char *output = malloc(len + 1);
+    rewind(out);
+    output[fread(output, 1, len, out)] = '\0';
+
+    char *expected[] = {
+        "  1) first item\n",
+        "  1) changed item\n",
+        "No item with that number.\n\nCanceled.\n",
+        "Select one of the parenthesized options.\n",
+        " changed item\nGo to one with (G)oto.\n",
+        "Nothing found for \"nothing here\".\n",
+        " this month.\n",
+        " this year.\n",
+        "  1) changed item\n",
+        "The sea was angry that day",
+    };
+
+    char *searchFrom = output;
+    for (int i = 0; i < 10; i++) {
+        char *found = strstr(searchFrom, expected[i]);
+        if (found == NULL) {
+            printf("FAILURE: Expected \"%s\" in the output after the last thing found.\n",
+                expected[i]);
+            continue;
+        }
+        searchFrom = found;
+    }
+
+    // Quitting should stop before the last command.
+    char *prompt = "(Q)uit\n> ";
+    int prompts = 0;
+    for (char *p = strstr(output, prompt); p != NULL; p = strstr(p + 1, prompt)) {
+        prompts++;
+    }
+    if (prompts != 12) {
+        printf("FAILURE: Expected 12 prompts, but found %d.\n", prompts);
+    }
+
+    free(output);
+    fclose(in);
+    fclose(out);
+
+    printf("...Completed testRunCommands.\n");
+}
+
+/**
+ * Run a lot of commands with a small stack.  When every command displayed the
+ * week by calling back into the display, this ran out of stack.
+ */
+void testManyCommands()
+{
+    printf("...Starting testManyCommands.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+    if ((rc = planner_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize, rc %d.\n", rc);
+        return;
+    }
+
+    char *cycle[] = {"n\n", "p\n", "c\n", "x\n", "e\n", "t\n"};
+
+    PlannerRun run = {tmpfile(), fopen("/dev/null", "w"), 0};
+    fputs("a m\nan item\ny\n", run.in);
+    for (int i = 0; i < MANY_COMMANDS; i++) {
+        fputs(cycle[i % 6], run.in);
+    }
+    // No quit, so it has to stop at the end of the input.
+    rewind(run.in);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, SMALL_STACK);
+
+    pthread_t thread;
+    if (pthread_create(&thread, &attr, runPlanner, &run)) {
+        printf("ERROR: Could not start the thread.\n");
+        return;
+    }
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attr);
+
+    if (run.rc) {
+        printf("FAILURE: Expected OK after %d commands, but found %d.\n", MANY_COMMANDS, run.rc);
+    }
+    if (!feof(run.in)) {
+        printf("FAILURE: Expected every command to be read.\n");
+    }
+
+    fclose(run.in);
+    fclose(run.out);
+
+    printf("...Completed testManyCommands.\n");
+}
+
+/**
+ * When the input ends partway through a command, the command fails, but the
+ * database still gets closed.
+ */
+void testInputEndsInCommand()
+{
+    printf("...Starting testInputEndsInCommand.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+    if ((rc = planner_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize, rc %d.\n", rc);
+        return;
+    }
+
+    FILE *in = tmpfile();
+    FILE *out = tmpfile();
+
+    fputs("a w\n", in);
+    rewind(in);
+
+    if ((rc = planner_interface_run(handle, in, out)) != PLANNER_INTERFACE__IO_ERROR) {
+        printf("FAILURE: Expected PLANNER_INTERFACE__IO_ERROR, but found %d.\n", rc);
+    }
+
+    // Closing the last connection cleans up the WAL file.
+    FILE *wal = fopen("./testing.db-wal", "r");
+    if (wal != NULL) {
+        printf("FAILURE: Expected the database to be closed.\n");
+        fclose(wal);
+    }
+
+    fclose(in);
+    fclose(out);
+
+    printf("...Completed testInputEndsInCommand.\n");
+}
+
+/**
+ * Adding after paging through months goes into a week of the month displayed,
+ * not the week that was displayed before.
+ */
+void testAddAfterPaging()
+{
+    printf("...Starting testAddAfterPaging.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+    if ((rc = planner_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize, rc %d.\n", rc);
+        return;
+    }
+
+    FILE *in = tmpfile();
+    FILE *out = tmpfile();
+
+    fputs(
+        "m\nn\nn\n"              // Two months on.
+        "a w\npaged item\nn\n"    // Add to Wednesday.
+        "w\n"                    // The week for that month.
+        "q\n",
+        in
+    );
+    rewind(in);
+
+    if ((rc = planner_interface_run(handle, in, out))) {
+        printf("FAILURE: Expected OK from running, but found %d.\n", rc);
+    }
+
+    size_t len = ftell(out);
+    char *output = malloc(len + 1);
+    rewind(out);
+    output[fread(output, 1, len, out)] = '\0';
+
+    if (strstr(output, "  1) paged item\n") == NULL) {
+        printf("FAILURE: Expected the item in the week of the month it was added from.\n");
+    }
+
+    free(output);
+    fclose(in);
+    fclose(out);
+
+    printf("...Completed testAddAfterPaging.\n");
+}
+
+// Helper functions below this line.
+
+/**
+ * Thread for testManyCommands.
+ *
+ * @param   arg     The PlannerRun.
+ */
+void *runPlanner(void *arg)
+{
+    PlannerRun *run = (PlannerRun *) arg;
+
+    run->rc = planner_interface_run(handle, run->in, run->out);
+
+    return NULL;
+}
+
+void deleteFileIfExists(char *filename)
+{
+    FILE *file;
+    if ((file = fopen(filename, "r"))) {
+        fclose(file);
+        remove(filename);
+    }
+}
@@ -1,8 +1,11 @@
 #include <ctype.h>
+#include <errno.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 // Only want to use time.h for *one* function!
 
 #include "planner-interface.h"
@@ -11,7 +14,10 @@
 #include "db-interface.h"
 #include "planner-functions.h"
 
-// No test for this module because it's basically only tested manually.
+// What planner_interface_run displays.
+#define VIEW_WEEK   0
+#define VIEW_MONTH  1
+#define VIEW_YEAR   2
 
 // Forward declaration of static functions.
 
@@ -19,79 +25,251 @@
 // just FYI, this is the last module I wrote, so it's sloppy because I'm
 // getting antsy about actually using it.
 
-// Also, I know the recursion risks a stack overflow, but... It's unlikely that
-// I'll keep the program open that much and I kinda like recursion.  If it ever
-// becomes a problem, I'll switch to a main loop.
+/**
+ * Everything about a running planner session.  Commands used to redisplay the
+ * week by calling back into it, so the stack grew with every command; now
+ * planner_interface_run loops, and this is what's kept between commands.
+ */
+typedef struct planner_state {
+    DbHandle *db;
+    FILE *in;
+    FILE *out;
+
+    /** @var First day (Sunday) of the week displayed. */
+    Date week;
+
+    /** @var Which view is displayed.  See the VIEW_ constants. */
+    char view;
+
+    /**
+     * @var First day of the month or year displayed, in those views.  The
+     * week is kept too, for going back to it.
+     */
+    Date period;
+
+    /**
+     * @var Currently-displayed number of item on screen.  Increments with
+     * every one printed on the screen.
+     */
+    long displayKey;
+
+    /** @var Map of the displayed item number to the item id. */
+    int *items;
+
+    /**
+     * @var Number of ids that `items` has room for.  It's kept between weeks,
+     * so it only grows when a week has more items than any before it.
+     */
+    long itemsCap;
+
+    /** @var Message to display at end of current week. */
+    char *flashMsg;
+
+    /**
+     * @var The screen being built.  It's written out all at once by
+     * flushFrame, so the week doesn't paint a line at a time over a slow
+     * connection.  The memory is kept between frames, like the item mapping.
+     */
+    char *frame;
+
+    /** @var Number of bytes in the frame so far. */
+    size_t frameLen;
+
+    /** @var Number of bytes that `frame` has room for. */
+    size_t frameCap;
+
+    /** @var Set by the quit command to end the loop. */
+    char quit;
+} PlannerState;
 
-static void printAllItemsInDay(Date dateObj);
+/**
+ * A command from the prompt.  Returns OK to redisplay the week, CANCEL to
+ * redisplay it saying that it was canceled, or an error to stop.
+ */
+typedef char (*PlannerCommand)(PlannerState *state);
 
-static int appendItemMapping(long id);
+/**
+ * A command and the key that runs it.
+ */
+typedef struct planner_command_entry {
+    char key;
+    PlannerCommand run;
+} PlannerCommandEntry;
 
-static void resetItemMapping();
+/**
+ * What a search has shown so far, for addSearchResult.
+ */
+typedef struct search_results {
+    PlannerState *state;
+    int count;
+} SearchResults;
 
-static void setRepType(char **repTypeStr, char rep);
+/**
+ * Where printing the week is up to, for printWeekItem.
+ */
+typedef struct week_printer {
+    PlannerState *state;
 
-static char showPrompt();
+    /** @var Day being printed. */
+    Date day;
 
-static char addItem();
+    /** @var Which day of the week it is, 0 - 6. */
+    int index;
 
-static char editItem();
+    /** @var Today, to mark it. */
+    Date today;
+} WeekPrinter;
 
-static char deleteItem();
+static void displayView(PlannerState *state);
 
-static char previousWeek();
+static void displayToday(PlannerState *state, Date today);
 
-static char nextWeek();
+static void displayWeek(PlannerState *state);
 
-static char gotoWeek();
+static void displayMonth(PlannerState *state);
 
-static char gotoToday();
+static void displayYear(PlannerState *state);
 
-static char getInput(char **inputStr, int len, char flush);
+static int monthLength(Date first);
 
-static void addFlashMessage(char *str);
+static Date periodStart(char view, Date day);
 
-static void displayFlashMessage();
+static Date viewedDay(PlannerState *state);
 
-static void printDbErr(char errCode);
+static void goToDay(PlannerState *state, Date day);
 
-// static variables.
+static void movePeriod(PlannerState *state, int step);
 
-/**
- * Currently-displayed number of item on screen.  Increments with every one
- * printed on the screen.
- */
-static long displayKey = 0;
+static void prefetchNearbyWeeks(PlannerState *state);
+
+static void printDayHeader(WeekPrinter *printer);
+
+static void nextPrintedDay(WeekPrinter *printer);
+
+static char printWeekItem(PlannerItemView *item, void *ctx);
+
+static void printItem(PlannerState *state, PlannerItemView *item);
+
+static int appendItemMapping(PlannerState *state, long id);
+
+static void resetItemMapping(PlannerState *state);
+
+static const char *repTypeSuffix(char rep);
+
+static void frameAppend(PlannerState *state, const char *str, size_t len);
+
+static void frameAppendStr(PlannerState *state, const char *str);
+
+static void framePrintf(PlannerState *state, const char *format, ...);
+
+static char frameReserve(PlannerState *state, size_t extra);
+
+static void flushFrame(PlannerState *state);
+
+static char readCommand(PlannerState *state, PlannerCommand *command);
+
+static char addItem(PlannerState *state);
+
+static char editItem(PlannerState *state);
+
+static char deleteItem(PlannerState *state);
+
+static char previousWeek(PlannerState *state);
+
+static char nextWeek(PlannerState *state);
+
+static char currentWeek(PlannerState *state);
+
+static char gotoWeek(PlannerState *state);
+
+static char gotoToday(PlannerState *state);
+
+static char weekView(PlannerState *state);
+
+static char monthView(PlannerState *state);
+
+static char yearView(PlannerState *state);
+
+static char searchItems(PlannerState *state);
+
+static char addSearchResult(PlannerItemView *item, void *ctx);
+
+static char quitPlanner(PlannerState *state);
+
+static char getInput(PlannerState *state, char **inputStr, int len, char flush);
+
+static void addFlashMessage(PlannerState *state, char *str);
+
+static void displayFlashMessage(PlannerState *state);
+
+static void printDbErr(PlannerState *state, char errCode);
+
+static void printUpdateProgress(
+    int version,
+    char *desc,
+    long rows,
+    double seconds,
+    char done
+);
+
+/** Most items that a search shows. */
+#define SEARCH_RESULTS 10
+
+// static variables.
 
 /**
- * Map of the displayed item number to the item id.
+ * Letters for the days of the week, starting with Sunday.
  */
-static int *items = NULL;
+static char weekdayLetters[7] = {'S','M','T','W','R','F','A'};
 
 /**
- * Store the current week displayed in memory.
+ * Names of the months, starting with January.
  */
-static Date *currentWeek = NULL;
+static const char *monthNames[12] = {
+    "January", "February", "March", "April", "May", "June", "July", "August",
+    "September", "October", "November", "December",
+};
 
 /**
- * Message to display at end of current week.
+ * What each key at the prompt does.
  */
-static char *flashMsg = NULL;
+static const PlannerCommandEntry commands[] = {
+    {'a', addItem},
+    {'e', editItem},
+    {'d', deleteItem},
+    {'p', previousWeek},
+    {'n', nextWeek},
+    {'c', currentWeek},
+    {'g', gotoWeek},
+    {'t', gotoToday},
+    {'s', searchItems},
+    {'w', weekView},
+    {'m', monthView},
+    {'y', yearView},
+    {'q', quitPlanner},
+};
+
+static const char *promptStr = "(A)dd, (E)dit, (D)elete, (P)revious, (N)ext,"
+    " (C)urrent, (T)oday, (G)oto, (S)earch,\n(W)eek, (M)onth, (Y)ear, (Q)uit\n> ";
 
 /**
- * Initialize the db from the filename.
+ * Open the database from the filename, showing how updating it goes.
  *
+ * @param   db          Set to the handle, or NULL if it couldn't be opened.
  * @param   filename
  */
-char planner_interface_initialize(char *filename)
+char planner_interface_initialize(DbHandle **db, char *filename)
 {
     char rc;
-    if ((rc = db_interface_initialize(filename))) {
+    db_interface_set_update_callback(printUpdateProgress);
+    if ((rc = db_interface_initialize(db, filename))) {
         char *errStr;
-        db_interface_build_err(&errStr, rc);
+        db_interface_build_err(*db, &errStr, rc);
         printf("Database error: %s\n", errStr);
         free(errStr);
         errStr = NULL;
+        db_interface_finalize(*db);
+        *db = NULL;
         return PLANNER_INTERFACE__DB_ERROR;
     }
 
@@ -99,192 +277,513 @@ char planner_interface_initialize(char *filename)
 }
 
 /**
- * Display the week that includes the specified day along with the options.
+ * Run the planner, starting on this week, until it's quit or the input ends.
+ * The database is finalized before this returns, even if a command failed, so
+ * the handle can't be used afterwards.  Returns RC from constants.
  *
- * @param   dayObj
+ * @param   db      From planner_interface_initialize.
+ * @param   in      Where commands are read from.
+ * @param   out     Where the week and prompts are written.
  */
-char planner_interface_display_week(Date dayObj)
+char planner_interface_run(DbHandle *db, FILE *in, FILE *out)
 {
-    Date rollDay = getWeek(dayObj); // Starting today, rolls through the week.
+    PlannerState state = {};
+    state.db = db;
+    state.in = in;
+    state.out = out;
+    state.week = getWeek(todayDate());
+
+    char rc = PLANNER_INTERFACE__OK;
+    char redisplay = 1;
+
+    while (!state.quit) {
+        if (redisplay) {
+            displayView(&state);
+        }
+
+        frameAppendStr(&state, promptStr);
+        flushFrame(&state);
+
+        if (redisplay && state.view == VIEW_WEEK) {
+            prefetchNearbyWeeks(&state);
+        }
+
+        PlannerCommand command;
+        if ((rc = readCommand(&state, &command)) == PLANNER_INTERFACE__IO_ERROR) {
+            // End of the input, so quit like it was asked to.
+            rc = quitPlanner(&state);
+            break;
+        } else if (rc) {
+            frameAppendStr(&state, "Select one of the parenthesized options.\n");
+            redisplay = 0;
+            continue;
+        }
+
+        rc = command(&state);
+
+        if (rc == PLANNER_INTERFACE__CANCEL) {
+            addFlashMessage(&state, "Canceled.\n");
+            rc = PLANNER_INTERFACE__OK;
+        } else if (rc) {
+            break;
+        }
 
-    // TODO: Make currentWeek set with a completely different function to avoid
-    // doing this every time the week is displayed.
-    free(currentWeek);
-    currentWeek = (Date *) malloc(sizeof(Date));
-    memcpy(currentWeek, &rollDay, sizeof(rollDay));
+        redisplay = 1;
+    }
+
+    if (!state.quit) {
+        // A command failed, so quitPlanner didn't get to close it.
+        db_interface_finalize(db);
+    }
+
+    flushFrame(&state);
+
+    free(state.items);
+    free(state.flashMsg);
+    free(state.frame);
+
+    return rc;
+}
+
+// Static functions below this line.
 
-    char *dayStr = NULL;
-    resetItemMapping();
+/**
+ * Add whichever view is displayed to the frame.
+ *
+ * @param   state
+ */
+static void displayView(PlannerState *state)
+{
+    // Item numbers only go with the week view.
+    resetItemMapping(state);
+
+    switch (state->view) {
+        case VIEW_MONTH:
+            displayMonth(state);
+            break;
+        case VIEW_YEAR:
+            displayYear(state);
+            break;
+        default:
+            displayWeek(state);
+    }
+}
+
+/**
+ * Add the line saying what today is to the frame.
+ *
+ * @param   state
+ * @param   today
+ */
+static void displayToday(PlannerState *state, Date today)
+{
+    char dayStr[DATE_STRING_SIZE];
+    formatDate(dayStr, today, '-');
+    framePrintf(state, "\nToday is %c %s.\n\n", weekdayLetters[getWeekday(today)], dayStr);
+}
+
+/**
+ * Add the week being displayed to the frame, along with any flash message.
+ *
+ * @param   state
+ */
+static void displayWeek(PlannerState *state)
+{
+    Date today = todayDate();
+    displayToday(state, today);
+
+    // The whole week comes back from one query, grouped by day, and each item
+    // is added to the frame straight from the query without being copied.
+    // The days between items are added as the items get to them.
+    WeekPrinter printer = {state, state->week, 0, today};
+    printDayHeader(&printer);
+
+    char weekRc = db_interface_each_in_week(state->db, state->week, printWeekItem, &printer);
+
+    while (printer.index < 6) {
+        nextPrintedDay(&printer);
+    }
+    frameAppend(state, "\n", 1);
 
-    char days[7] = {'S','M','T','W','R','F','A'};
+    if (weekRc != DB_INTERFACE__OK) {
+        printDbErr(state, weekRc);
+    }
 
-    printf("\n");
+    displayFlashMessage(state);
+}
 
+/**
+ * Add the month being displayed to the frame as a calendar, with the number of
+ * items on each day, along with any flash message.
+ *
+ * @param   state
+ */
+static void displayMonth(PlannerState *state)
+{
     Date today = todayDate();
-    toString(&dayStr, today);
-    printf("Today is %c %s.\n\n", days[getWeekday(today)], dayStr);
-    free(dayStr);
-    dayStr = NULL;
+    displayToday(state, today);
 
+    Date first = state->period;
+    int days = monthLength(first);
+    int counts[31];
+    char rc = db_interface_count_days(state->db, first, addDays(first, days - 1), counts);
+
+    framePrintf(state, "%s %d\n", monthNames[first.month], first.year + 2001);
     for (int i = 0; i < 7; i++) {
-        toString(&dayStr, rollDay);
-        printf("%c %s", days[i], dayStr);
-        if (dateMatch(&today, &rollDay)) {
-            putchar('*');
+        framePrintf(state, i < 6 ? "%3c      " : "%3c\n", weekdayLetters[i]);
+    }
+
+    // Each day is " DD*[N]  ", where * is today and N is how many items there
+    // are, if any.
+    int weekday = getWeekday(first);
+    for (int i = 0; i < weekday; i++) {
+        frameAppendStr(state, "         ");
+    }
+
+    int total = 0;
+    for (int day = 0; day < days; day++, weekday = (weekday + 1) % 7) {
+        char countStr[8] = "";
+        if (rc == DB_INTERFACE__OK && counts[day] > 0) {
+            snprintf(countStr, sizeof(countStr), counts[day] > 999 ? "[1k+]" : "[%d]",
+                counts[day]);
+            total += counts[day];
         }
-        printf("\n");
-        free(dayStr);
-        dayStr = NULL;
-        printAllItemsInDay(rollDay);
 
-        datepp(&rollDay);
+        char isToday = today.year == first.year && today.month == first.month
+            && today.day == day;
+        char endsLine = weekday == 6 || day == days - 1;
+        framePrintf(state, endsLine ? "%3d%c%s\n" : "%3d%c%-5s", day + 1,
+            isToday ? '*' : ' ', countStr);
+    }
+
+    if (rc != DB_INTERFACE__OK) {
+        printDbErr(state, rc);
+    } else {
+        framePrintf(state, "\n%d item%s this month.\n", total, total == 1 ? "" : "s");
     }
+    frameAppend(state, "\n", 1);
 
-    displayFlashMessage();
+    displayFlashMessage(state);
+}
 
-    char rc;
-    if ((rc = showPrompt()) == PLANNER_INTERFACE__CANCEL) {
-        addFlashMessage("Canceled.\n");
-        return planner_interface_display_week(*currentWeek);
-    } else if (rc) {
-        return rc;
+/**
+ * Add the year being displayed to the frame as a heat map: a row for each
+ * month and a column for each day, with how many items there are on it.
+ *
+ * @param   state
+ */
+static void displayYear(PlannerState *state)
+{
+    Date today = todayDate();
+    displayToday(state, today);
+
+    Date first = state->period;
+    Date last = buildDate(first.year, 11, 30);
+    int counts[366];
+    char rc = db_interface_count_days(state->db, first, last, counts);
+
+    framePrintf(state, "%-6d1        10        20        30\n", first.year + 2001);
+
+    int index = 0;
+    int total = 0;
+    for (int month = 0; month < 12; month++) {
+        char row[32];
+        int days = monthLength(buildDate(first.year, month, 0));
+
+        for (int day = 0; day < days; day++) {
+            int count = rc == DB_INTERFACE__OK ? counts[index++] : 0;
+            row[day] = count == 0 ? '.' : count < 10 ? '0' + count : '+';
+            total += count;
+        }
+        row[days] = '\0';
+
+        framePrintf(state, "%.3s   %s\n", monthNames[month], row);
     }
 
-    return PLANNER_INTERFACE__OK;
+    if (rc != DB_INTERFACE__OK) {
+        printDbErr(state, rc);
+    } else {
+        framePrintf(state, "\nItems on each day, + for ten or more.  %d item%s this year.\n",
+            total, total == 1 ? "" : "s");
+    }
+    frameAppend(state, "\n", 1);
+
+    displayFlashMessage(state);
 }
 
-// Static functions below this line.
+/**
+ * Get the number of days in a month.
+ *
+ * @param   first   First day of the month.
+ */
+static int monthLength(Date first)
+{
+    int days = 28;
+    while (days < 31 && dateIsValid(buildDate(first.year, first.month, days))) {
+        days++;
+    }
 
-static void printAllItemsInDay(Date dateObj)
+    return days;
+}
+
+/**
+ * Get the first day of the week, month, or year that has a day in it.
+ *
+ * @param   view    See the VIEW_ constants.
+ * @param   day
+ */
+static Date periodStart(char view, Date day)
 {
-    PlannerItem *item = NULL;
-    char rc;
+    switch (view) {
+        case VIEW_MONTH:
+            return buildDate(day.year, day.month, 0);
+        case VIEW_YEAR:
+            return buildDate(day.year, 0, 0);
+        default:
+            return getWeek(day);
+    }
+}
 
-    while ((rc = db_interface_day(&item, dateObj)) == DB_INTERFACE__CONT) {
-        char *repTypeStr = NULL;
-        setRepType(&repTypeStr, item->rep);
-        printf("  %d) %s%s\n", appendItemMapping(item->id), item->desc, repTypeStr);
-        free(repTypeStr);
-        repTypeStr = NULL;
-        freeItem(item);
-        item = NULL;
+/**
+ * Get the day that switching views should keep in sight: today, if it's
+ * displayed, or else the fourth day.  That's the middle of the week, so a
+ * week split between months goes with the month that has most of it, and
+ * going from a month or year to a week starts with a week that's mostly in
+ * it.
+ *
+ * @param   state
+ */
+static Date viewedDay(PlannerState *state)
+{
+    Date today = todayDate();
+    Date start = state->view == VIEW_WEEK ? state->week : state->period;
+    Date todayStart = periodStart(state->view, today);
+
+    if (dateMatch(&start, &todayStart)) {
+        return today;
     }
-    printf("\n");
 
-    if (rc != DB_INTERFACE__OK) {
-        printDbErr(rc);
+    return addDays(start, 3);
+}
+
+/**
+ * Show the week, month, or year with a day in it, in whichever view is
+ * displayed.
+ *
+ * @param   state
+ * @param   day
+ */
+static void goToDay(PlannerState *state, Date day)
+{
+    state->week = getWeek(day);
+    state->period = periodStart(state->view, day);
+}
+
+/**
+ * Show the week, month, or year before or after the one displayed.  The week
+ * moves along with a month or year, so (A)dd goes into the one displayed.
+ *
+ * @param   state
+ * @param   step    -1 for before, 1 for after.
+ */
+static void movePeriod(PlannerState *state, int step)
+{
+    Date *period = &state->period;
+
+    switch (state->view) {
+        case VIEW_MONTH:
+            period->month += step;
+            if (period->month < 0) {
+                period->month = 11;
+                period->year--;
+            } else if (period->month > 11) {
+                period->month = 0;
+                period->year++;
+            }
+            break;
+        case VIEW_YEAR:
+            period->year += step;
+            break;
+        default:
+            state->week = addDays(state->week, 7 * step);
+            return;
+    }
+
+    state->week = getWeek(viewedDay(state));
+}
+
+/**
+ * Start fetching the weeks that the next command is likely to show, while
+ * it's being typed: the weeks before and after this one, and this week.
+ *
+ * @param   state
+ */
+static void prefetchNearbyWeeks(PlannerState *state)
+{
+    Date weeks[] = {
+        addDays(state->week, -7),
+        addDays(state->week, 7),
+        getWeek(todayDate()),
+    };
+
+    db_interface_prefetch_weeks(state->db, weeks, 3);
+}
+
+/**
+ * Print the line for the day that the week printer is on.
+ *
+ * @param   printer
+ */
+static void printDayHeader(WeekPrinter *printer)
+{
+    // "W YYYY-MM-DD*\n", built in place.
+    char line[DATE_STRING_SIZE + 4];
+    int len = 0;
+
+    line[len++] = weekdayLetters[printer->index];
+    line[len++] = ' ';
+    formatDate(line + len, printer->day, '-');
+    len += DATE_STRING_SIZE - 1;
+    if (dateMatch(&printer->today, &printer->day)) {
+        line[len++] = '*';
+    }
+    line[len++] = '\n';
+
+    frameAppend(printer->state, line, len);
+}
+
+/**
+ * Finish the day that the week printer is on and start the next one.
+ *
+ * @param   printer
+ */
+static void nextPrintedDay(WeekPrinter *printer)
+{
+    frameAppend(printer->state, "\n", 1);
+    datepp(&printer->day);
+    printer->index++;
+    printDayHeader(printer);
+}
+
+/**
+ * Print an item of the week under its day, first printing any days before it
+ * that don't have items.  See DbItemCallback.
+ *
+ * @param   item
+ * @param   ctx     The WeekPrinter.
+ */
+static char printWeekItem(PlannerItemView *item, void *ctx)
+{
+    WeekPrinter *printer = (WeekPrinter *) ctx;
+
+    while (!dateMatch(&item->date, &printer->day)) {
+        if (printer->index == 6) {
+            return 1; // Shouldn't happen, but it's not in this week.
+        }
+        nextPrintedDay(printer);
     }
+
+    printItem(printer->state, item);
+
+    return 0;
+}
+
+/**
+ * Print a single item under its day and add it to the item mapping.
+ *
+ * @param   state
+ * @param   item
+ */
+static void printItem(PlannerState *state, PlannerItemView *item)
+{
+    framePrintf(state, "  %d) %.*s%s\n", appendItemMapping(state, item->id),
+        item->descLen, item->desc, repTypeSuffix(item->rep));
 }
 
 /**
  * Append an id to the item mapping.
  */
-static int appendItemMapping(long id)
+static int appendItemMapping(PlannerState *state, long id)
 {
-    if (items == NULL) {
-        items = (int *) malloc(sizeof(int));
-    } else {
-        items = (int *) realloc(items, (displayKey + 1) * sizeof(int));
+    if (state->displayKey == state->itemsCap) {
+        long newCap = state->itemsCap ? state->itemsCap * 2 : 32;
+        int *itemsDum = (int *) realloc(state->items, newCap * sizeof(int));
+        if (itemsDum == NULL) {
+            return 0; // Shown as 0, which can't be selected.
+        }
+        state->items = itemsDum;
+        state->itemsCap = newCap;
     }
 
-    items[displayKey] = id;
+    state->items[state->displayKey] = id;
 
-    return ++displayKey;
+    return ++state->displayKey;
 }
 
 /**
  * Reset the item mapping, which maps the displayed number to the item id.
  */
-static void resetItemMapping()
+static void resetItemMapping(PlannerState *state)
 {
-    free(items);
-    items = NULL;
-    displayKey = 0;
+    // Memory is kept for the next week.
+    state->displayKey = 0;
 }
 
 /**
- * Set the repetition type string to display.
+ * The text shown after an item for its repetition type.  Static, so don't free
+ * it.
  *
- * @param   repTypeStr  (String to set)
  * @param   rep
  */
-static void setRepType(char **repTypeStr, char rep)
+static const char *repTypeSuffix(char rep)
 {
-    char *repTypeStrDum;
     switch (rep) {
         case REP_YEARLY:
-            repTypeStrDum = "yearly";
-            break;
+            return " (yearly)";
         default:
-            *repTypeStr = (char *) malloc(1);
-            strcpy(*repTypeStr, "");
-            return;
+            return "";
     }
-
-    *repTypeStr = (char *) malloc(strlen(repTypeStrDum) + 4);
-    strcpy(*repTypeStr, " (");
-    strcat(*repTypeStr, repTypeStrDum);
-    strcat(*repTypeStr, ")");
 }
 
 /**
- * Show the standard prompt.
+ * Read a key at the prompt and find its command.  Returns CANCEL if there's no
+ * such command, or IO_ERROR at the end of the input.
+ *
+ * @param   state
+ * @param   command     Result passed back by argument.
  */
-static char showPrompt()
+static char readCommand(PlannerState *state, PlannerCommand *command)
 {
-    char rc = 0;
-    printf("(A)dd, (E)dit, (D)elete, (P)revious, (N)ext, (C)urrent, (T)oday, (G)oto, (Q)uit\n> ");
-
+    char rc;
     char *inp = NULL;
-    if ((rc = getInput(&inp, 3, 0))) { // 3 = first char, space, null term, I think.
-        printf("Select one of the parenthesized options.\n");
-        free(inp);
-        return showPrompt();
+
+    if ((rc = getInput(state, &inp, 3, 0))) { // 3 = first char, space, null term, I think.
+        return rc;
     }
     char inpChar = tolower(inp[0]);
     free(inp);
     inp = NULL;
 
-    switch (inpChar) {
-        case 'a':
-            return addItem();
-        case 'e':
-            return editItem();
-        case 'd':
-            return deleteItem();
-        case 'p':
-            return previousWeek();
-        case 'n':
-            return nextWeek();
-        case 'g':
-            return gotoWeek();
-        case 'c':
-            return planner_interface_display_week(*currentWeek);
-        case 't':
-            return gotoToday();
-        case 'q':
-            if ((rc = db_interface_finalize())) {
-                printDbErr(rc);
-            }
-            printf("The sea was angry that day, my friends.  Like an old man trying to send back soup in a deli.\n");
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        if (commands[i].key == inpChar) {
+            *command = commands[i].run;
             return PLANNER_INTERFACE__OK;
-        default:
-            // I know this is code duplication, but atm I don't care much.
-            printf("Select one of the parenthesized options.\n");
-            return showPrompt();
+        }
     }
+
+    return PLANNER_INTERFACE__CANCEL;
 }
 
 /**
  * Prompt for adding an item.
  */
-static char addItem()
+static char addItem(PlannerState *state)
 {
     char rc;
 
     char *day = NULL;
-    if ((rc = getInput(&day, 3, 1)) == PLANNER_INTERFACE__CANCEL) { // 3 = day, newline, null terminator.
-        addFlashMessage("Usage like \"A T\" to add an item to Tuesday.\n");
+    if ((rc = getInput(state, &day, 3, 1)) == PLANNER_INTERFACE__CANCEL) { // 3 = day, newline, null terminator.
+        addFlashMessage(state, "Usage like \"A T\" to add an item to Tuesday.\n");
         return rc;
     } else if (rc) {
         free(day);
@@ -297,9 +796,6 @@ static char addItem()
 
 
     PlannerItem *item;
-    Date *dateDum = (Date *) malloc(sizeof(Date));
-
-    memcpy(dateDum, currentWeek, sizeof(*currentWeek));
 
     char dateinc = 0;
     switch (dayChar) {
@@ -324,23 +820,19 @@ static char addItem()
             break;
     }
 
-    for (char i = 0; i < dateinc; i++) {
-        datepp(dateDum);
-    }
+    Date date = addDays(state->week, dateinc);
 
-    printf("Description?\n");
+    fprintf(state->out, "Description?\n");
     char *desc = NULL;
-    if ((rc = getInput(&desc, 99, 1))) {
+    if ((rc = getInput(state, &desc, 99, 1))) {
         return rc;
     }
 
-    printf("Repeat annually? (y/n)\n");
+    fprintf(state->out, "Repeat annually? (y/n)\n");
     char *repInp = NULL;
-    if ((rc = getInput(&repInp, 3, 1))) {
+    if ((rc = getInput(state, &repInp, 3, 1))) {
         free(desc);
         desc = NULL;
-        free(dateDum);
-        dateDum = NULL;
         return rc;
     }
 
@@ -348,43 +840,41 @@ static char addItem()
     free(repInp);
     repInp = NULL;
 
-    if ((rc = buildItem(&item, 0, *dateDum, desc, rep))) {
+    if ((rc = buildItem(&item, 0, date, desc, rep))) {
         char *errMsg = NULL;
         planner_functions_build_err(&errMsg, rc);
-        printf("%s\n", errMsg);
+        fprintf(state->out, "%s\n", errMsg);
         free(errMsg);
         errMsg = NULL;
         freeItem(item);
         item = NULL;
-        free(dateDum);
-        dateDum = NULL;
+        free(desc);
+        desc = NULL;
         return PLANNER_INTERFACE__GENERAL_ERROR;
     }
     free(desc);
     desc = NULL;
 
-    if ((rc = db_interface_save(item))) {
-        printDbErr(rc);
+    if ((rc = db_interface_save(state->db, item))) {
+        printDbErr(state, rc);
     }
     freeItem(item);
     item = NULL;
-    free(dateDum);
-    dateDum = NULL;
 
-    return planner_interface_display_week(*currentWeek);
+    return PLANNER_INTERFACE__OK;
 }
 
 /**
  * Prompt for editing an item.
  */
-static char editItem()
+static char editItem(PlannerState *state)
 {
     char rc;
 
     char *itemStr = NULL;
-    if ((rc = getInput(&itemStr, 5, 1)) == PLANNER_INTERFACE__CANCEL) { // 3 for items + 1 for line break + 1 null term = 5.
+    if ((rc = getInput(state, &itemStr, 5, 1)) == PLANNER_INTERFACE__CANCEL) { // 3 for items + 1 for line break + 1 null term = 5.
         free(itemStr);
-        addFlashMessage("Usage like \"E 5\" to edit the fifth item displayed.\n");
+        addFlashMessage(state, "Usage like \"E 5\" to edit the fifth item displayed.\n");
         return rc;
     } else if (rc) {
         free(itemStr);
@@ -392,36 +882,45 @@ static char editItem()
         return rc;
     }
 
-    long id = items[atoi(itemStr) - 1];
+    int key = atoi(itemStr);
     free(itemStr);
 
-    printf("New description?\n");
+    if (key < 1 || key > state->displayKey) {
+        // The mapping keeps its memory between weeks, so this has to be
+        // checked or it'd find an item from an old week.
+        addFlashMessage(state, "No item with that number.\n");
+        return PLANNER_INTERFACE__CANCEL;
+    }
+
+    long id = state->items[key - 1];
+
+    fprintf(state->out, "New description?\n");
     char *desc = NULL;
-    if ((rc = getInput(&desc, 99, 1))) {
+    if ((rc = getInput(state, &desc, 99, 1))) {
         free(desc);
         return rc;
     }
 
-    if ((rc = db_interface_update_desc(id, desc))) {
-        printDbErr(rc);
+    if ((rc = db_interface_update_desc(state->db, id, desc))) {
+        printDbErr(state, rc);
     }
     free(desc);
 
-    return planner_interface_display_week(*currentWeek);
+    return PLANNER_INTERFACE__OK;
 }
 
 /**
  * Prompt for deleting an item.
  */
-static char deleteItem()
+static char deleteItem(PlannerState *state)
 {
     char rc;
 
     char *itemStr = NULL;
-    if ((rc = getInput(&itemStr, 3, 1)) == PLANNER_INTERFACE__CANCEL) {
+    if ((rc = getInput(state, &itemStr, 3, 1)) == PLANNER_INTERFACE__CANCEL) {
         free(itemStr);
         itemStr = NULL;
-        addFlashMessage("Usage like \"D 3\" to delete third item displayed.\n");
+        addFlashMessage(state, "Usage like \"D 3\" to delete third item displayed.\n");
         return rc;
     } else if (rc) {
         free(itemStr);
@@ -429,9 +928,9 @@ static char deleteItem()
         return rc;
     }
 
-    printf("Are you sure you want to delete item #%s? (y/n)\n", itemStr);
+    fprintf(state->out, "Are you sure you want to delete item #%s? (y/n)\n", itemStr);
     char *confirmStr = NULL;
-    if ((rc = getInput(&confirmStr, 3, 1))) {
+    if ((rc = getInput(state, &confirmStr, 3, 1))) {
         free(confirmStr);
         confirmStr = NULL;
         free(itemStr);
@@ -442,59 +941,74 @@ static char deleteItem()
     if (tolower(confirmStr[0]) != 'y') {
         free(confirmStr);
         confirmStr = NULL;
-        return planner_interface_display_week(*currentWeek);
+        free(itemStr);
+        itemStr = NULL;
+        return PLANNER_INTERFACE__OK;
     }
 
     free(confirmStr);
     confirmStr = NULL;
 
-    long id = items[atoi(itemStr) - 1];
+    int key = atoi(itemStr);
     free(itemStr);
 
-    if ((rc = db_interface_delete(id))) {
-        printDbErr(rc);
+    if (key < 1 || key > state->displayKey) {
+        // The mapping keeps its memory between weeks, so this has to be
+        // checked or it'd find an item from an old week.
+        addFlashMessage(state, "No item with that number.\n");
+        return PLANNER_INTERFACE__CANCEL;
+    }
+
+    long id = state->items[key - 1];
+
+    if ((rc = db_interface_delete(state->db, id))) {
+        printDbErr(state, rc);
     }
 
-    return planner_interface_display_week(*currentWeek);
+    return PLANNER_INTERFACE__OK;
 }
 
 /**
- * Go to previous week.
+ * Go to previous week (or month or year, in those views).
  */
-static char previousWeek()
+static char previousWeek(PlannerState *state)
 {
-    for (char i = 0; i < 7; i++) {
-        datemm(currentWeek);
-    }
+    movePeriod(state, -1);
 
-    return planner_interface_display_week(*currentWeek);
+    return PLANNER_INTERFACE__OK;
 }
 
 
 /**
- * Go to next week.
+ * Go to next week (or month or year, in those views).
  */
-static char nextWeek()
+static char nextWeek(PlannerState *state)
 {
-    for (char i = 0; i < 7; i++) {
-        datepp(currentWeek);
-    }
+    movePeriod(state, 1);
+
+    return PLANNER_INTERFACE__OK;
+}
 
-    return planner_interface_display_week(*currentWeek);
+/**
+ * Display the current week again.
+ */
+static char currentWeek(PlannerState *state)
+{
+    return PLANNER_INTERFACE__OK;
 }
 
 /**
  * Go to defined week.
  */
-static char gotoWeek()
+static char gotoWeek(PlannerState *state)
 {
     char rc;
     char *weekStr = NULL;
     char *usageMsg = "Usage like \"G 241014\" to go to Oct 14, 2024.\n";
-    if ((rc = getInput(&weekStr, 8, 1)) == PLANNER_INTERFACE__CANCEL) {
+    if ((rc = getInput(state, &weekStr, 8, 1)) == PLANNER_INTERFACE__CANCEL) {
         free(weekStr);
         weekStr = NULL;
-        addFlashMessage(usageMsg);
+        addFlashMessage(state, usageMsg);
         return rc;
     } else if (rc) {
         free(weekStr);
@@ -505,7 +1019,7 @@ static char gotoWeek()
     if (strlen(weekStr) != 6) {
         free(weekStr);
         weekStr = NULL;
-        addFlashMessage(usageMsg);
+        addFlashMessage(state, usageMsg);
         return PLANNER_INTERFACE__CANCEL;
     }
 
@@ -524,15 +1038,125 @@ static char gotoWeek()
     Date newWeek = buildDate(yr - 1, mn - 1, dy - 1);
     free(weekStr);
 
-    return planner_interface_display_week(newWeek);
+    goToDay(state, newWeek);
+
+    return PLANNER_INTERFACE__OK;
 }
 
 /**
  * Goto today.
  */
-static char gotoToday()
+static char gotoToday(PlannerState *state)
+{
+    goToDay(state, todayDate());
+
+    return PLANNER_INTERFACE__OK;
+}
+
+/**
+ * Switch to showing a week at a time.
+ */
+static char weekView(PlannerState *state)
+{
+    state->week = getWeek(viewedDay(state));
+    state->view = VIEW_WEEK;
+
+    return PLANNER_INTERFACE__OK;
+}
+
+/**
+ * Switch to showing a month at a time, with how many items are on each day.
+ */
+static char monthView(PlannerState *state)
+{
+    Date day = viewedDay(state);
+    state->view = VIEW_MONTH;
+    goToDay(state, day);
+
+    return PLANNER_INTERFACE__OK;
+}
+
+/**
+ * Switch to showing a year at a time, with how many items are on each day.
+ */
+static char yearView(PlannerState *state)
+{
+    Date day = viewedDay(state);
+    state->view = VIEW_YEAR;
+    goToDay(state, day);
+
+    return PLANNER_INTERFACE__OK;
+}
+
+/**
+ * Search item descriptions and show what's found under the week, with the
+ * dates to go to.
+ */
+static char searchItems(PlannerState *state)
 {
-    return planner_interface_display_week(todayDate());
+    char rc;
+    char *text = NULL;
+    if ((rc = getInput(state, &text, 99, 1)) == PLANNER_INTERFACE__CANCEL) {
+        addFlashMessage(state, "Usage like \"S birthday\" to find items with \"birthday\".\n");
+        return rc;
+    } else if (rc) {
+        return rc;
+    }
+
+    SearchResults results = {state, 0};
+
+    if ((rc = db_interface_search(state->db, text, SEARCH_RESULTS, addSearchResult, &results))) {
+        printDbErr(state, rc);
+    } else if (results.count == 0) {
+        char msg[strlen(text) + 32];
+        sprintf(msg, "Nothing found for \"%s\".\n", text);
+        addFlashMessage(state, msg);
+    } else {
+        addFlashMessage(state, "Go to one with (G)oto.\n");
+    }
+
+    free(text);
+    text = NULL;
+
+    return PLANNER_INTERFACE__OK;
+}
+
+/**
+ * Add a search result to the flash message.  See DbItemCallback.
+ *
+ * @param   item
+ * @param   ctx     The SearchResults.
+ */
+static char addSearchResult(PlannerItemView *item, void *ctx)
+{
+    SearchResults *results = (SearchResults *) ctx;
+
+    char dayStr[DATE_STRING_SIZE];
+    formatDate(dayStr, item->date, '-');
+
+    char line[item->descLen + 32];
+    snprintf(line, sizeof(line), "  %c %s %.*s%s", weekdayLetters[getWeekday(item->date)],
+        dayStr, item->descLen, item->desc, repTypeSuffix(item->rep));
+    addFlashMessage(results->state, line);
+    results->count++;
+
+    return 0;
+}
+
+/**
+ * Close the database and end the loop.
+ */
+static char quitPlanner(PlannerState *state)
+{
+    char rc;
+
+    if ((rc = db_interface_finalize(state->db))) {
+        printDbErr(state, rc);
+    }
+    frameAppendStr(state, "The sea was angry that day, my friends.  Like an old man trying to send back soup in a deli.\n");
+    state->quit = 1;
+
+    return PLANNER_INTERFACE__OK;
 }
 
 /**
@@ -541,17 +1165,20 @@ static char gotoToday()
  *
  * If including the *end* of user input, will want to take that into
  * consideration when deciding the len value, to make sure the newline doesn't
- * get sucked into the *next* time stdin is read.  It'll make for confusing
+ * get sucked into the *next* time the input is read.  It'll make for confusing
  * problems otherwise.
  *
+ * @param   state
  * @param   inputStr
  * @param   len
  */
-static char getInput(char **inputStr, int len, char flush)
+static char getInput(PlannerState *state, char **inputStr, int len, char flush)
 {
     *inputStr = (char *) malloc(sizeof(char) * len);
-    if (fgets(*inputStr, sizeof(char) * len, stdin) == NULL) {
-        printf("IO error.\n");
+    if (fgets(*inputStr, sizeof(char) * len, state->in) == NULL) {
+        if (ferror(state->in)) {
+            fprintf(state->out, "IO error.\n");
+        }
         free(*inputStr);
         *inputStr = NULL;
         return PLANNER_INTERFACE__IO_ERROR;
@@ -574,8 +1201,8 @@ static char getInput(char **inputStr, int len, char flush)
     }
 
     if (flush && !hasNewline) {
-        char c;
-        while ((c = getchar()) != '\n');
+        int c;
+        while ((c = fgetc(state->in)) != '\n' && c != EOF);
     }
 
     return PLANNER_INTERFACE__OK;
@@ -584,42 +1211,207 @@ static char getInput(char **inputStr, int len, char flush)
 /**
  * Add string to flash message.
  */
-static void addFlashMessage(char *str)
+static void addFlashMessage(PlannerState *state, char *str)
 {
-    if (flashMsg == NULL) {
-        flashMsg = (char *) malloc(strlen(str) + 2 * sizeof(char));
-        strcpy(flashMsg, "");
+    if (state->flashMsg == NULL) {
+        state->flashMsg = (char *) malloc(strlen(str) + 2 * sizeof(char));
+        strcpy(state->flashMsg, "");
     } else {
-        flashMsg = (char *) realloc(flashMsg, strlen(str) + strlen(flashMsg) + 2 * sizeof(char));
+        state->flashMsg = (char *) realloc(state->flashMsg,
+            strlen(str) + strlen(state->flashMsg) + 2 * sizeof(char));
     }
-    strcat(flashMsg, str);
-    strcat(flashMsg, "\n");
+    strcat(state->flashMsg, str);
+    strcat(state->flashMsg, "\n");
 }
 
 /**
  * Display flash message and flush it.
  */
-static void displayFlashMessage()
+static void displayFlashMessage(PlannerState *state)
+{
+    if (state->flashMsg == NULL) {
+        return;
+    }
+
+    frameAppendStr(state, state->flashMsg);
+    frameAppend(state, "\n", 1);
+    free(state->flashMsg);
+    state->flashMsg = NULL;
+}
+
+/**
+ * Add bytes to the end of the frame.
+ *
+ * @param   state
+ * @param   str
+ * @param   len
+ */
+static void frameAppend(PlannerState *state, const char *str, size_t len)
+{
+    if (frameReserve(state, len)) {
+        // Out of memory, so write it out in pieces instead.
+        flushFrame(state);
+        fwrite(str, 1, len, state->out);
+        return;
+    }
+
+    memcpy(state->frame + state->frameLen, str, len);
+    state->frameLen += len;
+}
+
+/**
+ * Add a string to the end of the frame.
+ *
+ * @param   state
+ * @param   str
+ */
+static void frameAppendStr(PlannerState *state, const char *str)
+{
+    frameAppend(state, str, strlen(str));
+}
+
+/**
+ * Add formatted text to the end of the frame, like printf.
+ *
+ * @param   state
+ * @param   format
+ */
+static void framePrintf(PlannerState *state, const char *format, ...)
 {
-    if (flashMsg == NULL) {
+    va_list args;
+    char *end = state->frame == NULL ? NULL : state->frame + state->frameLen;
+
+    // Try in the room that's left first, since it almost always fits.
+    va_start(args, format);
+    int len = vsnprintf(end, state->frameCap - state->frameLen, format, args);
+    va_end(args);
+
+    if (len < 0) {
         return;
     }
 
-    printf("%s\n", flashMsg);
-    free(flashMsg);
-    flashMsg = NULL;
+    if (state->frameLen + len >= state->frameCap) {
+        va_start(args, format);
+        if (frameReserve(state, len + 1)) {
+            flushFrame(state);
+            vfprintf(state->out, format, args);
+            va_end(args);
+            return;
+        }
+        vsnprintf(state->frame + state->frameLen, state->frameCap - state->frameLen,
+            format, args);
+        va_end(args);
+    }
+
+    state->frameLen += len;
+}
+
+/**
+ * Make sure that the frame has room for more bytes.  Returns true if it's out
+ * of memory.
+ *
+ * @param   state
+ * @param   extra
+ */
+static char frameReserve(PlannerState *state, size_t extra)
+{
+    if (state->frameLen + extra <= state->frameCap) {
+        return 0;
+    }
+
+    size_t newCap = state->frameCap ? state->frameCap : 4096;
+    while (newCap < state->frameLen + extra) {
+        newCap *= 2;
+    }
+
+    char *frameDum = (char *) realloc(state->frame, newCap);
+    if (frameDum == NULL) {
+        return 1;
+    }
+    state->frame = frameDum;
+    state->frameCap = newCap;
+
+    return 0;
+}
+
+/**
+ * Write the frame out with one write and start a new one.  Anything printed
+ * before it with stdio goes out first.
+ *
+ * @param   state
+ */
+static void flushFrame(PlannerState *state)
+{
+    fflush(state->out);
+
+    int fd = fileno(state->out);
+    if (fd < 0) {
+        // Not a real file (like from fmemopen), so it has to go through stdio.
+        fwrite(state->frame, 1, state->frameLen, state->out);
+        fflush(state->out);
+        state->frameLen = 0;
+        return;
+    }
+
+    size_t written = 0;
+    while (written < state->frameLen) {
+        ssize_t rc = write(fd, state->frame + written, state->frameLen - written);
+        if (rc < 0 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            break; // Nowhere to show an error anyway.
+        }
+        written += rc;
+    }
+
+    state->frameLen = 0;
 }
 
 /**
  * Print database error from return code.
  *
+ * @param   state
  * @param   errCode
  */
-static void printDbErr(char errCode)
+static void printDbErr(PlannerState *state, char errCode)
 {
     char *error = NULL;
-    db_interface_build_err(&error, errCode);
-    printf("Database error: %s\n", error);
+    db_interface_build_err(state->db, &error, errCode);
+    framePrintf(state, "Database error: %s\n", error);
     free(error);
     error = NULL;
 }
+
+/**
+ * Print progress of updating the database.  See DbUpdateCallback.  Batches
+ * only print about once a second, so big updates don't flood the screen.
+ * Updates run inside db_interface_initialize, so keeping track per thread is
+ * enough for databases being opened on different threads at once.
+ */
+static void printUpdateProgress(
+    int version,
+    char *desc,
+    long rows,
+    double seconds,
+    char done
+) {
+    static _Thread_local double lastPrinted = 0;
+
+    if (!done && seconds - lastPrinted < 1) {
+        return;
+    }
+    lastPrinted = done ? 0 : seconds;
+
+    // Stderr, so it doesn't end up in an export that's going to stdout.
+    fprintf(
+        stderr,
+        "%s database to version %d: %s (%ld rows, %.3fs%s).\n",
+        done ? "Updated" : "Updating",
+        version,
+        desc,
+        rows,
+        seconds,
+        done ? "" : " so far"
+    );
+}
@@ -1,7 +1,10 @@
 #ifndef plannerinterface_h
 #define plannerinterface_h
 
+#include <stdio.h>
+
 #include "date-functions.h"
+#include "db-interface.h"
 
 // Constants
 
@@ -14,8 +17,8 @@
 #define PLANNER_INTERFACE__CANCEL 4
 
 // Functions
-char planner_interface_initialize(char *filename);
+char planner_interface_initialize(DbHandle **db, char *filename);
 
-char planner_interface_display_week(Date dayObj);
+char planner_interface_run(DbHandle *db, FILE *in, FILE *out);
 
 #endif
@@ -0,0 +1,793 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "serve-handler.h"
+#include "date-functions.h"
+#include "db-interface.h"
+#include "planner-functions.h"
+
+void testServe();
+void testPipelined();
+void testLongRequest();
+void testListen();
+void testListenKeepsOtherFiles();
+void testListenOutOfFiles();
+void testStopBeforeListen();
+void *runListen(void *arg);
+
+void deleteFileIfExists(char *filename);
+void printError(char *desc, char rc);
+FILE *writeInput(char *text);
+int connectClient(char *path);
+void sendText(int fd, char *text);
+char *readLines(int fd, int lines);
+char *readOutput(FILE *file);
+
+char *testDb = "./testing.db";
+DbHandle *handle = NULL;
+char *testSocket = "./testing.sock";
+
+/**
+ * What runListen runs with and what it got back.
+ */
+typedef struct listen_run {
+    ServeListener listener;
+    ServeStats stats;
+    char rc;
+
+    /** @var Set once serve_handler_listen has returned. */
+    volatile char done;
+} ListenRun;
+
+int main()
+{
+    testServe();
+    testPipelined();
+    testLongRequest();
+    testListen();
+    testListenKeepsOtherFiles();
+    testListenOutOfFiles();
+    testStopBeforeListen();
+
+    deleteFileIfExists(testDb);
+}
+
+void testServe()
+{
+    printf("...Starting testServe.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    FILE *input = writeInput(
+        "{\"op\":\"add\",\"date\":\"2024-12-25\",\"description\":\"Christmas \\\"dinner\\\"\",\"req\":1}\n"
+        "{ \"req\" : \"b\", \"op\" : \"add\", \"date\" : \"2024-03-05\","
+            " \"description\" : \"Birthday \\u00e9\", \"repetition\" : \"yearly\" }\n"
+        "{\"op\":\"add\",\"date\":\"2024-12-27\",\"description\":\"Boxing day?\",\"extra\":null}\r\n"
+        "{\"op\":\"edit\",\"id\":1,\"description\":\"Christmas\\tlunch\"}\n"
+        "{\"op\":\"delete\",\"id\":3}\n"
+        "{\"op\":\"edit\",\"id\":4294967298,\"description\":\"hijacked\"}\n"
+        "{\"op\":\"delete\",\"id\":4294967297}\n"
+        "{\"op\":\"week\",\"date\":\"2024-12-25\",\"req\":6}\n"
+        "{\"op\":\"range\",\"from\":\"2024-03-01\",\"to\":\"2024-03-31\"}\n"
+        "{\"op\":\"edit\",\"id\":99,\"description\":\"Nothing\"}\n"
+        "{\"op\":\"delete\"}\n"
+        "{\"op\":\"add\",\"date\":\"2023-02-29\",\"description\":\"Not a leap year\"}\n"
+        "{\"req\":11,\"op\":\"dance\"}\n"
+        "not json\n"
+        "{\"op\":\"ping\",\"req\":\"x\\\"y\"}\n"
+        "\n"
+        "{\"op\":\"week\",\"date\":\"2024-12-25\""
+    );
+    FILE *output = tmpfile();
+
+    ServeStats stats;
+
+    if ((rc = serve_handler_run(handle, input, output, &stats))) {
+        char *str;
+        serve_handler_build_err(&str, rc);
+        printf("ERROR serving: %s\n", str);
+        free(str);
+        fclose(input);
+        fclose(output);
+        return;
+    }
+    fclose(input);
+
+    char *result = readOutput(output);
+    char *expected =
+        "{\"req\":1,\"ok\":true,\"id\":1}\n"
+        "{\"req\":\"b\",\"ok\":true,\"id\":2}\n"
+        "{\"ok\":true,\"id\":3}\n"
+        "{\"ok\":true}\n"
+        "{\"ok\":true}\n"
+        "{\"ok\":false,\"error\":\"no item with that id\"}\n"
+        "{\"ok\":false,\"error\":\"no item with that id\"}\n"
+        "{\"req\":6,\"ok\":true,\"week\":\"2024-12-22\",\"items\":["
+            "{\"id\":1,\"date\":\"2024-12-25\",\"description\":\"Christmas\\u0009lunch\","
+            "\"repetition\":\"none\"}]}\n"
+        "{\"ok\":true,\"items\":["
+            "{\"id\":2,\"date\":\"2024-03-05\",\"description\":\"Birthday \xc3\xa9\","
+            "\"repetition\":\"yearly\"}]}\n"
+        "{\"ok\":false,\"error\":\"no item with that id\"}\n"
+        "{\"ok\":false,\"error\":\"expected an item id\"}\n"
+        "{\"ok\":false,\"error\":\"expected a date (YYYY-MM-DD)\"}\n"
+        "{\"req\":11,\"ok\":false,\"error\":\"unknown op\"}\n"
+        "{\"ok\":false,\"error\":\"expected a JSON object\"}\n"
+        "{\"req\":\"x\\\"y\",\"ok\":true}\n"
+        "{\"ok\":false,\"error\":\"expected a comma or the end of the object\"}\n";
+
+    if (strcmp(result, expected) != 0) {
+        printf("FAILURE: Expected output:\n%sBut found:\n%s", expected, result);
+    }
+    free(result);
+
+    if (stats.requests != 16 || stats.failed != 8) {
+        printf("FAILURE: Expected 16 requests with 8 failed, but found %ld with %ld.\n",
+            stats.requests, stats.failed);
+    }
+
+    // Everything but the unfinished last line arrives in one read.
+    if (stats.flushes != 2) {
+        printf("FAILURE: Expected 2 flushes, but found %ld.\n", stats.flushes);
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testServe.\n");
+}
+
+/**
+ * Send a lot of requests without waiting, and check that they're all answered
+ * in order without a write for every one.
+ */
+void testPipelined()
+{
+    printf("...Starting testPipelined.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    int items = 50;
+    int requests = 20000;
+
+    for (int i = 0; i < items; i++) {
+        PlannerItem item = {0, buildDate(23, 11, i % 7), "An item", REP_NONE};
+        if ((rc = db_interface_save(handle, &item))) {
+            printError("saving", rc);
+            return;
+        }
+    }
+
+    FILE *input = tmpfile();
+    for (int i = 0; i < requests; i++) {
+        fprintf(input, "{\"op\":\"week\",\"date\":\"2024-12-0%d\",\"req\":%d}\n", i % 7 + 1, i);
+    }
+    rewind(input);
+
+    FILE *output = tmpfile();
+    ServeStats stats;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if ((rc = serve_handler_run(handle, input, output, &stats))) {
+        printf("ERROR serving: %d\n", rc);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    fclose(input);
+
+    char *result = readOutput(output);
+    int lines = 0;
+    char tag[32];
+
+    for (char *line = result; *line != '\0'; line = strchr(line, '\n') + 1) {
+        snprintf(tag, sizeof(tag), "{\"req\":%d,\"ok\":true,", lines);
+        if (strncmp(line, tag, strlen(tag)) != 0) {
+            printf("FAILURE: Expected response %d to start with %s.\n", lines, tag);
+            break;
+        }
+        lines++;
+    }
+
+    if (lines != requests || stats.failed != 0) {
+        printf("FAILURE: Expected %d responses with none failed, but found %d with %ld.\n",
+            requests, lines, stats.failed);
+    }
+
+    // Every item is in the week of Dec 1.
+    char *lastItem = strstr(result, "{\"id\":50,");
+    if (lastItem == NULL) {
+        printf("FAILURE: Expected every item in the responses.\n");
+    }
+    free(result);
+
+    if (stats.flushes * 100 > requests) {
+        printf("FAILURE: Expected far fewer flushes than %d requests, but found %ld.\n",
+            requests, stats.flushes);
+    }
+
+    printf("...Answered %ld requests in %.3fs (%.1f us each) with %ld flushes.\n",
+        stats.requests, seconds, seconds * 1e6 / requests, stats.flushes);
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testPipelined.\n");
+}
+
+
+/**
+ * A line that never ends is answered with an error instead of being buffered
+ * for as long as it keeps coming.
+ */
+void testLongRequest()
+{
+    printf("...Starting testLongRequest.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    FILE *input = tmpfile();
+    fputs("{\"op\":\"ping\"}\n", input);
+    for (int i = 0; i < 4 << 20; i++) {
+        fputc('x', input);
+    }
+    fputs("\n{\"op\":\"ping\"}\n", input);
+    rewind(input);
+
+    FILE *output = tmpfile();
+    ServeStats stats;
+
+    if ((rc = serve_handler_run(handle, input, output, &stats))) {
+        printf("FAILURE: Expected OK from serving, but found %d.\n", rc);
+    }
+    fclose(input);
+
+    char *result = readOutput(output);
+    char *expected =
+        "{\"ok\":true}\n"
+        "{\"ok\":false,\"error\":\"request too long\"}\n";
+
+    if (strcmp(result, expected) != 0) {
+        printf("FAILURE: Expected output:\n%sBut found:\n%s", expected, result);
+    }
+    free(result);
+
+    if (stats.requests != 2 || stats.failed != 1) {
+        printf("FAILURE: Expected 2 requests with 1 failed, but found %ld with %ld.\n",
+            stats.requests, stats.failed);
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testLongRequest.\n");
+}
+
+/**
+ * Several clients at once, with requests split across writes and pipelined,
+ * each getting its own answers.
+ */
+void testListen()
+{
+    printf("...Starting testListen.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    PlannerItem item = {0, buildDate(23, 11, 24), "Christmas", REP_NONE};
+    if ((rc = db_interface_save(handle, &item))) {
+        printError("saving", rc);
+        return;
+    }
+
+    ListenRun run;
+    pthread_t thread;
+
+    if (serve_handler_listener_initialize(&run.listener)) {
+        printf("ERROR: Could not initialize the listener.\n");
+        return;
+    }
+    if (pthread_create(&thread, NULL, runListen, &run)) {
+        printf("ERROR: Could not start the thread.\n");
+        serve_handler_listener_finalize(&run.listener);
+        return;
+    }
+
+    int first = connectClient(testSocket);
+    int second = connectClient(testSocket);
+    int third = connectClient(testSocket);
+
+    if (first < 0 || second < 0 || third < 0) {
+        printf("ERROR: Could not connect.\n");
+        serve_handler_stop(&run.listener);
+        pthread_join(thread, NULL);
+        serve_handler_listener_finalize(&run.listener);
+        return;
+    }
+
+    // Half a request, which shouldn't hold up the others.
+    sendText(first, "{\"op\":\"week\",\"req\":\"a\",");
+
+    sendText(second, "{\"op\":\"ping\",\"req\":1}\n{\"op\":\"week\",\"date\":\"2024-12-25\",\"req\":2}\n");
+    char *result = readLines(second, 2);
+    char *expected =
+        "{\"req\":1,\"ok\":true}\n"
+        "{\"req\":2,\"ok\":true,\"week\":\"2024-12-22\",\"items\":["
+            "{\"id\":1,\"date\":\"2024-12-25\",\"description\":\"Christmas\",\"repetition\":\"none\"}]}\n";
+    if (strcmp(result, expected) != 0) {
+        printf("FAILURE: Expected the second client to get:\n%sBut found:\n%s", expected, result);
+    }
+    free(result);
+
+    sendText(first, "\"date\":\"2024-12-01\"}\n");
+    result = readLines(first, 1);
+    expected = "{\"req\":\"a\",\"ok\":true,\"week\":\"2024-12-01\",\"items\":[]}\n";
+    if (strcmp(result, expected) != 0) {
+        printf("FAILURE: Expected the first client to get:\n%sBut found:\n%s", expected, result);
+    }
+    free(result);
+
+    // The last request doesn't need a newline if the client stops sending.
+    sendText(third, "{\"op\":\"delete\",\"id\":1}");
+    shutdown(third, SHUT_WR);
+    result = readLines(third, 1);
+    if (strcmp(result, "{\"ok\":true}\n") != 0) {
+        printf("FAILURE: Expected the third client to delete, but found %s", result);
+    }
+    free(result);
+
+    close(first);
+    close(second);
+    close(third);
+
+    serve_handler_stop(&run.listener);
+    pthread_join(thread, NULL);
+    serve_handler_listener_finalize(&run.listener);
+
+    if (run.rc) {
+        printf("FAILURE: Expected OK from listening, but found %d.\n", run.rc);
+    }
+
+    if (run.stats.connections != 3 || run.stats.requests != 4 || run.stats.failed != 0) {
+        printf("FAILURE: Expected 3 clients with 4 requests and none failed, but found"
+            " %ld with %ld and %ld failed.\n",
+            run.stats.connections, run.stats.requests, run.stats.failed);
+    }
+
+    if (access(testSocket, F_OK) == 0) {
+        printf("FAILURE: Expected the socket to be removed.\n");
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testListen.\n");
+}
+
+/**
+ * Anything at the socket's path that isn't a socket is left alone, both when
+ * starting and when stopping.
+ */
+void testListenKeepsOtherFiles()
+{
+    printf("...Starting testListenKeepsOtherFiles.\n");
+
+    deleteFileIfExists(testDb);
+    deleteFileIfExists(testSocket);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    // Like giving the database as the socket by mistake.
+    FILE *file = fopen(testSocket, "w");
+    fclose(file);
+
+    // On a thread, so it can still be stopped if it does start listening.
+    ListenRun run = {.done = 0};
+    pthread_t thread;
+
+    if (serve_handler_listener_initialize(&run.listener)) {
+        printf("ERROR: Could not initialize the listener.\n");
+        return;
+    }
+    if (pthread_create(&thread, NULL, runListen, &run)) {
+        printf("ERROR: Could not start the thread.\n");
+        serve_handler_listener_finalize(&run.listener);
+        return;
+    }
+    for (int tries = 0; tries < 200 && !run.done; tries++) {
+        usleep(10000);
+    }
+    if (!run.done) {
+        printf("FAILURE: Expected not to listen on the file.\n");
+        serve_handler_stop(&run.listener);
+    }
+    pthread_join(thread, NULL);
+
+    if (run.rc != SERVE_HANDLER__SOCKET_ERROR) {
+        printf("FAILURE: Expected SERVE_HANDLER__SOCKET_ERROR, but found %d.\n", run.rc);
+    }
+    if (access(testSocket, F_OK) != 0) {
+        printf("FAILURE: Expected the file to be left alone when starting.\n");
+    }
+    remove(testSocket);
+    serve_handler_listener_finalize(&run.listener);
+
+    // Replaced while listening.
+    run.done = 0;
+
+    if (serve_handler_listener_initialize(&run.listener)) {
+        printf("ERROR: Could not initialize the listener.\n");
+        return;
+    }
+
+    if (pthread_create(&thread, NULL, runListen, &run)) {
+        printf("ERROR: Could not start the thread.\n");
+        serve_handler_listener_finalize(&run.listener);
+        return;
+    }
+
+    // Once it's answered, it's in the loop and can be stopped.
+    int client = connectClient(testSocket);
+    if (client < 0) {
+        printf("ERROR: Could not connect.\n");
+    } else {
+        sendText(client, "{\"op\":\"ping\"}\n");
+        free(readLines(client, 1));
+        close(client);
+    }
+
+    remove(testSocket);
+    file = fopen(testSocket, "w");
+    fclose(file);
+
+    serve_handler_stop(&run.listener);
+    pthread_join(thread, NULL);
+    serve_handler_listener_finalize(&run.listener);
+
+    if (access(testSocket, F_OK) != 0) {
+        printf("FAILURE: Expected the file to be left alone when stopping.\n");
+    }
+    remove(testSocket);
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testListenKeepsOtherFiles.\n");
+}
+
+/**
+ * A client that can't be accepted for lack of file descriptors waits without
+ * the listener spinning, and is answered once there's one.
+ */
+void testListenOutOfFiles()
+{
+    printf("...Starting testListenOutOfFiles.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    ListenRun run;
+    pthread_t thread;
+
+    if (serve_handler_listener_initialize(&run.listener)) {
+        printf("ERROR: Could not initialize the listener.\n");
+        return;
+    }
+    if (pthread_create(&thread, NULL, runListen, &run)) {
+        printf("ERROR: Could not start the thread.\n");
+        serve_handler_listener_finalize(&run.listener);
+        return;
+    }
+
+    int first = connectClient(testSocket);
+    if (first < 0) {
+        printf("ERROR: Could not connect.\n");
+        serve_handler_stop(&run.listener);
+        pthread_join(thread, NULL);
+        serve_handler_listener_finalize(&run.listener);
+        return;
+    }
+    sendText(first, "{\"op\":\"ping\"}\n");
+    free(readLines(first, 1));
+
+    // Use up every file descriptor but one, under a low limit, and connect
+    // with that one.
+    struct rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    rlim_t oldLimit = limit.rlim_cur;
+
+    int spares[64];
+    int spareCount = 0;
+    int fd = dup(first);
+    close(fd);
+    limit.rlim_cur = fd + 8;
+    setrlimit(RLIMIT_NOFILE, &limit);
+
+    while (spareCount < 64 && (fd = dup(first)) >= 0) {
+        spares[spareCount++] = fd;
+    }
+    close(spares[--spareCount]);
+
+    int second = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, testSocket);
+
+    if (second < 0 || connect(second, (struct sockaddr *) &addr, sizeof(addr))) {
+        printf("ERROR: Could not connect with the last file descriptor.\n");
+    }
+
+    struct timespec before, after;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &before);
+    usleep(300000);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &after);
+
+    double cpuMs = (after.tv_sec - before.tv_sec) * 1e3
+        + (after.tv_nsec - before.tv_nsec) / 1e6;
+    if (cpuMs > 100) {
+        printf("FAILURE: Expected the listener to wait, but it used %.0fms of CPU in 300ms.\n",
+            cpuMs);
+    }
+
+    while (spareCount > 0) {
+        close(spares[--spareCount]);
+    }
+    limit.rlim_cur = oldLimit;
+    setrlimit(RLIMIT_NOFILE, &limit);
+
+    sendText(second, "{\"op\":\"ping\",\"req\":2}\n");
+    char *result = readLines(second, 1);
+    if (strcmp(result, "{\"req\":2,\"ok\":true}\n") != 0) {
+        printf("FAILURE: Expected the waiting client to be answered, but found %s", result);
+    }
+    free(result);
+
+    close(first);
+    close(second);
+
+    serve_handler_stop(&run.listener);
+    pthread_join(thread, NULL);
+    serve_handler_listener_finalize(&run.listener);
+
+    if (run.rc) {
+        printf("FAILURE: Expected OK from listening, but found %d.\n", run.rc);
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testListenOutOfFiles.\n");
+}
+
+/**
+ * Stopping a listener before it's listening still stops it, as soon as it
+ * starts.
+ */
+void testStopBeforeListen()
+{
+    printf("...Starting testStopBeforeListen.\n");
+
+    deleteFileIfExists(testDb);
+
+    char rc;
+
+    if ((rc = db_interface_initialize(&handle, testDb))) {
+        printf("ERROR: Could not initialize db. %d\n", rc);
+        return;
+    }
+
+    ListenRun run = {.done = 0};
+    pthread_t thread;
+
+    if (serve_handler_listener_initialize(&run.listener)) {
+        printf("ERROR: Could not initialize the listener.\n");
+        return;
+    }
+    serve_handler_stop(&run.listener);
+
+    if (pthread_create(&thread, NULL, runListen, &run)) {
+        printf("ERROR: Could not start the thread.\n");
+        serve_handler_listener_finalize(&run.listener);
+        return;
+    }
+    for (int tries = 0; tries < 200 && !run.done; tries++) {
+        usleep(10000);
+    }
+    if (!run.done) {
+        printf("FAILURE: Expected listening to stop straight away.\n");
+        // It can't be stopped any other way, so leave it.
+        pthread_detach(thread);
+        return;
+    }
+    pthread_join(thread, NULL);
+    serve_handler_listener_finalize(&run.listener);
+
+    if (run.rc) {
+        printf("FAILURE: Expected OK from listening, but found %d.\n", run.rc);
+    }
+    if (access(testSocket, F_OK) == 0) {
+        printf("FAILURE: Expected the socket to be removed.\n");
+    }
+
+    if ((rc = db_interface_finalize(handle))) {
+        printError("during finalization", rc);
+        return;
+    }
+
+    printf("...Completed testStopBeforeListen.\n");
+}
+
+// Helper functions below this line.
+
+void deleteFileIfExists(char *filename)
+{
+    FILE *file;
+
+    if ((file = fopen(filename, "r"))) {
+        fclose(file);
+        remove(filename);
+    }
+}
+
+void printError(char *desc, char rc) {
+    char *str;
+    db_interface_build_err(handle, &str, rc);
+    printf("ERROR %s: %s\n", desc, str);
+    free(str);
+}
+
+/**
+ * Write text to a temporary file and rewind it, to use as input.
+ */
+FILE *writeInput(char *text)
+{
+    FILE *file = tmpfile();
+    fputs(text, file);
+    rewind(file);
+
+    return file;
+}
+
+/**
+ * Read everything that was written to a temporary file, and close it.
+ */
+char *readOutput(FILE *file)
+{
+    long len = ftell(file);
+    char *text = malloc(len + 1);
+
+    rewind(file);
+    text[fread(text, 1, len, file)] = '\0';
+    fclose(file);
+
+    return text;
+}
+
+/**
+ * Thread for the listening tests.
+ *
+ * @param   arg     The ListenRun.
+ */
+void *runListen(void *arg)
+{
+    ListenRun *run = (ListenRun *) arg;
+
+    run->rc = serve_handler_listen(handle, testSocket, &run->listener, &run->stats);
+    run->done = 1;
+
+    return NULL;
+}
+
+/**
+ * Connect to the socket, waiting a little for it to be there.  Returns -1 if
+ * it never is.
+ */
+int connectClient(char *path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    for (int tries = 0; tries < 500; tries++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+        close(fd);
+        usleep(10000);
+    }
+
+    return -1;
+}
+
+void sendText(int fd, char *text)
+{
+    if (write(fd, text, strlen(text)) != strlen(text)) {
+        printf("ERROR: Could not send to the socket.\n");
+    }
+}
+
+/**
+ * Read from the socket until that many lines have come back.
+ */
+char *readLines(int fd, int lines)
+{
+    size_t cap = 4096;
+    size_t len = 0;
+    char *text = malloc(cap);
+
+    while (lines > 0) {
+        ssize_t got = read(fd, text + len, cap - len - 1);
+        if (got <= 0) {
+            break;
+        }
+        for (ssize_t i = 0; i < got; i++) {
+            lines -= text[len + i] == '\n';
+        }
+        len += got;
+    }
+    text[len] = '\0';
+
+    return text;
+}
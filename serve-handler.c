@@ -0,0 +1,1179 @@
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "serve-handler.h"
+
+#include "date-functions.h"
+#include "db-interface.h"
+#include "json-functions.h"
+#include "planner-functions.h"
+
+// Answers requests for as long as the other end stays connected, so whatever
+// is there (a status bar, an editor plugin, the thin client) doesn't pay for
+// starting up and opening the database every time.  Requests and responses
+// are JSON Lines, one flat object per line:
+//
+//   {"op":"ping"}
+//   {"op":"week","date":"2026-10-17"}                  Items in that week.
+//   {"op":"range","from":"2026-10-01","to":"2026-10-31"}
+//   {"op":"add","date":"2026-10-17","description":"...","repetition":"yearly"}
+//   {"op":"edit","id":3,"description":"..."}
+//   {"op":"delete","id":3}
+//
+// Every request gets exactly one response line, in order, with "ok" and
+// whatever the op returns, or "error" and why.  A "req" in the request (a
+// string or number) is echoed back, so the client can match them up.
+//
+// Requests can be pipelined: everything that arrives in one read is answered
+// before the responses are written, so a burst of requests costs one write.
+// The same connection handling serves stdin and stdout, or any number of
+// clients on a Unix socket from one poll loop.
+
+/** How much input is read at a time, to start with. */
+#define INPUT_SIZE 65536
+
+/**
+ * Longest a request line can be, in bytes.  A client that sends more than
+ * this without a newline is answered with an error and disconnected, so it
+ * can't make the server buffer without end.
+ */
+#define REQUEST_MAX (1 << 20)
+
+/**
+ * Once this much output is waiting, a connection stops answering (and
+ * reading) until it's been written, so a client that doesn't read can't make
+ * the server buffer without end.
+ */
+#define OUTPUT_FLUSH 65536
+
+/** Connections waiting to be accepted on the socket. */
+#define LISTEN_BACKLOG 64
+
+/**
+ * When there are no file descriptors left to accept with, how long to wait
+ * before trying again (in ms), if no connection closes first.
+ */
+#define ACCEPT_RETRY_MS 100
+
+/** Dates in requests are YYYY-MM-DD. */
+#define DATE_FORMAT_ERR "expected a date (YYYY-MM-DD)"
+
+/**
+ * A request, parsed in place in its line.  Strings that weren't in the
+ * request are NULL.
+ */
+typedef struct serve_request {
+    char *op;
+    char *date;
+    char *from;
+    char *to;
+    char *description;
+    char *repetition;
+
+    /** @var Item id, if hasId. */
+    long id;
+    char hasId;
+
+    /** @var The "req" value exactly as it was sent, to echo back. */
+    const char *tag;
+    size_t tagLen;
+} ServeRequest;
+
+/**
+ * One client: requests that haven't been answered and responses that haven't
+ * been written.
+ */
+typedef struct serve_conn {
+    /** @var Handle that requests are answered from. */
+    DbHandle *db;
+
+    /** @var Socket, or -1 when writing to output instead. */
+    int fd;
+    FILE *output;
+
+    char *in;
+    size_t inLen;
+    size_t inCap;
+
+    char *out;
+    size_t outLen;
+    size_t outCap;
+
+    /** @var How much of out has been sent on the socket. */
+    size_t outSent;
+
+    /** @var Set if the output couldn't grow, which stops the connection. */
+    char outOfMemory;
+
+    /** @var Set if anything's been written since the output was flushed. */
+    char unflushed;
+
+    /** @var Set once the client has finished sending. */
+    char eof;
+
+    /** @var Room to build an error message that isn't a constant. */
+    char errBuf[256];
+
+    ServeStats *stats;
+} ServeConn;
+
+/**
+ * An op, which appends its fields to the response and returns NULL, or
+ * returns why it didn't work.
+ */
+typedef const char *(*ServeCommand)(ServeConn *conn, ServeRequest *req);
+
+/**
+ * An op and its name in requests.
+ */
+typedef struct serve_command_entry {
+    char *name;
+    ServeCommand run;
+} ServeCommandEntry;
+
+/**
+ * A string key in requests and where it goes.
+ */
+typedef struct serve_string_key {
+    char *name;
+    size_t offset;
+} ServeStringKey;
+
+static char openSocket(char *socketPath, int *listenFd, struct stat *created);
+static void removeSocket(char *socketPath, struct stat *created);
+static char acceptClients(DbHandle *db, int listenFd, ServeConn **conns, struct pollfd **fds,
+    int *count, int *cap, char *paused, ServeStats *stats);
+static char initConn(ServeConn *conn, DbHandle *db, int fd, FILE *output, ServeStats *stats);
+static void freeConn(ServeConn *conn);
+static char readConn(ServeConn *conn, int fd);
+static void rejectLongLine(ServeConn *conn);
+static char runLines(ServeConn *conn);
+static char sendConn(ServeConn *conn);
+static size_t pendingOutput(ServeConn *conn);
+static void runLine(ServeConn *conn, char *line);
+static const char *pingCommand(ServeConn *conn, ServeRequest *req);
+static const char *weekCommand(ServeConn *conn, ServeRequest *req);
+static const char *rangeCommand(ServeConn *conn, ServeRequest *req);
+static const char *addCommand(ServeConn *conn, ServeRequest *req);
+static const char *editCommand(ServeConn *conn, ServeRequest *req);
+static const char *deleteCommand(ServeConn *conn, ServeRequest *req);
+static const char *dbError(ServeConn *conn, char dbRc);
+static char appendItem(PlannerItemView *item, void *ctx);
+static const char *parseRequest(char *line, ServeRequest *req);
+static const char *requestField(char *key, JsonValue *value, void *ctx);
+static void appendBytes(ServeConn *conn, const char *bytes, size_t len);
+static void appendStr(ServeConn *conn, const char *str);
+static void appendLong(ServeConn *conn, long value);
+static void appendDate(ServeConn *conn, Date date);
+static void appendJsonBytes(const char *bytes, size_t len, void *ctx);
+static char writeOut(ServeConn *conn, char flush);
+
+/** What each op does. */
+static const ServeCommandEntry commands[] = {
+    {"ping", pingCommand},
+    {"week", weekCommand},
+    {"range", rangeCommand},
+    {"add", addCommand},
+    {"edit", editCommand},
+    {"delete", deleteCommand},
+};
+
+/** The string keys that requests can have.  Any others are ignored. */
+static const ServeStringKey stringKeys[] = {
+    {"op", offsetof(ServeRequest, op)},
+    {"date", offsetof(ServeRequest, date)},
+    {"from", offsetof(ServeRequest, from)},
+    {"to", offsetof(ServeRequest, to)},
+    {"description", offsetof(ServeRequest, description)},
+    {"repetition", offsetof(ServeRequest, repetition)},
+};
+
+/**
+ * Answer requests from input until it ends, writing the responses to output.
+ * The database needs to have already been initialized.  Input is read
+ * straight from its file descriptor, so nothing should have been read from it
+ * through the FILE.  Returns RC from constants; requests that fail are
+ * counted in stats instead.
+ *
+ * @param   db
+ * @param   input   Where requests come from (can be stdin).
+ * @param   output  Where responses go.
+ * @param   stats   Results passed back by argument.
+ */
+char serve_handler_run(DbHandle *db, FILE *input, FILE *output, ServeStats *stats)
+{
+    memset(stats, 0, sizeof(ServeStats));
+
+    ServeConn conn;
+    if (initConn(&conn, db, -1, output, stats)) {
+        return SERVE_HANDLER__OUT_OF_MEMORY;
+    }
+
+    int fd = fileno(input);
+    char rc = SERVE_HANDLER__OK;
+
+    while (!conn.eof) {
+        if ((rc = readConn(&conn, fd))) {
+            break;
+        }
+
+        // Answer every whole line that's arrived before flushing anything.
+        while (runLines(&conn)) {
+            if (writeOut(&conn, 0)) {
+                rc = SERVE_HANDLER__IO_ERROR;
+                break;
+            }
+        }
+
+        if (rc == SERVE_HANDLER__OK && conn.outOfMemory) {
+            rc = SERVE_HANDLER__OUT_OF_MEMORY;
+        }
+        if (rc == SERVE_HANDLER__OK && writeOut(&conn, 1)) {
+            rc = SERVE_HANDLER__IO_ERROR;
+        }
+        if (rc) {
+            break;
+        }
+    }
+
+    freeConn(&conn);
+
+    return rc;
+}
+
+/**
+ * Set up a listener for serve_handler_listen, so that it can be stopped
+ * before it has even started.  Returns RC from constants.
+ *
+ * @param   listener
+ */
+char serve_handler_listener_initialize(ServeListener *listener)
+{
+    if (pipe(listener->stopPipe)) {
+        listener->stopPipe[0] = listener->stopPipe[1] = -1;
+        return SERVE_HANDLER__SOCKET_ERROR;
+    }
+    fcntl(listener->stopPipe[1], F_SETFL, O_NONBLOCK);
+
+    return SERVE_HANDLER__OK;
+}
+
+/**
+ * Free a listener, once serve_handler_listen has returned and nothing can
+ * call serve_handler_stop with it any more.
+ *
+ * @param   listener
+ */
+void serve_handler_listener_finalize(ServeListener *listener)
+{
+    if (listener->stopPipe[0] != -1) {
+        close(listener->stopPipe[0]);
+        close(listener->stopPipe[1]);
+        listener->stopPipe[0] = listener->stopPipe[1] = -1;
+    }
+}
+
+/**
+ * Answer requests from any number of clients on a Unix socket, until
+ * serve_handler_stop is called with the listener.  The database and the
+ * listener need to have already been initialized.  Returns RC from
+ * constants; clients that go wrong are just disconnected.
+ *
+ * @param   db
+ * @param   socketPath  Where to make the socket.  Removed when it stops, if
+ *                      it's still the one that was made.
+ * @param   listener
+ * @param   stats       Results passed back by argument.
+ */
+char serve_handler_listen(DbHandle *db, char *socketPath, ServeListener *listener, ServeStats *stats)
+{
+    memset(stats, 0, sizeof(ServeStats));
+
+    int listenFd;
+    struct stat created;
+    char rc;
+
+    if ((rc = openSocket(socketPath, &listenFd, &created))) {
+        return rc;
+    }
+
+    // fds has the stop pipe and the socket first, and then a pollfd for each
+    // connection in conns.
+    int count = 0;
+    int cap = 16;
+    char acceptPaused = 0;
+    ServeConn *conns = malloc(cap * sizeof(ServeConn));
+    struct pollfd *fds = malloc((cap + 2) * sizeof(struct pollfd));
+
+    if (conns == NULL || fds == NULL) {
+        rc = SERVE_HANDLER__OUT_OF_MEMORY;
+    }
+
+    while (rc == SERVE_HANDLER__OK) {
+        fds[0] = (struct pollfd) {listener->stopPipe[0], POLLIN, 0};
+        // The socket stays readable while a client can't be accepted, so it
+        // isn't polled until there might be a file descriptor for it.
+        fds[1] = (struct pollfd) {listenFd, acceptPaused ? 0 : POLLIN, 0};
+
+        for (int i = 0; i < count; i++) {
+            size_t pending = pendingOutput(&conns[i]);
+            fds[i + 2].fd = conns[i].fd;
+            fds[i + 2].events = (conns[i].eof || pending >= OUTPUT_FLUSH ? 0 : POLLIN)
+                | (pending > 0 ? POLLOUT : 0);
+            fds[i + 2].revents = 0;
+        }
+
+        int ready = poll(fds, count + 2, acceptPaused ? ACCEPT_RETRY_MS : -1);
+        if (ready < 0) {
+            if (errno != EINTR) {
+                rc = SERVE_HANDLER__SOCKET_ERROR;
+            }
+            continue;
+        }
+        if (ready == 0) {
+            acceptPaused = 0;
+            continue;
+        }
+
+        if (fds[0].revents) {
+            break;
+        }
+
+        // Handle the ones that were polled before adding any new ones.
+        int polled = count;
+
+        for (int i = 0; i < polled; i++) {
+            ServeConn *conn = &conns[i];
+            char drop = 0;
+
+            if (fds[i + 2].revents & (POLLIN | POLLHUP | POLLERR)) {
+                drop = readConn(conn, conn->fd) != SERVE_HANDLER__OK;
+            }
+
+            // Answer what's arrived and send it straight away, instead of
+            // waiting to be told the socket can take it.  Lines can also be
+            // waiting from before, if the output had backed up.
+            if (!drop) {
+                runLines(conn);
+                drop = conn->outOfMemory || sendConn(conn);
+            }
+
+            if (drop || (conn->eof && conn->inLen == 0 && pendingOutput(conn) == 0)) {
+                freeConn(conn);
+                conn->fd = -1;
+            }
+        }
+
+        // Take the closed ones out, keeping the order.
+        int kept = 0;
+        for (int i = 0; i < count; i++) {
+            if (conns[i].fd != -1) {
+                conns[kept++] = conns[i];
+            }
+        }
+        if (kept < count) {
+            acceptPaused = 0;
+        }
+        count = kept;
+
+        if (fds[1].revents & POLLIN) {
+            rc = acceptClients(db, listenFd, &conns, &fds, &count, &cap, &acceptPaused, stats);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        freeConn(&conns[i]);
+    }
+    free(conns);
+    free(fds);
+
+    close(listenFd);
+    removeSocket(socketPath, &created);
+
+    return rc;
+}
+
+/**
+ * Stop serve_handler_listen on the listener, or make it stop as soon as it
+ * starts.  Safe to call from a signal handler or another thread.
+ *
+ * @param   listener
+ */
+void serve_handler_stop(ServeListener *listener)
+{
+    if (listener->stopPipe[1] != -1) {
+        char byte = 0;
+        // If the pipe's full, it's already been told.
+        if (write(listener->stopPipe[1], &byte, 1) < 0) {
+            return;
+        }
+    }
+}
+
+/**
+ * Build an error message from the code.  Returns RC.
+ *
+ * @param   str     Passed back by argument.  Needs to be freed.
+ * @param   code
+ */
+char serve_handler_build_err(char **str, int code)
+{
+    char *strdum;
+
+    switch (code) {
+        case SERVE_HANDLER__OK:
+            strdum = "No error for serve handler.";
+            break;
+        case SERVE_HANDLER__IO_ERROR:
+            strdum = "Could not read requests or write responses.";
+            break;
+        case SERVE_HANDLER__OUT_OF_MEMORY:
+            strdum = "Out of memory for serve handler.";
+            break;
+        case SERVE_HANDLER__SOCKET_ERROR:
+            strdum = "Could not listen on the socket.";
+            break;
+        case SERVE_HANDLER__IN_USE:
+            strdum = "Something is already listening on the socket.";
+            break;
+        default:
+            strdum = "Unknown error for serve handler.";
+    }
+
+    *str = malloc(strlen(strdum) + 1);
+
+    if (*str == NULL) {
+        return SERVE_HANDLER__OUT_OF_MEMORY;
+    }
+
+    strcpy(*str, strdum);
+
+    return SERVE_HANDLER__OK;
+}
+
+// Static functions below this line.
+
+/**
+ * Make the socket and start listening on it.  A socket file that's left over
+ * from a daemon that didn't stop cleanly is replaced, but not one that's
+ * still being listened on, and never anything that isn't a socket (like a
+ * database given as the socket by mistake).
+ *
+ * @param   socketPath
+ * @param   listenFd    Passed back by argument.
+ * @param   created     Passed back by argument.  Identifies the socket file,
+ *                      for removeSocket.
+ */
+static char openSocket(char *socketPath, int *listenFd, struct stat *created)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (strlen(socketPath) >= sizeof(addr.sun_path)) {
+        return SERVE_HANDLER__SOCKET_ERROR;
+    }
+    strcpy(addr.sun_path, socketPath);
+
+    if ((*listenFd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        return SERVE_HANDLER__SOCKET_ERROR;
+    }
+
+    if (bind(*listenFd, (struct sockaddr *) &addr, sizeof(addr)) && errno == EADDRINUSE) {
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        char live = probe >= 0 && connect(probe, (struct sockaddr *) &addr, sizeof(addr)) == 0;
+        if (probe >= 0) {
+            close(probe);
+        }
+
+        if (live) {
+            close(*listenFd);
+            return SERVE_HANDLER__IN_USE;
+        }
+
+        struct stat existing;
+        if (lstat(socketPath, &existing) || !S_ISSOCK(existing.st_mode)) {
+            close(*listenFd);
+            return SERVE_HANDLER__SOCKET_ERROR;
+        }
+
+        unlink(socketPath);
+        bind(*listenFd, (struct sockaddr *) &addr, sizeof(addr));
+    }
+
+    // Bound or not, listen fails if it wasn't.
+    if (listen(*listenFd, LISTEN_BACKLOG)
+        || fcntl(*listenFd, F_SETFL, O_NONBLOCK)
+        || lstat(socketPath, created)
+    ) {
+        close(*listenFd);
+        return SERVE_HANDLER__SOCKET_ERROR;
+    }
+
+    return SERVE_HANDLER__OK;
+}
+
+/**
+ * Remove the socket file, but only if it's still the one openSocket made.
+ * Something else could have been put there since.
+ *
+ * @param   socketPath
+ * @param   created     From openSocket.
+ */
+static void removeSocket(char *socketPath, struct stat *created)
+{
+    struct stat current;
+
+    if (lstat(socketPath, &current) == 0
+        && S_ISSOCK(current.st_mode)
+        && current.st_dev == created->st_dev
+        && current.st_ino == created->st_ino
+    ) {
+        unlink(socketPath);
+    }
+}
+
+/**
+ * Accept every client that's waiting, growing the connections to fit.
+ *
+ * @param   db
+ * @param   listenFd
+ * @param   conns
+ * @param   fds     One more than conns for the stop pipe and socket.
+ * @param   count
+ * @param   cap     Capacity of conns.
+ * @param   paused  Set to true if there weren't file descriptors to accept
+ *                  with, so the socket shouldn't be polled for a while.
+ * @param   stats
+ */
+static char acceptClients(DbHandle *db, int listenFd, ServeConn **conns, struct pollfd **fds,
+    int *count, int *cap, char *paused, ServeStats *stats)
+{
+    int fd;
+
+    while ((fd = accept(listenFd, NULL, NULL)) >= 0) {
+        if (*count == *cap) {
+            ServeConn *connsDum = realloc(*conns, *cap * 2 * sizeof(ServeConn));
+            if (connsDum == NULL) {
+                close(fd);
+                return SERVE_HANDLER__OUT_OF_MEMORY;
+            }
+            *conns = connsDum;
+
+            struct pollfd *fdsDum = realloc(*fds, (*cap * 2 + 2) * sizeof(struct pollfd));
+            if (fdsDum == NULL) {
+                close(fd);
+                return SERVE_HANDLER__OUT_OF_MEMORY;
+            }
+            *fds = fdsDum;
+
+            *cap *= 2;
+        }
+
+        if (fcntl(fd, F_SETFL, O_NONBLOCK) || initConn(&(*conns)[*count], db, fd, NULL, stats)) {
+            close(fd);
+            continue;
+        }
+
+        (*count)++;
+        stats->connections++;
+    }
+
+    if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+        // The client is still waiting, and will be accepted when there's room.
+        *paused = 1;
+    }
+
+    // Clients that gave up before being accepted don't matter.
+    return SERVE_HANDLER__OK;
+}
+
+/**
+ * Start a connection.  Returns true if there wasn't memory for it.
+ *
+ * @param   conn
+ * @param   db
+ * @param   fd      Socket, or -1 to write to output.
+ * @param   output
+ * @param   stats   Shared by every connection.
+ */
+static char initConn(ServeConn *conn, DbHandle *db, int fd, FILE *output, ServeStats *stats)
+{
+    memset(conn, 0, sizeof(ServeConn));
+    conn->db = db;
+    conn->fd = fd;
+    conn->output = output;
+    conn->stats = stats;
+    conn->inCap = INPUT_SIZE;
+
+    return (conn->in = malloc(conn->inCap)) == NULL;
+}
+
+/**
+ * Free a connection's buffers, and close its socket.
+ */
+static void freeConn(ServeConn *conn)
+{
+    if (conn->fd != -1) {
+        close(conn->fd);
+    }
+    free(conn->in);
+    free(conn->out);
+}
+
+/**
+ * Read whatever has arrived.  Returns RC from constants.
+ *
+ * @param   conn
+ * @param   fd
+ */
+static char readConn(ServeConn *conn, int fd)
+{
+    if (conn->inLen == conn->inCap - 1) {
+        if (conn->inCap >= REQUEST_MAX && memchr(conn->in, '\n', conn->inLen) == NULL) {
+            rejectLongLine(conn);
+            return SERVE_HANDLER__OK;
+        }
+
+        // A line longer than the buffer.
+        char *bigger = realloc(conn->in, conn->inCap * 2);
+        if (bigger == NULL) {
+            return SERVE_HANDLER__OUT_OF_MEMORY;
+        }
+        conn->in = bigger;
+        conn->inCap *= 2;
+    }
+
+    ssize_t got;
+
+    // Leave room to terminate a last line that has no newline.
+    while ((got = read(fd, conn->in + conn->inLen, conn->inCap - conn->inLen - 1)) < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return SERVE_HANDLER__OK;
+        }
+        if (errno != EINTR) {
+            return SERVE_HANDLER__IO_ERROR;
+        }
+    }
+
+    if (got == 0) {
+        conn->eof = 1;
+    }
+    conn->inLen += got;
+
+    return SERVE_HANDLER__OK;
+}
+
+/**
+ * Answer a line that's too long with an error, and stop reading from the
+ * client, since there's no telling where the next request would start.
+ *
+ * @param   conn
+ */
+static void rejectLongLine(ServeConn *conn)
+{
+    const char *error = "request too long";
+
+    conn->stats->requests++;
+    conn->stats->failed++;
+
+    appendStr(conn, "{\"ok\":false,\"error\":");
+    jsonWriteString(error, strlen(error), appendJsonBytes, conn);
+    appendStr(conn, "}\n");
+
+    conn->inLen = 0;
+    conn->eof = 1;
+}
+
+/**
+ * Answer the whole lines that have arrived, and the last one if nothing
+ * else is coming.  Returns true if it stopped because the output backed up,
+ * so there are lines still waiting.
+ *
+ * @param   conn
+ */
+static char runLines(ServeConn *conn)
+{
+    char *start = conn->in;
+    char *end = conn->in + conn->inLen;
+    char *newline;
+    char waiting = 0;
+
+    while ((newline = memchr(start, '\n', end - start)) != NULL) {
+        if (pendingOutput(conn) >= OUTPUT_FLUSH || conn->outOfMemory) {
+            waiting = 1;
+            break;
+        }
+
+        *newline = '\0';
+        runLine(conn, start);
+        start = newline + 1;
+    }
+
+    if (!waiting && conn->eof && start < end) {
+        *end = '\0';
+        runLine(conn, start);
+        start = end;
+    }
+
+    conn->inLen = end - start;
+    memmove(conn->in, start, conn->inLen);
+
+    return waiting;
+}
+
+/**
+ * Send as much waiting output as the socket will take.  Returns true if the
+ * client is gone.
+ *
+ * @param   conn
+ */
+static char sendConn(ServeConn *conn)
+{
+    while (conn->outSent < conn->outLen) {
+        ssize_t sent = send(conn->fd, conn->out + conn->outSent,
+            conn->outLen - conn->outSent, MSG_NOSIGNAL);
+
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno != EAGAIN && errno != EWOULDBLOCK;
+        }
+
+        conn->outSent += sent;
+        conn->stats->flushes++;
+    }
+
+    conn->outLen = conn->outSent = 0;
+
+    return 0;
+}
+
+static size_t pendingOutput(ServeConn *conn)
+{
+    return conn->outLen - conn->outSent;
+}
+
+/**
+ * Answer one request.  The response is built optimistically, and cut back to
+ * just the error if the op fails partway.
+ *
+ * @param   conn
+ * @param   line
+ */
+static void runLine(ServeConn *conn, char *line)
+{
+    size_t len = strlen(line);
+    while (len > 0 && isspace((unsigned char) line[len - 1])) {
+        line[--len] = '\0';
+    }
+
+    if (*jsonSkipSpace(line) == '\0') {
+        return;
+    }
+
+    conn->stats->requests++;
+
+    ServeRequest req;
+    const char *error = parseRequest(line, &req);
+
+    size_t start = conn->outLen;
+    appendStr(conn, "{");
+    if (req.tag != NULL) {
+        appendStr(conn, "\"req\":");
+        appendBytes(conn, req.tag, req.tagLen);
+        appendStr(conn, ",");
+    }
+    size_t beforeOk = conn->outLen;
+
+    if (error == NULL && req.op == NULL) {
+        error = "expected an op";
+    } else if (error == NULL) {
+        error = "unknown op";
+
+        for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+            if (strcmp(commands[i].name, req.op) == 0) {
+                appendStr(conn, "\"ok\":true");
+                error = commands[i].run(conn, &req);
+                break;
+            }
+        }
+    }
+
+    if (error != NULL) {
+        conn->stats->failed++;
+        conn->outLen = beforeOk < conn->outLen ? beforeOk : conn->outLen;
+        appendStr(conn, "\"ok\":false,\"error\":");
+        jsonWriteString(error, strlen(error), appendJsonBytes, conn);
+    }
+
+    appendStr(conn, "}\n");
+
+    if (conn->outOfMemory) {
+        conn->outLen = start;
+    }
+}
+
+/**
+ * {"op":"ping"}
+ */
+static const char *pingCommand(ServeConn *conn, ServeRequest *req)
+{
+    return NULL;
+}
+
+/**
+ * {"op":"week","date":DATE}, where the date is any day in the week, and
+ * defaults to today.
+ */
+static const char *weekCommand(ServeConn *conn, ServeRequest *req)
+{
+    Date date = todayDate();
+    if (req->date != NULL && !parseDate(req->date, &date)) {
+        return DATE_FORMAT_ERR;
+    }
+
+    Date week = getWeek(date);
+
+    appendStr(conn, ",\"week\":");
+    appendDate(conn, week);
+    appendStr(conn, ",\"items\":[");
+
+    char dbRc;
+    if ((dbRc = db_interface_each_in_week(conn->db, week, appendItem, conn))) {
+        return dbError(conn, dbRc);
+    }
+
+    appendStr(conn, "]");
+
+    return NULL;
+}
+
+/**
+ * {"op":"range","from":DATE,"to":DATE}, both inclusive.
+ */
+static const char *rangeCommand(ServeConn *conn, ServeRequest *req)
+{
+    Date from, to;
+    if (req->from == NULL || !parseDate(req->from, &from)
+        || req->to == NULL || !parseDate(req->to, &to)
+    ) {
+        return "expected from and to dates (YYYY-MM-DD)";
+    }
+
+    if (toInt(to) < toInt(from)) {
+        return "from is after to";
+    }
+
+    appendStr(conn, ",\"items\":[");
+
+    char dbRc;
+    if ((dbRc = db_interface_each_in_range(conn->db, from, to, appendItem, conn))) {
+        return dbError(conn, dbRc);
+    }
+
+    appendStr(conn, "]");
+
+    return NULL;
+}
+
+/**
+ * {"op":"add","date":DATE,"description":STRING,"repetition":"none"|"yearly"}
+ */
+static const char *addCommand(ServeConn *conn, ServeRequest *req)
+{
+    Date date;
+    if (req->date == NULL || !parseDate(req->date, &date)) {
+        return DATE_FORMAT_ERR;
+    }
+
+    if (req->description == NULL || *req->description == '\0') {
+        return "expected a description";
+    }
+
+    char rep = REP_NONE;
+    if (req->repetition != NULL && strcmp(req->repetition, "yearly") == 0) {
+        rep = REP_YEARLY;
+    } else if (req->repetition != NULL && strcmp(req->repetition, "none") != 0) {
+        return "expected repetition to be none or yearly";
+    }
+
+    PlannerItem item = {0, date, req->description, rep};
+
+    char dbRc;
+    if ((dbRc = db_interface_save(conn->db, &item))) {
+        return dbError(conn, dbRc);
+    }
+
+    appendStr(conn, ",\"id\":");
+    appendLong(conn, item.id);
+
+    return NULL;
+}
+
+/**
+ * {"op":"edit","id":NUMBER,"description":STRING}
+ */
+static const char *editCommand(ServeConn *conn, ServeRequest *req)
+{
+    if (!req->hasId || req->id <= 0) {
+        return "expected an item id";
+    }
+
+    if (req->description == NULL || *req->description == '\0') {
+        return "expected a description";
+    }
+
+    char dbRc;
+    if ((dbRc = db_interface_update_desc(conn->db, req->id, req->description))) {
+        return dbError(conn, dbRc);
+    }
+
+    if (db_interface_changes(conn->db) == 0) {
+        return "no item with that id";
+    }
+
+    return NULL;
+}
+
+/**
+ * {"op":"delete","id":NUMBER}
+ */
+static const char *deleteCommand(ServeConn *conn, ServeRequest *req)
+{
+    if (!req->hasId || req->id <= 0) {
+        return "expected an item id";
+    }
+
+    char dbRc;
+    if ((dbRc = db_interface_delete(conn->db, req->id))) {
+        return dbError(conn, dbRc);
+    }
+
+    if (db_interface_changes(conn->db) == 0) {
+        return "no item with that id";
+    }
+
+    return NULL;
+}
+
+/**
+ * Describe a db interface error, for a response.  Unlike a batch, a failed
+ * request doesn't stop the ones after it, since there's no transaction for
+ * it to have spoiled.
+ *
+ * @param   conn
+ * @param   dbRc
+ */
+static const char *dbError(ServeConn *conn, char dbRc)
+{
+    char *str;
+    if (db_interface_build_err(conn->db, &str, dbRc)) {
+        return "database error";
+    }
+
+    snprintf(conn->errBuf, sizeof(conn->errBuf), "database error: %s", str);
+    free(str);
+
+    return conn->errBuf;
+}
+
+/**
+ * DbItemCallback that appends an item to an "items" array.
+ *
+ * @param   item
+ * @param   ctx     The ServeConn.
+ */
+static char appendItem(PlannerItemView *item, void *ctx)
+{
+    ServeConn *conn = (ServeConn *) ctx;
+
+    if (conn->outOfMemory) {
+        return 1;
+    }
+
+    if (conn->out[conn->outLen - 1] != '[') {
+        appendStr(conn, ",");
+    }
+
+    appendStr(conn, "{\"id\":");
+    appendLong(conn, item->id);
+    appendStr(conn, ",\"date\":");
+    appendDate(conn, item->date);
+    appendStr(conn, ",\"description\":");
+    jsonWriteString(item->desc, item->descLen, appendJsonBytes, conn);
+    appendStr(conn, item->rep == REP_YEARLY
+        ? ",\"repetition\":\"yearly\"}"
+        : ",\"repetition\":\"none\"}");
+
+    return conn->outOfMemory;
+}
+
+/**
+ * Parse a request.  Returns NULL if it parsed, or why it didn't.  The tag is
+ * set as soon as it's found, so it can be echoed even if something after it
+ * is wrong.
+ *
+ * @param   line
+ * @param   req     Passed back by argument.
+ */
+static const char *parseRequest(char *line, ServeRequest *req)
+{
+    memset(req, 0, sizeof(ServeRequest));
+
+    const char *error;
+    if ((error = jsonParseObject(&line, requestField, req)) != NULL) {
+        return error;
+    }
+
+    return *jsonSkipSpace(line) == '\0' ? NULL : "unexpected text after the object";
+}
+
+/**
+ * Put a field of a request where it goes.  See JsonFieldCallback.
+ *
+ * @param   key
+ * @param   value
+ * @param   ctx     The ServeRequest.
+ */
+static const char *requestField(char *key, JsonValue *value, void *ctx)
+{
+    ServeRequest *req = (ServeRequest *) ctx;
+
+    if (strcmp(key, "req") == 0) {
+        // Kept as it was sent, so it isn't unescaped.
+        if (value->type != JSON__STRING && value->type != JSON__NUMBER) {
+            return "expected req to be a string or whole number";
+        }
+        req->tag = value->raw;
+        req->tagLen = value->rawLen;
+        return NULL;
+    }
+
+    if (strcmp(key, "id") == 0) {
+        if (value->type != JSON__NUMBER) {
+            return "expected id to be a whole number";
+        }
+        req->id = value->num;
+        req->hasId = 1;
+        return NULL;
+    }
+
+    for (size_t i = 0; i < sizeof(stringKeys) / sizeof(stringKeys[0]); i++) {
+        if (strcmp(stringKeys[i].name, key) == 0) {
+            if (value->type != JSON__STRING) {
+                return "expected a string";
+            }
+            if (jsonParseString(value->raw, (char **) ((char *) req + stringKeys[i].offset)) == NULL) {
+                return "bad string";
+            }
+            return NULL;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Append to the responses waiting to be written.  If there's no memory for
+ * it, outOfMemory is set and nothing more is appended.
+ *
+ * @param   conn
+ * @param   bytes
+ * @param   len
+ */
+static void appendBytes(ServeConn *conn, const char *bytes, size_t len)
+{
+    if (conn->outOfMemory) {
+        return;
+    }
+
+    if (conn->outLen + len > conn->outCap) {
+        size_t cap = conn->outCap ? conn->outCap : OUTPUT_FLUSH;
+        while (conn->outLen + len > cap) {
+            cap *= 2;
+        }
+
+        char *bigger = realloc(conn->out, cap);
+        if (bigger == NULL) {
+            conn->outOfMemory = 1;
+            return;
+        }
+        conn->out = bigger;
+        conn->outCap = cap;
+    }
+
+    memcpy(conn->out + conn->outLen, bytes, len);
+    conn->outLen += len;
+}
+
+static void appendStr(ServeConn *conn, const char *str)
+{
+    appendBytes(conn, str, strlen(str));
+}
+
+static void appendLong(ServeConn *conn, long value)
+{
+    char str[24];
+    appendBytes(conn, str, snprintf(str, sizeof(str), "%ld", value));
+}
+
+/**
+ * Append a date as a quoted YYYY-MM-DD.
+ */
+static void appendDate(ServeConn *conn, Date date)
+{
+    char str[DATE_STRING_SIZE + 2];
+    str[0] = '"';
+    formatDate(str + 1, date, '-');
+    str[DATE_STRING_SIZE] = '"';
+    appendBytes(conn, str, DATE_STRING_SIZE + 1);
+}
+
+/**
+ * Append part of a string from jsonWriteString.  See JsonWriteCallback.
+ *
+ * @param   bytes
+ * @param   len
+ * @param   ctx     The ServeConn.
+ */
+static void appendJsonBytes(const char *bytes, size_t len, void *ctx)
+{
+    appendBytes((ServeConn *) ctx, bytes, len);
+}
+
+/**
+ * Write out the responses that are waiting.  Returns true if that failed.
+ *
+ * @param   conn
+ * @param   flush   True to flush the output too, once nothing else is coming.
+ */
+static char writeOut(ServeConn *conn, char flush)
+{
+    if (conn->outLen > 0) {
+        if (fwrite(conn->out, 1, conn->outLen, conn->output) != conn->outLen) {
+            return 1;
+        }
+        conn->outLen = 0;
+        conn->unflushed = 1;
+    }
+
+    if (flush && conn->unflushed) {
+        conn->stats->flushes++;
+        conn->unflushed = 0;
+        return fflush(conn->output) != 0;
+    }
+
+    return 0;
+}
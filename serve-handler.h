@@ -0,0 +1,51 @@
+#ifndef servehandler_h
+#define servehandler_h
+
+#include <stdio.h>
+
+#include "db-interface.h"
+
+// Constants
+
+#define SERVE_HANDLER__OK               0
+#define SERVE_HANDLER__IO_ERROR         1
+#define SERVE_HANDLER__OUT_OF_MEMORY    2
+#define SERVE_HANDLER__SOCKET_ERROR     3
+#define SERVE_HANDLER__IN_USE           4
+
+// Types
+
+typedef struct serve_stats {
+    /** @var Number of requests answered (not counting blank lines). */
+    long requests;
+
+    /** @var Number of those requests that got an error back. */
+    long failed;
+
+    /** @var Number of times responses were written out. */
+    long flushes;
+
+    /** @var Number of clients that connected to the socket. */
+    long connections;
+} ServeStats;
+
+typedef struct serve_listener {
+    /** @var Writing to this wakes the poll loop up to stop. */
+    int stopPipe[2];
+} ServeListener;
+
+// Functions
+
+char serve_handler_run(DbHandle *db, FILE *input, FILE *output, ServeStats *stats);
+
+char serve_handler_listener_initialize(ServeListener *listener);
+
+void serve_handler_listener_finalize(ServeListener *listener);
+
+char serve_handler_listen(DbHandle *db, char *socketPath, ServeListener *listener, ServeStats *stats);
+
+void serve_handler_stop(ServeListener *listener);
+
+char serve_handler_build_err(char **str, int code);
+
+#endif
@@ -1,11 +1,41 @@
+#include <errno.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "planner-interface.h"
+#include "batch-handler.h"
+#include "serve-handler.h"
+#include "client-handler.h"
+#include "csv-handler.h"
+#include "export-handler.h"
+#include "ics-handler.h"
 #include "date-functions.h"
+#include "db-interface.h"
 
 #define ERR__GENERAL 1
 #define ERR__MISSING_ARG 2
+#define ERR__COMMAND_FAILED 3
+
+#define PURGE_RETENTION_DAYS 30
+
+/** More than this is a typo, not a retention period. */
+#define PURGE_MAX_DAYS 36500
+
+static int importCsv(DbHandle *db, char *filename, char delim);
+static int importIcs(DbHandle *db, char *filename);
+static int exportItems(DbHandle *db, char *formatName, char *filename);
+static int runBatch(DbHandle *db, char *filename);
+static int purge(DbHandle *db, char *days);
+static int tune(char *setting);
+static int serve(DbHandle *db);
+static int runDaemon(DbHandle *db, char *socketPath);
+static void stopDaemon(int sig);
+static int showWeek(char *socketPath, char *date);
+
+/** The daemon's listener, for the signal handler to stop. */
+static ServeListener daemonListener = {{-1, -1}};
 
 int main(int argc, char *argv[])
 {
@@ -14,13 +44,451 @@ int main(int argc, char *argv[])
         return ERR__MISSING_ARG;
     }
 
-    char rc;
+    // Tuning has to be set before the database is opened, so it's taken out of
+    // the arguments before anything else looks at them.
+    int kept = 2;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            if (db_interface_set_profile(argv[++i])) {
+                fprintf(stderr, "Unknown profile %s.  Use default, durable, or compat.\n", argv[i]);
+                return ERR__MISSING_ARG;
+            }
+        } else if (strcmp(argv[i], "--tune") == 0 && i + 1 < argc) {
+            if (tune(argv[++i])) {
+                return ERR__MISSING_ARG;
+            }
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+
+    // The client talks to a daemon instead of opening the database, so it
+    // has to be before that.
+    if (argc > 2 && strcmp(argv[2], "--client") == 0 && argc <= 4) {
+        return showWeek(argv[1], argc == 4 ? argv[3] : NULL);
+    }
+
+    DbHandle *db;
+
+    if (planner_interface_initialize(&db, argv[1])) {
+        return ERR__GENERAL;
+    }
+
+    if (argc > 2) {
+        // Options that do something other than open the planner.
+        if (strcmp(argv[2], "--export") == 0 && argc == 5) {
+            return exportItems(db, argv[3], argv[4]);
+        }
+        if (strcmp(argv[2], "--serve") == 0 && argc == 3) {
+            return serve(db);
+        }
+        if (strcmp(argv[2], "--purge") == 0 && argc <= 4) {
+            return purge(db, argc == 4 ? argv[3] : NULL);
+        }
+
+        if (argc != 4) {
+            fprintf(stderr, "Usage: %s dbfile [--import-csv|--import-tsv|--import-ics file]\n", argv[0]);
+            fprintf(stderr, "       %s dbfile --export csv|jsonl|ics file\n", argv[0]);
+            fprintf(stderr, "       %s dbfile --batch script\n", argv[0]);
+            fprintf(stderr, "       %s dbfile --serve\n", argv[0]);
+            fprintf(stderr, "       %s dbfile --purge [days]\n", argv[0]);
+            fprintf(stderr, "       %s dbfile --daemon socket\n", argv[0]);
+            fprintf(stderr, "       %s socket --client [date]\n", argv[0]);
+            fprintf(stderr, "Any of them can also take --profile default|durable|compat and --tune pragma=value.\n");
+            db_interface_finalize(db);
+            return ERR__MISSING_ARG;
+        }
+
+        if (strcmp(argv[2], "--import-csv") == 0) {
+            return importCsv(db, argv[3], ',');
+        }
+        if (strcmp(argv[2], "--import-tsv") == 0) {
+            return importCsv(db, argv[3], '\t');
+        }
+        if (strcmp(argv[2], "--import-ics") == 0) {
+            return importIcs(db, argv[3]);
+        }
+        if (strcmp(argv[2], "--batch") == 0) {
+            return runBatch(db, argv[3]);
+        }
+        if (strcmp(argv[2], "--daemon") == 0) {
+            return runDaemon(db, argv[3]);
+        }
+
+        fprintf(stderr, "Unknown option %s.\n", argv[2]);
+        db_interface_finalize(db);
+        return ERR__MISSING_ARG;
+    }
+
+    // Finalizes the database, however it ends.
+    if (planner_interface_run(db, stdin, stdout)) {
+        return ERR__GENERAL;
+    }
+
+    return 0;
+}
+
+/**
+ * Import a CSV or TSV file (or stdin, if the filename is "-") and print how
+ * fast it went.
+ *
+ * @param   filename
+ * @param   delim
+ */
+static int importCsv(DbHandle *db, char *filename, char delim)
+{
+    FILE *input = stdin;
+
+    if (strcmp(filename, "-") != 0 && (input = fopen(filename, "r")) == NULL) {
+        fprintf(stderr, "Could not open %s.\n", filename);
+        db_interface_finalize(db);
+        return ERR__GENERAL;
+    }
+
+    CsvImportStats stats;
+    char rc = csv_handler_import(db, input, delim, &stats);
+
+    if (input != stdin) {
+        fclose(input);
+    }
+
+    if (rc) {
+        char *errStr;
+        csv_handler_build_err(db, &stats, &errStr, rc);
+        fprintf(stderr, "Import failed: %s\n", errStr);
+        free(errStr);
+        errStr = NULL;
+    }
+
+    printf("Imported %ld rows in %.3fs (%.0f rows/sec).\n",
+        stats.rows, stats.seconds,
+        stats.seconds > 0 ? stats.rows / stats.seconds : 0);
+
+    if (stats.skipped) {
+        printf("Skipped %ld lines that could not be parsed, starting with line %ld.\n",
+            stats.skipped, stats.firstSkipped);
+    }
+
+    if (db_interface_finalize(db)) {
+        return ERR__GENERAL;
+    }
+
+    return rc ? ERR__GENERAL : 0;
+}
+
+/**
+ * Import an iCalendar file (or stdin, if the filename is "-") and print how
+ * fast it went.
+ *
+ * @param   filename
+ */
+static int importIcs(DbHandle *db, char *filename)
+{
+    FILE *input = stdin;
+
+    if (strcmp(filename, "-") != 0 && (input = fopen(filename, "r")) == NULL) {
+        fprintf(stderr, "Could not open %s.\n", filename);
+        db_interface_finalize(db);
+        return ERR__GENERAL;
+    }
+
+    IcsImportStats stats;
+    char rc = ics_handler_import(db, input, &stats);
+
+    if (input != stdin) {
+        fclose(input);
+    }
+
+    if (rc) {
+        char *errStr;
+        ics_handler_build_err(db, &stats, &errStr, rc);
+        fprintf(stderr, "Import failed: %s\n", errStr);
+        free(errStr);
+        errStr = NULL;
+    }
+
+    printf("Imported %ld events (%ld yearly) in %.3fs (%.0f events/sec).\n",
+        stats.events, stats.yearly, stats.seconds,
+        stats.seconds > 0 ? stats.events / stats.seconds : 0);
+
+    if (stats.unsupportedRules) {
+        printf("%ld events repeat in a way that isn't supported, so only the first occurrence was imported.\n",
+            stats.unsupportedRules);
+    }
+
+    if (stats.skipped) {
+        printf("Skipped %ld events without a start date.\n", stats.skipped);
+    }
 
-    if ((rc = planner_interface_initialize(argv[1]))) {
+    if (db_interface_finalize(db)) {
         return ERR__GENERAL;
     }
 
-    planner_interface_display_week(todayDate());
+    return rc ? ERR__GENERAL : 0;
+}
+
+/**
+ * Export every item to a file (or stdout, if the filename is "-").  Stats go
+ * to stderr, so they don't end up in the export.
+ *
+ * @param   formatName  csv, jsonl, or ics.
+ * @param   filename
+ */
+static int exportItems(DbHandle *db, char *formatName, char *filename)
+{
+    char format;
+    char rc = export_handler_format(formatName, &format);
+
+    FILE *output = stdout;
+
+    if (!rc && strcmp(filename, "-") != 0 && (output = fopen(filename, "w")) == NULL) {
+        fprintf(stderr, "Could not open %s.\n", filename);
+        db_interface_finalize(db);
+        return ERR__GENERAL;
+    }
+
+    ExportStats stats = {0, 0, 0};
+
+    if (!rc) {
+        rc = export_handler_export(db, output, format, &stats);
+    }
+
+    if (output != stdout && fclose(output) != 0 && !rc) {
+        rc = EXPORT_HANDLER__IO_ERROR;
+    }
+
+    if (rc) {
+        char *errStr;
+        export_handler_build_err(db, &stats, &errStr, rc);
+        fprintf(stderr, "Export failed: %s\n", errStr);
+        free(errStr);
+        errStr = NULL;
+    } else {
+        fprintf(stderr, "Exported %ld items (%ld bytes) in %.3fs (%.0f items/sec).\n",
+            stats.rows, stats.bytes, stats.seconds,
+            stats.seconds > 0 ? stats.rows / stats.seconds : 0);
+    }
+
+    if (db_interface_finalize(db)) {
+        return ERR__GENERAL;
+    }
+
+    return rc ? ERR__GENERAL : 0;
+}
+
+/**
+ * Run a script of commands (or stdin, if the filename is "-").  The result of
+ * each command goes to stdout and the stats go to stderr.  Returns
+ * ERR__COMMAND_FAILED if any of the commands failed.
+ *
+ * @param   filename
+ */
+static int runBatch(DbHandle *db, char *filename)
+{
+    FILE *input = stdin;
+
+    if (strcmp(filename, "-") != 0 && (input = fopen(filename, "r")) == NULL) {
+        fprintf(stderr, "Could not open %s.\n", filename);
+        db_interface_finalize(db);
+        return ERR__GENERAL;
+    }
+
+    BatchStats stats;
+    char rc = batch_handler_run(db, input, stdout, &stats);
+
+    if (input != stdin) {
+        fclose(input);
+    }
+
+    if (rc) {
+        char *errStr;
+        batch_handler_build_err(db, &stats, &errStr, rc);
+        fprintf(stderr, "Batch failed, so nothing since the last commit was saved: %s\n", errStr);
+        free(errStr);
+        errStr = NULL;
+    }
+
+    fprintf(stderr, "Ran %ld commands (%ld failed) in %.3fs (%.0f commands/sec).\n",
+        stats.commands, stats.failed, stats.seconds,
+        stats.seconds > 0 ? stats.commands / stats.seconds : 0);
+
+    if (db_interface_finalize(db) || rc) {
+        return ERR__GENERAL;
+    }
+
+    return stats.failed ? ERR__COMMAND_FAILED : 0;
+}
+
+/**
+ * Remove items deleted more than some number of days ago for good, shrink the
+ * file, and print what was reclaimed.
+ *
+ * @param   days    Number of days to keep deleted items for, or NULL for the
+ *  default.
+ */
+static int purge(DbHandle *db, char *days)
+{
+    int retention = PURGE_RETENTION_DAYS;
+    char *end;
+
+    if (days != NULL) {
+        // Checked as a long, since something too big for an int could wrap
+        // around to 0 and purge everything.
+        errno = 0;
+        long parsed = strtol(days, &end, 10);
+
+        if (*days == '\0' || *end != '\0' || errno == ERANGE
+            || parsed < 0 || parsed > PURGE_MAX_DAYS
+        ) {
+            fprintf(stderr, "Days must be a number from 0 to %d.\n", PURGE_MAX_DAYS);
+            db_interface_finalize(db);
+            return ERR__MISSING_ARG;
+        }
+
+        retention = parsed;
+    }
+
+    DbPurgeStats stats;
+    char rc = db_interface_purge(db, retention, &stats);
+
+    if (rc) {
+        char *errStr;
+        db_interface_build_err(db, &errStr, rc);
+        fprintf(stderr, "Purge failed: %s\n", errStr);
+        free(errStr);
+        errStr = NULL;
+    }
+
+    printf("Purged %ld deleted rows in %ld batches and reclaimed %ld bytes (%ld pages) in %.3fs.\n",
+        stats.rows, stats.batches, stats.bytes, stats.pages, stats.seconds);
+
+    if (db_interface_finalize(db) || rc) {
+        return ERR__GENERAL;
+    }
+
+    return 0;
+}
+
+/**
+ * Set one of the database's tuning pragmas from a "name=value" argument, like
+ * "synchronous=FULL".
+ *
+ * @param   setting
+ */
+static int tune(char *setting)
+{
+    char *equals = strchr(setting, '=');
+
+    if (equals != NULL) {
+        *equals = '\0';
+
+        if (!db_interface_set_tuning(setting, equals + 1)) {
+            return 0;
+        }
+
+        *equals = '=';
+    }
+
+    fprintf(stderr, "Can't tune %s.  Use journal_mode, synchronous, mmap_size, cache_size, temp_store, or busy_timeout=value.\n",
+        setting);
+    return ERR__MISSING_ARG;
+}
+
+/**
+ * Answer JSON Lines requests from stdin until it's closed.
+ */
+static int serve(DbHandle *db)
+{
+    ServeStats stats;
+    char rc = serve_handler_run(db, stdin, stdout, &stats);
+
+    if (rc) {
+        char *errStr;
+        serve_handler_build_err(&errStr, rc);
+        fprintf(stderr, "Stopped serving: %s\n", errStr);
+        free(errStr);
+        errStr = NULL;
+    }
+
+    if (db_interface_finalize(db) || rc) {
+        return ERR__GENERAL;
+    }
+
+    return 0;
+}
+
+/**
+ * Answer clients on a Unix socket until interrupted or terminated.
+ *
+ * @param   socketPath
+ */
+static int runDaemon(DbHandle *db, char *socketPath)
+{
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stopDaemon;
+
+    ServeStats stats = {0, 0, 0, 0};
+    char rc = serve_handler_listener_initialize(&daemonListener);
+
+    if (rc == SERVE_HANDLER__OK) {
+        sigaction(SIGINT, &action, NULL);
+        sigaction(SIGTERM, &action, NULL);
+
+        rc = serve_handler_listen(db, socketPath, &daemonListener, &stats);
+
+        // Nothing is listening any more, and the pipe is about to be closed.
+        action.sa_handler = SIG_IGN;
+        sigaction(SIGINT, &action, NULL);
+        sigaction(SIGTERM, &action, NULL);
+        serve_handler_listener_finalize(&daemonListener);
+    }
+
+    if (rc) {
+        char *errStr;
+        serve_handler_build_err(&errStr, rc);
+        fprintf(stderr, "Stopped serving: %s\n", errStr);
+        free(errStr);
+        errStr = NULL;
+    }
+
+    fprintf(stderr, "Answered %ld requests (%ld failed) from %ld clients.\n",
+        stats.requests, stats.failed, stats.connections);
+    fprintf(stderr, "Week cache: %ld hits, %ld misses.\n",
+        db_interface_get_week_cache_hits(db), db_interface_get_week_cache_misses(db));
+
+    if (db_interface_finalize(db) || rc) {
+        return ERR__GENERAL;
+    }
+
+    return 0;
+}
+
+static void stopDaemon(int sig)
+{
+    serve_handler_stop(&daemonListener);
+}
+
+/**
+ * Print a week from the daemon on socketPath.
+ *
+ * @param   socketPath
+ * @param   date        Any day in the week, or NULL for this week.
+ */
+static int showWeek(char *socketPath, char *date)
+{
+    ClientResult result;
+    char rc;
+
+    if ((rc = client_handler_week(socketPath, date, stdout, &result))) {
+        char *errStr;
+        client_handler_build_err(&result, &errStr, rc);
+        fprintf(stderr, "%s\n", errStr);
+        free(errStr);
+        errStr = NULL;
+        return ERR__GENERAL;
+    }
 
     return 0;
 }